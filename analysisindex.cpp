@@ -0,0 +1,504 @@
+// analysisindex.cpp
+
+#include "analysisindex.h"
+#include "perceptualhash.h"
+#include "ziparchive.h"
+
+#include <QBuffer>
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QImageReader>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QThread>
+#include <algorithm>
+#include <numeric>
+
+namespace {
+    const int kBatchSize = 64;
+    const int kProbeBatchSize = 512;  // header probes are a few KB each
+    const int kThumbnailSide = 128;   // decode size for the hash and statistics
+    const int kRecentCount = 20;     // how many shown files count as "recent"
+    const int kSaveEvery = 2000;     // records analysed between cache writes
+    const int kGroupDistance = 6;    // bits, for the end-of-pass duplicate report
+
+    const quint32 kCacheMagic = 0x52524958;  // "RRIX"
+    const quint32 kCacheVersion = 3;
+}
+
+// Size and modification time; archive members use the archive's time
+static bool statFile(const QString& path, qint64* size, qint64* modified)
+{
+    if (ZipArchive::isMemberPath(path)) {
+        QDateTime archiveModified;
+        if (!ZipArchive::statPath(path, size, &archiveModified)) return false;
+        *modified = archiveModified.toMSecsSinceEpoch();
+        return true;
+    }
+    const QFileInfo info(path);
+    if (!info.exists()) return false;
+    *size = info.size();
+    *modified = info.lastModified().toMSecsSinceEpoch();
+    return true;
+}
+
+AnalysisIndex::AnalysisIndex(const FileIndex& files, QObject* parent)
+    : QObject(parent),
+    m_files(files),
+    m_maxBatches(qBound(1, QThread::idealThreadCount() / 2, 4))  // stay in the background: half the cores at most
+{
+}
+
+AnalysisIndex::~AnalysisIndex()
+{
+    stop();
+    m_tasks.wait();
+}
+
+void AnalysisIndex::start(const QString& rootDirectory)
+{
+    stop();
+
+    m_root = rootDirectory;
+    m_records.clear();
+    m_hashTree.clear();
+    ensureSize();
+    load();
+
+    m_cancel = std::make_shared<std::atomic_bool>(false);
+    ++m_generation;
+    m_stage = Stage::Probe;
+    m_nextId = 0;
+    m_queued.clear();
+    m_probeQueue.clear();
+    m_batchesInFlight = 0;
+    m_analysed = 0;
+    m_sinceSave = 0;
+    m_recent.clear();
+    m_nearRecent.clear();
+
+    dispatch();
+}
+
+void AnalysisIndex::stop()
+{
+    if (m_cancel) {
+        m_cancel->store(true);
+        m_cancel.reset();
+        ++m_generation;  // results still in flight are dropped
+        save();
+    }
+}
+
+void AnalysisIndex::enqueue(FileIndex::Id id)
+{
+    if (!m_cancel) return;
+    m_queued.push_back(id);
+    dispatch();
+}
+
+void AnalysisIndex::prioritizeProbe(FileIndex::Id id)
+{
+    if (!m_cancel || isProbed(id) || m_probeQueue.size() >= static_cast<size_t>(kProbeBatchSize)) return;
+    m_probeQueue.push_back(id);
+    dispatch();
+}
+
+void AnalysisIndex::ensureSize()
+{
+    const size_t count = static_cast<size_t>(m_files.idCount());
+    if (m_records.size() < count)
+        m_records.resize(count);
+}
+
+void AnalysisIndex::dispatch()
+{
+    if (!m_cancel) return;
+
+    while (m_batchesInFlight < m_maxBatches) {
+        const bool probeOnly = m_stage == Stage::Probe;
+        const int batchSize = probeOnly ? kProbeBatchSize : kBatchSize;
+        std::vector<WorkItem> batch;
+        batch.reserve(batchSize);
+        ensureSize();
+        while (static_cast<int>(batch.size()) < batchSize) {
+            FileIndex::Id id;
+            bool itemProbeOnly = probeOnly;
+            if (!m_probeQueue.empty()) {
+                id = m_probeQueue.front();
+                m_probeQueue.pop_front();
+                itemProbeOnly = true;
+                if (isProbed(id)) continue;  // the pass got there first
+            }
+            else if (!m_queued.empty()) {
+                id = m_queued.front();
+                m_queued.pop_front();
+                itemProbeOnly = false;  // files added later get everything at once
+            }
+            else if (m_nextId < static_cast<FileIndex::Id>(m_files.idCount())) {
+                id = m_nextId++;
+            }
+            else {
+                break;
+            }
+            if (!m_files.isAlive(id)) continue;
+            batch.push_back({ id, m_files.filePath(id), m_records[id], itemProbeOnly });
+        }
+
+        if (batch.empty()) {
+            if (m_stage == Stage::Probe) {
+                // Wait for the probes still in flight, so the hash pass sees their records
+                if (m_batchesInFlight > 0) return;
+                qDebug() << "[AnalysisIndex] Header probe complete";
+                m_stage = Stage::Decode;
+                m_nextId = 0;
+                emit probesFinished();
+                continue;
+            }
+            if (m_batchesInFlight == 0) {
+                save();
+                qDebug() << "[AnalysisIndex] Pass complete," << m_analysed << "files checked";
+                // The duplicate report walks every hash: grouped on the scheduler, from a copy
+                TaskScheduler::TaskOptions reportOptions;
+                reportOptions.group = m_tasks;
+                TaskScheduler::instance().submit(TaskScheduler::Priority::Indexing, [hashes = liveHashes()]() {
+                    const QList<QList<FileIndex::Id>> groups = groupHashes(hashes, kGroupDistance);
+                    int duplicates = 0;
+                    for (const QList<FileIndex::Id>& group : groups) {
+                        duplicates += group.size() - 1;
+                    }
+                    qDebug() << "[AnalysisIndex]" << groups.size() << "near-duplicate groups,"
+                        << duplicates << "redundant files";
+                    }, reportOptions);
+                emit finished();
+            }
+            return;
+        }
+
+        const std::shared_ptr<std::atomic_bool> cancel = m_cancel;
+        const int generation = m_generation;
+        TaskScheduler::TaskOptions options;
+        options.group = m_tasks;
+        TaskScheduler::instance().submit(TaskScheduler::Priority::Indexing, [this, cancel, generation, batch]() {
+            std::vector<std::pair<FileIndex::Id, Record>> results;
+            results.reserve(batch.size());
+            for (const WorkItem& item : batch) {
+                if (cancel->load()) return;
+                results.emplace_back(item.id, analyseFile(item));
+            }
+            QMetaObject::invokeMethod(this, [this, generation, results]() {
+                onBatchDone(generation, results);
+                }, Qt::QueuedConnection);
+            }, options);
+        ++m_batchesInFlight;
+    }
+}
+
+void AnalysisIndex::onBatchDone(int generation, const std::vector<std::pair<FileIndex::Id, Record>>& results)
+{
+    if (generation != m_generation) return;  // folder changed meanwhile
+
+    --m_batchesInFlight;
+    ensureSize();
+    for (const auto& result : results) {
+        Record& record = m_records[result.first];
+        const bool newHash = (result.second.flags & HasHash)
+            && (!(record.flags & HasHash) || record.hash != result.second.hash);
+        record = result.second;
+        if (newHash) addToHashTree(result.first);
+    }
+    if (m_stage == Stage::Decode)
+        m_analysed += static_cast<int>(results.size());
+    m_sinceSave += static_cast<int>(results.size());
+    if (m_sinceSave >= kSaveEvery) {
+        save();
+        m_sinceSave = 0;
+    }
+    emit progress(m_analysed, static_cast<int>(m_files.size()));
+    dispatch();
+}
+
+AnalysisIndex::Record AnalysisIndex::analyseFile(const WorkItem& item)
+{
+    qint64 size = 0, modified = 0;
+    if (!statFile(item.path, &size, &modified)) return Record();
+
+    // Unchanged since the cache was written: keep what we have, fill in what's missing
+    Record record = item.cached;
+    if (record.size != size || record.modified != modified) {
+        record = Record();
+        record.size = size;
+        record.modified = modified;
+    }
+
+    if (!(record.flags & (HasProbe | ProbeFailed))) {
+        applyProbe(&record, item.path);
+    }
+    if (!item.probeOnly && !(record.flags & Failed) && (record.flags & (HasHash | HasStats)) != (HasHash | HasStats)) {
+        // One small decode serves both the hash and the statistics. Archive members are
+        // decoded from memory (stored ones straight from the archive's mapping, if it has one).
+        ZipArchive::Data member;
+        QBuffer buffer;
+        QImageReader reader;
+        if (ZipArchive::isMemberPath(item.path)) {
+            ZipArchive::readPath(item.path, &member);
+            buffer.setBuffer(&member.bytes);
+            buffer.open(QIODevice::ReadOnly);
+            reader.setDevice(&buffer);
+        }
+        else {
+            reader.setFileName(item.path);
+        }
+        reader.setAutoTransform(true);
+        const QSize fullSize = reader.size();
+        if (fullSize.isValid())
+            reader.setScaledSize(fullSize.scaled(kThumbnailSide, kThumbnailSide, Qt::KeepAspectRatio).boundedTo(fullSize));
+        const QImage thumbnail = reader.read();
+        if (thumbnail.isNull()) {
+            record.flags |= Failed;
+        }
+        else {
+            record.hash = PerceptualHash::fromImage(thumbnail);
+            record.stats = ImageStats::fromImage(thumbnail);
+            record.flags |= HasHash | HasStats;
+        }
+    }
+    return record;
+}
+
+void AnalysisIndex::applyProbe(Record* record, const QString& path)
+{
+    const ImageProbe::Info probe = ImageProbe::probeFile(path);
+    if (probe.valid) {
+        record->width = probe.width;
+        record->height = probe.height;
+        record->orientation = static_cast<quint8>(probe.orientation);
+        record->flags |= HasProbe;
+    }
+    else {
+        record->flags |= ProbeFailed;
+    }
+}
+
+bool AnalysisIndex::hasHash(FileIndex::Id id) const
+{
+    return id < m_records.size() && (m_records[id].flags & HasHash);
+}
+
+quint64 AnalysisIndex::hash(FileIndex::Id id) const
+{
+    return hasHash(id) ? m_records[id].hash : 0;
+}
+
+bool AnalysisIndex::hasProbe(FileIndex::Id id) const
+{
+    return id < m_records.size() && (m_records[id].flags & HasProbe);
+}
+
+bool AnalysisIndex::isProbed(FileIndex::Id id) const
+{
+    return id < m_records.size() && (m_records[id].flags & (HasProbe | ProbeFailed));
+}
+
+bool AnalysisIndex::stats(FileIndex::Id id, ImageStats::Stats* stats) const
+{
+    if (id >= m_records.size() || !(m_records[id].flags & HasStats)) return false;
+    *stats = m_records[id].stats;
+    return true;
+}
+
+ImageProbe::Info AnalysisIndex::probeInfo(FileIndex::Id id) const
+{
+    ImageProbe::Info info;
+    if (!m_files.isAlive(id) || !hasProbe(id)) return info;
+
+    const Record& record = m_records[id];
+    info.valid = true;
+    info.width = record.width;
+    info.height = record.height;
+    info.orientation = record.orientation;
+    return info;
+}
+
+void AnalysisIndex::addToHashTree(FileIndex::Id id)
+{
+    const quint64 h = m_records[id].hash;
+    m_hashTree.insert(h, id);
+
+    // Hashed after a recent file was shown: it may be near that file too
+    for (Shown& shown : m_recent) {
+        if (PerceptualHash::distance(h, shown.hash) <= shown.maxDistance) {
+            shown.neighbours.push_back(id);
+            ++m_nearRecent[id];
+        }
+    }
+}
+
+void AnalysisIndex::markShown(FileIndex::Id id, int maxDistance)
+{
+    if (!hasHash(id)) return;
+
+    // The neighbours are looked up once, here; a pick is then a hash lookup per candidate
+    Shown shown{ m_records[id].hash, maxDistance, {} };
+    std::vector<quint32> found;
+    m_hashTree.find(shown.hash, maxDistance, &found);
+    std::sort(found.begin(), found.end());
+    found.erase(std::unique(found.begin(), found.end()), found.end());
+    for (quint32 other : found) {
+        if (!m_files.isAlive(other) || !hasHash(other)
+            || PerceptualHash::distance(m_records[other].hash, shown.hash) > maxDistance)
+            continue;  // stale node
+        shown.neighbours.push_back(other);
+        ++m_nearRecent[other];
+    }
+    m_recent.push_back(std::move(shown));
+
+    while (m_recent.size() > static_cast<size_t>(kRecentCount)) {
+        for (FileIndex::Id other : m_recent.front().neighbours) {
+            auto it = m_nearRecent.find(other);
+            if (it != m_nearRecent.end() && --it.value() == 0)
+                m_nearRecent.erase(it);
+        }
+        m_recent.pop_front();
+    }
+}
+
+bool AnalysisIndex::isNearDuplicateOfRecent(FileIndex::Id id) const
+{
+    return m_nearRecent.contains(id);
+}
+
+QList<QList<FileIndex::Id>> AnalysisIndex::nearDuplicateGroups(int maxDistance) const
+{
+    return groupHashes(liveHashes(), maxDistance);
+}
+
+AnalysisIndex::HashList AnalysisIndex::liveHashes() const
+{
+    HashList hashes;
+    for (FileIndex::Id id = 0; id < m_records.size(); ++id) {
+        if (hasHash(id) && m_files.isAlive(id))
+            hashes.emplace_back(m_records[id].hash, id);
+    }
+    return hashes;
+}
+
+QList<QList<FileIndex::Id>> AnalysisIndex::groupHashes(const HashList& hashes, int maxDistance)
+{
+    HammingBKTree tree;
+    for (quint32 i = 0; i < hashes.size(); ++i) {
+        tree.insert(hashes[i].first, i);
+    }
+
+    // Union-find over every pair the tree reports (indices into hashes)
+    std::vector<quint32> parent(hashes.size());
+    std::iota(parent.begin(), parent.end(), 0);
+    auto root = [&parent](quint32 x) {
+        while (parent[x] != x) {
+            parent[x] = parent[parent[x]];
+            x = parent[x];
+        }
+        return x;
+    };
+
+    std::vector<quint32> neighbours;
+    for (quint32 i = 0; i < hashes.size(); ++i) {
+        neighbours.clear();
+        tree.find(hashes[i].first, maxDistance, &neighbours);
+        for (quint32 other : neighbours) {
+            const quint32 a = root(i);
+            const quint32 b = root(other);
+            if (a != b) parent[b] = a;
+        }
+    }
+
+    QHash<quint32, QList<FileIndex::Id>> byRoot;
+    for (quint32 i = 0; i < hashes.size(); ++i) {
+        byRoot[root(i)].append(hashes[i].second);
+    }
+    QList<QList<FileIndex::Id>> groups;
+    for (auto it = byRoot.cbegin(); it != byRoot.cend(); ++it) {
+        if (it.value().size() > 1)
+            groups.append(it.value());
+    }
+    return groups;
+}
+
+QString AnalysisIndex::cachePath() const
+{
+    const QString dir = QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation) + "/index";
+    const QByteArray key = QCryptographicHash::hash(m_root.toUtf8(), QCryptographicHash::Md5).toHex();
+    return dir + "/" + QString::fromLatin1(key) + ".idx";
+}
+
+void AnalysisIndex::load()
+{
+    QFile file(cachePath());
+    if (!file.open(QIODevice::ReadOnly)) return;
+
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_6_0);
+    quint32 magic = 0, version = 0, count = 0;
+    in >> magic >> version >> count;
+    if (magic != kCacheMagic || version != kCacheVersion) {
+        qDebug() << "[AnalysisIndex] Ignoring cache with an old format:" << file.fileName();
+        return;
+    }
+
+    int matched = 0;
+    for (quint32 i = 0; i < count && in.status() == QDataStream::Ok; ++i) {
+        QString relativePath;
+        Record record;
+        ImageStats::Stats& stats = record.stats;
+        in >> relativePath >> record.size >> record.modified >> record.hash
+            >> record.width >> record.height >> record.orientation >> record.flags
+            >> stats.meanLuma >> stats.p10Luma >> stats.p50Luma >> stats.p90Luma
+            >> stats.saturation >> stats.colorfulness >> stats.dominantHue >> stats.hueBins;
+        const FileIndex::Id id = m_files.find(m_root + "/" + relativePath);
+        if (id == FileIndex::InvalidId || id >= m_records.size()) continue;
+        m_records[id] = record;
+        if (record.flags & HasHash)
+            m_hashTree.insert(record.hash, id);
+        ++matched;
+    }
+    qDebug() << "[AnalysisIndex] Loaded" << matched << "cached records from" << file.fileName();
+}
+
+void AnalysisIndex::save() const
+{
+    if (m_root.isEmpty()) return;
+
+    const QString path = cachePath();
+    QDir().mkpath(QFileInfo(path).absolutePath());
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "[AnalysisIndex] Cannot write cache:" << path;
+        return;
+    }
+
+    quint32 count = 0;
+    for (FileIndex::Id id = 0; id < m_records.size(); ++id) {
+        if (m_records[id].flags && m_files.isAlive(id)) ++count;
+    }
+
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_6_0);
+    out << kCacheMagic << kCacheVersion << count;
+    const int prefix = m_root.size() + 1;
+    for (FileIndex::Id id = 0; id < m_records.size(); ++id) {
+        const Record& record = m_records[id];
+        if (!record.flags || !m_files.isAlive(id)) continue;
+        const ImageStats::Stats& stats = record.stats;
+        out << m_files.filePath(id).mid(prefix) << record.size << record.modified << record.hash
+            << record.width << record.height << record.orientation << record.flags
+            << stats.meanLuma << stats.p10Luma << stats.p50Luma << stats.p90Luma
+            << stats.saturation << stats.colorfulness << stats.dominantHue << stats.hueBins;
+    }
+    if (!file.commit())
+        qWarning() << "[AnalysisIndex] Failed to write cache:" << path;
+}
@@ -0,0 +1,165 @@
+// analysisindex.h
+
+#ifndef ANALYSISINDEX_H
+#define ANALYSISINDEX_H
+
+#include <QObject>
+#include <QString>
+#include <QHash>
+#include <QList>
+#include <vector>
+#include <deque>
+#include <atomic>
+#include <memory>
+
+#include "fileindex.h"
+#include "imageprobe.h"
+#include "imagestats.h"
+#include "perceptualhash.h"
+#include "taskscheduler.h"
+
+/*!
+ * \brief The AnalysisIndex class computes per-file data in the background and keeps it
+ *        in a persistent per-folder cache, indexed by FileIndex id.
+ *
+ *        Two passes run over the folder: a quick header probe (dimensions and EXIF
+ *        orientation, see ImageProbe) so pick filters work almost immediately, then a decode
+ *        of a small thumbnail for the 64-bit perceptual hash (used to avoid showing
+ *        near-duplicates back to back) and the tonal/colour statistics (ImageStats) that
+ *        pick queries run on. Work is handed
+ *        to the TaskScheduler in batches at Indexing priority, so it never holds up the
+ *        displayed image; the records themselves are only touched on the GUI thread. Cached records are reused as long as the file's size and
+ *        modification time are unchanged.
+ */
+class AnalysisIndex : public QObject
+{
+    Q_OBJECT
+public:
+    explicit AnalysisIndex(const FileIndex& files, QObject* parent = nullptr);
+    ~AnalysisIndex() override;
+
+    /*!
+     * \brief start loads the cache for rootDirectory and analyses everything that is missing or stale.
+     *        Call it after the FileIndex was (re)built for that folder.
+     */
+    void start(const QString& rootDirectory);
+
+    // Cancels the background pass and writes the cache
+    void stop();
+
+    // Queues a file that was added while the folder is open
+    void enqueue(FileIndex::Id id);
+
+    bool hasHash(FileIndex::Id id) const;
+    quint64 hash(FileIndex::Id id) const;
+
+    bool hasProbe(FileIndex::Id id) const;
+    // Whether the header probe has run on a file, successfully or not
+    bool isProbed(FileIndex::Id id) const;
+    // Probes a file ahead of the rest of the pass (a pick is waiting for it)
+    void prioritizeProbe(FileIndex::Id id);
+
+    // Statistics of a file; false if it hasn't been analysed (yet) or couldn't be decoded
+    bool stats(FileIndex::Id id, ImageStats::Stats* stats) const;
+
+    /*!
+     * \brief probeInfo returns the header info (size, orientation) of a file, from the records
+     *        only: no I/O.
+     * \return The info; valid is false if the file couldn't be probed or the background pass
+     *         hasn't reached it yet (see hasProbe()).
+     */
+    ImageProbe::Info probeInfo(FileIndex::Id id) const;
+
+    // Remembers a shown file, and the files within maxDistance bits of it, for isNearDuplicateOfRecent()
+    void markShown(FileIndex::Id id, int maxDistance);
+
+    // True if id looks like one of the recently shown files
+    bool isNearDuplicateOfRecent(FileIndex::Id id) const;
+
+    // Groups of ids whose hashes are within maxDistance bits of each other (groups of 2+)
+    QList<QList<FileIndex::Id>> nearDuplicateGroups(int maxDistance) const;
+
+signals:
+    void progress(int analysed, int total);
+    void probesFinished();  // every live file has been probed
+    void finished();
+
+private:
+    // (hash, id) of every live file that has a hash
+    using HashList = std::vector<std::pair<quint64, FileIndex::Id>>;
+    HashList liveHashes() const;
+    static QList<QList<FileIndex::Id>> groupHashes(const HashList& hashes, int maxDistance);
+
+    struct Record {
+        qint64 size = -1;
+        qint64 modified = 0;   // msecs since epoch
+        quint64 hash = 0;
+        qint32 width = 0;      // as stored, see ImageProbe::Info
+        qint32 height = 0;
+        quint8 orientation = 1;
+        quint8 flags = 0;
+        ImageStats::Stats stats;
+    };
+    enum RecordFlag : quint8 {
+        HasHash = 0x1,
+        Failed = 0x2,       // decoded unsuccessfully; don't retry until the file changes
+        HasProbe = 0x4,
+        ProbeFailed = 0x8,  // header not recognised; same as Failed
+        HasStats = 0x10,
+    };
+
+    enum class Stage {
+        Probe,   // headers only, large batches
+        Decode,  // decodes a thumbnail for the hash and statistics
+    };
+
+    struct WorkItem {
+        FileIndex::Id id;
+        QString path;
+        Record cached;
+        bool probeOnly;
+    };
+
+    // Every hash that was computed or loaded; records rehashed or removed since leave stale
+    // nodes behind, so results are checked against the records
+    void addToHashTree(FileIndex::Id id);
+
+    void dispatch();
+    void onBatchDone(int generation, const std::vector<std::pair<FileIndex::Id, Record>>& results);
+    static Record analyseFile(const WorkItem& item);
+    static void applyProbe(Record* record, const QString& path);
+
+    void ensureSize();
+    QString cachePath() const;
+    void load();
+    void save() const;
+
+    const FileIndex& m_files;
+    QString m_root;
+    std::vector<Record> m_records;
+
+    TaskScheduler::TaskGroup m_tasks;
+    const int m_maxBatches;                 // batches in flight at once
+    std::shared_ptr<std::atomic_bool> m_cancel;
+    int m_generation = 0;
+    Stage m_stage = Stage::Probe;
+    FileIndex::Id m_nextId = 0;             // sequential pass over all ids (per stage)
+    std::deque<FileIndex::Id> m_queued;     // files added later
+    std::deque<FileIndex::Id> m_probeQueue; // probes a pick is waiting for
+    int m_batchesInFlight = 0;
+    int m_analysed = 0;
+    int m_sinceSave = 0;
+
+    HammingBKTree m_hashTree;
+
+    // A recently shown file and the files near it when it was shown (or hashed since)
+    struct Shown {
+        quint64 hash;
+        int maxDistance;
+        std::vector<FileIndex::Id> neighbours;
+    };
+    std::deque<Shown> m_recent;
+    QHash<FileIndex::Id, int> m_nearRecent;  // id -> number of recent files it is near
+};
+
+#endif // ANALYSISINDEX_H
@@ -0,0 +1,257 @@
+// batchprocessor.cpp
+
+#include "batchprocessor.h"
+#include "directorywatcher.h"
+#include "fileindex.h"
+#include "imageutils.h"
+#include "mappedfile.h"
+#include "taskscheduler.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QSemaphore>
+#include <QStringList>
+#include <atomic>
+#include <memory>
+
+namespace {
+    const int kDefaultPosterizeLevels = 3;  // the GUI spin box default
+    const int kDefaultBlurSigma = 5;        // MainWindow::onDegradeButtonClicked
+
+    QString stepName(const BatchProcessor::Step& step)
+    {
+        switch (step.filter) {
+        case BatchProcessor::Filter::Grayscale: return "gray";
+        case BatchProcessor::Filter::Posterize: return QString("posterize%1").arg(step.value);
+        case BatchProcessor::Filter::Blur: return QString("blur%1").arg(step.value);
+        case BatchProcessor::Filter::Median: return "median";
+        }
+        return QString();
+    }
+
+    // The same steps MainWindow::processAndDisplayImage takes before showing an image
+    QImage decodeForDisplay(const QString& filePath)
+    {
+        cv::Mat mat = ImageUtils::loadAndApplyColorProfile(filePath);
+        if (mat.empty()) return QImage();
+        cv::Mat resampled = ImageUtils::lanczosResizeIfNeeded(mat);
+        mat.release();
+        return ImageUtils::convertMatToQImage(resampled);
+    }
+
+    // Counters shared by the pool tasks of one run
+    struct RunState {
+        explicit RunState(int slots) : freeSlots(slots) {}
+
+        QSemaphore freeSlots;
+        std::atomic<qsizetype> filesDone{ 0 };
+        std::atomic<qsizetype> filesFailed{ 0 };
+        std::atomic<qsizetype> outputsWritten{ 0 };
+        std::atomic<qsizetype> outputsSkipped{ 0 };
+        std::atomic<qsizetype> outputsFailed{ 0 };
+        std::atomic<qint64> pixels{ 0 };
+    };
+}
+
+bool BatchProcessor::parseChain(const QString& spec, Chain* chain, QString* error)
+{
+    *chain = Chain();
+    QString steps = spec.trimmed();
+    const int equals = steps.indexOf('=');
+    if (equals >= 0) {
+        chain->name = steps.left(equals).trimmed();
+        steps = steps.mid(equals + 1);
+        if (chain->name.isEmpty() || chain->name.contains('/') || chain->name.contains('\\')) {
+            *error = QString("Invalid chain name in \"%1\"").arg(spec);
+            return false;
+        }
+    }
+
+    QStringList names;
+    for (const QString& part : steps.split(',', Qt::SkipEmptyParts)) {
+        const QStringList fields = part.trimmed().split(':');
+        const QString filter = fields.value(0).toLower();
+        Step step;
+        bool ok = true;
+        if (filter == "gray" || filter == "grey" || filter == "grayscale") {
+            step.filter = Filter::Grayscale;
+        }
+        else if (filter == "posterize") {
+            step.filter = Filter::Posterize;
+            step.value = fields.size() > 1 ? fields[1].toInt(&ok) : kDefaultPosterizeLevels;
+            ok = ok && step.value >= 2 && step.value <= 100;
+        }
+        else if (filter == "blur") {
+            step.filter = Filter::Blur;
+            step.value = fields.size() > 1 ? fields[1].toInt(&ok) : kDefaultBlurSigma;
+            ok = ok && step.value >= 1 && step.value <= 100;
+        }
+        else if (filter == "median") {
+            step.filter = Filter::Median;
+        }
+        else {
+            *error = QString("Unknown filter \"%1\" in \"%2\"").arg(part.trimmed(), spec);
+            return false;
+        }
+        if (!ok) {
+            *error = QString("Invalid value in \"%1\"").arg(part.trimmed());
+            return false;
+        }
+        chain->steps << step;
+        names << stepName(step);
+    }
+
+    if (chain->steps.isEmpty()) {
+        *error = QString("Empty filter chain \"%1\"").arg(spec);
+        return false;
+    }
+    if (chain->name.isEmpty()) chain->name = names.join('_');
+    return true;
+}
+
+QImage BatchProcessor::applyStep(const QImage& image, const Step& step)
+{
+    switch (step.filter) {
+    case Filter::Grayscale: return ImageUtils::convertToGrayscale(image);
+    case Filter::Posterize: return ImageUtils::posterize(image, step.value);
+    case Filter::Blur: return ImageUtils::gaussianBlur(image, step.value);
+    case Filter::Median: return ImageUtils::medianFilter(image);
+    }
+    return image;
+}
+
+BatchProcessor::BatchProcessor(const Options& options)
+    : m_options(options)
+{
+    if (m_options.threads < 1) m_options.threads = QThread::idealThreadCount();
+    if (m_options.maxInFlight < 1) m_options.maxInFlight = 2 * m_options.threads;
+}
+
+QString BatchProcessor::outputPath(const QString& inputPath, const Chain& chain) const
+{
+    // Archive members ("book.cbz::page01.jpg") become a folder named after the archive
+    QString relative = QDir(m_options.inputDirectory).relativeFilePath(inputPath);
+    relative.replace("::", "/");
+    const QFileInfo info(relative);
+    QString base = info.completeBaseName() + "_" + chain.name + ExportWriter::suffix(m_options.encoder);
+    if (info.path() != ".") base.prepend(info.path() + "/");
+    return QDir::cleanPath(m_options.outputDirectory + "/" + base);
+}
+
+BatchProcessor::Progress BatchProcessor::run(const ProgressCallback& report, int reportIntervalMs)
+{
+    QElapsedTimer elapsed;
+    elapsed.start();
+
+    FileIndex index;
+    index.build(m_options.inputDirectory, DirectoryWatcher::imageNameFilters());
+    QStringList files;
+    files.reserve(index.size());
+    for (qsizetype id = 0; id < index.idCount(); ++id) {
+        if (index.isAlive(static_cast<FileIndex::Id>(id)))
+            files << index.filePath(static_cast<FileIndex::Id>(id));
+    }
+
+    RunState state(m_options.maxInFlight);
+    // All threads are ours (nothing to reserve for a GUI); chains outrank decodes, so workers
+    // finish the images they hold before starting new ones
+    TaskScheduler scheduler(m_options.threads, 0);
+    TaskScheduler::TaskOptions taskOptions;
+
+    const auto progress = [&]() {
+        Progress p;
+        p.files = files.size();
+        p.filesDone = state.filesDone.load();
+        p.filesFailed = state.filesFailed.load();
+        p.outputsWritten = state.outputsWritten.load();
+        p.outputsSkipped = state.outputsSkipped.load();
+        p.outputsFailed = state.outputsFailed.load();
+        p.megapixels = state.pixels.load() / 1e6;
+        p.elapsedMs = elapsed.elapsed();
+        p.inFlight = m_options.maxInFlight - state.freeSlots.available();
+        return p;
+    };
+    QElapsedTimer sinceReport;
+    sinceReport.start();
+    const auto maybeReport = [&]() {
+        if (report && sinceReport.elapsed() >= reportIntervalMs) {
+            report(progress());
+            sinceReport.restart();
+        }
+    };
+
+    for (const QString& path : files) {
+        QList<Chain> chains;
+        QStringList targets;
+        for (const Chain& chain : m_options.chains) {
+            const QString target = outputPath(path, chain);
+            if (m_options.skipExisting && QFileInfo::exists(target)) {
+                ++state.outputsSkipped;
+                continue;
+            }
+            chains << chain;
+            targets << target;
+        }
+        if (chains.isEmpty()) {
+            ++state.filesDone;
+            continue;
+        }
+
+        // Waiting for a slot is what keeps the decoded images in memory bounded; the file is
+        // read into the OS cache meanwhile, so the decode doesn't start on a cold disk
+        MappedFile::prefetch(path);
+        while (!state.freeSlots.tryAcquire(1, reportIntervalMs)) {
+            maybeReport();
+        }
+        maybeReport();
+
+        scheduler.submit(TaskScheduler::Priority::Prefetch, [&scheduler, &state, taskOptions, path, chains, targets, encoder = m_options.encoder]() {
+            const QImage decoded = decodeForDisplay(path);
+            if (decoded.isNull()) {
+                qWarning() << "[BatchProcessor] Cannot decode" << path;
+                ++state.filesFailed;
+                ++state.filesDone;
+                state.freeSlots.release();
+                return;
+            }
+            state.pixels += qint64(decoded.width()) * decoded.height();
+
+            // One task per chain; the last one to finish frees the slot
+            auto remaining = std::make_shared<std::atomic<int>>(static_cast<int>(chains.size()));
+            for (int i = 0; i < chains.size(); ++i) {
+                scheduler.submit(TaskScheduler::Priority::InteractiveFilter, [&state, decoded, remaining, steps = chains[i].steps, target = targets[i], encoder]() {
+                    QImage image = decoded;
+                    for (const Step& step : steps) {
+                        image = applyStep(image, step);
+                    }
+
+                    QDir().mkpath(QFileInfo(target).absolutePath());
+                    QSaveFile file(target);
+                    if (file.open(QIODevice::WriteOnly) && ExportWriter::encode(image, encoder, &file) && file.commit()) {
+                        ++state.outputsWritten;
+                    }
+                    else {
+                        qWarning() << "[BatchProcessor] Cannot write" << target;
+                        ++state.outputsFailed;
+                    }
+
+                    if (remaining->fetch_sub(1) == 1) {
+                        ++state.filesDone;
+                        state.freeSlots.release();
+                    }
+                    }, taskOptions);
+            }
+            }, taskOptions);
+    }
+
+    while (!taskOptions.group.wait(reportIntervalMs)) {
+        maybeReport();
+    }
+
+    const Progress result = progress();
+    if (report) report(result);
+    return result;
+}
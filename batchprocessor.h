@@ -0,0 +1,98 @@
+// batchprocessor.h
+
+#ifndef BATCHPROCESSOR_H
+#define BATCHPROCESSOR_H
+
+#include "exportwriter.h"
+
+#include <QImage>
+#include <QList>
+#include <QString>
+#include <QThread>
+#include <functional>
+
+/*!
+ * \brief The BatchProcessor class applies filter chains to every image below a folder,
+ *        without the GUI (used by the RefPickerBatch tool).
+ *
+ *        Images are decoded exactly as MainWindow displays them (color profile, Lanczos
+ *        resize) and filtered and encoded with the same ImageUtils and ExportWriter code, so
+ *        the output files are byte-identical to what the GUI writes to the shared folder.
+ *        Each image is a small pipeline on a TaskScheduler: a decode task queues one
+ *        task per chain, which filters and then encodes; idle threads steal whole chains or
+ *        the next decode, so decode, filter and encode overlap across cores. At most
+ *        Options::maxInFlight images are between decode and their last write at any time,
+ *        which bounds the memory in use.
+ */
+class BatchProcessor
+{
+public:
+    enum class Filter {
+        Grayscale,   // "gray"
+        Posterize,   // "posterize[:levels]", 3 levels by default as in the GUI
+        Blur,        // "blur[:sigma]", 5 by default as in the GUI
+        Median,      // "median"
+    };
+
+    struct Step {
+        Filter filter = Filter::Grayscale;
+        int value = 0;
+    };
+
+    // One output per input image: the steps are applied in order, like stacking the GUI toggles
+    struct Chain {
+        QString name;   // output file suffix, e.g. "posterize8_gray"
+        QList<Step> steps;
+    };
+
+    struct Options {
+        QString inputDirectory;
+        QString outputDirectory;
+        QList<Chain> chains;
+        ExportWriter::Encoder encoder = ExportWriter::Encoder::FastPng;
+        int threads = QThread::idealThreadCount();
+        int maxInFlight = 0;        // decoded images held at once; 0 = two per thread
+        bool skipExisting = false;  // leave outputs that already exist alone
+    };
+
+    struct Progress {
+        qsizetype files = 0;
+        qsizetype filesDone = 0;
+        qsizetype filesFailed = 0;
+        qsizetype outputsWritten = 0;
+        qsizetype outputsSkipped = 0;
+        qsizetype outputsFailed = 0;
+        double megapixels = 0.0;   // decoded so far
+        qint64 elapsedMs = 0;
+        int inFlight = 0;
+    };
+
+    using ProgressCallback = std::function<void(const Progress& progress)>;
+
+    /*!
+     * \brief parseChain parses "[name=]step,step,...", e.g. "gray", "posterize:6,gray" or
+     *        "soft=blur:3". Without a name, one is made from the steps.
+     * \return false (with a message in *error) if the spec is invalid.
+     */
+    static bool parseChain(const QString& spec, Chain* chain, QString* error);
+
+    // The filtering the GUI does for a step
+    static QImage applyStep(const QImage& image, const Step& step);
+
+    explicit BatchProcessor(const Options& options);
+
+    /*!
+     * \brief run processes the folder and blocks until done, calling report on this thread
+     *        about every reportIntervalMs and once at the end.
+     * \return The final progress.
+     */
+    Progress run(const ProgressCallback& report = ProgressCallback(), int reportIntervalMs = 1000);
+
+    // Output path for an input file and chain (mirrors the input tree below the output folder)
+    QString outputPath(const QString& inputPath, const Chain& chain) const;
+
+private:
+    Options m_options;
+};
+
+#endif // BATCHPROCESSOR_H
@@ -0,0 +1,150 @@
+// fileindex_benchmark.cpp
+//
+// Memory/throughput comparison of FileIndex against the QFileInfoList it replaced.
+// Usage: FileIndexBenchmark [count ...]   (default: 10000 100000 1000000)
+
+#include "fileindex.h"
+#include "randompermutation.h"
+
+#include <QFileInfo>
+#include <QFileInfoList>
+#include <QElapsedTimer>
+#include <QString>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#ifdef Q_OS_WIN
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace {
+
+    qint64 residentBytes()
+    {
+#ifdef Q_OS_WIN
+        PROCESS_MEMORY_COUNTERS counters;
+        if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+            return static_cast<qint64>(counters.WorkingSetSize);
+        return 0;
+#else
+        long pages = 0, resident = 0;
+        FILE* f = std::fopen("/proc/self/statm", "r");
+        if (!f) return 0;
+        if (std::fscanf(f, "%ld %ld", &pages, &resident) != 2) resident = 0;
+        std::fclose(f);
+        return static_cast<qint64>(resident) * sysconf(_SC_PAGESIZE);
+#endif
+    }
+
+    // A library layout similar to real reference packs: 1000 files per folder, two levels deep
+    QString syntheticPath(int i)
+    {
+        return QString("C:/REFERENCE/library/set_%1/pose_%2/reference_%3.jpg")
+            .arg(i / 50000, 3, 10, QChar('0'))
+            .arg((i / 1000) % 50, 2, 10, QChar('0'))
+            .arg(i, 7, 10, QChar('0'));
+    }
+
+    double mib(qint64 bytes) { return bytes / (1024.0 * 1024.0); }
+
+    void runFileIndex(int count)
+    {
+        QElapsedTimer timer;
+
+        const qint64 rssBefore = residentBytes();
+        FileIndex index;
+        timer.start();
+        for (int i = 0; i < count; ++i) {
+            index.append(syntheticPath(i));
+        }
+        const qint64 buildMs = timer.elapsed();
+        const qint64 rssAfter = residentBytes();
+
+        // "Shuffling" is just picking a new permutation key
+        RandomPermutation order;
+        timer.start();
+        order.reset(static_cast<quint64>(index.idCount()));
+        const qint64 shuffleUs = timer.nsecsElapsed() / 1000;
+
+        timer.start();
+        quint64 checksum = 0;
+        for (int i = 0; i < count; ++i) {
+            checksum += order.next(static_cast<quint64>(index.idCount()), [&index](quint64 id) {
+                return index.isAlive(static_cast<FileIndex::Id>(id));
+                });
+        }
+        const qint64 pickNs = timer.nsecsElapsed();
+
+        const int lookups = std::min(count, 100000);
+        timer.start();
+        for (int i = 0; i < lookups; ++i) {
+            checksum += index.find(syntheticPath((i * 7919) % count));
+        }
+        const qint64 findNs = timer.nsecsElapsed();
+
+        std::printf("FileIndex      %8d files | build %6lld ms | index %8.1f MiB (rss +%8.1f MiB, %5.1f B/file)"
+            " | shuffle %8lld us | next %6.1f ns | find %7.1f ns  [%llu]\n",
+            count, static_cast<long long>(buildMs), mib(index.memoryUsage()), mib(rssAfter - rssBefore),
+            static_cast<double>(index.memoryUsage()) / count, static_cast<long long>(shuffleUs),
+            static_cast<double>(pickNs) / count, static_cast<double>(findNs) / lookups,
+            static_cast<unsigned long long>(checksum % 10));
+    }
+
+    void runFileInfoList(int count)
+    {
+        std::mt19937 rng(12345);
+        QElapsedTimer timer;
+
+        const qint64 rssBefore = residentBytes();
+        QFileInfoList files;
+        timer.start();
+        for (int i = 0; i < count; ++i) {
+            files << QFileInfo(syntheticPath(i));
+        }
+        const qint64 buildMs = timer.elapsed();
+        const qint64 rssAfter = residentBytes();
+
+        timer.start();
+        std::shuffle(files.begin(), files.end(), rng);
+        const qint64 shuffleUs = timer.nsecsElapsed() / 1000;
+
+        timer.start();
+        qsizetype checksum = 0;
+        for (int i = 0; i < count; ++i) {
+            checksum += files[i].filePath().size();
+        }
+        const qint64 pickNs = timer.nsecsElapsed();
+
+        // Note: these QFileInfos were never stat'ed; the ones from QDirIterator also carry
+        // cached stat data, so real usage is higher than this.
+        std::printf("QFileInfoList  %8d files | build %6lld ms | rss +%8.1f MiB (%5.1f B/file)"
+            " | shuffle %8lld us | pick %6.1f ns  [%lld]\n",
+            count, static_cast<long long>(buildMs), mib(rssAfter - rssBefore),
+            static_cast<double>(rssAfter - rssBefore) / count, static_cast<long long>(shuffleUs),
+            static_cast<double>(pickNs) / count, static_cast<long long>(checksum % 10));
+    }
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    std::vector<int> counts;
+    for (int i = 1; i < argc; ++i) {
+        counts.push_back(std::atoi(argv[i]));
+    }
+    if (counts.empty())
+        counts = { 10000, 100000, 1000000 };
+
+    for (int count : counts) {
+        if (count <= 0) continue;
+        runFileIndex(count);
+        runFileInfoList(count);
+    }
+    return 0;
+}
@@ -0,0 +1,586 @@
+// imageutils_benchmark.cpp
+//
+// Throughput of the ImageUtils kernels at several image sizes, on synthetic images and
+// (optionally) on real images from a corpus folder, scaled to each size.
+// Usage: ImageUtilsBenchmark [--sizes 1,12,48,100] [--reps N] [--corpus DIR] [--kernels a,b]
+//                            [--json FILE] [--verbose]
+// The decode_* kernels decode the image as JPEG, PNG and WebP from memory with the native
+// decoders (when built in) and, as decode_*_magick, with ImageMagick; a native vs ImageMagick
+// table follows the results (and goes to the JSON as "decode_comparison").
+// The resample_* kernels compare LanczosResampler with cv::resize (the _cv variants).
+// Runs headless (no GUI application is created).
+
+#include "imageutils.h"
+#include "imagedecoders.h"
+#include "lanczosresampler.h"
+#include "scratcharena.h"
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QImage>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+#include <QStringList>
+#include <QTemporaryDir>
+#include <opencv2/opencv.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <new>
+#include <vector>
+
+#ifdef Q_OS_WIN
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+// ---------------------------------------------------------------------------
+// Allocation counting: C++ allocations through operator new, and cv::Mat buffers through
+// a counting MatAllocator. (QImage and ImageMagick use malloc directly and aren't counted.)
+// Mat buffers of 1 MiB or more are counted apart: at benchmark sizes those are full frames.
+// The kernels' ScratchArena reports its own borrows and the blocks it had to allocate.
+// ---------------------------------------------------------------------------
+namespace {
+    std::atomic<quint64> g_newCount{ 0 };
+    std::atomic<quint64> g_newBytes{ 0 };
+}
+
+void* operator new(std::size_t size)
+{
+    g_newCount.fetch_add(1, std::memory_order_relaxed);
+    g_newBytes.fetch_add(size, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+namespace {
+
+    const size_t kLargeMatBytes = size_t(1) << 20;
+
+    class CountingMatAllocator : public cv::MatAllocator
+    {
+    public:
+        explicit CountingMatAllocator(cv::MatAllocator* base) : m_base(base) {}
+
+        cv::UMatData* allocate(int dims, const int* sizes, int type, void* data, size_t* step,
+            cv::AccessFlag flags, cv::UMatUsageFlags usageFlags) const override
+        {
+            cv::UMatData* u = m_base->allocate(dims, sizes, type, data, step, flags, usageFlags);
+            if (u && !data) {
+                count.fetch_add(1, std::memory_order_relaxed);
+                bytes.fetch_add(u->size, std::memory_order_relaxed);
+                if (u->size >= kLargeMatBytes) large.fetch_add(1, std::memory_order_relaxed);
+            }
+            return u;
+        }
+
+        bool allocate(cv::UMatData* data, cv::AccessFlag accessFlags, cv::UMatUsageFlags usageFlags) const override
+        {
+            return m_base->allocate(data, accessFlags, usageFlags);
+        }
+
+        void deallocate(cv::UMatData* data) const override
+        {
+            m_base->deallocate(data);
+        }
+
+        mutable std::atomic<quint64> count{ 0 };
+        mutable std::atomic<quint64> bytes{ 0 };
+        mutable std::atomic<quint64> large{ 0 };
+
+    private:
+        cv::MatAllocator* m_base;
+    };
+
+    CountingMatAllocator* g_matAllocator = nullptr;
+
+    struct Allocations {
+        quint64 newCount = 0;
+        quint64 newBytes = 0;
+        quint64 matCount = 0;
+        quint64 matBytes = 0;
+        quint64 matLarge = 0;
+        quint64 scratchBorrows = 0;
+        quint64 scratchAllocations = 0;
+    };
+
+    Allocations allocationsNow()
+    {
+        Allocations a;
+        a.newCount = g_newCount.load();
+        a.newBytes = g_newBytes.load();
+        a.matCount = g_matAllocator ? g_matAllocator->count.load() : 0;
+        a.matBytes = g_matAllocator ? g_matAllocator->bytes.load() : 0;
+        a.matLarge = g_matAllocator ? g_matAllocator->large.load() : 0;
+        const ScratchArena::Stats scratch = ScratchArena::stats();
+        a.scratchBorrows = scratch.borrows;
+        a.scratchAllocations = scratch.allocations;
+        return a;
+    }
+
+    // ---------------------------------------------------------------------------
+    // Resident memory
+    // ---------------------------------------------------------------------------
+
+    // Resets the peak so each case reports its own (Linux only; elsewhere the peak is
+    // process-wide and only grows)
+    void resetPeakResident()
+    {
+#ifdef Q_OS_LINUX
+        if (FILE* f = std::fopen("/proc/self/clear_refs", "w")) {
+            std::fputs("5", f);
+            std::fclose(f);
+        }
+#endif
+    }
+
+    qint64 peakResidentBytes()
+    {
+#ifdef Q_OS_WIN
+        PROCESS_MEMORY_COUNTERS counters;
+        if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+            return static_cast<qint64>(counters.PeakWorkingSetSize);
+        return 0;
+#elif defined(Q_OS_LINUX)
+        qint64 kb = 0;
+        if (FILE* f = std::fopen("/proc/self/status", "r")) {
+            char line[256];
+            while (std::fgets(line, sizeof(line), f)) {
+                if (std::sscanf(line, "VmHWM: %lld kB", &kb) == 1) break;
+            }
+            std::fclose(f);
+        }
+        return kb * 1024;
+#else
+        struct rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        return static_cast<qint64>(usage.ru_maxrss);  // bytes on macOS
+#endif
+    }
+
+    double mib(qint64 bytes) { return bytes / (1024.0 * 1024.0); }
+
+    // ---------------------------------------------------------------------------
+    // Inputs
+    // ---------------------------------------------------------------------------
+
+    cv::Size sizeForMegapixels(double megapixels)
+    {
+        // 3:2, like most camera images
+        const double pixels = megapixels * 1e6;
+        const int width = static_cast<int>(std::lround(std::sqrt(pixels * 1.5)));
+        return cv::Size(width, static_cast<int>(std::lround(pixels / width)));
+    }
+
+    // Smooth gradients plus noise: compresses and filters like a photo, not like a flat fill
+    cv::Mat syntheticImage(cv::Size size)
+    {
+        cv::Mat bgr(size, CV_8UC3);
+        for (int y = 0; y < size.height; ++y) {
+            cv::Vec3b* row = bgr.ptr<cv::Vec3b>(y);
+            for (int x = 0; x < size.width; ++x) {
+                row[x] = cv::Vec3b(
+                    static_cast<uchar>((x * 255) / size.width),
+                    static_cast<uchar>((y * 255) / size.height),
+                    static_cast<uchar>(((x + y) * 255) / (size.width + size.height)));
+            }
+        }
+        cv::Mat noise(size, CV_8UC3);
+        cv::randn(noise, cv::Scalar::all(0), cv::Scalar::all(12));
+        cv::add(bgr, noise, bgr, cv::noArray(), CV_8UC3);
+        return bgr;
+    }
+
+    struct Input {
+        QString name;         // "synthetic" or the corpus file name
+        cv::Mat bgr;          // at the target size
+        QString encodedPath;  // the same image as JPEG, for the load kernel
+    };
+
+    // ---------------------------------------------------------------------------
+    // Kernels
+    // ---------------------------------------------------------------------------
+
+    struct Kernel {
+        const char* name;
+        // Prepared once per input (conversions the kernel doesn't measure), then run
+        std::function<std::function<void()>(const Input&)> prepare;
+    };
+
+    std::vector<Kernel> kernels()
+    {
+        auto rgbImage = [](const Input& input) {
+            cv::Mat rgb;
+            cv::cvtColor(input.bgr, rgb, cv::COLOR_BGR2RGB);
+            return ImageUtils::convertMatToQImage(rgb);
+        };
+        // The same image in each format, decoded from memory by the native decoder (when built
+        // in) and by ImageMagick; an empty function skips a format OpenCV can't write
+        auto decode = [](const char* extension, ImageUtils::Decoder decoder) {
+            return [extension, decoder](const Input& input) {
+                std::vector<uchar> encoded;
+                if (!cv::haveImageWriter(extension) || !cv::imencode(extension, input.bgr, encoded))
+                    return std::function<void()>();
+                const QByteArray data(reinterpret_cast<const char*>(encoded.data()), static_cast<qsizetype>(encoded.size()));
+                return std::function<void()>([data, decoder]() {
+                    cv::Mat m = ImageUtils::loadAndApplyColorProfileFromMemory(data, decoder);
+                    Q_UNUSED(m);
+                    });
+                };
+        };
+        // Lanczos-4 to RGB by LanczosResampler (linear light) and by cv::resize + cvtColor (what
+        // lanczosResizeIfNeeded did before). cv::resize doesn't widen the kernel when shrinking,
+        // so at 0.5x it does less work (and aliases). 2x is skipped past 12 MP.
+        auto resample = [](double factor, bool openCv) {
+            return [factor, openCv](const Input& input) {
+                const cv::Size size(static_cast<int>(input.bgr.cols * factor), static_cast<int>(input.bgr.rows * factor));
+                if (factor > 1.0 && input.bgr.total() > 12000000)
+                    return std::function<void()>();
+                return std::function<void()>([bgr = input.bgr, size, openCv]() {
+                    cv::Mat rgb;
+                    if (openCv) {
+                        cv::resize(bgr, rgb, size, 0, 0, cv::INTER_LANCZOS4);
+                        cv::cvtColor(rgb, rgb, cv::COLOR_BGR2RGB);
+                    }
+                    else {
+                        rgb = LanczosResampler::resizeBgrToRgb(bgr, size, 4);
+                    }
+                    Q_UNUSED(rgb);
+                    });
+                };
+        };
+        return {
+            { "loadAndApplyColorProfile", [](const Input& input) {
+                return std::function<void()>([path = input.encodedPath]() {
+                    cv::Mat m = ImageUtils::loadAndApplyColorProfile(path);
+                    Q_UNUSED(m);
+                    });
+                } },
+            { "decode_jpeg", decode(".jpg", ImageUtils::Decoder::Auto) },
+            { "decode_jpeg_magick", decode(".jpg", ImageUtils::Decoder::Magick) },
+            { "decode_png", decode(".png", ImageUtils::Decoder::Auto) },
+            { "decode_png_magick", decode(".png", ImageUtils::Decoder::Magick) },
+            { "decode_webp", decode(".webp", ImageUtils::Decoder::Auto) },
+            { "decode_webp_magick", decode(".webp", ImageUtils::Decoder::Magick) },
+            { "lanczosResizeIfNeeded", [](const Input& input) {
+                return std::function<void()>([bgr = input.bgr]() {
+                    cv::Mat m = ImageUtils::lanczosResizeIfNeeded(bgr);
+                    Q_UNUSED(m);
+                    });
+                } },
+            { "resample_2x", resample(2.0, false) },
+            { "resample_2x_cv", resample(2.0, true) },
+            { "resample_half", resample(0.5, false) },
+            { "resample_half_cv", resample(0.5, true) },
+            { "convertMatToQImage", [](const Input& input) {
+                cv::Mat rgb;
+                cv::cvtColor(input.bgr, rgb, cv::COLOR_BGR2RGB);
+                return std::function<void()>([rgb]() {
+                    QImage image = ImageUtils::convertMatToQImage(rgb);
+                    Q_UNUSED(image);
+                    });
+                } },
+            { "convertQImageToMat", [rgbImage](const Input& input) {
+                return std::function<void()>([image = rgbImage(input)]() {
+                    cv::Mat m = ImageUtils::convertQImageToMat(image);
+                    Q_UNUSED(m);
+                    });
+                } },
+            { "convertToGrayscale", [rgbImage](const Input& input) {
+                return std::function<void()>([image = rgbImage(input)]() {
+                    QImage gray = ImageUtils::convertToGrayscale(image);
+                    Q_UNUSED(gray);
+                    });
+                } },
+            { "posterize", [rgbImage](const Input& input) {
+                return std::function<void()>([image = rgbImage(input)]() {
+                    QImage out = ImageUtils::posterize(image, 8, false);
+                    Q_UNUSED(out);
+                    });
+                } },
+            { "posterize_normalizeAB", [rgbImage](const Input& input) {
+                return std::function<void()>([image = rgbImage(input)]() {
+                    QImage out = ImageUtils::posterize(image, 8, true);
+                    Q_UNUSED(out);
+                    });
+                } },
+            { "gaussianBlur", [rgbImage](const Input& input) {
+                return std::function<void()>([image = rgbImage(input)]() {
+                    QImage out = ImageUtils::gaussianBlur(image, 5);
+                    Q_UNUSED(out);
+                    });
+                } },
+            { "medianFilter", [rgbImage](const Input& input) {
+                return std::function<void()>([image = rgbImage(input)]() {
+                    QImage out = ImageUtils::medianFilter(image);
+                    Q_UNUSED(out);
+                    });
+                } },
+        };
+    }
+
+    struct Options {
+        std::vector<double> sizes = { 1, 12, 48, 100 };
+        int reps = 3;
+        QString corpus;
+        QStringList kernelFilter;
+        QString jsonPath;
+        bool verbose = false;
+    };
+
+    QJsonObject runCase(const Kernel& kernel, const Input& input, const Options& options)
+    {
+        const std::function<void()> run = kernel.prepare(input);
+        if (!run) return QJsonObject();
+
+        run();  // warm-up: first-touch page faults, OpenCV/Magick initialisation
+
+        resetPeakResident();
+        const Allocations before = allocationsNow();
+        std::vector<double> ms;
+        QElapsedTimer timer;
+        for (int i = 0; i < options.reps; ++i) {
+            timer.start();
+            run();
+            ms.push_back(timer.nsecsElapsed() / 1e6);
+        }
+        const Allocations after = allocationsNow();
+        const qint64 peak = peakResidentBytes();
+
+        std::sort(ms.begin(), ms.end());
+        const double median = ms[ms.size() / 2];
+        const double megapixels = input.bgr.total() / 1e6;
+        const double mpPerSecond = median > 0.0 ? megapixels / (median / 1000.0) : 0.0;
+        const double reps = static_cast<double>(options.reps);
+
+        std::printf("%-26s %-20s %6.1f MP | median %9.2f ms | min %9.2f ms | %8.1f MP/s"
+            " | new %7.0f (%8.1f MiB) | mat %5.0f (%8.1f MiB, %3.0f large) | scratch %3.0f (%3.0f new)"
+            " | peak rss %8.1f MiB\n",
+            kernel.name, qPrintable(input.name.left(20)), megapixels, median, ms.front(), mpPerSecond,
+            (after.newCount - before.newCount) / reps, mib(static_cast<qint64>((after.newBytes - before.newBytes) / reps)),
+            (after.matCount - before.matCount) / reps, mib(static_cast<qint64>((after.matBytes - before.matBytes) / reps)),
+            (after.matLarge - before.matLarge) / reps,
+            (after.scratchBorrows - before.scratchBorrows) / reps, (after.scratchAllocations - before.scratchAllocations) / reps,
+            mib(peak));
+        std::fflush(stdout);
+
+        QJsonObject result;
+        result["kernel"] = kernel.name;
+        result["image"] = input.name;
+        result["width"] = input.bgr.cols;
+        result["height"] = input.bgr.rows;
+        result["megapixels"] = megapixels;
+        result["reps"] = options.reps;
+        result["ms_median"] = median;
+        result["ms_min"] = ms.front();
+        result["mp_per_s"] = mpPerSecond;
+        result["allocations_per_run"] = (after.newCount - before.newCount) / reps;
+        result["allocated_bytes_per_run"] = (after.newBytes - before.newBytes) / reps;
+        result["mat_allocations_per_run"] = (after.matCount - before.matCount) / reps;
+        result["mat_bytes_per_run"] = (after.matBytes - before.matBytes) / reps;
+        result["large_mat_allocations_per_run"] = (after.matLarge - before.matLarge) / reps;
+        result["scratch_borrows_per_run"] = (after.scratchBorrows - before.scratchBorrows) / reps;
+        result["scratch_allocations_per_run"] = (after.scratchAllocations - before.scratchAllocations) / reps;
+        result["peak_rss_bytes"] = static_cast<double>(peak);
+        return result;
+    }
+
+    // Native decoder against ImageMagick, per format and case, from the decode_* results
+    QJsonArray decodeComparison(const QJsonArray& results)
+    {
+        QJsonArray comparison;
+        bool header = false;
+        for (const QJsonValue& value : results) {
+            const QJsonObject native = value.toObject();
+            const QString kernel = native["kernel"].toString();
+            if (!kernel.startsWith("decode_") || kernel.endsWith("_magick")) continue;
+            for (const QJsonValue& other : results) {
+                const QJsonObject magick = other.toObject();
+                if (magick["kernel"].toString() != kernel + "_magick" || magick["image"] != native["image"]
+                    || magick["width"] != native["width"] || magick["height"] != native["height"])
+                    continue;
+
+                const QString format = kernel.mid(7);
+                const double nativeMs = native["ms_median"].toDouble();
+                const double magickMs = magick["ms_median"].toDouble();
+                const double speedup = nativeMs > 0.0 ? magickMs / nativeMs : 0.0;
+                const bool available = ImageDecoders::isAvailable(format == "jpeg" ? ImageDecoders::Format::Jpeg
+                    : format == "png" ? ImageDecoders::Format::Png : ImageDecoders::Format::Webp);
+                if (!header) {
+                    std::printf("\nDecode, native vs ImageMagick (median):\n");
+                    header = true;
+                }
+                std::printf("  %-5s %-20s %6.1f MP | %-6s %9.2f ms | magick %9.2f ms | %5.2fx\n",
+                    qPrintable(format), qPrintable(native["image"].toString().left(20)), native["megapixels"].toDouble(),
+                    available ? "native" : "magick", nativeMs, magickMs, speedup);
+
+                QJsonObject entry;
+                entry["format"] = format;
+                entry["image"] = native["image"];
+                entry["megapixels"] = native["megapixels"];
+                entry["native_available"] = available;
+                entry["ms_native"] = nativeMs;
+                entry["ms_magick"] = magickMs;
+                entry["speedup"] = speedup;
+                comparison.append(entry);
+                break;
+            }
+        }
+        std::fflush(stdout);
+        return comparison;
+    }
+
+    bool parseOptions(const QStringList& args, Options* options)
+    {
+        for (int i = 1; i < args.size(); ++i) {
+            const QString& arg = args[i];
+            const bool hasValue = i + 1 < args.size();
+            if (arg == "--sizes" && hasValue) {
+                options->sizes.clear();
+                for (const QString& s : args[++i].split(',', Qt::SkipEmptyParts)) {
+                    options->sizes.push_back(s.toDouble());
+                }
+            }
+            else if (arg == "--reps" && hasValue) {
+                options->reps = qMax(1, args[++i].toInt());
+            }
+            else if (arg == "--corpus" && hasValue) {
+                options->corpus = args[++i];
+            }
+            else if (arg == "--kernels" && hasValue) {
+                options->kernelFilter = args[++i].split(',', Qt::SkipEmptyParts);
+            }
+            else if (arg == "--json" && hasValue) {
+                options->jsonPath = args[++i];
+            }
+            else if (arg == "--verbose") {
+                options->verbose = true;
+            }
+            else {
+                std::fprintf(stderr, "Usage: ImageUtilsBenchmark [--sizes 1,12,48,100] [--reps N] [--corpus DIR]"
+                    " [--kernels a,b] [--json FILE] [--verbose]\n");
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void quietMessageHandler(QtMsgType type, const QMessageLogContext&, const QString& message)
+    {
+        // ImageUtils logs every step with qDebug; keep the table readable
+        if (type == QtDebugMsg || type == QtInfoMsg) return;
+        std::fprintf(stderr, "%s\n", qPrintable(message));
+    }
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    Options options;
+    if (!parseOptions(app.arguments(), &options)) return 1;
+    if (!options.verbose) qInstallMessageHandler(quietMessageHandler);
+
+    static CountingMatAllocator matAllocator(cv::Mat::getStdAllocator());
+    g_matAllocator = &matAllocator;
+    cv::Mat::setDefaultAllocator(&matAllocator);
+
+    // Sources: the synthetic pattern plus every readable image in the corpus folder
+    std::vector<std::pair<QString, cv::Mat>> sources;
+    sources.emplace_back("synthetic", cv::Mat());
+    if (!options.corpus.isEmpty()) {
+        const QFileInfoList files = QDir(options.corpus).entryInfoList(
+            { "*.jpg", "*.jpeg", "*.png", "*.tif", "*.tiff", "*.webp", "*.bmp" }, QDir::Files, QDir::Name);
+        for (const QFileInfo& file : files) {
+            cv::Mat mat = ImageUtils::loadAndApplyColorProfile(file.filePath());
+            if (mat.empty()) {
+                std::fprintf(stderr, "Skipping unreadable corpus image %s\n", qPrintable(file.fileName()));
+                continue;
+            }
+            sources.emplace_back(file.fileName(), mat);
+        }
+    }
+
+    QTemporaryDir tempDir;
+    if (!tempDir.isValid()) {
+        std::fprintf(stderr, "Cannot create a temporary folder\n");
+        return 1;
+    }
+
+    QJsonArray results;
+    for (double megapixels : options.sizes) {
+        if (megapixels <= 0) continue;
+        const cv::Size size = sizeForMegapixels(megapixels);
+        for (const auto& source : sources) {
+            Input input;
+            input.name = source.first;
+            if (source.second.empty()) {
+                input.bgr = syntheticImage(size);
+            }
+            else {
+                const int interpolation = source.second.total() > static_cast<size_t>(size.area()) ? cv::INTER_AREA : cv::INTER_CUBIC;
+                cv::resize(source.second, input.bgr, size, 0, 0, interpolation);
+            }
+            input.encodedPath = tempDir.filePath(QString("input_%1.jpg").arg(results.size()));
+            cv::imwrite(input.encodedPath.toStdString(), input.bgr, { cv::IMWRITE_JPEG_QUALITY, 92 });
+
+            for (const Kernel& kernel : kernels()) {
+                if (!options.kernelFilter.isEmpty() && !options.kernelFilter.contains(kernel.name)) continue;
+                const QJsonObject result = runCase(kernel, input, options);
+                if (!result.isEmpty()) results.append(result);
+            }
+            QFile::remove(input.encodedPath);
+        }
+    }
+
+    const QJsonArray comparison = decodeComparison(results);
+
+    if (!options.jsonPath.isEmpty()) {
+        QJsonArray nativeDecoders;
+        for (ImageDecoders::Format format : { ImageDecoders::Format::Jpeg, ImageDecoders::Format::Png, ImageDecoders::Format::Webp }) {
+            if (ImageDecoders::isAvailable(format)) nativeDecoders.append(ImageDecoders::formatName(format));
+        }
+        QJsonObject root;
+        root["benchmark"] = "ImageUtils";
+        root["opencv"] = QString::fromLatin1(CV_VERSION);
+        root["qt"] = QString::fromLatin1(qVersion());
+        root["threads"] = cv::getNumThreads();
+        root["native_decoders"] = nativeDecoders;
+        root["results"] = results;
+        root["decode_comparison"] = comparison;
+        QSaveFile file(options.jsonPath);
+        if (!file.open(QIODevice::WriteOnly)) {
+            std::fprintf(stderr, "Cannot write %s\n", qPrintable(options.jsonPath));
+            return 1;
+        }
+        file.write(QJsonDocument(root).toJson());
+        if (!file.commit()) {
+            std::fprintf(stderr, "Cannot write %s\n", qPrintable(options.jsonPath));
+            return 1;
+        }
+        std::printf("Wrote %lld results to %s\n", static_cast<long long>(results.size()), qPrintable(options.jsonPath));
+    }
+    return 0;
+}
@@ -0,0 +1,472 @@
+// imageutils_golden.cpp
+//
+// Golden-image and time-budget check for the ImageUtils kernels, to run before and after
+// changing the loader or a filter.
+// Usage: ImageUtilsGolden generate --corpus DIR
+//        ImageUtilsGolden record --corpus DIR --golden DIR [--reps N] [--keep]
+//        ImageUtilsGolden check  --corpus DIR --golden DIR [--reps N] [--margin 0.25] [--no-timing]
+//                                [--verbose]
+//
+// "record" runs every kernel on every corpus image and stores the outputs (lossless PNG)
+// plus the per-kernel time in DIR/baseline.json. "check" runs them again and fails (exit
+// code 1) when an output differs from its golden image beyond the kernel's tolerance
+// (PSNR and CIE76 colour difference), when a golden image is missing, or when a kernel got
+// slower than its baseline by more than the margin. Times are machine-specific: record the
+// baseline on the machine that runs the check. With --keep, record leaves an existing
+// baseline and its goldens as they are.
+//
+// The corpus should cover what the loader has to handle: sRGB, Adobe RGB and Display P3
+// JPEGs (embedded ICC), a CMYK JPEG, a 16-bit PNG, a PNG with alpha, a GIF and a WebP.
+// "generate" writes exactly that, from a synthetic test pattern (ramps, saturated patches
+// and fine detail), with ICC profiles built by LittleCMS and the lossy formats encoded by
+// ImageMagick; the pixels only depend on the encoder versions, which the tolerances cover.
+// CTest generates the corpus and records the goldens once, both in the build directory, then
+// checks the outputs and, as a separate test, the times against them; the
+// ImageUtilsGoldenRecord target re-records them after an intended change.
+
+#include "imageutils.h"
+
+#include <MagickWand.h>
+#include <lcms2.h>
+#include <QCoreApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QImage>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+#include <QStringList>
+#include <opencv2/opencv.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <functional>
+#include <map>
+#include <vector>
+
+namespace {
+
+    const quint32 kBaselineVersion = 1;
+
+    struct Tolerance {
+        double minPsnr;       // dB, over all channels
+        double maxMeanDeltaE; // CIE76, mean over the image
+        double maxP99DeltaE;  // CIE76, 99th percentile
+    };
+
+    struct Kernel {
+        const char* name;
+        Tolerance tolerance;
+        // Runs on the decoded image as the GUI displays it (the load kernel ignores it)
+        std::function<cv::Mat(const QString& path, const QImage& display)> run;
+    };
+
+    // Output of the QImage filters as BGR, for comparing and storing
+    cv::Mat bgrOf(const QImage& image)
+    {
+        return ImageUtils::convertQImageToMat(image);
+    }
+
+    std::vector<Kernel> kernels()
+    {
+        // The loader goes through the native decoders or ImageMagick, then LittleCMS: allow for
+        // rounding differences between library versions, but not for a profile that was skipped
+        // or misapplied. (Goldens recorded without a native decoder include ImageMagick's JPEG
+        // round trip; re-record them when a build gains one. "display" goldens recorded before
+        // the linear-light resampler differ in fine detail and need re-recording too.)
+        // Posterize is quantisation, so a few pixels near a level boundary may flip level.
+        return {
+            { "load", { 40.0, 0.5, 2.0 }, [](const QString& path, const QImage&) {
+                return ImageUtils::loadAndApplyColorProfile(path);
+                } },
+            { "display", { 40.0, 0.5, 2.0 }, [](const QString& path, const QImage&) {
+                cv::Mat rgb = ImageUtils::lanczosResizeIfNeeded(ImageUtils::loadAndApplyColorProfile(path));
+                return bgrOf(ImageUtils::convertMatToQImage(rgb));
+                } },
+            { "grayscale", { 50.0, 0.1, 0.5 }, [](const QString&, const QImage& display) {
+                return bgrOf(ImageUtils::convertToGrayscale(display));
+                } },
+            { "posterize", { 25.0, 1.5, 30.0 }, [](const QString&, const QImage& display) {
+                return bgrOf(ImageUtils::posterize(display, 3, false));
+                } },
+            { "posterize_normalizeAB", { 25.0, 1.5, 30.0 }, [](const QString&, const QImage& display) {
+                return bgrOf(ImageUtils::posterize(display, 3, true));
+                } },
+            { "gaussianBlur", { 45.0, 0.2, 1.0 }, [](const QString&, const QImage& display) {
+                return bgrOf(ImageUtils::gaussianBlur(display, 5));
+                } },
+            { "medianFilter", { 45.0, 0.2, 1.0 }, [](const QString&, const QImage& display) {
+                return bgrOf(ImageUtils::medianFilter(display));
+                } },
+        };
+    }
+
+    struct Difference {
+        bool sameSize = false;
+        double psnr = 0.0;
+        double meanDeltaE = 0.0;
+        double p99DeltaE = 0.0;
+    };
+
+    Difference compare(const cv::Mat& actual, const cv::Mat& golden)
+    {
+        Difference d;
+        d.sameSize = actual.size() == golden.size() && actual.type() == golden.type();
+        if (!d.sameSize) return d;
+
+        d.psnr = cv::PSNR(actual, golden);  // 361 dB for identical images
+
+        // CIE L*a*b* from float BGR in [0, 1] gives real L*a*b* units
+        cv::Mat a, b, labA, labB;
+        actual.convertTo(a, CV_32FC3, 1.0 / 255.0);
+        golden.convertTo(b, CV_32FC3, 1.0 / 255.0);
+        cv::cvtColor(a, labA, cv::COLOR_BGR2Lab);
+        cv::cvtColor(b, labB, cv::COLOR_BGR2Lab);
+        std::vector<cv::Mat> diff;
+        cv::split(labA - labB, diff);
+        cv::Mat deltaE;
+        cv::sqrt(diff[0].mul(diff[0]) + diff[1].mul(diff[1]) + diff[2].mul(diff[2]), deltaE);
+        d.meanDeltaE = cv::mean(deltaE)[0];
+
+        std::vector<float> values(deltaE.begin<float>(), deltaE.end<float>());
+        if (!values.empty()) {
+            const size_t index = std::min(values.size() - 1, static_cast<size_t>(values.size() * 0.99));
+            std::nth_element(values.begin(), values.begin() + index, values.end());
+            d.p99DeltaE = values[index];
+        }
+        return d;
+    }
+
+    bool withinTolerance(const Difference& d, const Tolerance& t)
+    {
+        return d.sameSize && d.psnr >= t.minPsnr && d.meanDeltaE <= t.maxMeanDeltaE && d.p99DeltaE <= t.maxP99DeltaE;
+    }
+
+    struct Options {
+        QString mode;
+        QString corpus;
+        QString golden;
+        int reps = 3;
+        double margin = 0.25;
+        bool timing = true;
+        bool keep = false;
+        bool verbose = false;
+    };
+
+    bool parseOptions(const QStringList& args, Options* options)
+    {
+        if (args.size() > 1) options->mode = args[1];
+        for (int i = 2; i < args.size(); ++i) {
+            const QString& arg = args[i];
+            const bool hasValue = i + 1 < args.size();
+            if (arg == "--corpus" && hasValue) {
+                options->corpus = args[++i];
+            }
+            else if (arg == "--golden" && hasValue) {
+                options->golden = args[++i];
+            }
+            else if (arg == "--reps" && hasValue) {
+                options->reps = qMax(1, args[++i].toInt());
+            }
+            else if (arg == "--margin" && hasValue) {
+                options->margin = args[++i].toDouble();
+            }
+            else if (arg == "--no-timing") {
+                options->timing = false;
+            }
+            else if (arg == "--keep") {
+                options->keep = true;
+            }
+            else if (arg == "--verbose") {
+                options->verbose = true;
+            }
+            else {
+                options->mode.clear();
+                break;
+            }
+        }
+        const bool generating = options->mode == "generate";
+        if ((!generating && options->mode != "record" && options->mode != "check") || options->corpus.isEmpty()
+            || (!generating && options->golden.isEmpty())) {
+            std::fprintf(stderr, "Usage: ImageUtilsGolden generate --corpus DIR\n"
+                "       ImageUtilsGolden record|check --corpus DIR --golden DIR [--reps N]"
+                " [--keep] [--margin 0.25] [--no-timing] [--verbose]\n");
+            return false;
+        }
+        return true;
+    }
+
+    // 640x480 test pattern: a hue ramp darkening downwards, a row of saturated and neutral
+    // patches, and a band of 1-3 px checkers and diagonals for the blur and median kernels
+    cv::Mat testPattern()
+    {
+        cv::Mat hsv(480, 640, CV_8UC3);
+        for (int y = 0; y < hsv.rows; ++y) {
+            for (int x = 0; x < hsv.cols; ++x) {
+                hsv.at<cv::Vec3b>(y, x) = cv::Vec3b(static_cast<uchar>(x * 180 / hsv.cols),
+                    static_cast<uchar>(255 - y * 128 / hsv.rows), static_cast<uchar>(255 - y * 192 / hsv.rows));
+            }
+        }
+        cv::Mat bgr;
+        cv::cvtColor(hsv, bgr, cv::COLOR_HSV2BGR);
+
+        const cv::Scalar patches[] = {
+            { 0, 0, 255 }, { 0, 255, 0 }, { 255, 0, 0 }, { 0, 255, 255 }, { 255, 0, 255 }, { 255, 255, 0 },
+            { 0, 0, 0 }, { 64, 64, 64 }, { 128, 128, 128 }, { 192, 192, 192 }, { 255, 255, 255 }, { 60, 110, 200 } };
+        for (int i = 0; i < 12; ++i) {
+            cv::rectangle(bgr, cv::Rect(i * 53 + 2, 300, 49, 60), patches[i], cv::FILLED);
+        }
+        for (int y = 380; y < 480; ++y) {
+            for (int x = 0; x < bgr.cols; ++x) {
+                const int cell = 1 + x / 160;  // 1, 2 or 3 px
+                const bool on = x < 480 ? ((x / cell + y / cell) & 1) : ((x + y) % 8 < 2);
+                bgr.at<cv::Vec3b>(y, x) = on ? cv::Vec3b(235, 235, 235) : cv::Vec3b(20, 20, 20);
+            }
+        }
+        return bgr;
+    }
+
+    QByteArray profileBytes(cmsHPROFILE profile)
+    {
+        QByteArray bytes;
+        cmsUInt32Number length = 0;
+        if (profile && cmsSaveProfileToMem(profile, nullptr, &length) && length > 0) {
+            bytes.resize(static_cast<qsizetype>(length));
+            if (!cmsSaveProfileToMem(profile, bytes.data(), &length)) bytes.clear();
+        }
+        if (profile) cmsCloseProfile(profile);
+        return bytes;
+    }
+
+    // D65 RGB profile with the given primaries (x, y of red, green, blue) and tone curve
+    QByteArray rgbProfile(const double primaries[6], cmsToneCurve* curve)
+    {
+        const cmsCIExyY white = { 0.3127, 0.3290, 1.0 };
+        const cmsCIExyYTRIPLE xyY = { { primaries[0], primaries[1], 1.0 }, { primaries[2], primaries[3], 1.0 },
+            { primaries[4], primaries[5], 1.0 } };
+        cmsToneCurve* curves[3] = { curve, curve, curve };
+        const QByteArray bytes = curve ? profileBytes(cmsCreateRGBProfile(&white, &xyY, curves)) : QByteArray();
+        if (curve) cmsFreeToneCurve(curve);
+        return bytes;
+    }
+
+    QByteArray adobeRgbProfile()
+    {
+        const double primaries[6] = { 0.64, 0.33, 0.21, 0.71, 0.15, 0.06 };
+        return rgbProfile(primaries, cmsBuildGamma(nullptr, 563.0 / 256.0));
+    }
+
+    QByteArray displayP3Profile()
+    {
+        const double primaries[6] = { 0.680, 0.320, 0.265, 0.690, 0.150, 0.060 };
+        const double srgbCurve[5] = { 2.4, 1.0 / 1.055, 0.055 / 1.055, 1.0 / 12.92, 0.04045 };
+        return rgbProfile(primaries, cmsBuildParametricToneCurve(nullptr, 4, srgbCurve));
+    }
+
+    // Encodes bgr with ImageMagick, optionally tagged with an ICC profile or converted to CMYK
+    bool writeWithMagick(const cv::Mat& bgr, const QString& path, const char* format, const QByteArray& icc, bool cmyk)
+    {
+        const cv::Mat pixels = bgr.isContinuous() ? bgr : bgr.clone();
+        MagickWand* wand = NewMagickWand();
+        bool ok = MagickConstituteImage(wand, static_cast<size_t>(pixels.cols), static_cast<size_t>(pixels.rows),
+            "BGR", CharPixel, pixels.data) == MagickTrue;
+        if (ok && !icc.isEmpty())
+            ok = MagickSetImageProfile(wand, "icc", icc.constData(), static_cast<size_t>(icc.size())) == MagickTrue;
+        if (ok && cmyk)
+            ok = MagickTransformImageColorspace(wand, CMYKColorspace) == MagickTrue;
+        ok = ok && MagickSetImageFormat(wand, format) == MagickTrue
+            && MagickSetImageCompressionQuality(wand, 92) == MagickTrue
+            && MagickWriteImage(wand, QFile::encodeName(path).constData()) == MagickTrue;
+        DestroyMagickWand(wand);
+        return ok;
+    }
+
+    // Writes the corpus described at the top of this file; false if any image failed
+    bool generateCorpus(const QString& directory)
+    {
+        if (!QDir().mkpath(directory)) return false;
+        ImageUtils::initializeMagick();
+        const cv::Mat bgr = testPattern();
+        const QDir dir(directory);
+
+        cv::Mat bgr16;
+        bgr.convertTo(bgr16, CV_16UC3, 257.0);
+        bgr16 += cv::Scalar(0, 64, 128);  // low bits a 8-bit decode has to drop, not wrap
+        cv::Mat bgra;
+        cv::cvtColor(bgr, bgra, cv::COLOR_BGR2BGRA);
+        for (int y = 0; y < bgra.rows; ++y) {
+            for (int x = 0; x < bgra.cols; ++x) {
+                bgra.at<cv::Vec4b>(y, x)[3] = static_cast<uchar>(x * 255 / (bgra.cols - 1));
+            }
+        }
+
+        const std::vector<std::pair<const char*, std::function<bool(const QString&)>>> images = {
+            { "srgb.jpg", [&](const QString& path) { return writeWithMagick(bgr, path, "JPEG", profileBytes(cmsCreate_sRGBProfile()), false); } },
+            { "adobergb.jpg", [&](const QString& path) { return writeWithMagick(bgr, path, "JPEG", adobeRgbProfile(), false); } },
+            { "displayp3.jpg", [&](const QString& path) { return writeWithMagick(bgr, path, "JPEG", displayP3Profile(), false); } },
+            { "cmyk.jpg", [&](const QString& path) { return writeWithMagick(bgr, path, "JPEG", QByteArray(), true); } },
+            { "rgb16.png", [&](const QString& path) { return cv::imwrite(path.toStdString(), bgr16); } },
+            { "alpha.png", [&](const QString& path) { return cv::imwrite(path.toStdString(), bgra); } },
+            { "palette.gif", [&](const QString& path) { return writeWithMagick(bgr, path, "GIF", QByteArray(), false); } },
+            { "lossy.webp", [&](const QString& path) { return writeWithMagick(bgr, path, "WEBP", QByteArray(), false); } },
+        };
+        bool ok = true;
+        for (const auto& image : images) {
+            const QString path = dir.filePath(QString::fromLatin1(image.first));
+            if (!image.second(path)) {
+                std::fprintf(stderr, "Cannot write %s\n", qPrintable(path));
+                ok = false;
+            }
+        }
+        if (ok) std::printf("Generated %d images in %s\n", static_cast<int>(images.size()), qPrintable(directory));
+        return ok;
+    }
+
+    QString goldenPath(const Options& options, const QString& fileName, const char* kernel)
+    {
+        return QDir(options.golden).filePath(QString("%1.%2.png").arg(fileName, QString::fromLatin1(kernel)));
+    }
+
+    void quietMessageHandler(QtMsgType type, const QMessageLogContext&, const QString& message)
+    {
+        // ImageUtils logs every step with qDebug; keep the report readable
+        if (type == QtDebugMsg || type == QtInfoMsg) return;
+        std::fprintf(stderr, "%s\n", qPrintable(message));
+    }
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    Options options;
+    if (!parseOptions(app.arguments(), &options)) return 2;
+    if (!options.verbose) qInstallMessageHandler(quietMessageHandler);
+    if (options.mode == "generate") return generateCorpus(options.corpus) ? 0 : 1;
+    const bool recording = options.mode == "record";
+    const QString baselinePath = QDir(options.golden).filePath("baseline.json");
+    if (recording && options.keep && QFileInfo::exists(baselinePath)) {
+        std::printf("Keeping the goldens in %s\n", qPrintable(options.golden));
+        return 0;
+    }
+
+    const QFileInfoList files = QDir(options.corpus).entryInfoList(
+        { "*.jpg", "*.jpeg", "*.png", "*.gif", "*.webp", "*.tif", "*.tiff", "*.bmp" }, QDir::Files, QDir::Name);
+    if (files.isEmpty()) {
+        std::fprintf(stderr, "No images in %s\n", qPrintable(options.corpus));
+        return 2;
+    }
+    if (recording && !QDir().mkpath(options.golden)) {
+        std::fprintf(stderr, "Cannot create %s\n", qPrintable(options.golden));
+        return 2;
+    }
+
+    int failures = 0;
+    std::map<std::string, double> kernelMs;  // sum of the per-image medians
+    const std::vector<Kernel> allKernels = kernels();
+
+    for (const QFileInfo& file : files) {
+        const QString path = file.filePath();
+        cv::Mat rgb = ImageUtils::lanczosResizeIfNeeded(ImageUtils::loadAndApplyColorProfile(path));
+        const QImage display = ImageUtils::convertMatToQImage(rgb);
+        if (display.isNull()) {
+            std::printf("FAIL  %-28s cannot be decoded\n", qPrintable(file.fileName()));
+            ++failures;
+            continue;
+        }
+
+        for (const Kernel& kernel : allKernels) {
+            cv::Mat output;
+            std::vector<double> ms;
+            QElapsedTimer timer;
+            for (int i = 0; i < options.reps; ++i) {
+                timer.start();
+                output = kernel.run(path, display);
+                ms.push_back(timer.nsecsElapsed() / 1e6);
+            }
+            std::sort(ms.begin(), ms.end());
+            kernelMs[kernel.name] += ms[ms.size() / 2];
+
+            const QString target = goldenPath(options, file.fileName(), kernel.name);
+            if (recording) {
+                if (output.empty() || !cv::imwrite(target.toStdString(), output)) {
+                    std::printf("FAIL  %-28s %-22s cannot write %s\n", qPrintable(file.fileName()), kernel.name, qPrintable(target));
+                    ++failures;
+                }
+                continue;
+            }
+
+            const cv::Mat golden = cv::imread(target.toStdString(), cv::IMREAD_COLOR);
+            if (golden.empty()) {
+                std::printf("FAIL  %-28s %-22s no golden image (run record first)\n", qPrintable(file.fileName()), kernel.name);
+                ++failures;
+                continue;
+            }
+            const Difference d = compare(output, golden);
+            const bool ok = withinTolerance(d, kernel.tolerance);
+            if (!ok) ++failures;
+            if (!d.sameSize) {
+                std::printf("FAIL  %-28s %-22s size %dx%d, golden %dx%d\n", qPrintable(file.fileName()), kernel.name,
+                    output.cols, output.rows, golden.cols, golden.rows);
+            }
+            else if (!ok || options.verbose) {
+                std::printf("%s  %-28s %-22s PSNR %6.1f dB (min %4.1f) | dE mean %5.2f (max %4.2f) | dE p99 %5.2f (max %4.2f)\n",
+                    ok ? "ok  " : "FAIL", qPrintable(file.fileName()), kernel.name, d.psnr, kernel.tolerance.minPsnr,
+                    d.meanDeltaE, kernel.tolerance.maxMeanDeltaE, d.p99DeltaE, kernel.tolerance.maxP99DeltaE);
+            }
+        }
+    }
+
+    if (recording) {
+        QJsonObject times;
+        for (const auto& entry : kernelMs) {
+            times[QString::fromStdString(entry.first)] = entry.second;
+        }
+        QJsonObject root;
+        root["version"] = static_cast<int>(kBaselineVersion);
+        root["images"] = static_cast<int>(files.size());
+        root["reps"] = options.reps;
+        root["opencv"] = QString::fromLatin1(CV_VERSION);
+        root["threads"] = cv::getNumThreads();
+        root["kernel_ms"] = times;
+        QSaveFile baseline(baselinePath);
+        if (!baseline.open(QIODevice::WriteOnly) || baseline.write(QJsonDocument(root).toJson()) < 0 || !baseline.commit()) {
+            std::fprintf(stderr, "Cannot write %s\n", qPrintable(baselinePath));
+            return 1;
+        }
+        std::printf("Recorded %lld images x %d kernels to %s\n", static_cast<long long>(files.size()),
+            static_cast<int>(allKernels.size()), qPrintable(options.golden));
+        return failures > 0 ? 1 : 0;
+    }
+
+    if (options.timing) {
+        QFile baseline(baselinePath);
+        if (!baseline.open(QIODevice::ReadOnly)) {
+            std::printf("FAIL  no time baseline at %s (run record, or pass --no-timing)\n", qPrintable(baselinePath));
+            ++failures;
+        }
+        else {
+            const QJsonObject root = QJsonDocument::fromJson(baseline.readAll()).object();
+            if (root.value("images").toInt() != files.size()) {
+                std::printf("note  the baseline was recorded on %d images, the corpus has %lld\n",
+                    root.value("images").toInt(), static_cast<long long>(files.size()));
+            }
+            const QJsonObject times = root.value("kernel_ms").toObject();
+            for (const auto& entry : kernelMs) {
+                const double base = times.value(QString::fromStdString(entry.first)).toDouble();
+                if (base <= 0.0) continue;
+                const double budget = base * (1.0 + options.margin);
+                const bool ok = entry.second <= budget;
+                if (!ok) ++failures;
+                std::printf("%s  %-22s %9.2f ms | baseline %9.2f ms | budget %9.2f ms (%+.0f%%)\n", ok ? "ok  " : "FAIL",
+                    entry.first.c_str(), entry.second, base, budget, (entry.second / base - 1.0) * 100.0);
+            }
+        }
+    }
+
+    std::printf(failures ? "%d check(s) failed\n" : "All checks passed\n", failures);
+    return failures > 0 ? 1 : 0;
+}
@@ -0,0 +1,134 @@
+// contenthash.cpp
+
+#include "contenthash.h"
+
+#include <cstring>
+
+namespace {
+
+    const quint64 kPrime1 = 0x9E3779B185EBCA87ull;
+    const quint64 kPrime2 = 0xC2B2AE3D27D4EB4Full;
+    const quint64 kPrime3 = 0x165667B19E3779F9ull;
+    const quint64 kPrime4 = 0x85EBCA77C2B2AE63ull;
+    const quint64 kPrime5 = 0x27D4EB2F165667C5ull;
+
+    inline quint64 rotl(quint64 x, int r)
+    {
+        return (x << r) | (x >> (64 - r));
+    }
+
+    // Little-endian loads; memcpy keeps unaligned access well-defined
+    inline quint64 read64(const uchar* p)
+    {
+        quint64 v;
+        std::memcpy(&v, p, sizeof(v));
+#if Q_BYTE_ORDER == Q_BIG_ENDIAN
+        v = qbswap(v);
+#endif
+        return v;
+    }
+
+    inline quint32 read32(const uchar* p)
+    {
+        quint32 v;
+        std::memcpy(&v, p, sizeof(v));
+#if Q_BYTE_ORDER == Q_BIG_ENDIAN
+        v = qbswap(v);
+#endif
+        return v;
+    }
+
+    inline quint64 round(quint64 acc, quint64 input)
+    {
+        acc += input * kPrime2;
+        acc = rotl(acc, 31);
+        return acc * kPrime1;
+    }
+
+    inline quint64 mergeRound(quint64 acc, quint64 value)
+    {
+        acc ^= round(0, value);
+        return acc * kPrime1 + kPrime4;
+    }
+
+} // namespace
+
+namespace ContentHash {
+
+    quint64 xxh64(const void* data, size_t size, quint64 seed)
+    {
+        const uchar* p = static_cast<const uchar*>(data);
+        const uchar* const end = p + size;
+        quint64 h;
+
+        if (size >= 32) {
+            // Four independent lanes over 32-byte stripes
+            quint64 v1 = seed + kPrime1 + kPrime2;
+            quint64 v2 = seed + kPrime2;
+            quint64 v3 = seed;
+            quint64 v4 = seed - kPrime1;
+            const uchar* const limit = end - 32;
+            do {
+                v1 = round(v1, read64(p));
+                v2 = round(v2, read64(p + 8));
+                v3 = round(v3, read64(p + 16));
+                v4 = round(v4, read64(p + 24));
+                p += 32;
+            } while (p <= limit);
+
+            h = rotl(v1, 1) + rotl(v2, 7) + rotl(v3, 12) + rotl(v4, 18);
+            h = mergeRound(h, v1);
+            h = mergeRound(h, v2);
+            h = mergeRound(h, v3);
+            h = mergeRound(h, v4);
+        }
+        else {
+            h = seed + kPrime5;
+        }
+        h += static_cast<quint64>(size);
+
+        for (; p + 8 <= end; p += 8) {
+            h ^= round(0, read64(p));
+            h = rotl(h, 27) * kPrime1 + kPrime4;
+        }
+        if (p + 4 <= end) {
+            h ^= static_cast<quint64>(read32(p)) * kPrime1;
+            h = rotl(h, 23) * kPrime2 + kPrime3;
+            p += 4;
+        }
+        for (; p < end; ++p) {
+            h ^= (*p) * kPrime5;
+            h = rotl(h, 11) * kPrime1;
+        }
+
+        // Avalanche
+        h ^= h >> 33;
+        h *= kPrime2;
+        h ^= h >> 29;
+        h *= kPrime3;
+        h ^= h >> 32;
+        return h;
+    }
+
+    quint64 image(const QImage& image, quint64 seed)
+    {
+        if (image.isNull()) return 0;
+
+        const quint32 header[3] = {
+            static_cast<quint32>(image.width()),
+            static_cast<quint32>(image.height()),
+            static_cast<quint32>(image.format()) };
+        quint64 h = xxh64(header, sizeof(header), seed);
+
+        const size_t rowBytes = (static_cast<size_t>(image.width()) * image.depth() + 7) / 8;
+        if (static_cast<size_t>(image.bytesPerLine()) == rowBytes) {
+            // No scanline padding: one pass over the whole buffer
+            return xxh64(image.constBits(), rowBytes * image.height(), h);
+        }
+        for (int y = 0; y < image.height(); ++y) {
+            h = xxh64(image.constScanLine(y), rowBytes, h);
+        }
+        return h;
+    }
+
+} // namespace ContentHash
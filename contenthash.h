@@ -0,0 +1,31 @@
+// contenthash.h
+
+#ifndef CONTENTHASH_H
+#define CONTENTHASH_H
+
+#include <QtGlobal>
+#include <QImage>
+
+/*!
+ * \brief The ContentHash namespace provides a fast non-cryptographic hash (XXH64) for
+ *        recognising identical pixel buffers, e.g. to skip writing an export that is
+ *        already on disk.
+ */
+namespace ContentHash {
+
+    /*!
+     * \brief xxh64 hashes a buffer with XXH64 (same output as the reference xxHash library).
+     */
+    quint64 xxh64(const void* data, size_t size, quint64 seed = 0);
+
+    /*!
+     * \brief image hashes an image's pixels together with its size and format. Padding at the
+     *        end of scanlines is ignored, so equal pixels always give equal keys.
+     * \param seed Mixed into the key; callers use it for anything else that changes the
+     *             output (e.g. the encoder).
+     */
+    quint64 image(const QImage& image, quint64 seed = 0);
+
+} // namespace ContentHash
+
+#endif // CONTENTHASH_H
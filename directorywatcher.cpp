@@ -0,0 +1,259 @@
+// directorywatcher.cpp
+
+#include "directorywatcher.h"
+#include "ziparchive.h"
+
+#include <QFileSystemWatcher>
+#include <QDateTime>
+#include <QDir>
+#include <QDirIterator>
+#include <QDebug>
+#include <QFileInfo>
+
+namespace {
+    // Changes usually arrive in bursts (copying a folder of references, a sync client, ...),
+    // so wait for the directory to settle before re-listing it.
+    const int kDebounceMs = 500;
+
+    QPair<qint64, qint64> archiveState(const QFileInfo& info)
+    {
+        return qMakePair(info.size(), info.lastModified().toMSecsSinceEpoch());
+    }
+
+    // Member paths of an archive that FileIndex::build() would index; false if unreadable
+    bool readArchiveMembers(const QString& archivePath, QStringList* paths)
+    {
+        const std::shared_ptr<const ZipArchive> archive = ZipArchive::open(archivePath);
+        if (!archive) return false;
+        const QStringList filters = DirectoryWatcher::imageNameFilters();
+        for (const ZipArchive::Member& member : archive->members()) {
+            const QString fileName = member.name.mid(member.name.lastIndexOf('/') + 1);
+            if (QDir::match(filters, fileName))
+                *paths << ZipArchive::memberPath(archivePath, member.name);
+        }
+        return true;
+    }
+}
+
+DirectoryWatcher::DirectoryWatcher(QObject* parent)
+    : QObject(parent),
+    m_watcher(new QFileSystemWatcher(this))
+{
+    m_debounceTimer.setSingleShot(true);
+    m_debounceTimer.setInterval(kDebounceMs);
+    connect(&m_debounceTimer, &QTimer::timeout, this, &DirectoryWatcher::flushPendingChanges);
+    connect(m_watcher, &QFileSystemWatcher::directoryChanged, this, &DirectoryWatcher::onDirectoryChanged);
+}
+
+QStringList DirectoryWatcher::imageNameFilters()
+{
+    return QStringList() << "*.jpg" << "*.jpeg" << "*.png" << "*.bmp" << "*.gif" << "*.webp";
+}
+
+void DirectoryWatcher::setKnownFilesProvider(KnownFilesProvider provider)
+{
+    m_knownFiles = std::move(provider);
+}
+
+void DirectoryWatcher::setKnownMembersProvider(KnownMembersProvider provider)
+{
+    m_knownMembers = std::move(provider);
+}
+
+void DirectoryWatcher::clear()
+{
+    m_debounceTimer.stop();
+    m_dirtyDirectories.clear();
+    m_directories.clear();
+    m_archives.clear();
+    const QStringList watched = m_watcher->directories();
+    if (!watched.isEmpty())
+        m_watcher->removePaths(watched);
+    m_root.clear();
+}
+
+void DirectoryWatcher::setRoot(const QString& root)
+{
+    clear();
+    m_root = root;
+    if (root.isEmpty()) return;
+
+    QStringList directories;
+    directories << root;
+    QDirIterator it(root, QDir::Dirs | QDir::NoDotAndDotDot, QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+        directories << it.next();
+    }
+    m_directories = QSet<QString>(directories.cbegin(), directories.cend());
+    m_watcher->addPaths(directories);
+    for (const QString& directory : directories) {
+        rememberArchives(directory, nullptr);  // the index already has their members
+    }
+    qDebug() << "[DirectoryWatcher] Watching" << directories.size() << "directories below" << root;
+}
+
+void DirectoryWatcher::onDirectoryChanged(const QString& path)
+{
+    m_dirtyDirectories.insert(path);
+    m_debounceTimer.start();  // restarts the timer if already running
+}
+
+void DirectoryWatcher::watchDirectory(const QString& directory, QStringList* addedFiles, QStringList* addedMembers)
+{
+    if (m_directories.contains(directory)) return;
+
+    QDir dir(directory);
+    m_directories.insert(directory);
+    m_watcher->addPath(directory);
+
+    const QStringList files = dir.entryList(imageNameFilters(), QDir::Files);
+    for (const QString& name : files) {
+        *addedFiles << directory + "/" + name;
+    }
+    rememberArchives(directory, addedMembers);
+    const QStringList subdirs = dir.entryList(QDir::Dirs | QDir::NoDotAndDotDot);
+    for (const QString& sub : subdirs) {
+        watchDirectory(directory + "/" + sub, addedFiles, addedMembers);
+    }
+}
+
+void DirectoryWatcher::forgetDirectory(const QString& directory, QStringList* removedFiles)
+{
+    const QString prefix = directory + "/";
+    const QSet<QString> known = m_directories;
+    for (const QString& dir : known) {
+        if (dir != directory && !dir.startsWith(prefix)) continue;
+        if (m_knownFiles) {
+            for (const QString& name : m_knownFiles(dir)) {
+                *removedFiles << dir + "/" + name;
+            }
+        }
+        for (auto it = m_archives.begin(); it != m_archives.end();) {
+            if (QFileInfo(it.key()).path() != dir) {
+                ++it;
+                continue;
+            }
+            if (m_knownMembers) *removedFiles << m_knownMembers(it.key());
+            it = m_archives.erase(it);
+        }
+        m_directories.remove(dir);
+        m_watcher->removePath(dir);
+    }
+}
+
+void DirectoryWatcher::flushPendingChanges()
+{
+    QStringList added;
+    QStringList addedMembers;
+    QStringList removed;
+
+    const QSet<QString> dirty = m_dirtyDirectories;
+    m_dirtyDirectories.clear();
+
+    for (const QString& directory : dirty) {
+        if (!m_directories.contains(directory)) continue;  // already forgotten with its parent
+
+        QDir dir(directory);
+        if (!dir.exists()) {
+            forgetDirectory(directory, &removed);
+            continue;
+        }
+
+        // Diff the image files against the index
+        const QStringList current = dir.entryList(imageNameFilters(), QDir::Files);
+        const QSet<QString> currentSet(current.cbegin(), current.cend());
+        const QStringList known = m_knownFiles ? m_knownFiles(directory) : QStringList();
+        const QSet<QString> knownSet(known.cbegin(), known.cend());
+        for (const QString& name : current) {
+            if (!knownSet.contains(name)) added << directory + "/" + name;
+        }
+        for (const QString& name : known) {
+            if (!currentSet.contains(name)) removed << directory + "/" + name;
+        }
+        diffArchives(directory, &addedMembers, &removed);
+
+        // Diff the subdirectories
+        const QStringList subdirs = dir.entryList(QDir::Dirs | QDir::NoDotAndDotDot);
+        const QSet<QString> subdirSet(subdirs.cbegin(), subdirs.cend());
+        for (const QString& sub : subdirs) {
+            watchDirectory(directory + "/" + sub, &added, &addedMembers);
+        }
+        const QString prefix = directory + "/";
+        const QSet<QString> watched = m_directories;
+        for (const QString& child : watched) {
+            if (!child.startsWith(prefix)) continue;
+            const QString name = child.mid(prefix.size());
+            if (!name.contains('/') && !subdirSet.contains(name)) {
+                forgetDirectory(child, &removed);
+            }
+        }
+    }
+
+    // A new folder and its contents can both be dirty in the same batch
+    added.removeDuplicates();
+    addedMembers.removeDuplicates();
+    removed.removeDuplicates();
+
+    if (!removed.isEmpty()) {
+        qDebug() << "[DirectoryWatcher]" << removed.size() << "file(s) removed";
+        emit filesRemoved(removed);
+    }
+    if (!added.isEmpty()) {
+        qDebug() << "[DirectoryWatcher]" << added.size() << "file(s) added";
+        emit filesAdded(added);
+    }
+    if (!addedMembers.isEmpty()) {
+        qDebug() << "[DirectoryWatcher]" << addedMembers.size() << "archive member(s) added";
+        emit archiveMembersAdded(addedMembers);
+    }
+}
+
+void DirectoryWatcher::rememberArchives(const QString& directory, QStringList* addedMembers)
+{
+    const QFileInfoList archives = QDir(directory).entryInfoList(ZipArchive::archiveNameFilters(), QDir::Files);
+    for (const QFileInfo& info : archives) {
+        m_archives.insert(info.filePath(), archiveState(info));
+        if (addedMembers) readArchiveMembers(info.filePath(), addedMembers);
+    }
+}
+
+void DirectoryWatcher::diffArchives(const QString& directory, QStringList* addedMembers, QStringList* removedFiles)
+{
+    const QFileInfoList archives = QDir(directory).entryInfoList(ZipArchive::archiveNameFilters(), QDir::Files);
+    QSet<QString> present;
+    for (const QFileInfo& info : archives) {
+        const QString path = info.filePath();
+        present.insert(path);
+        const QPair<qint64, qint64> state = archiveState(info);
+        const auto it = m_archives.constFind(path);
+        if (it != m_archives.constEnd() && it.value() == state) continue;
+
+        // New or rewritten: read the central directory again and diff the members
+        QStringList current;
+        const bool readable = readArchiveMembers(path, &current);
+        const QStringList known = m_knownMembers ? m_knownMembers(path) : QStringList();
+        const QSet<QString> currentSet(current.cbegin(), current.cend());
+        const QSet<QString> knownSet(known.cbegin(), known.cend());
+        for (const QString& member : current) {
+            if (!knownSet.contains(member)) *addedMembers << member;
+        }
+        for (const QString& member : known) {
+            if (!currentSet.contains(member)) *removedFiles << member;
+        }
+        // An archive still being written can't be read yet; try again on its next change
+        if (readable)
+            m_archives.insert(path, state);
+        else
+            m_archives.remove(path);
+    }
+
+    // Deleted (or renamed) archives
+    for (auto it = m_archives.begin(); it != m_archives.end();) {
+        if (present.contains(it.key()) || QFileInfo(it.key()).path() != directory) {
+            ++it;
+            continue;
+        }
+        if (m_knownMembers) *removedFiles << m_knownMembers(it.key());
+        it = m_archives.erase(it);
+    }
+}
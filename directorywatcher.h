@@ -0,0 +1,84 @@
+// directorywatcher.h
+
+#ifndef DIRECTORYWATCHER_H
+#define DIRECTORYWATCHER_H
+
+#include <QHash>
+#include <QObject>
+#include <QPair>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+#include <QTimer>
+#include <functional>
+
+class QFileSystemWatcher;
+
+/*!
+ * \brief The DirectoryWatcher class keeps a reference folder (and all of its subfolders)
+ *        under observation and reports added/removed image files in debounced batches.
+ *
+ *        QFileSystemWatcher only tells us *which* directory changed, so when the debounce timer
+ *        fires the watcher re-lists that directory and diffs it against what the index holds.
+ *        The watcher itself only remembers the set of directories, not the files.
+ *
+ *        ZIP/CBZ archives are diffed as a unit: the watcher remembers each archive's size and
+ *        modification time, and when an archive appears, changes or goes away its central
+ *        directory is read again and its members are diffed against what the index holds.
+ *        Added members are reported apart from added files (archiveMembersAdded), so the index
+ *        doesn't have to tell them apart by name.
+ */
+class DirectoryWatcher : public QObject
+{
+    Q_OBJECT
+public:
+    // Returns the file names (not paths) the index currently holds for a directory
+    using KnownFilesProvider = std::function<QStringList(const QString& directory)>;
+    // Returns the member paths the index currently holds for an archive
+    using KnownMembersProvider = std::function<QStringList(const QString& archivePath)>;
+
+    explicit DirectoryWatcher(QObject* parent = nullptr);
+
+    void setKnownFilesProvider(KnownFilesProvider provider);
+    void setKnownMembersProvider(KnownMembersProvider provider);
+
+    /*!
+     * \brief setRoot starts watching a new root folder and all of its subfolders.
+     * \param root The folder that was indexed.
+     */
+    void setRoot(const QString& root);
+
+    // Stops watching everything
+    void clear();
+
+    // The file patterns we index (shared with MainWindow::setDirectory)
+    static QStringList imageNameFilters();
+
+signals:
+    void filesAdded(const QStringList& paths);
+    // "<archive>::<member>" paths (see ZipArchive::memberPath())
+    void archiveMembersAdded(const QStringList& paths);
+    void filesRemoved(const QStringList& paths);
+
+private slots:
+    void onDirectoryChanged(const QString& path);
+    void flushPendingChanges();
+
+private:
+    void watchDirectory(const QString& directory, QStringList* addedFiles, QStringList* addedMembers);
+    void forgetDirectory(const QString& directory, QStringList* removedFiles);
+    void diffArchives(const QString& directory, QStringList* addedMembers, QStringList* removedFiles);
+    void rememberArchives(const QString& directory, QStringList* addedMembers);
+
+    QFileSystemWatcher* m_watcher;
+    QTimer m_debounceTimer;
+    QString m_root;
+
+    KnownFilesProvider m_knownFiles;
+    KnownMembersProvider m_knownMembers;
+    QSet<QString> m_directories;
+    QHash<QString, QPair<qint64, qint64>> m_archives;  // path -> (size, modified msecs)
+    QSet<QString> m_dirtyDirectories;
+};
+
+#endif // DIRECTORYWATCHER_H
@@ -0,0 +1,290 @@
+// exportwriter.cpp
+
+#include "exportwriter.h"
+#include "imageencoders.h"
+#include "contenthash.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <QThread>
+
+#ifdef Q_OS_WIN
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace {
+    // Dedup bookkeeping is dropped past this many paths (the shared folder keeps far fewer)
+    const int kMaxRememberedPaths = 1024;
+}
+
+ExportWriter::ExportWriter(int capacity, QObject* parent)
+    : QObject(parent),
+    m_capacity(qMax(1, capacity)),
+    m_thread(QThread::create([this]() { run(); }))
+{
+    m_thread->setObjectName("ExportWriter");
+    m_thread->start(QThread::LowPriority);
+}
+
+ExportWriter::~ExportWriter()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_stopping = true;
+        m_hasWork.wakeAll();
+    }
+    m_thread->wait();
+    delete m_thread;
+}
+
+void ExportWriter::setEncoder(Encoder encoder)
+{
+    QMutexLocker locker(&m_mutex);
+    m_encoder = encoder;
+}
+
+ExportWriter::Encoder ExportWriter::encoder() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_encoder;
+}
+
+QString ExportWriter::suffix(Encoder encoder)
+{
+    switch (encoder) {
+    case Encoder::Qoi: return ".qoi";
+    case Encoder::Tiff: return ".tif";
+    case Encoder::FastPng: break;
+    }
+    return ".png";
+}
+
+QString ExportWriter::ownerMarker()
+{
+    return ".refpicker-export";
+}
+
+QString ExportWriter::encoderName(Encoder encoder)
+{
+    switch (encoder) {
+    case Encoder::Qoi: return "qoi";
+    case Encoder::Tiff: return "tiff";
+    case Encoder::FastPng: break;
+    }
+    return "png";
+}
+
+ExportWriter::Encoder ExportWriter::encoderFromName(const QString& name)
+{
+    if (name == "qoi") return Encoder::Qoi;
+    if (name == "tiff") return Encoder::Tiff;
+    return Encoder::FastPng;
+}
+
+bool ExportWriter::encode(const QImage& image, Encoder encoder, QIODevice* device)
+{
+    switch (encoder) {
+    case Encoder::Qoi: return ImageEncoders::writeQoi(image, device);
+    case Encoder::Tiff: return ImageEncoders::writeTiff(image, device);
+    case Encoder::FastPng: break;
+    }
+    return ImageEncoders::writePngFast(image, device);
+}
+
+QString ExportWriter::enqueue(const QImage& image, const QString& basePath)
+{
+    QMutexLocker locker(&m_mutex);
+    const QString path = basePath + suffix(m_encoder);
+
+    // Superseded: a newer image for a path that hasn't been written yet
+    for (Job& job : m_queue) {
+        if (job.path == path) {
+            job.image = image;
+            job.encoder = m_encoder;
+            ++m_stats.coalesced;
+            return path;
+        }
+    }
+
+    if (static_cast<int>(m_queue.size()) >= m_capacity) {
+        qWarning() << "[ExportWriter] Queue full, dropping" << m_queue.front().path;
+        m_queue.pop_front();
+        ++m_stats.dropped;
+    }
+
+    Job job;
+    job.path = path;
+    job.image = image;
+    job.encoder = m_encoder;
+    job.queued.start();
+    m_queue.push_back(std::move(job));
+
+    m_stats.queueDepth = static_cast<int>(m_queue.size());
+    m_stats.maxQueueDepth = qMax(m_stats.maxQueueDepth, m_stats.queueDepth);
+    m_hasWork.wakeOne();
+    return path;
+}
+
+void ExportWriter::flush()
+{
+    QMutexLocker locker(&m_mutex);
+    while (!m_queue.empty() || m_busy) {
+        m_idle.wait(&m_mutex);
+    }
+}
+
+ExportWriter::Stats ExportWriter::stats() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_stats;
+}
+
+void ExportWriter::run()
+{
+    for (;;) {
+        Job job;
+        {
+            QMutexLocker locker(&m_mutex);
+            while (m_queue.empty() && !m_stopping) {
+                m_idle.wakeAll();
+                m_hasWork.wait(&m_mutex);
+            }
+            if (m_queue.empty()) {  // stopping, nothing left to write
+                m_idle.wakeAll();
+                return;
+            }
+            job = std::move(m_queue.front());
+            m_queue.pop_front();
+            m_stats.queueDepth = static_cast<int>(m_queue.size());
+            m_busy = true;
+        }
+
+        QElapsedTimer timer;
+        timer.start();
+        const Result result = exportImage(job);
+        const bool ok = result != Result::Failed;
+        const double writeMs = timer.nsecsElapsed() / 1e6;
+        const double latencyMs = job.queued.nsecsElapsed() / 1e6;
+
+        int depth;
+        {
+            QMutexLocker locker(&m_mutex);
+            m_busy = false;
+            depth = m_stats.queueDepth;
+            if (result == Result::Skipped) {
+                ++m_stats.skipped;
+            }
+            else if (result == Result::Linked) {
+                ++m_stats.linked;
+            }
+            else if (ok) {
+                ++m_stats.written;
+                m_stats.lastWriteMs = writeMs;
+                m_stats.lastLatencyMs = latencyMs;
+                m_stats.maxWriteMs = qMax(m_stats.maxWriteMs, writeMs);
+                m_stats.averageWriteMs += (writeMs - m_stats.averageWriteMs) / static_cast<double>(m_stats.written);
+            }
+            else {
+                ++m_stats.failed;
+            }
+            if (m_queue.empty())
+                m_idle.wakeAll();
+        }
+
+        if (result == Result::Skipped) {
+            qDebug() << "[ExportWriter] Unchanged, skipped" << job.path;
+            emit written(job.path, writeMs, depth);
+        }
+        else if (result == Result::Linked) {
+            qDebug() << "[ExportWriter] Linked identical" << job.path << "in" << writeMs << "ms";
+            emit written(job.path, writeMs, depth);
+        }
+        else if (ok) {
+            qDebug() << "[ExportWriter] Wrote" << job.path << "in" << writeMs << "ms (latency"
+                << latencyMs << "ms, queue depth" << depth << ")";
+            emit written(job.path, writeMs, depth);
+        }
+        else {
+            qWarning() << "[ExportWriter] Failed to write" << job.path;
+            emit failed(job.path);
+        }
+    }
+}
+
+ExportWriter::Result ExportWriter::exportImage(const Job& job)
+{
+    if (job.image.isNull()) return Result::Failed;
+
+    // The encoder is part of the key: the same pixels as PNG and as QOI are different files
+    const quint64 key = ContentHash::image(job.image, static_cast<quint64>(job.encoder) + 1);
+
+    auto it = m_pathKeys.constFind(job.path);
+    if (it != m_pathKeys.constEnd() && it.value() == key && QFileInfo::exists(job.path))
+        return Result::Skipped;
+
+    // Another export with this content: link to it, as long as it still holds that content
+    const QString source = m_contentPaths.value(key);
+    if (!source.isEmpty() && source != job.path && m_pathKeys.value(source) == key
+        && QFileInfo::exists(source) && linkFile(source, job.path)) {
+        m_pathKeys.insert(job.path, key);
+        return Result::Linked;
+    }
+
+    if (!writeImage(job)) {
+        m_pathKeys.remove(job.path);
+        return Result::Failed;
+    }
+    if (m_pathKeys.size() >= kMaxRememberedPaths) {
+        m_pathKeys.clear();
+        m_contentPaths.clear();
+    }
+    m_pathKeys.insert(job.path, key);
+    m_contentPaths.insert(key, job.path);
+    return Result::Written;
+}
+
+bool ExportWriter::linkFile(const QString& source, const QString& target)
+{
+    // Replacing the target gives it a new inode; the old content stays intact for other links
+    if (QFileInfo::exists(target) && !QFile::remove(target)) return false;
+
+#ifdef Q_OS_WIN
+    const QString nativeSource = QDir::toNativeSeparators(source);
+    const QString nativeTarget = QDir::toNativeSeparators(target);
+    if (CreateHardLinkW(reinterpret_cast<LPCWSTR>(nativeTarget.utf16()),
+        reinterpret_cast<LPCWSTR>(nativeSource.utf16()), nullptr))
+        return true;
+#else
+    if (::link(QFile::encodeName(source).constData(), QFile::encodeName(target).constData()) == 0)
+        return true;
+#endif
+    // Hard links need the same volume (and NTFS on Windows); a copy still saves the encode
+    return QFile::copy(source, target);
+}
+
+bool ExportWriter::writeImage(const Job& job)
+{
+    if (job.image.isNull()) return false;
+
+    const QString folder = QFileInfo(job.path).absolutePath();
+    if (!QFileInfo::exists(folder)) {
+        if (!QDir().mkpath(folder)) return false;
+        QFile marker(folder + "/" + ownerMarker());
+        if (!marker.open(QIODevice::WriteOnly))
+            qWarning() << "[ExportWriter] Cannot mark" << folder << "as an export folder";
+    }
+    QSaveFile file(job.path);
+    if (!file.open(QIODevice::WriteOnly)) return false;
+
+    if (!encode(job.image, job.encoder, &file)) {
+        file.cancelWriting();
+        return false;
+    }
+    return file.commit();
+}
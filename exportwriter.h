@@ -0,0 +1,128 @@
+// exportwriter.h
+
+#ifndef EXPORTWRITER_H
+#define EXPORTWRITER_H
+
+#include <QObject>
+#include <QImage>
+#include <QString>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QElapsedTimer>
+#include <QHash>
+#include <deque>
+
+class QThread;
+class QIODevice;
+
+/*!
+ * \brief The ExportWriter class encodes and writes images on a dedicated thread, so saving
+ *        to the shared folder never blocks the GUI.
+ *
+ *        The queue is bounded: when it is full the oldest pending write is dropped (the shared
+ *        folder only cares about the latest images). A write to a path that is still queued
+ *        replaces the queued image instead of adding a second write (e.g. several posterize
+ *        updates in a row). Files are written through QSaveFile, so readers never see a
+ *        half-written image.
+ *
+ *        Writes are deduplicated by content (XXH64 of the pixels, size, format and encoder):
+ *        if the target already holds the same content the write is skipped, and if another
+ *        exported file does, the target is hard-linked to it instead of encoding again.
+ *
+ *        A folder the writer creates gets an empty ownerMarker() file, which is what lets
+ *        RetentionManager delete it later; folders that already existed are never marked.
+ */
+class ExportWriter : public QObject
+{
+    Q_OBJECT
+public:
+    enum class Encoder {
+        FastPng,   // PNG at zlib level 1
+        Qoi,       // QOI, lossless and much faster than PNG
+        Tiff,      // uncompressed TIFF
+    };
+
+    struct Stats {
+        int queueDepth = 0;
+        int maxQueueDepth = 0;
+        quint64 written = 0;
+        quint64 failed = 0;
+        quint64 coalesced = 0;    // writes replaced by a newer image for the same path
+        quint64 dropped = 0;      // writes dropped because the queue was full
+        quint64 skipped = 0;      // target already held identical content
+        quint64 linked = 0;       // hard-linked (or copied) from an identical export
+        double lastWriteMs = 0.0; // encode + write of the last image
+        double averageWriteMs = 0.0;
+        double maxWriteMs = 0.0;
+        double lastLatencyMs = 0.0;  // enqueue to file on disk
+    };
+
+    explicit ExportWriter(int capacity = 8, QObject* parent = nullptr);
+    ~ExportWriter() override;  // writes what is still queued
+
+    void setEncoder(Encoder encoder);
+    Encoder encoder() const;
+
+    // File suffix (with the dot) the encoder produces
+    static QString suffix(Encoder encoder);
+    // Settings value <-> encoder ("png", "qoi", "tiff"); unknown names give FastPng
+    static QString encoderName(Encoder encoder);
+    static Encoder encoderFromName(const QString& name);
+
+    // Name of the file left in every folder the writer creates
+    static QString ownerMarker();
+
+    // Encodes synchronously, as the writer thread does (shared with the batch tool)
+    static bool encode(const QImage& image, Encoder encoder, QIODevice* device);
+
+    /*!
+     * \brief enqueue schedules a write and returns immediately.
+     * \param image The image; QImage is implicitly shared, so this doesn't copy pixels.
+     * \param basePath Target path without suffix; the current encoder's suffix is appended.
+     * \return The full path that will be written.
+     */
+    QString enqueue(const QImage& image, const QString& basePath);
+
+    // Blocks until everything queued so far is written
+    void flush();
+
+    Stats stats() const;
+
+signals:
+    // Emitted from the writer thread (use a queued connection to touch widgets)
+    void written(const QString& path, double writeMs, int queueDepth);
+    void failed(const QString& path);
+
+private:
+    struct Job {
+        QString path;
+        QImage image;
+        Encoder encoder;
+        QElapsedTimer queued;
+    };
+
+    enum class Result { Written, Linked, Skipped, Failed };
+
+    void run();
+    Result exportImage(const Job& job);
+    static bool writeImage(const Job& job);
+    static bool linkFile(const QString& source, const QString& target);
+
+    const int m_capacity;
+    QThread* m_thread;
+
+    mutable QMutex m_mutex;
+    QWaitCondition m_hasWork;
+    QWaitCondition m_idle;
+    std::deque<Job> m_queue;
+    bool m_busy = false;
+    bool m_stopping = false;
+    Encoder m_encoder = Encoder::FastPng;
+    Stats m_stats;
+
+    // Content keys of what we wrote, only touched by the writer thread
+    QHash<QString, quint64> m_pathKeys;      // path -> key of its current content
+    QHash<quint64, QString> m_contentPaths;  // key -> a path written with that content
+};
+
+#endif // EXPORTWRITER_H
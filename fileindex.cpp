@@ -0,0 +1,368 @@
+// fileindex.cpp
+
+#include "fileindex.h"
+#include "ziparchive.h"
+
+#include <QDirIterator>
+#include <QDebug>
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+namespace {
+    // 64-bit FNV-1a; streaming, so a stored entry can be hashed as dir + '/' + name
+    constexpr quint64 kFnvOffset = 14695981039346656037ull;
+    constexpr quint64 kFnvPrime = 1099511628211ull;
+
+    inline quint64 fnv1a(quint64 h, const char* data, size_t length)
+    {
+        for (size_t i = 0; i < length; ++i) {
+            h ^= static_cast<unsigned char>(data[i]);
+            h *= kFnvPrime;
+        }
+        return h;
+    }
+
+    // Folds the path hash of the next id into a mapping fingerprint
+    inline quint64 extendFingerprint(quint64 fingerprint, quint64 pathHash)
+    {
+        return fnv1a(fingerprint, reinterpret_cast<const char*>(&pathHash), sizeof(pathHash));
+    }
+
+    const size_t kMinSlots = 1024;
+}
+
+void FileIndex::clear()
+{
+    // Swap with empty containers so switching away from a huge folder gives the memory back
+    std::vector<char>().swap(m_arena);
+    std::vector<quint32>().swap(m_dirOffsets);
+    std::vector<Entry>().swap(m_entries);
+    std::vector<Id>().swap(m_slots);
+    m_dirIds.clear();
+    std::vector<std::pair<Id, Id>>().swap(m_dirRanges);
+    m_sortedCount = 0;
+    m_fingerprint = kFnvOffset;
+    m_aliveCount = 0;
+    m_lastDirectory.clear();
+    m_lastDirId = InvalidId;
+}
+
+void FileIndex::build(const QString& directory, const QStringList& nameFilters)
+{
+    clear();
+    int archives = 0;
+    QDirIterator it(directory, nameFilters + ZipArchive::archiveNameFilters(), QDir::Files, QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+        // Only the path string is needed, don't touch it.fileInfo() (that would stat the file)
+        const QString path = it.next();
+        if (ZipArchive::isArchiveFile(path)) {
+            appendArchive(path, nameFilters);
+            ++archives;
+        }
+        else {
+            append(path);
+        }
+    }
+    sortEntries();
+    qDebug() << "[FileIndex] Indexed" << m_aliveCount << "files in" << m_dirOffsets.size()
+        << "directories (" << archives << "archives)," << memoryUsage() / 1024 << "KiB";
+}
+
+void FileIndex::appendArchive(const QString& archivePath, const QStringList& nameFilters)
+{
+    // Only the central directory is read; members become "<archive>::<member>" paths
+    const std::shared_ptr<const ZipArchive> archive = ZipArchive::open(archivePath);
+    if (!archive) return;
+    for (const ZipArchive::Member& member : archive->members()) {
+        const QString fileName = member.name.mid(member.name.lastIndexOf('/') + 1);
+        if (QDir::match(nameFilters, fileName))
+            append(ZipArchive::memberPath(archivePath, member.name), true);
+    }
+}
+
+void FileIndex::sortEntries()
+{
+    // QDirIterator order is platform/filesystem dependent; sort by (directory, name) so ids
+    // are reproducible. Directories are ranked once so entries mostly compare two integers.
+    std::vector<quint32> dirOrder(m_dirOffsets.size());
+    for (quint32 i = 0; i < dirOrder.size(); ++i) {
+        dirOrder[i] = i;
+    }
+    std::sort(dirOrder.begin(), dirOrder.end(), [this](quint32 a, quint32 b) {
+        return std::strcmp(stringAt(m_dirOffsets[a]), stringAt(m_dirOffsets[b])) < 0;
+        });
+    std::vector<quint32> dirRank(m_dirOffsets.size());
+    for (quint32 r = 0; r < dirOrder.size(); ++r) {
+        dirRank[dirOrder[r]] = r;
+    }
+
+    std::sort(m_entries.begin(), m_entries.end(), [this, &dirRank](const Entry& a, const Entry& b) {
+        const quint32 ra = dirRank[a.dirId & kDirMask];
+        const quint32 rb = dirRank[b.dirId & kDirMask];
+        if (ra != rb) return ra < rb;
+        return std::strcmp(stringAt(a.nameOffset), stringAt(b.nameOffset)) < 0;
+        });
+
+    // Ids changed: rebuild the lookup table and the fingerprint
+    std::fill(m_slots.begin(), m_slots.end(), InvalidId);
+    m_fingerprint = kFnvOffset;
+    for (Id id = 0; id < m_entries.size(); ++id) {
+        const quint64 hash = hashEntry(m_entries[id]);
+        insertSlot(id, hash);
+        m_fingerprint = extendFingerprint(m_fingerprint, hash);
+    }
+
+    // Each directory's entries are now contiguous
+    m_dirRanges.assign(m_dirOffsets.size(), { 0, 0 });
+    for (Id id = 0; id < m_entries.size(); ++id) {
+        std::pair<Id, Id>& range = m_dirRanges[m_entries[id].dirId & kDirMask];
+        if (range.first == range.second) range.first = id;
+        range.second = id + 1;
+    }
+    m_sortedCount = static_cast<Id>(m_entries.size());
+}
+
+quint32 FileIndex::storeString(const QByteArray& utf8)
+{
+    const quint32 offset = static_cast<quint32>(m_arena.size());
+    m_arena.insert(m_arena.end(), utf8.constData(), utf8.constData() + utf8.size());
+    m_arena.push_back('\0');
+    return offset;
+}
+
+quint32 FileIndex::directoryId(const QString& directory)
+{
+    if (m_lastDirId != InvalidId && directory == m_lastDirectory)
+        return m_lastDirId;
+
+    auto it = m_dirIds.constFind(directory);
+    quint32 dirId;
+    if (it != m_dirIds.constEnd()) {
+        dirId = it.value();
+    }
+    else {
+        dirId = static_cast<quint32>(m_dirOffsets.size());
+        m_dirOffsets.push_back(storeString(directory.toUtf8()));
+        m_dirIds.insert(directory, dirId);
+    }
+    m_lastDirectory = directory;
+    m_lastDirId = dirId;
+    return dirId;
+}
+
+quint64 FileIndex::hashEntry(const Entry& entry) const
+{
+    const char* dir = stringAt(m_dirOffsets[entry.dirId & kDirMask]);
+    const char* name = stringAt(entry.nameOffset);
+    quint64 h = fnv1a(kFnvOffset, dir, std::strlen(dir));
+    if (dir[0] != '\0')
+        h = fnv1a(h, "/", 1);
+    return fnv1a(h, name, std::strlen(name));
+}
+
+bool FileIndex::entryMatches(const Entry& entry, const QByteArray& utf8Path) const
+{
+    const char* dir = stringAt(m_dirOffsets[entry.dirId & kDirMask]);
+    const char* name = stringAt(entry.nameOffset);
+    const size_t dirLength = std::strlen(dir);
+    const size_t nameLength = std::strlen(name);
+    const size_t separator = dirLength > 0 ? 1 : 0;
+    if (static_cast<size_t>(utf8Path.size()) != dirLength + separator + nameLength)
+        return false;
+    const char* p = utf8Path.constData();
+    return std::memcmp(p, dir, dirLength) == 0
+        && (separator == 0 || p[dirLength] == '/')
+        && std::memcmp(p + dirLength + separator, name, nameLength) == 0;
+}
+
+FileIndex::Id FileIndex::lookup(const QByteArray& utf8Path, quint64 hash) const
+{
+    if (m_slots.empty()) return InvalidId;
+    const size_t mask = m_slots.size() - 1;
+    for (size_t i = hash & mask; m_slots[i] != InvalidId; i = (i + 1) & mask) {
+        const Id id = m_slots[i];
+        if (entryMatches(m_entries[id], utf8Path))
+            return id;
+    }
+    return InvalidId;
+}
+
+void FileIndex::insertSlot(Id id, quint64 hash)
+{
+    const size_t mask = m_slots.size() - 1;
+    size_t i = hash & mask;
+    while (m_slots[i] != InvalidId) {
+        i = (i + 1) & mask;
+    }
+    m_slots[i] = id;
+}
+
+void FileIndex::growSlots()
+{
+    const size_t newSize = std::max(kMinSlots, m_slots.size() * 2);
+    std::vector<Id>(newSize, InvalidId).swap(m_slots);
+    for (Id id = 0; id < m_entries.size(); ++id) {
+        insertSlot(id, hashEntry(m_entries[id]));
+    }
+}
+
+FileIndex::Id FileIndex::append(const QString& filePath, bool archiveMember)
+{
+    const QByteArray utf8 = filePath.toUtf8();
+    const quint64 hash = fnv1a(kFnvOffset, utf8.constData(), utf8.size());
+
+    Id id = lookup(utf8, hash);
+    if (id != InvalidId) {
+        Entry& entry = m_entries[id];
+        if (entry.dirId & kRemovedBit) {
+            entry.dirId &= ~kRemovedBit;
+            ++m_aliveCount;
+        }
+        return id;
+    }
+
+    // Worst case both the directory and the name are new
+    if (m_arena.size() + utf8.size() + 2 > std::numeric_limits<quint32>::max()
+        || m_entries.size() >= InvalidId - 1 || m_dirOffsets.size() > kDirMask) {
+        qWarning() << "[FileIndex] Index is full, ignoring" << filePath;
+        return InvalidId;
+    }
+
+    const int slash = filePath.lastIndexOf('/');
+    const QString directory = slash >= 0 ? filePath.left(slash) : QString();
+    const QString name = slash >= 0 ? filePath.mid(slash + 1) : filePath;
+
+    Entry entry;
+    entry.dirId = directoryId(directory) | (archiveMember ? kMemberBit : 0);
+    entry.nameOffset = storeString(name.toUtf8());
+
+    id = static_cast<Id>(m_entries.size());
+    m_entries.push_back(entry);
+    m_fingerprint = extendFingerprint(m_fingerprint, hash);
+    if ((m_entries.size() * 2) > m_slots.size())
+        growSlots();  // rehashes every entry, including the new one
+    else
+        insertSlot(id, hash);
+    ++m_aliveCount;
+    return id;
+}
+
+bool FileIndex::remove(const QString& filePath)
+{
+    const Id id = find(filePath);
+    if (id == InvalidId || !isAlive(id))
+        return false;
+    m_entries[id].dirId |= kRemovedBit;
+    --m_aliveCount;
+    return true;
+}
+
+void FileIndex::compact()
+{
+    std::vector<std::pair<QString, bool>> live;
+    live.reserve(static_cast<size_t>(m_aliveCount));
+    for (Id id = 0; id < m_entries.size(); ++id) {
+        if (isAlive(id))
+            live.emplace_back(filePath(id), (m_entries[id].dirId & kMemberBit) != 0);
+    }
+    clear();
+    for (const std::pair<QString, bool>& file : live) {
+        append(file.first, file.second);
+    }
+    sortEntries();
+}
+
+FileIndex::Id FileIndex::find(const QString& filePath) const
+{
+    const QByteArray utf8 = filePath.toUtf8();
+    return lookup(utf8, fnv1a(kFnvOffset, utf8.constData(), utf8.size()));
+}
+
+QString FileIndex::filePath(Id id) const
+{
+    if (id >= m_entries.size()) return QString();
+    const Entry& entry = m_entries[id];
+    const QString dir = QString::fromUtf8(stringAt(m_dirOffsets[entry.dirId & kDirMask]));
+    const QString name = QString::fromUtf8(stringAt(entry.nameOffset));
+    return dir.isEmpty() ? name : dir + '/' + name;
+}
+
+bool FileIndex::isAlive(Id id) const
+{
+    return id < m_entries.size() && !(m_entries[id].dirId & kRemovedBit);
+}
+
+quint64 FileIndex::fingerprint(qsizetype count) const
+{
+    if (count < 0 || count >= idCount()) return m_fingerprint;
+    quint64 fingerprint = kFnvOffset;
+    for (Id id = 0; id < static_cast<Id>(count); ++id) {
+        fingerprint = extendFingerprint(fingerprint, hashEntry(m_entries[id]));
+    }
+    return fingerprint;
+}
+
+void FileIndex::forEachNameInDirectory(quint32 dirId, const std::function<void(const char* name, bool member)>& f) const
+{
+    // The directory's range from the last build, then whatever was appended since
+    const auto scan = [this, dirId, &f](Id first, Id end) {
+        for (Id id = first; id < end; ++id) {
+            const Entry& entry = m_entries[id];
+            if ((entry.dirId & ~kMemberBit) == dirId)  // also excludes tombstones
+                f(stringAt(entry.nameOffset), (entry.dirId & kMemberBit) != 0);
+        }
+    };
+    if (dirId < m_dirRanges.size())
+        scan(m_dirRanges[dirId].first, m_dirRanges[dirId].second);
+    scan(m_sortedCount, static_cast<Id>(m_entries.size()));
+}
+
+QStringList FileIndex::fileNamesInDirectory(const QString& directory) const
+{
+    QStringList names;
+    auto it = m_dirIds.constFind(directory);
+    if (it == m_dirIds.constEnd()) return names;
+
+    // Members at an archive's root are stored here as "<archive>::<member>"
+    forEachNameInDirectory(it.value(), [&names](const char* name, bool member) {
+        if (!member)
+            names << QString::fromUtf8(name);
+        });
+    return names;
+}
+
+QStringList FileIndex::archiveMemberPaths(const QString& archivePath) const
+{
+    // Members at the archive's root live in its folder, nested ones in "<archive>::<dir>" folders
+    QStringList paths;
+    const int slash = archivePath.lastIndexOf('/');
+    const QString directory = slash >= 0 ? archivePath.left(slash) : QString();
+    const QByteArray rootPrefix = (archivePath.mid(slash + 1) + "::").toUtf8();
+    const QString nestedPrefix = archivePath + "::";
+    for (auto it = m_dirIds.cbegin(); it != m_dirIds.cend(); ++it) {
+        const QString& dir = it.key();
+        const bool root = dir == directory;
+        if (!root && !dir.startsWith(nestedPrefix)) continue;
+        const QString prefix = dir.isEmpty() ? QString() : dir + '/';
+        forEachNameInDirectory(it.value(), [&](const char* name, bool member) {
+            if (member && (!root || std::strncmp(name, rootPrefix.constData(), static_cast<size_t>(rootPrefix.size())) == 0))
+                paths << prefix + QString::fromUtf8(name);
+            });
+    }
+    return paths;
+}
+
+qsizetype FileIndex::memoryUsage() const
+{
+    qsizetype bytes = static_cast<qsizetype>(m_arena.capacity());
+    bytes += static_cast<qsizetype>(m_dirOffsets.capacity() * sizeof(quint32));
+    bytes += static_cast<qsizetype>(m_entries.capacity() * sizeof(Entry));
+    bytes += static_cast<qsizetype>(m_slots.capacity() * sizeof(Id));
+    bytes += static_cast<qsizetype>(m_dirRanges.capacity() * sizeof(std::pair<Id, Id>));
+    // Rough cost of the directory hash (key QString + node)
+    for (auto it = m_dirIds.cbegin(); it != m_dirIds.cend(); ++it) {
+        bytes += it.key().size() * 2 + 32;
+    }
+    return bytes;
+}
@@ -0,0 +1,127 @@
+// fileindex.h
+
+#ifndef FILEINDEX_H
+#define FILEINDEX_H
+
+#include <QString>
+#include <QStringList>
+#include <QHash>
+#include <QByteArray>
+#include <utility>
+#include <vector>
+#include <cstdint>
+#include <functional>
+
+/*!
+ * \brief The FileIndex class is a compact list of image paths for very large reference libraries.
+ *
+ *        Every path is split into a directory (stored once) and a file name; both live as
+ *        NUL-terminated UTF-8 strings in a single contiguous arena and entries only hold
+ *        32-bit offsets into it. Files are identified by a stable 32-bit id, so shuffling
+ *        and picking only ever deal with integers. build() assigns ids in path order, so the
+ *        same folder contents always get the same ids (the saved random order relies on it).
+ *
+ *        Removed files are tombstoned (their id stays valid but is never picked again) and
+ *        come back under the same id if the same path is added again.
+ */
+class FileIndex
+{
+public:
+    using Id = quint32;
+    static constexpr Id InvalidId = 0xFFFFFFFFu;
+
+    FileIndex() = default;
+
+    /*!
+     * \brief build replaces the contents with every file below directory matching nameFilters.
+     *        ZIP/CBZ archives are indexed as virtual folders (see ZipArchive::memberPath()).
+     * \param directory Root folder, walked recursively.
+     * \param nameFilters Wildcard patterns such as "*.jpg".
+     */
+    void build(const QString& directory, const QStringList& nameFilters);
+
+    void clear();
+
+    // Adds a path (or revives it if it was removed). Returns its id, or InvalidId if the arena is full.
+    // archiveMember marks a "<archive>::<member>" path (see ZipArchive::memberPath()).
+    Id append(const QString& filePath, bool archiveMember = false);
+
+    // Tombstones a path. Returns false if it wasn't in the index.
+    bool remove(const QString& filePath);
+
+    // Drops the tombstones and renumbers the live files in path order, as build() would
+    void compact();
+
+    // Looks a path up; returns InvalidId if it was never added
+    Id find(const QString& filePath) const;
+
+    QString filePath(Id id) const;
+    bool isAlive(Id id) const;
+
+    // Number of live files
+    qsizetype size() const { return m_aliveCount; }
+    bool isEmpty() const { return m_aliveCount == 0; }
+
+    // Number of ids handed out so far (live + removed)
+    qsizetype idCount() const { return static_cast<qsizetype>(m_entries.size()); }
+
+    /*!
+     * \brief fingerprint hashes the id -> path mapping of ids [0, count) (every id when count
+     *        is negative), tombstones included. Two indexes with the same fingerprint for a
+     *        count give those ids to the same paths.
+     */
+    quint64 fingerprint(qsizetype count = -1) const;
+
+    // File names (not paths) of the live files directly inside directory; archive members
+    // aren't files of the directory (see archiveMemberPaths())
+    QStringList fileNamesInDirectory(const QString& directory) const;
+
+    // Paths of the live members of an archive, at any depth inside it
+    QStringList archiveMemberPaths(const QString& archivePath) const;
+
+    // Approximate heap usage in bytes (arena, entries, lookup table)
+    qsizetype memoryUsage() const;
+
+private:
+    struct Entry {
+        quint32 nameOffset;  // arena offset of the file name
+        quint32 dirId;       // index into m_dirOffsets; kRemovedBit set when tombstoned,
+                             // kMemberBit for archive members
+    };
+    static constexpr quint32 kRemovedBit = 0x80000000u;
+    static constexpr quint32 kMemberBit = 0x40000000u;
+    static constexpr quint32 kDirMask = ~(kRemovedBit | kMemberBit);
+
+    void appendArchive(const QString& archivePath, const QStringList& nameFilters);
+    // Calls f with the name of each live entry of a directory, and whether it's an archive member
+    void forEachNameInDirectory(quint32 dirId, const std::function<void(const char* name, bool member)>& f) const;
+    void sortEntries();
+    quint32 storeString(const QByteArray& utf8);
+    quint32 directoryId(const QString& directory);
+    const char* stringAt(quint32 offset) const { return m_arena.data() + offset; }
+
+    // Open-addressing path -> id table
+    quint64 hashEntry(const Entry& entry) const;
+    bool entryMatches(const Entry& entry, const QByteArray& utf8Path) const;
+    Id lookup(const QByteArray& utf8Path, quint64 hash) const;
+    void insertSlot(Id id, quint64 hash);
+    void growSlots();
+
+    std::vector<char> m_arena;
+    std::vector<quint32> m_dirOffsets;
+    std::vector<Entry> m_entries;
+    std::vector<Id> m_slots;
+    QHash<QString, quint32> m_dirIds;
+    // Per directory, the [first, end) ids it got from the last sortEntries(); ids appended
+    // since then (from m_sortedCount on) aren't in any range
+    std::vector<std::pair<Id, Id>> m_dirRanges;
+    Id m_sortedCount = 0;
+    quint64 m_fingerprint = 14695981039346656037ull;  // of every id; FNV-1a offset basis when empty
+    qsizetype m_aliveCount = 0;
+
+    // Iteration fast-path: files arrive directory by directory
+    QString m_lastDirectory;
+    quint32 m_lastDirId = InvalidId;
+};
+
+#endif // FILEINDEX_H
@@ -0,0 +1,258 @@
+// imagedecoders.cpp
+
+#include "imagedecoders.h"
+#include "imageprobe.h"
+#include "profiler.h"
+
+#include <QList>
+#include <opencv2/imgproc.hpp>
+#include <cstring>
+
+#ifdef HAVE_TURBOJPEG
+#include <turbojpeg.h>
+#endif
+#ifdef HAVE_SPNG
+#include <spng.h>
+#endif
+#ifdef HAVE_WEBP
+#include <webp/decode.h>
+#endif
+
+namespace {
+
+    // Give up on files with absurd numbers of segments/chunks
+    const int kMaxSegments = 1024;
+
+    inline quint32 be16(const uchar* p) { return (quint32(p[0]) << 8) | p[1]; }
+    inline quint32 le32(const uchar* p) { return quint32(p[0]) | (quint32(p[1]) << 8) | (quint32(p[2]) << 16) | (quint32(p[3]) << 24); }
+
+    // EXIF orientation of a TIFF block, with or without the "Exif\0\0" prefix
+    int exifBlockOrientation(const uchar* data, qint64 length)
+    {
+        if (length >= 6 && std::memcmp(data, "Exif\0\0", 6) == 0)
+            return ImageProbe::exifOrientation(data + 6, length - 6);
+        return ImageProbe::exifOrientation(data, length);
+    }
+
+    // Turns the image as stored into the image as displayed
+    void applyOrientation(cv::Mat& image, int orientation)
+    {
+        switch (orientation) {
+        case 2: cv::flip(image, image, 1); break;
+        case 3: cv::rotate(image, image, cv::ROTATE_180); break;
+        case 4: cv::flip(image, image, 0); break;
+        case 5: cv::transpose(image, image); break;
+        case 6: cv::rotate(image, image, cv::ROTATE_90_CLOCKWISE); break;
+        case 7: cv::transpose(image, image); cv::flip(image, image, -1); break;
+        case 8: cv::rotate(image, image, cv::ROTATE_90_COUNTERCLOCKWISE); break;
+        default: break;
+        }
+    }
+
+#ifdef HAVE_TURBOJPEG
+    // ICC profile (APP2 "ICC_PROFILE", split over as many segments as it needs) and EXIF
+    // orientation (APP1) from the segments before the first scan
+    void readJpegMetadata(const uchar* data, qint64 size, QByteArray* icc, int* orientation)
+    {
+        QList<QByteArray> iccParts;
+        qint64 pos = 2;
+        for (int i = 0; i < kMaxSegments && pos + 4 <= size && data[pos] == 0xFF; ++i) {
+            const uchar marker = data[pos + 1];
+            if (marker == 0xFF) {  // fill byte
+                ++pos;
+                continue;
+            }
+            if (marker == 0xDA || marker == 0xD9) break;  // start of scan, end of image
+            const qint64 length = be16(data + pos + 2);
+            if (length < 2 || pos + 2 + length > size) break;
+            const uchar* payload = data + pos + 4;
+            const qint64 payloadSize = length - 2;
+
+            if (marker == 0xE2 && payloadSize > 14 && std::memcmp(payload, "ICC_PROFILE\0", 12) == 0) {
+                const int sequence = payload[12];  // 1-based
+                const int count = payload[13];
+                if (iccParts.size() < count) iccParts.resize(count);
+                if (sequence >= 1 && sequence <= iccParts.size())
+                    iccParts[sequence - 1] = QByteArray(reinterpret_cast<const char*>(payload + 14), payloadSize - 14);
+            }
+            else if (marker == 0xE1 && *orientation == 1 && payloadSize > 6 && std::memcmp(payload, "Exif\0\0", 6) == 0) {
+                *orientation = exifBlockOrientation(payload, payloadSize);
+            }
+            pos += 2 + length;
+        }
+
+        for (const QByteArray& part : iccParts) {
+            if (part.isEmpty()) {  // a segment is missing: the profile is unusable
+                icc->clear();
+                return;
+            }
+            icc->append(part);
+        }
+    }
+
+    bool decodeJpeg(const QByteArray& data, ImageDecoders::Decoded* decoded, int* orientation)
+    {
+        ScopedTimer timer("jpeg decode");
+        const uchar* src = reinterpret_cast<const uchar*>(data.constData());
+        const unsigned long size = static_cast<unsigned long>(data.size());
+        tjhandle handle = tjInitDecompress();
+        if (!handle) return false;
+
+        int width = 0, height = 0, subsampling = 0, colorspace = 0;
+        // CMYK/YCCK (Adobe) JPEGs need ImageMagick's color conversion
+        bool ok = tjDecompressHeader3(handle, src, size, &width, &height, &subsampling, &colorspace) == 0
+            && colorspace != TJCS_CMYK && colorspace != TJCS_YCCK;
+        if (ok) {
+            decoded->bgr.create(height, width, CV_8UC3);
+            // A warning (e.g. a truncated file) still leaves a usable image, as with ImageMagick
+            ok = tjDecompress2(handle, src, size, decoded->bgr.data, width, static_cast<int>(decoded->bgr.step), height, TJPF_BGR, 0) == 0
+                || tjGetErrorCode(handle) == TJERR_WARNING;
+        }
+        tjDestroy(handle);
+        if (!ok) return false;
+
+        readJpegMetadata(src, data.size(), &decoded->iccProfile, orientation);
+        return true;
+    }
+#endif
+
+#ifdef HAVE_SPNG
+    bool decodePng(const QByteArray& data, ImageDecoders::Decoded* decoded, int* orientation)
+    {
+        ScopedTimer timer("png decode");
+        spng_ctx* ctx = spng_ctx_new(0);
+        if (!ctx) return false;
+
+        // RGB8 from every color type and depth: palette and gray expanded, 16 bits cut to 8,
+        // alpha dropped (as cv::imdecode with IMREAD_COLOR does)
+        struct spng_ihdr ihdr;
+        size_t rgbSize = 0;
+        bool ok = spng_set_png_buffer(ctx, data.constData(), static_cast<size_t>(data.size())) == 0
+            && spng_get_ihdr(ctx, &ihdr) == 0
+            && spng_decoded_image_size(ctx, SPNG_FMT_RGB8, &rgbSize) == 0;
+        if (ok) {
+            cv::Mat rgb(static_cast<int>(ihdr.height), static_cast<int>(ihdr.width), CV_8UC3);
+            ok = rgbSize == rgb.total() * rgb.elemSize()
+                && spng_decode_image(ctx, rgb.data, rgbSize, SPNG_FMT_RGB8, 0) == 0;
+            if (ok) {
+                cv::cvtColor(rgb, rgb, cv::COLOR_RGB2BGR);
+                decoded->bgr = rgb;
+
+                struct spng_iccp iccp;
+                if (spng_get_iccp(ctx, &iccp) == 0)
+                    decoded->iccProfile = QByteArray(iccp.profile, static_cast<qsizetype>(iccp.profile_len));
+                struct spng_exif exif;
+                if (spng_get_exif(ctx, &exif) == 0)
+                    *orientation = exifBlockOrientation(reinterpret_cast<const uchar*>(exif.data), static_cast<qint64>(exif.length));
+            }
+        }
+        spng_ctx_free(ctx);
+        return ok;
+    }
+#endif
+
+#ifdef HAVE_WEBP
+    // ICCP and EXIF chunks of an extended (VP8X) WebP
+    void readWebpMetadata(const uchar* data, qint64 size, QByteArray* icc, int* orientation)
+    {
+        qint64 pos = 12;  // after "RIFF", size, "WEBP"
+        for (int i = 0; i < kMaxSegments && pos + 8 <= size; ++i) {
+            const qint64 chunkSize = le32(data + pos + 4);
+            if (pos + 8 + chunkSize > size) break;
+            const uchar* payload = data + pos + 8;
+            if (std::memcmp(data + pos, "ICCP", 4) == 0)
+                *icc = QByteArray(reinterpret_cast<const char*>(payload), static_cast<qsizetype>(chunkSize));
+            else if (std::memcmp(data + pos, "EXIF", 4) == 0)
+                *orientation = exifBlockOrientation(payload, chunkSize);
+            pos += 8 + ((chunkSize + 1) & ~qint64(1));
+        }
+    }
+
+    bool decodeWebp(const QByteArray& data, ImageDecoders::Decoded* decoded, int* orientation)
+    {
+        ScopedTimer timer("webp decode");
+        const uint8_t* src = reinterpret_cast<const uint8_t*>(data.constData());
+        const size_t size = static_cast<size_t>(data.size());
+
+        // Animations are left to ImageMagick, which reads their first frame
+        WebPBitstreamFeatures features;
+        if (WebPGetFeatures(src, size, &features) != VP8_STATUS_OK || features.has_animation)
+            return false;
+        decoded->bgr.create(features.height, features.width, CV_8UC3);
+        const size_t step = decoded->bgr.step;
+        if (!WebPDecodeBGRInto(src, size, decoded->bgr.data, step * decoded->bgr.rows, static_cast<int>(step)))
+            return false;
+
+        readWebpMetadata(src, data.size(), &decoded->iccProfile, orientation);
+        return true;
+    }
+#endif
+
+} // namespace
+
+namespace ImageDecoders {
+
+    Format sniff(const QByteArray& data)
+    {
+        const uchar* p = reinterpret_cast<const uchar*>(data.constData());
+        const qsizetype size = data.size();
+        if (size >= 3 && p[0] == 0xFF && p[1] == 0xD8 && p[2] == 0xFF)
+            return Format::Jpeg;
+        if (size >= 8 && std::memcmp(p, "\x89PNG\r\n\x1a\n", 8) == 0)
+            return Format::Png;
+        if (size >= 12 && std::memcmp(p, "RIFF", 4) == 0 && std::memcmp(p + 8, "WEBP", 4) == 0)
+            return Format::Webp;
+        return Format::Unknown;
+    }
+
+    const char* formatName(Format format)
+    {
+        switch (format) {
+        case Format::Jpeg: return "jpeg";
+        case Format::Png: return "png";
+        case Format::Webp: return "webp";
+        default: return "unknown";
+        }
+    }
+
+    bool isAvailable(Format format)
+    {
+        switch (format) {
+#ifdef HAVE_TURBOJPEG
+        case Format::Jpeg: return true;
+#endif
+#ifdef HAVE_SPNG
+        case Format::Png: return true;
+#endif
+#ifdef HAVE_WEBP
+        case Format::Webp: return true;
+#endif
+        default: return false;
+        }
+    }
+
+    bool decode(const QByteArray& data, Decoded* decoded)
+    {
+        int orientation = 1;
+        bool ok = false;
+        switch (sniff(data)) {
+#ifdef HAVE_TURBOJPEG
+        case Format::Jpeg: ok = decodeJpeg(data, decoded, &orientation); break;
+#endif
+#ifdef HAVE_SPNG
+        case Format::Png: ok = decodePng(data, decoded, &orientation); break;
+#endif
+#ifdef HAVE_WEBP
+        case Format::Webp: ok = decodeWebp(data, decoded, &orientation); break;
+#endif
+        default: break;
+        }
+        if (!ok) {
+            *decoded = Decoded();
+            return false;
+        }
+        applyOrientation(decoded->bgr, orientation);
+        return true;
+    }
+
+} // namespace ImageDecoders
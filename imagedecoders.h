@@ -0,0 +1,45 @@
+// imagedecoders.h
+
+#ifndef IMAGEDECODERS_H
+#define IMAGEDECODERS_H
+
+#include <QByteArray>
+#include <opencv2/core.hpp>
+
+/*!
+ * \brief The ImageDecoders namespace decodes the common formats with their own libraries,
+ *        straight to BGR, without the ImageMagick decode + blob re-encode + OpenCV decode
+ *        round trip of ImageUtils::loadAndApplyColorProfile.
+ *
+ *        JPEG goes to libjpeg-turbo (HAVE_TURBOJPEG), PNG to libspng (HAVE_SPNG) and WebP to
+ *        libwebp (HAVE_WEBP); each is compiled in only when CMake finds its library. The ICC
+ *        profile and EXIF orientation are read from the container (JPEG APP1/APP2 segments,
+ *        PNG iCCP/eXIf chunks, WebP ICCP/EXIF chunks). What they don't handle (CMYK JPEGs,
+ *        animated WebPs, other formats) is left to ImageMagick.
+ */
+namespace ImageDecoders {
+
+    enum class Format { Unknown, Jpeg, Png, Webp };
+
+    struct Decoded {
+        cv::Mat bgr;            // 8-bit BGR, EXIF orientation applied, alpha dropped
+        QByteArray iccProfile;  // empty if the file has none
+    };
+
+    // The format from the file signature
+    Format sniff(const QByteArray& data);
+    const char* formatName(Format format);
+
+    // Whether the native decoder of format is compiled in
+    bool isAvailable(Format format);
+
+    /*!
+     * \brief decode decodes data with the native decoder of its format.
+     * \return False if no native decoder takes it (not compiled in, unsupported variant or
+     *         corrupt data); the caller falls back to ImageMagick.
+     */
+    bool decode(const QByteArray& data, Decoded* decoded);
+
+} // namespace ImageDecoders
+
+#endif // IMAGEDECODERS_H
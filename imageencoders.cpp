@@ -0,0 +1,206 @@
+// imageencoders.cpp
+
+#include "imageencoders.h"
+
+#include <QImageWriter>
+#include <cstring>
+
+namespace {
+
+    // Pixel data as tightly handled 8-bit RGB(A) scanlines
+    QImage toRgb(const QImage& image)
+    {
+        return image.convertToFormat(image.hasAlphaChannel() ? QImage::Format_RGBA8888 : QImage::Format_RGB888);
+    }
+
+    inline void putBE32(uchar* p, quint32 v)
+    {
+        p[0] = uchar(v >> 24); p[1] = uchar(v >> 16); p[2] = uchar(v >> 8); p[3] = uchar(v);
+    }
+    inline void putLE16(uchar* p, quint32 v)
+    {
+        p[0] = uchar(v); p[1] = uchar(v >> 8);
+    }
+    inline void putLE32(uchar* p, quint32 v)
+    {
+        putLE16(p, v);
+        putLE16(p + 2, v >> 16);
+    }
+
+    bool writeAll(QIODevice* device, const QByteArray& data)
+    {
+        return !data.isEmpty() && device->write(data) == data.size();
+    }
+
+} // namespace
+
+namespace ImageEncoders {
+
+    bool writePngFast(const QImage& image, QIODevice* device)
+    {
+        QImageWriter writer(device, "png");
+        // Qt maps PNG quality to the zlib level as (100 - q) * 9 / 91: 80 gives level 1, the
+        // fastest level that still compresses (0 would store raw deflate blocks).
+        writer.setQuality(80);
+        return writer.write(toRgb(image));
+    }
+
+    QByteArray encodeQoi(const QImage& image)
+    {
+        const QImage rgb = toRgb(image);
+        if (rgb.isNull()) return QByteArray();
+
+        const int channels = rgb.format() == QImage::Format_RGBA8888 ? 4 : 3;
+        const qint64 pixels = qint64(rgb.width()) * rgb.height();
+
+        // Worst case is one QOI_OP_RGBA (5 bytes) per pixel, plus header and end marker
+        QByteArray out(static_cast<qsizetype>(14 + pixels * (channels + 1) + 8), Qt::Uninitialized);
+        uchar* o = reinterpret_cast<uchar*>(out.data());
+        std::memcpy(o, "qoif", 4);
+        putBE32(o + 4, static_cast<quint32>(rgb.width()));
+        putBE32(o + 8, static_cast<quint32>(rgb.height()));
+        o[12] = static_cast<uchar>(channels);
+        o[13] = 0;  // sRGB with linear alpha
+        uchar* p = o + 14;
+
+        struct Pixel { uchar r, g, b, a; };
+        Pixel index[64] = {};
+        Pixel previous = { 0, 0, 0, 255 };
+        int run = 0;
+
+        for (int y = 0; y < rgb.height(); ++y) {
+            const uchar* line = rgb.constScanLine(y);
+            for (int x = 0; x < rgb.width(); ++x, line += channels) {
+                const Pixel px = { line[0], line[1], line[2], channels == 4 ? line[3] : uchar(255) };
+                if (std::memcmp(&px, &previous, sizeof(Pixel)) == 0) {
+                    if (++run == 62) {
+                        *p++ = uchar(0xC0 | (run - 1));  // QOI_OP_RUN
+                        run = 0;
+                    }
+                    continue;
+                }
+                if (run > 0) {
+                    *p++ = uchar(0xC0 | (run - 1));
+                    run = 0;
+                }
+
+                const int hash = (px.r * 3 + px.g * 5 + px.b * 7 + px.a * 11) % 64;
+                if (std::memcmp(&index[hash], &px, sizeof(Pixel)) == 0) {
+                    *p++ = uchar(hash);  // QOI_OP_INDEX
+                }
+                else {
+                    index[hash] = px;
+                    if (px.a == previous.a) {
+                        const signed char vr = static_cast<signed char>(px.r - previous.r);
+                        const signed char vg = static_cast<signed char>(px.g - previous.g);
+                        const signed char vb = static_cast<signed char>(px.b - previous.b);
+                        const int vgr = vr - vg;
+                        const int vgb = vb - vg;
+                        if (vr > -3 && vr < 2 && vg > -3 && vg < 2 && vb > -3 && vb < 2) {
+                            *p++ = uchar(0x40 | ((vr + 2) << 4) | ((vg + 2) << 2) | (vb + 2));  // QOI_OP_DIFF
+                        }
+                        else if (vgr > -9 && vgr < 8 && vg > -33 && vg < 32 && vgb > -9 && vgb < 8) {
+                            *p++ = uchar(0x80 | (vg + 32));  // QOI_OP_LUMA
+                            *p++ = uchar(((vgr + 8) << 4) | (vgb + 8));
+                        }
+                        else {
+                            *p++ = 0xFE;  // QOI_OP_RGB
+                            *p++ = px.r; *p++ = px.g; *p++ = px.b;
+                        }
+                    }
+                    else {
+                        *p++ = 0xFF;  // QOI_OP_RGBA
+                        *p++ = px.r; *p++ = px.g; *p++ = px.b; *p++ = px.a;
+                    }
+                }
+                previous = px;
+            }
+        }
+        if (run > 0)
+            *p++ = uchar(0xC0 | (run - 1));
+
+        static const uchar endMarker[8] = { 0, 0, 0, 0, 0, 0, 0, 1 };
+        std::memcpy(p, endMarker, sizeof(endMarker));
+        p += sizeof(endMarker);
+
+        out.truncate(static_cast<qsizetype>(p - o));
+        return out;
+    }
+
+    bool writeQoi(const QImage& image, QIODevice* device)
+    {
+        return writeAll(device, encodeQoi(image));
+    }
+
+    QByteArray encodeTiff(const QImage& image)
+    {
+        const QImage rgb = toRgb(image);
+        if (rgb.isNull()) return QByteArray();
+
+        const int channels = rgb.format() == QImage::Format_RGBA8888 ? 4 : 3;
+        const quint32 width = static_cast<quint32>(rgb.width());
+        const quint32 height = static_cast<quint32>(rgb.height());
+        const quint32 rowBytes = width * channels;
+        const qint64 pixelBytes = qint64(rowBytes) * height;
+        if (pixelBytes > 0xFFFFFFFFll - 4096) return QByteArray();  // classic TIFF is 32-bit
+
+        // Layout: header | IFD | bits-per-sample | resolutions | pixels
+        const int entryCount = channels == 4 ? 14 : 13;
+        const quint32 ifdOffset = 8;
+        const quint32 ifdSize = 2 + entryCount * 12 + 4;
+        const quint32 bitsOffset = ifdOffset + ifdSize;
+        const quint32 resolutionOffset = bitsOffset + 8;
+        const quint32 pixelOffset = resolutionOffset + 16;
+
+        QByteArray out(static_cast<qsizetype>(pixelOffset + pixelBytes), Qt::Uninitialized);
+        uchar* o = reinterpret_cast<uchar*>(out.data());
+        std::memset(o, 0, pixelOffset);
+        o[0] = 'I'; o[1] = 'I';
+        putLE16(o + 2, 42);
+        putLE32(o + 4, ifdOffset);
+
+        uchar* entry = o + ifdOffset + 2;
+        putLE16(o + ifdOffset, static_cast<quint32>(entryCount));
+        auto addEntry = [&entry](quint32 tag, quint32 type, quint32 count, quint32 value) {
+            putLE16(entry, tag);
+            putLE16(entry + 2, type);
+            putLE32(entry + 4, count);
+            if (type == 3 && count == 1) putLE16(entry + 8, value);  // SHORT, left-justified
+            else putLE32(entry + 8, value);
+            entry += 12;
+        };
+        const quint32 SHORT = 3, LONG = 4, RATIONAL = 5;
+        addEntry(256, LONG, 1, width);                  // ImageWidth
+        addEntry(257, LONG, 1, height);                 // ImageLength
+        addEntry(258, SHORT, channels, bitsOffset);     // BitsPerSample (8 each)
+        addEntry(259, SHORT, 1, 1);                     // Compression: none
+        addEntry(262, SHORT, 1, 2);                     // PhotometricInterpretation: RGB
+        addEntry(273, LONG, 1, pixelOffset);            // StripOffsets
+        addEntry(277, SHORT, 1, channels);              // SamplesPerPixel
+        addEntry(278, LONG, 1, height);                 // RowsPerStrip: one strip
+        addEntry(279, LONG, 1, static_cast<quint32>(pixelBytes));  // StripByteCounts
+        addEntry(282, RATIONAL, 1, resolutionOffset);   // XResolution
+        addEntry(283, RATIONAL, 1, resolutionOffset + 8);  // YResolution
+        addEntry(284, SHORT, 1, 1);                     // PlanarConfiguration: chunky
+        addEntry(296, SHORT, 1, 2);                     // ResolutionUnit: inch
+        if (channels == 4)
+            addEntry(338, SHORT, 1, 2);                 // ExtraSamples: unassociated alpha
+        putLE32(entry, 0);                              // no next IFD
+
+        for (int c = 0; c < channels; ++c) putLE16(o + bitsOffset + c * 2, 8);
+        putLE32(o + resolutionOffset, 72); putLE32(o + resolutionOffset + 4, 1);
+        putLE32(o + resolutionOffset + 8, 72); putLE32(o + resolutionOffset + 12, 1);
+
+        uchar* pixels = o + pixelOffset;
+        for (quint32 y = 0; y < height; ++y) {
+            std::memcpy(pixels + qint64(y) * rowBytes, rgb.constScanLine(static_cast<int>(y)), rowBytes);
+        }
+        return out;
+    }
+
+    bool writeTiff(const QImage& image, QIODevice* device)
+    {
+        return writeAll(device, encodeTiff(image));
+    }
+
+} // namespace ImageEncoders
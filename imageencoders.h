@@ -0,0 +1,41 @@
+// imageencoders.h
+
+#ifndef IMAGEENCODERS_H
+#define IMAGEENCODERS_H
+
+#include <QImage>
+#include <QByteArray>
+#include <QIODevice>
+
+/*!
+ * \brief The ImageEncoders namespace holds encoders tuned for write speed rather than size,
+ *        for images that are only handed over to another application (the shared folder).
+ *
+ *        All of them write 8-bit RGB, or RGBA when the image has an alpha channel.
+ */
+namespace ImageEncoders {
+
+    /*!
+     * \brief writePngFast writes a PNG at the fastest zlib level.
+     */
+    bool writePngFast(const QImage& image, QIODevice* device);
+
+    /*!
+     * \brief writeQoi writes a QOI ("Quite OK Image") file: lossless, roughly PNG-sized for
+     *        photos and many times faster to encode. See https://qoiformat.org.
+     */
+    bool writeQoi(const QImage& image, QIODevice* device);
+
+    /*!
+     * \brief writeTiff writes an uncompressed baseline TIFF (single strip). Largest output,
+     *        but hardly any CPU; readable by every image editor.
+     */
+    bool writeTiff(const QImage& image, QIODevice* device);
+
+    // Encodes to memory (used by writeQoi/writeTiff; exposed for callers that need the bytes)
+    QByteArray encodeQoi(const QImage& image);
+    QByteArray encodeTiff(const QImage& image);
+
+} // namespace ImageEncoders
+
+#endif // IMAGEENCODERS_H
@@ -0,0 +1,228 @@
+// imageprobe.cpp
+
+#include "imageprobe.h"
+#include "ziparchive.h"
+
+#include <QBuffer>
+#include <QFile>
+#include <QIODevice>
+#include <cstring>
+
+namespace {
+
+    // Never read more than this of an EXIF block; IFD0 (with the orientation) comes first
+    const qint64 kMaxExifBytes = 4096;
+    // Give up on files with absurd numbers of segments/chunks before the one we need
+    const int kMaxSegments = 128;
+    // Prefix of an archive member that is decompressed for a probe (covers large EXIF thumbnails)
+    const qint64 kArchiveProbeBytes = 256 * 1024;
+
+    inline quint32 be16(const uchar* p) { return (quint32(p[0]) << 8) | p[1]; }
+    inline quint32 be32(const uchar* p) { return (quint32(p[0]) << 24) | (quint32(p[1]) << 16) | (quint32(p[2]) << 8) | p[3]; }
+    inline quint32 le16(const uchar* p) { return quint32(p[0]) | (quint32(p[1]) << 8); }
+    inline quint32 le24(const uchar* p) { return quint32(p[0]) | (quint32(p[1]) << 8) | (quint32(p[2]) << 16); }
+    inline quint32 le32(const uchar* p) { return le24(p) | (quint32(p[3]) << 24); }
+
+    bool readAt(QIODevice* device, qint64 pos, uchar* buffer, qint64 length)
+    {
+        return device->seek(pos) && device->read(reinterpret_cast<char*>(buffer), length) == length;
+    }
+
+    // Reads up to maxLength bytes (fewer at EOF); returns the number read
+    qint64 readUpTo(QIODevice* device, qint64 pos, uchar* buffer, qint64 maxLength)
+    {
+        if (!device->seek(pos)) return 0;
+        const qint64 n = device->read(reinterpret_cast<char*>(buffer), maxLength);
+        return n > 0 ? n : 0;
+    }
+
+    ImageProbe::Info makeInfo(quint32 width, quint32 height, int orientation = 1)
+    {
+        ImageProbe::Info info;
+        info.width = static_cast<int>(width);
+        info.height = static_cast<int>(height);
+        info.orientation = orientation;
+        info.valid = width > 0 && height > 0 && width < (1u << 30) && height < (1u << 30);
+        return info;
+    }
+
+    int exifBlockOrientation(const uchar* data, qint64 length)
+    {
+        // Accept both a bare TIFF block and one prefixed with "Exif\0\0"
+        if (length >= 6 && std::memcmp(data, "Exif\0\0", 6) == 0)
+            return ImageProbe::exifOrientation(data + 6, length - 6);
+        return ImageProbe::exifOrientation(data, length);
+    }
+
+    bool isStartOfFrame(uchar marker)
+    {
+        // SOF0..SOF15, except DHT (C4), JPG (C8) and DAC (CC)
+        return marker >= 0xC0 && marker <= 0xCF && marker != 0xC4 && marker != 0xC8 && marker != 0xCC;
+    }
+
+    ImageProbe::Info probeJpeg(QIODevice* device)
+    {
+        int orientation = 1;
+        qint64 pos = 2;  // after SOI
+        uchar header[4];
+
+        for (int segment = 0; segment < kMaxSegments; ++segment) {
+            if (!readAt(device, pos, header, 4) || header[0] != 0xFF)
+                return ImageProbe::Info();
+            if (header[1] == 0xFF) {  // fill byte
+                ++pos;
+                continue;
+            }
+
+            const uchar marker = header[1];
+            if (marker == 0x01 || (marker >= 0xD0 && marker <= 0xD8)) {  // markers without a length
+                pos += 2;
+                continue;
+            }
+            if (marker == 0xD9 || marker == 0xDA)  // EOI/SOS before any SOF
+                return ImageProbe::Info();
+
+            const qint64 length = be16(header + 2);
+            if (length < 2)
+                return ImageProbe::Info();
+
+            if (marker == 0xE1 && orientation == 1) {
+                uchar exif[kMaxExifBytes];
+                const qint64 n = readUpTo(device, pos + 4, exif, qMin(length - 2, kMaxExifBytes));
+                if (n >= 6 && std::memcmp(exif, "Exif\0\0", 6) == 0)
+                    orientation = exifBlockOrientation(exif, n);
+            }
+            else if (isStartOfFrame(marker)) {
+                uchar sof[5];  // precision, height, width
+                if (!readAt(device, pos + 4, sof, 5))
+                    return ImageProbe::Info();
+                return makeInfo(be16(sof + 3), be16(sof + 1), orientation);
+            }
+            pos += 2 + length;  // skip the payload (ICC, XMP, thumbnails, ...) without reading it
+        }
+        return ImageProbe::Info();
+    }
+
+    ImageProbe::Info probeWebp(QIODevice* device)
+    {
+        uchar chunk[18];  // fourcc, size, first 10 bytes of data
+        if (!readAt(device, 12, chunk, sizeof(chunk)))
+            return ImageProbe::Info();
+        const uchar* data = chunk + 8;
+
+        if (std::memcmp(chunk, "VP8 ", 4) == 0) {
+            if (data[3] != 0x9D || data[4] != 0x01 || data[5] != 0x2A)
+                return ImageProbe::Info();
+            return makeInfo(le16(data + 6) & 0x3FFF, le16(data + 8) & 0x3FFF);
+        }
+        if (std::memcmp(chunk, "VP8L", 4) == 0) {
+            if (data[0] != 0x2F)
+                return ImageProbe::Info();
+            const quint32 bits = le32(data + 1);
+            return makeInfo((bits & 0x3FFF) + 1, ((bits >> 14) & 0x3FFF) + 1);
+        }
+        if (std::memcmp(chunk, "VP8X", 4) != 0)
+            return ImageProbe::Info();
+
+        const quint32 width = le24(data + 4) + 1;
+        const quint32 height = le24(data + 7) + 1;
+        int orientation = 1;
+        if (data[0] & 0x08) {
+            // EXIF flag: walk the chunk headers to find it (usually after the bitstream)
+            qint64 pos = 12 + 8 + ((le32(chunk + 4) + 1) & ~1u);
+            const qint64 end = device->size();
+            uchar header[8];
+            for (int i = 0; i < kMaxSegments && pos + 8 <= end; ++i) {
+                if (!readAt(device, pos, header, 8)) break;
+                const qint64 size = le32(header + 4);
+                if (std::memcmp(header, "EXIF", 4) == 0) {
+                    uchar exif[kMaxExifBytes];
+                    const qint64 n = readUpTo(device, pos + 8, exif, qMin(size, kMaxExifBytes));
+                    orientation = exifBlockOrientation(exif, n);
+                    break;
+                }
+                pos += 8 + ((size + 1) & ~qint64(1));
+            }
+        }
+        return makeInfo(width, height, orientation);
+    }
+
+} // namespace
+
+namespace ImageProbe {
+
+    int exifOrientation(const uchar* data, qint64 length)
+    {
+        if (length < 8) return 1;
+
+        bool little;
+        if (data[0] == 'I' && data[1] == 'I') little = true;
+        else if (data[0] == 'M' && data[1] == 'M') little = false;
+        else return 1;
+
+        auto u16 = [little](const uchar* p) { return little ? le16(p) : be16(p); };
+        auto u32 = [little](const uchar* p) { return little ? le32(p) : be32(p); };
+
+        if (u16(data + 2) != 42) return 1;
+        const qint64 ifd = u32(data + 4);
+        if (ifd + 2 > length) return 1;
+
+        const quint32 count = u16(data + ifd);
+        for (quint32 i = 0; i < count; ++i) {
+            const qint64 entry = ifd + 2 + qint64(i) * 12;
+            if (entry + 12 > length) break;
+            if (u16(data + entry) == 0x0112) {  // Orientation, SHORT
+                const int value = static_cast<int>(u16(data + entry + 8));
+                return (value >= 1 && value <= 8) ? value : 1;
+            }
+        }
+        return 1;
+    }
+
+    Info probeDevice(QIODevice* device)
+    {
+        uchar head[30];
+        const qint64 n = readUpTo(device, 0, head, sizeof(head));
+
+        if (n >= 4 && head[0] == 0xFF && head[1] == 0xD8 && head[2] == 0xFF)
+            return probeJpeg(device);
+
+        if (n >= 24 && std::memcmp(head, "\x89PNG\r\n\x1a\n", 8) == 0 && std::memcmp(head + 12, "IHDR", 4) == 0)
+            return makeInfo(be32(head + 16), be32(head + 20));
+
+        if (n >= 10 && (std::memcmp(head, "GIF87a", 6) == 0 || std::memcmp(head, "GIF89a", 6) == 0))
+            return makeInfo(le16(head + 6), le16(head + 8));
+
+        if (n >= 26 && head[0] == 'B' && head[1] == 'M') {
+            const quint32 dibSize = le32(head + 14);
+            if (dibSize == 12)  // OS/2 BITMAPCOREHEADER
+                return makeInfo(le16(head + 18), le16(head + 20));
+            const qint32 width = static_cast<qint32>(le32(head + 18));
+            const qint32 height = static_cast<qint32>(le32(head + 22));  // negative = top-down
+            return makeInfo(static_cast<quint32>(qAbs(width)), static_cast<quint32>(qAbs(height)));
+        }
+
+        if (n >= 12 && std::memcmp(head, "RIFF", 4) == 0 && std::memcmp(head + 8, "WEBP", 4) == 0)
+            return probeWebp(device);
+
+        return Info();
+    }
+
+    Info probeFile(const QString& filePath)
+    {
+        if (ZipArchive::isMemberPath(filePath)) {
+            ZipArchive::Data member;
+            if (!ZipArchive::readPath(filePath, &member, kArchiveProbeBytes))
+                return Info();
+            QBuffer buffer(&member.bytes);
+            buffer.open(QIODevice::ReadOnly);
+            return probeDevice(&buffer);
+        }
+
+        QFile file(filePath);
+        if (!file.open(QIODevice::ReadOnly))
+            return Info();
+        return probeDevice(&file);
+    }
+
+} // namespace ImageProbe
@@ -0,0 +1,55 @@
+// imageprobe.h
+
+#ifndef IMAGEPROBE_H
+#define IMAGEPROBE_H
+
+#include <QtGlobal>
+#include <QSize>
+#include <QString>
+
+class QIODevice;
+
+/*!
+ * \brief The ImageProbe namespace reads image dimensions and EXIF orientation straight from
+ *        the file headers (JPEG SOFn/APP1, PNG IHDR, WebP VP8/VP8L/VP8X, GIF logical screen,
+ *        BMP DIB header) without decoding any pixels.
+ *
+ *        Large JPEG/WebP metadata segments are skipped with a seek, so a probe reads a few KB
+ *        at most regardless of how much ICC/XMP data the file carries.
+ */
+namespace ImageProbe {
+
+    struct Info {
+        bool valid = false;
+        int width = 0;        // as stored in the file
+        int height = 0;
+        int orientation = 1;  // EXIF orientation 1..8 (1 = as stored)
+
+        // Size as displayed, i.e. with the EXIF rotation applied
+        QSize displaySize() const
+        {
+            return (orientation >= 5 && orientation <= 8) ? QSize(height, width) : QSize(width, height);
+        }
+    };
+
+    /*!
+     * \brief probeFile reads the header of an image file.
+     * \param filePath Path to the file.
+     * \return The probed info; valid is false for unknown or truncated files.
+     */
+    Info probeFile(const QString& filePath);
+
+    /*!
+     * \brief probeDevice is probeFile() for an already opened, seekable device positioned at 0.
+     */
+    Info probeDevice(QIODevice* device);
+
+    /*!
+     * \brief exifOrientation parses a TIFF-structured EXIF block ("II*\0"/"MM\0*" header).
+     * \return The orientation tag (1..8) or 1 if absent.
+     */
+    int exifOrientation(const uchar* data, qint64 length);
+
+} // namespace ImageProbe
+
+#endif // IMAGEPROBE_H
@@ -0,0 +1,144 @@
+// imagestats.cpp
+
+#include "imagestats.h"
+
+#include <QStringList>
+#include <cmath>
+
+namespace {
+
+    // Pixels with less chroma than this (max - min, 0..255) don't vote for a hue
+    const int kMinChroma = 16;
+    // Share of the total chroma a hue bin needs to count as present
+    const double kHueBinShare = 0.15;
+    // Below this much total chroma per pixel the image is treated as grayscale
+    const double kMinMeanChroma = 4.0;
+
+    const char* const kHueNames[ImageStats::kHueBinCount] = {
+        "red", "orange", "yellow", "lime", "green", "teal",
+        "cyan", "azure", "blue", "violet", "magenta", "pink"
+    };
+
+    quint8 percentile(const quint32* histogram, quint64 total, double fraction)
+    {
+        const quint64 target = static_cast<quint64>(std::ceil(fraction * static_cast<double>(total)));
+        quint64 cumulative = 0;
+        for (int value = 0; value < 256; ++value) {
+            cumulative += histogram[value];
+            if (cumulative >= target && cumulative > 0)
+                return static_cast<quint8>(value);
+        }
+        return 255;
+    }
+
+    // Hue in degrees [0, 360) of a pixel with chroma > 0
+    double hueDegrees(int r, int g, int b, int max, int chroma)
+    {
+        double h;
+        if (max == r) h = static_cast<double>(g - b) / chroma;
+        else if (max == g) h = static_cast<double>(b - r) / chroma + 2.0;
+        else h = static_cast<double>(r - g) / chroma + 4.0;
+        h *= 60.0;
+        return h < 0.0 ? h + 360.0 : h;
+    }
+
+} // namespace
+
+namespace ImageStats {
+
+    Stats fromImage(const QImage& image)
+    {
+        Stats stats;
+        if (image.isNull()) return stats;
+
+        const QImage rgb = image.convertToFormat(QImage::Format_RGB32);
+        const quint64 pixelCount = static_cast<quint64>(rgb.width()) * rgb.height();
+
+        quint32 histogram[256] = {};
+        quint64 saturationSum = 0;
+        double chromaByBin[kHueBinCount] = {};
+        double chromaSum = 0.0;
+        // Hasler-Suesstrunk opponent channels: rg = R - G, yb = (R + G) / 2 - B
+        double rgSum = 0.0, rgSquares = 0.0, ybSum = 0.0, ybSquares = 0.0;
+        quint64 lumaSum = 0;
+
+        for (int y = 0; y < rgb.height(); ++y) {
+            const QRgb* line = reinterpret_cast<const QRgb*>(rgb.constScanLine(y));
+            for (int x = 0; x < rgb.width(); ++x) {
+                const int r = qRed(line[x]);
+                const int g = qGreen(line[x]);
+                const int b = qBlue(line[x]);
+
+                const int luma = (54 * r + 183 * g + 19 * b + 128) >> 8;
+                ++histogram[luma];
+                lumaSum += luma;
+
+                const int max = qMax(r, qMax(g, b));
+                const int min = qMin(r, qMin(g, b));
+                const int chroma = max - min;
+                if (max > 0)
+                    saturationSum += (chroma * 255) / max;
+
+                if (chroma >= kMinChroma) {
+                    const int bin = static_cast<int>((hueDegrees(r, g, b, max, chroma) + 15.0) / 30.0) % kHueBinCount;
+                    chromaByBin[bin] += chroma;
+                }
+                chromaSum += chroma;
+
+                const double rg = r - g;
+                const double yb = 0.5 * (r + g) - b;
+                rgSum += rg;
+                rgSquares += rg * rg;
+                ybSum += yb;
+                ybSquares += yb * yb;
+            }
+        }
+        if (pixelCount == 0) return stats;
+
+        const double n = static_cast<double>(pixelCount);
+        stats.meanLuma = static_cast<quint8>(lumaSum / pixelCount);
+        stats.p10Luma = percentile(histogram, pixelCount, 0.10);
+        stats.p50Luma = percentile(histogram, pixelCount, 0.50);
+        stats.p90Luma = percentile(histogram, pixelCount, 0.90);
+        stats.saturation = static_cast<quint8>(saturationSum / pixelCount);
+
+        const double rgMean = rgSum / n;
+        const double ybMean = ybSum / n;
+        const double rgVariance = qMax(0.0, rgSquares / n - rgMean * rgMean);
+        const double ybVariance = qMax(0.0, ybSquares / n - ybMean * ybMean);
+        const double colorfulness = std::sqrt(rgVariance + ybVariance)
+            + 0.3 * std::sqrt(rgMean * rgMean + ybMean * ybMean);
+        stats.colorfulness = static_cast<quint8>(qMin(255.0, std::round(colorfulness)));
+
+        double binnedChroma = 0.0;
+        int dominant = -1;
+        for (int bin = 0; bin < kHueBinCount; ++bin) {
+            binnedChroma += chromaByBin[bin];
+            if (dominant < 0 || chromaByBin[bin] > chromaByBin[dominant])
+                dominant = bin;
+        }
+        if (chromaSum / n >= kMinMeanChroma && binnedChroma > 0.0) {
+            stats.dominantHue = static_cast<quint8>(dominant);
+            for (int bin = 0; bin < kHueBinCount; ++bin) {
+                if (chromaByBin[bin] >= kHueBinShare * binnedChroma)
+                    stats.hueBins |= static_cast<quint16>(1u << bin);
+            }
+        }
+        return stats;
+    }
+
+    QString hueName(int bin)
+    {
+        return (bin >= 0 && bin < kHueBinCount) ? QString::fromLatin1(kHueNames[bin]) : QString();
+    }
+
+    int hueBinFromName(const QString& name)
+    {
+        for (int bin = 0; bin < kHueBinCount; ++bin) {
+            if (name.compare(QLatin1String(kHueNames[bin]), Qt::CaseInsensitive) == 0)
+                return bin;
+        }
+        return -1;
+    }
+
+} // namespace ImageStats
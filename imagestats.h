@@ -0,0 +1,45 @@
+// imagestats.h
+
+#ifndef IMAGESTATS_H
+#define IMAGESTATS_H
+
+#include <QtGlobal>
+#include <QImage>
+#include <QString>
+
+/*!
+ * \brief The ImageStats namespace computes compact tonal/colour statistics of an image,
+ *        meant for picking references by value key or saturation ("high-key only").
+ *
+ *        The statistics are coarse on purpose: they are computed from a thumbnail of a
+ *        hundred pixels or so per side and stored per file in the AnalysisIndex cache.
+ */
+namespace ImageStats {
+
+    enum : quint8 { NoHue = 0xFF };
+    const int kHueBinCount = 12;  // 30 degrees each, bin 0 centred on red
+
+    struct Stats {
+        quint8 meanLuma = 0;      // Rec. 709 luma of the sRGB values, 0..255
+        quint8 p10Luma = 0;       // luma percentiles
+        quint8 p50Luma = 0;
+        quint8 p90Luma = 0;
+        quint8 saturation = 0;    // mean HSV saturation, 0..255
+        quint8 colorfulness = 0;  // Hasler-Suesstrunk M, clamped to 255 (0 = gray, ~60 = quite colourful)
+        quint8 dominantHue = NoHue;  // hue bin with the most chroma, or NoHue for (near) grayscale images
+        quint16 hueBins = 0;      // bit i set if bin i holds a significant share of the chroma
+    };
+
+    /*!
+     * \brief fromImage computes the statistics of an already decoded (small) image.
+     * \param image Any QImage; every pixel is visited, so pass a thumbnail.
+     */
+    Stats fromImage(const QImage& image);
+
+    // Bin name ("red", "orange", ... "pink") and the reverse lookup (-1 if unknown)
+    QString hueName(int bin);
+    int hueBinFromName(const QString& name);
+
+} // namespace ImageStats
+
+#endif // IMAGESTATS_H
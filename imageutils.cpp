@@ -1,362 +1,508 @@
-#include "imageutils.h"
-
-#include <QFile>
-#include <QDebug>
-#include <QtGlobal>
-#include <QColor>
-#include <QByteArray>
-#include <QImage>
-
-#include <MagickWand.h>
-#include <lcms2.h>
-#include <opencv2/opencv.hpp>
-
-// For applying style to the QApplication
-#include <QApplication>
-#include <QFile>
-#include <QDir>
-
-namespace ImageUtils {
-
-    cv::Mat loadAndApplyColorProfile(const QString& filePath)
-    {
-        // Normalize file path and log it
-        QString nativePath = QDir::toNativeSeparators(filePath).trimmed();
-        qDebug() << "[loadAndApplyColorProfile] Native file path:" << nativePath;
-
-        // Check file existence
-        if (!QFile::exists(nativePath)) {
-            qWarning() << "[loadAndApplyColorProfile] File does not exist:" << nativePath;
-            return cv::Mat();
-        }
-
-        // Initialize MagickWand
-        MagickWandGenesis();
-        MagickWand* wand = NewMagickWand();
-
-        // Open the file using QFile
-        QFile file(nativePath);
-        if (!file.open(QIODevice::ReadOnly)) {
-            qWarning() << "[loadAndApplyColorProfile] Cannot open file:" << nativePath;
-            DestroyMagickWand(wand);
-            MagickWandTerminus();
-            return cv::Mat();
-        }
-        QByteArray data = file.readAll();
-        file.close();
-        qDebug() << "[loadAndApplyColorProfile] File size (bytes):" << data.size();
-
-        // Attempt to read the image via MagickWand
-        MagickBooleanType result = MagickReadImageBlob(wand, data.constData(), data.size());
-        if (result == MagickFalse) {
-            // Get the error description from MagickWand
-            char* desc = nullptr;
-            ExceptionType severity;
-            desc = MagickGetException(wand, &severity);
-            qWarning() << "[loadAndApplyColorProfile] Failed to read image via Magick. Exception:" << desc;
-            if (desc)
-                MagickRelinquishMemory(desc);
-
-            DestroyMagickWand(wand);
-            MagickWandTerminus();
-            return cv::Mat();
-        }
-        qDebug() << "[loadAndApplyColorProfile] Image read via Magick successfully.";
-
-        // Retrieve ICC profile if present
-        size_t length = 0;
-        unsigned char* profile = MagickGetImageProfile(wand, "ICC", &length);
-        if (profile)
-            qDebug() << "[loadAndApplyColorProfile] ICC profile found, length:" << length;
-        else
-            qDebug() << "[loadAndApplyColorProfile] No ICC profile found.";
-
-        // Get image blob in PNG format (or another format supported by OpenCV)
-        size_t blobLength = 0;
-        unsigned char* blob = MagickGetImageBlob(wand, &blobLength);
-        if (!blob || blobLength == 0) {
-            qWarning() << "[loadAndApplyColorProfile] Failed to get image blob from MagickWand.";
-            DestroyMagickWand(wand);
-            MagickWandTerminus();
-            return cv::Mat();
-        }
-        qDebug() << "[loadAndApplyColorProfile] Image blob retrieved, length:" << blobLength;
-
-        // Decode the image blob using OpenCV
-        cv::Mat bufMat(1, blobLength, CV_8UC1, blob);
-        cv::Mat img = cv::imdecode(bufMat, cv::IMREAD_COLOR);
-        if (img.empty()) {
-            qWarning() << "[loadAndApplyColorProfile] Failed to decode image blob with OpenCV.";
-            MagickRelinquishMemory(blob);
-            DestroyMagickWand(wand);
-            MagickWandTerminus();
-            return cv::Mat();
-        }
-        qDebug() << "[loadAndApplyColorProfile] Image decoded successfully, size:" << img.cols << "x" << img.rows;
-
-        // If an ICC profile exists, apply the color transformation using LittleCMS
-        if (profile) {
-            qDebug() << "[loadAndApplyColorProfile] Applying color profile transformation.";
-            cmsHPROFILE inProfile = cmsOpenProfileFromMem(profile, length);
-            cmsHPROFILE outProfile = cmsCreate_sRGBProfile();
-            cmsHTRANSFORM transform = cmsCreateTransform(inProfile, TYPE_BGR_8, outProfile, TYPE_BGR_8, INTENT_PERCEPTUAL, 0);
-            cmsDoTransform(transform, img.data, img.data, img.total());
-            cmsDeleteTransform(transform);
-            cmsCloseProfile(inProfile);
-            cmsCloseProfile(outProfile);
-        }
-
-        // Clean up MagickWand resources
-        MagickRelinquishMemory(blob);
-        DestroyMagickWand(wand);
-        MagickWandTerminus();
-
-        return img;
-    }
-
-    cv::Mat lanczosResizeIfNeeded(const cv::Mat& input)
-    {
-        if (input.empty()) return cv::Mat();
-
-        cv::Mat output;
-        if (input.cols < 2000 && input.rows < 2000) {
-            // If smaller than 2000x2000, double the size with Lanczos
-            cv::resize(input, output, cv::Size(input.cols * 2, input.rows * 2), 0, 0, cv::INTER_LANCZOS4);
-        }
-        else {
-            // Otherwise, keep same size but still use Lanczos for consistency
-            cv::resize(input, output, cv::Size(input.cols, input.rows), 0, 0, cv::INTER_LANCZOS4);
-        }
-        // Convert BGR -> RGB for QImage
-        cv::cvtColor(output, output, cv::COLOR_BGR2RGB);
-        return output;
-    }
-
-    QImage convertMatToQImage(const cv::Mat& mat)
-    {
-        if (mat.empty()) return QImage();
-
-        // Here we assume mat is in RGB
-        return QImage(mat.data,
-            mat.cols,
-            mat.rows,
-            static_cast<int>(mat.step),
-            QImage::Format_RGB888).copy();
-    }
-
-    cv::Mat convertQImageToMat(const QImage& image)
-    {
-        QImage converted = image.convertToFormat(QImage::Format_RGB888);
-        cv::Mat mat(converted.height(), converted.width(), CV_8UC3,
-            (uchar*)converted.bits(), converted.bytesPerLine());
-        cv::Mat matCopy;
-        // Convert RGB -> BGR
-        cv::cvtColor(mat, matCopy, cv::COLOR_RGB2BGR);
-        return matCopy;
-    }
-
-    QImage convertToGrayscale(const QImage& image)
-    {
-        QImage gray(image.size(), QImage::Format_ARGB32);
-        for (int y = 0; y < gray.height(); ++y) {
-            for (int x = 0; x < gray.width(); ++x) {
-                QColor c = image.pixelColor(x, y);
-                int g = qRound(0.299 * c.red() + 0.587 * c.green() + 0.114 * c.blue());
-                gray.setPixelColor(x, y, QColor(g, g, g, c.alpha()));
-            }
-        }
-        return gray;
-    }
-
-    QImage posterize(const QImage& image, int levels, bool normalizeAB)
-    {
-        if (levels < 2) {
-            qDebug() << "Posterize levels must be at least 2. Returning original image.";
-            return image;
-        }
-
-        // Convert QImage to cv::Mat
-        cv::Mat mat = convertQImageToMat(image);
-        if (mat.empty()) {
-            qWarning() << "Empty image provided for posterization.";
-            return image;
-        }
-
-        // Convert BGR to CIELAB
-        cv::Mat lab;
-        cv::cvtColor(mat, lab, cv::COLOR_BGR2Lab);
-
-        // Split into channels: channels[0]=L*, channels[1]=a*, channels[2]=b*
-        std::vector<cv::Mat> channels;
-        cv::split(lab, channels);
-
-        // Convert L* to float for precision
-        cv::Mat L_float;
-        channels[0].convertTo(L_float, CV_32F);
-
-        // Define quantization interval based on OpenCV’s Lab scaling (0-255)
-        double interval = 255.0 / levels;
-
-        // Build a lookup table for the quantized L* value:
-        std::vector<float> lut(levels, 0.0f);
-        for (int i = 0; i < levels; ++i) {
-            lut[i] = (i + 0.5f) * interval;
-            if (lut[i] > 255.0f)
-                lut[i] = 255.0f;
-        }
-
-        // Quantize L* channel using the lookup table
-        cv::Mat posterized_L = L_float.clone();
-        for (int i = 0; i < posterized_L.rows; ++i) {
-            float* ptr = posterized_L.ptr<float>(i);
-            for (int j = 0; j < posterized_L.cols; ++j) {
-                float original_L = ptr[j];
-                int bin = static_cast<int>(std::floor(original_L / interval));
-                if (bin >= levels)
-                    bin = levels - 1;
-                ptr[j] = lut[bin];
-            }
-        }
-
-        // Convert the posterized L* channel back to 8-bit
-        cv::Mat posterized_L_uchar;
-        posterized_L.convertTo(posterized_L_uchar, CV_8U);
-
-        // Replace the original L* channel
-        channels[0] = posterized_L_uchar;
-
-        // Optional: Normalize the a* and b* channels within each bin
-        if (normalizeAB) {
-            std::vector<cv::Vec2f> avg_ab(levels, cv::Vec2f(0.0f, 0.0f));
-            std::vector<int> count(levels, 0);
-
-            for (int i = 0; i < posterized_L_uchar.rows; ++i) {
-                for (int j = 0; j < posterized_L_uchar.cols; ++j) {
-                    uchar l = posterized_L_uchar.at<uchar>(i, j);
-                    int bin = static_cast<int>(std::floor(static_cast<float>(l) / interval));
-                    if (bin >= levels)
-                        bin = levels - 1;
-                    avg_ab[bin][0] += channels[1].at<uchar>(i, j);
-                    avg_ab[bin][1] += channels[2].at<uchar>(i, j);
-                    count[bin]++;
-                }
-            }
-            for (int i = 0; i < levels; ++i) {
-                if (count[i] > 0) {
-                    avg_ab[i][0] /= static_cast<float>(count[i]);
-                    avg_ab[i][1] /= static_cast<float>(count[i]);
-                }
-            }
-            for (int i = 0; i < posterized_L_uchar.rows; ++i) {
-                for (int j = 0; j < posterized_L_uchar.cols; ++j) {
-                    uchar l = posterized_L_uchar.at<uchar>(i, j);
-                    int bin = static_cast<int>(std::floor(static_cast<float>(l) / interval));
-                    if (bin >= levels)
-                        bin = levels - 1;
-                    channels[1].at<uchar>(i, j) = static_cast<uchar>(avg_ab[bin][0]);
-                    channels[2].at<uchar>(i, j) = static_cast<uchar>(avg_ab[bin][1]);
-                }
-            }
-        }
-
-        // Merge channels back into a Lab image
-        cv::Mat labPosterized;
-        cv::merge(channels, labPosterized);
-
-        // Convert Lab back to BGR
-        cv::Mat posterizedBGR;
-        cv::cvtColor(labPosterized, posterizedBGR, cv::COLOR_Lab2BGR);
-
-        // Convert BGR to RGB for QImage
-        cv::Mat posterizedRGB;
-        cv::cvtColor(posterizedBGR, posterizedRGB, cv::COLOR_BGR2RGB);
-
-        // ***** Noise removal step *****
-        // To eliminate isolated "lone" pixels, apply a small morphological opening.
-        int morphKernelSize = 3; // Choose 3x3; adjust as needed
-        cv::Mat kernel = cv::getStructuringElement(cv::MORPH_RECT, cv::Size(morphKernelSize, morphKernelSize));
-        cv::Mat cleaned;
-        cv::morphologyEx(posterizedRGB, cleaned, cv::MORPH_OPEN, kernel);
-
-        // Convert the cleaned image to QImage for output
-        QImage posterizedImage = convertMatToQImage(cleaned);
-        return posterizedImage;
-    }
-
-    QImage gaussianBlur(const QImage& image, int kernelSize)
-    {
-        if (image.isNull()) return QImage();
-
-        cv::Mat mat = convertQImageToMat(image);
-        cv::GaussianBlur(mat, mat, cv::Size(0, 0), kernelSize);
-        cv::Mat rgb;
-        cv::cvtColor(mat, rgb, cv::COLOR_BGR2RGB);
-        return convertMatToQImage(rgb);
-    }
-
-    QImage medianFilter(const QImage& image)
-    {
-        if (image.isNull()) return QImage();
-
-        cv::Mat mat = convertQImageToMat(image);
-        int kSize = 1;
-        // Choose a kernel size based on image resolution
-        if (mat.cols < 1000 && mat.rows < 1000)
-            kSize = 1;
-        else if (mat.cols < 2000 && mat.rows < 2000)
-            kSize = 3;
-        else
-            kSize = 5;
-        cv::medianBlur(mat, mat, kSize);
-        cv::Mat rgb;
-        cv::cvtColor(mat, rgb, cv::COLOR_BGR2RGB);
-        return convertMatToQImage(rgb);
-    }
-
-    void applyGlobalStyleSheet(const QString& qssFilePath)
-    {
-        if (QApplication::instance() == nullptr) {
-            qWarning() << "No QApplication found. Cannot apply stylesheet.";
-            return;
-        }
-        QApplication* app = qobject_cast<QApplication*>(QApplication::instance());
-        if (!app) {
-            qWarning() << "The application instance is not a QApplication.";
-            return;
-        }
-        if (!qssFilePath.isEmpty()) {
-            QFile file(qssFilePath);
-            if (file.open(QFile::ReadOnly)) {
-                QString styleContent = QString::fromUtf8(file.readAll());
-                app->setStyleSheet(styleContent);
-                qDebug() << "Applied stylesheet from file:" << qssFilePath;
-                return;
-            }
-            else {
-                qWarning() << "Failed to open QSS file:" << qssFilePath;
-            }
-        }
-        QString defaultStyle = R"(
-QMainWindow {
-    background-color: #2b2b2b;
-}
-QPushButton {
-    background-color: #3c8dbc;
-    color: white;
-    border: 1px solid #337ab7;
-    padding: 6px;
-    border-radius: 4px;
-    font: bold 14px "Arial";
-}
-QPushButton:hover {
-    background-color: #2491d1;
-}
-QLabel {
-    color: #ffffff;
-}
-)";
-        app->setStyleSheet(defaultStyle);
-        qDebug() << "Applied default inline stylesheet.";
-    }
-
-} // namespace ImageUtils
+#include "imageutils.h"
+#include "ziparchive.h"
+#include "profiler.h"
+#include "scratcharena.h"
+#include "mappedfile.h"
+#include "imagedecoders.h"
+#include "lanczosresampler.h"
+
+#include <QFile>
+#include <QDebug>
+#include <QtGlobal>
+#include <QColor>
+#include <QByteArray>
+#include <QImage>
+#include <QColorSpace>
+
+#include <MagickWand.h>
+#include <lcms2.h>
+#include <opencv2/opencv.hpp>
+#include <mutex>
+
+// For applying style to the QApplication
+#include <QApplication>
+#include <QFile>
+#include <QDir>
+
+namespace {
+
+    // MagickWandGenesis/Terminus aren't reference counted: a Terminus on one thread tears
+    // ImageMagick down under a decode running on another. Start it once; the application
+    // stops it with terminateMagick() once its decoding threads are gone.
+    void ensureMagickWand()
+    {
+        static std::once_flag once;
+        std::call_once(once, []() { MagickWandGenesis(); });
+    }
+
+    // Converts a BGR image from the given ICC profile to sRGB, in place
+    void applyIccProfile(cv::Mat& img, const void* profile, size_t length)
+    {
+        ScopedTimer timer("icc transform");
+        cmsHPROFILE inProfile = cmsOpenProfileFromMem(profile, static_cast<cmsUInt32Number>(length));
+        if (!inProfile) {
+            qWarning() << "[applyIccProfile] Invalid ICC profile, keeping the pixels as they are.";
+            return;
+        }
+        cmsHPROFILE outProfile = cmsCreate_sRGBProfile();
+        cmsHTRANSFORM transform = cmsCreateTransform(inProfile, TYPE_BGR_8, outProfile, TYPE_BGR_8, INTENT_PERCEPTUAL, 0);
+        if (transform) {
+            cmsDoTransform(transform, img.data, img.data, img.total());
+            cmsDeleteTransform(transform);
+        }
+        cmsCloseProfile(inProfile);
+        cmsCloseProfile(outProfile);
+    }
+
+    // The image as BGR in arena workspace; the same pixels as ImageUtils::convertQImageToMat.
+    // RGB888 and RGB32 (what QPixmap::toImage() gives) are read in place, without the
+    // intermediate QImage a format conversion would allocate.
+    ScratchArena::Lease bgrScratch(const QImage& image)
+    {
+        ScratchArena::Lease bgr = ScratchArena::local().borrow(image.height(), image.width(), CV_8UC3);
+        uchar* bits = const_cast<uchar*>(image.constBits());  // read only; avoids a detach
+        switch (image.format()) {
+        case QImage::Format_RGB888:
+            cv::cvtColor(cv::Mat(image.height(), image.width(), CV_8UC3, bits, image.bytesPerLine()),
+                bgr.mat, cv::COLOR_RGB2BGR);
+            break;
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+        case QImage::Format_RGB32:
+            // 0xffRRGGBB words: B, G, R, 0xff in memory
+            cv::cvtColor(cv::Mat(image.height(), image.width(), CV_8UC4, bits, image.bytesPerLine()),
+                bgr.mat, cv::COLOR_BGRA2BGR);
+            break;
+#endif
+        default: {
+            const QImage rgb = image.convertToFormat(QImage::Format_RGB888);
+            cv::cvtColor(cv::Mat(rgb.height(), rgb.width(), CV_8UC3, const_cast<uchar*>(rgb.constBits()), rgb.bytesPerLine()),
+                bgr.mat, cv::COLOR_RGB2BGR);
+            break;
+        }
+        }
+        return bgr;
+    }
+
+    // An RGB888 QImage of a BGR Mat, swapped straight into the image's own buffer
+    QImage rgbImageFromBgr(const cv::Mat& bgr)
+    {
+        QImage rgb(bgr.cols, bgr.rows, QImage::Format_RGB888);
+        if (rgb.isNull()) return QImage();
+        cv::Mat target(rgb.height(), rgb.width(), CV_8UC3, rgb.bits(), rgb.bytesPerLine());
+        cv::cvtColor(bgr, target, cv::COLOR_BGR2RGB);
+        return rgb;
+    }
+
+} // namespace
+
+namespace ImageUtils {
+
+    cv::Mat loadAndApplyColorProfile(const QString& filePath)
+    {
+        // Members of ZIP/CBZ archives are read straight from the archive, no extraction.
+        // Stored members of a mapped archive point into it; `member` keeps that mapping alive.
+        ZipArchive::Data member;
+        if (ZipArchive::isMemberPath(filePath)) {
+            qDebug() << "[loadAndApplyColorProfile] Archive member:" << filePath;
+            ScopedTimer readTimer("file read");
+            if (!ZipArchive::readPath(filePath, &member)) {
+                qWarning() << "[loadAndApplyColorProfile] Cannot read archive member:" << filePath;
+                return cv::Mat();
+            }
+            readTimer.stop();
+            return loadAndApplyColorProfileFromMemory(member.bytes);
+        }
+
+        // Normalize file path and log it
+        QString nativePath = QDir::toNativeSeparators(filePath).trimmed();
+        qDebug() << "[loadAndApplyColorProfile] Native file path:" << nativePath;
+
+        // Check file existence
+        if (!QFile::exists(nativePath)) {
+            qWarning() << "[loadAndApplyColorProfile] File does not exist:" << nativePath;
+            return cv::Mat();
+        }
+
+        // Map the file; the decoder reads the page cache directly, no copy on the heap. Only
+        // the mapping is timed here: the pages are read in while the decoder runs, so the I/O
+        // is part of the decode stages.
+        ScopedTimer mapTimer("file map setup");
+        MappedFile mapped(nativePath);
+        mapTimer.stop();
+        if (mapped.isValid()) {
+            cv::Mat mat = loadAndApplyColorProfileFromMemory(mapped.bytes());
+            if (mapped.isUnchanged()) return mat;
+            qWarning() << "[loadAndApplyColorProfile] File changed while decoding, reading it again:" << nativePath;
+        }
+
+        // Not mapped (see MappedFile), or rewritten under the decoder: read it
+        ScopedTimer readTimer("file read");
+        QFile file(nativePath);
+        if (!file.open(QIODevice::ReadOnly)) {
+            qWarning() << "[loadAndApplyColorProfile] Cannot open file:" << nativePath;
+            return cv::Mat();
+        }
+        QByteArray data = file.readAll();
+        file.close();
+        readTimer.stop();
+        return loadAndApplyColorProfileFromMemory(data);
+    }
+
+    cv::Mat loadAndApplyColorProfileFromMemory(const QByteArray& data, Decoder decoder)
+    {
+        qDebug() << "[loadAndApplyColorProfile] File size (bytes):" << data.size();
+
+        // Straight to BGR, without the ImageMagick decode + blob re-encode + OpenCV decode below
+        ImageDecoders::Decoded native;
+        if (decoder == Decoder::Auto && ImageDecoders::decode(data, &native)) {
+            qDebug() << "[loadAndApplyColorProfile] Decoded natively:" << ImageDecoders::formatName(ImageDecoders::sniff(data))
+                << native.bgr.cols << "x" << native.bgr.rows;
+            if (!native.iccProfile.isEmpty()) {
+                qDebug() << "[loadAndApplyColorProfile] Applying color profile transformation.";
+                applyIccProfile(native.bgr, native.iccProfile.constData(), static_cast<size_t>(native.iccProfile.size()));
+            }
+            return native.bgr;
+        }
+
+        // Initialize MagickWand
+        ScopedTimer decodeTimer("magick decode");
+        ensureMagickWand();
+        MagickWand* wand = NewMagickWand();
+
+        // Attempt to read the image via MagickWand
+        MagickBooleanType result = MagickReadImageBlob(wand, data.constData(), data.size());
+        if (result == MagickFalse) {
+            // Get the error description from MagickWand
+            char* desc = nullptr;
+            ExceptionType severity;
+            desc = MagickGetException(wand, &severity);
+            qWarning() << "[loadAndApplyColorProfile] Failed to read image via Magick. Exception:" << desc;
+            if (desc)
+                MagickRelinquishMemory(desc);
+
+            DestroyMagickWand(wand);
+            return cv::Mat();
+        }
+        decodeTimer.stop();
+        qDebug() << "[loadAndApplyColorProfile] Image read via Magick successfully.";
+
+        // Retrieve ICC profile if present
+        ScopedTimer blobTimer("blob extraction");
+        size_t length = 0;
+        unsigned char* profile = MagickGetImageProfile(wand, "ICC", &length);
+        if (profile)
+            qDebug() << "[loadAndApplyColorProfile] ICC profile found, length:" << length;
+        else
+            qDebug() << "[loadAndApplyColorProfile] No ICC profile found.";
+
+        // Get image blob in PNG format (or another format supported by OpenCV)
+        size_t blobLength = 0;
+        unsigned char* blob = MagickGetImageBlob(wand, &blobLength);
+        if (!blob || blobLength == 0) {
+            qWarning() << "[loadAndApplyColorProfile] Failed to get image blob from MagickWand.";
+            DestroyMagickWand(wand);
+            return cv::Mat();
+        }
+        blobTimer.stop();
+        qDebug() << "[loadAndApplyColorProfile] Image blob retrieved, length:" << blobLength;
+
+        // Decode the image blob using OpenCV
+        ScopedTimer imdecodeTimer("opencv decode");
+        cv::Mat bufMat(1, blobLength, CV_8UC1, blob);
+        cv::Mat img = cv::imdecode(bufMat, cv::IMREAD_COLOR);
+        if (img.empty()) {
+            qWarning() << "[loadAndApplyColorProfile] Failed to decode image blob with OpenCV.";
+            MagickRelinquishMemory(blob);
+            DestroyMagickWand(wand);
+            return cv::Mat();
+        }
+        imdecodeTimer.stop();
+        qDebug() << "[loadAndApplyColorProfile] Image decoded successfully, size:" << img.cols << "x" << img.rows;
+
+        // If an ICC profile exists, apply the color transformation using LittleCMS
+        if (profile) {
+            qDebug() << "[loadAndApplyColorProfile] Applying color profile transformation.";
+            applyIccProfile(img, profile, length);
+        }
+
+        // Clean up MagickWand resources
+        MagickRelinquishMemory(blob);
+        DestroyMagickWand(wand);
+
+        return img;
+    }
+
+    cv::Mat lanczosResizeIfNeeded(const cv::Mat& input)
+    {
+        if (input.empty()) return cv::Mat();
+
+        if (input.cols < 2000 && input.rows < 2000) {
+            // If smaller than 2000x2000, double the size with Lanczos-4, in linear light;
+            // BGR -> RGB for QImage is done by the resampler's store
+            return LanczosResampler::resizeBgrToRgb(input, cv::Size(input.cols * 2, input.rows * 2), 4);
+        }
+
+        // Otherwise keep the same size (a same-size cv::resize is a copy): only BGR -> RGB
+        cv::Mat output;
+        cv::cvtColor(input, output, cv::COLOR_BGR2RGB);
+        return output;
+    }
+
+    QImage convertMatToQImage(const cv::Mat& mat)
+    {
+        if (mat.empty()) return QImage();
+
+        // Here we assume mat is in RGB
+        return QImage(mat.data,
+            mat.cols,
+            mat.rows,
+            static_cast<int>(mat.step),
+            QImage::Format_RGB888).copy();
+    }
+
+    cv::Mat convertQImageToMat(const QImage& image)
+    {
+        QImage converted = image.convertToFormat(QImage::Format_RGB888);
+        cv::Mat mat(converted.height(), converted.width(), CV_8UC3,
+            (uchar*)converted.bits(), converted.bytesPerLine());
+        cv::Mat matCopy;
+        // Convert RGB -> BGR
+        cv::cvtColor(mat, matCopy, cv::COLOR_RGB2BGR);
+        return matCopy;
+    }
+
+    cv::Mat convertQImageToMatWithColorProfile(const QImage& image)
+    {
+        if (image.isNull()) return cv::Mat();
+
+        cv::Mat mat = convertQImageToMat(image);
+
+        // Qt fills the color space from the clipboard data (e.g. the ICC chunk of a PNG)
+        const QColorSpace colorSpace = image.colorSpace();
+        if (colorSpace.isValid() && colorSpace != QColorSpace(QColorSpace::SRgb)) {
+            const QByteArray icc = colorSpace.iccProfile();
+            if (!icc.isEmpty()) {
+                qDebug() << "[convertQImageToMatWithColorProfile] Applying color profile:" << colorSpace.description();
+                applyIccProfile(mat, icc.constData(), static_cast<size_t>(icc.size()));
+            }
+            else {
+                // A color space Qt built itself has no ICC data; let Qt convert it instead
+                QImage converted = image.convertedToColorSpace(QColorSpace::SRgb);
+                if (!converted.isNull()) mat = convertQImageToMat(converted);
+            }
+        }
+        return mat;
+    }
+
+    void convertToSRgb(cv::Mat& bgr, const QByteArray& iccProfile)
+    {
+        if (bgr.empty() || iccProfile.isEmpty()) return;
+        applyIccProfile(bgr, iccProfile.constData(), static_cast<size_t>(iccProfile.size()));
+    }
+
+    void initializeMagick()
+    {
+        ensureMagickWand();
+    }
+
+    void terminateMagick()
+    {
+        if (IsMagickWandInstantiated() == MagickTrue)
+            MagickWandTerminus();
+    }
+
+    QImage convertToGrayscale(const QImage& image)
+    {
+        QImage gray(image.size(), QImage::Format_ARGB32);
+        for (int y = 0; y < gray.height(); ++y) {
+            for (int x = 0; x < gray.width(); ++x) {
+                QColor c = image.pixelColor(x, y);
+                int g = qRound(0.299 * c.red() + 0.587 * c.green() + 0.114 * c.blue());
+                gray.setPixelColor(x, y, QColor(g, g, g, c.alpha()));
+            }
+        }
+        return gray;
+    }
+
+    QImage posterize(const QImage& image, int levels, bool normalizeAB)
+    {
+        if (levels < 2) {
+            qDebug() << "Posterize levels must be at least 2. Returning original image.";
+            return image;
+        }
+        if (image.isNull()) {
+            qWarning() << "Empty image provided for posterization.";
+            return image;
+        }
+
+        // Every temporary comes from this thread's arena: after the first image of a size,
+        // a level change allocates nothing but the result
+        ScratchArena& arena = ScratchArena::local();
+        const cv::Size size(image.width(), image.height());
+        ScratchArena::Lease bgr = bgrScratch(image);
+
+        // Convert BGR to CIELAB
+        ScratchArena::Lease lab = arena.borrow(size, CV_8UC3);
+        cv::cvtColor(bgr.mat, lab.mat, cv::COLOR_BGR2Lab);
+
+        // Split into channels: channels[0]=L*, channels[1]=a*, channels[2]=b*
+        ScratchArena::Lease planeL = arena.borrow(size, CV_8UC1);
+        ScratchArena::Lease planeA = arena.borrow(size, CV_8UC1);
+        ScratchArena::Lease planeB = arena.borrow(size, CV_8UC1);
+        cv::Mat channels[3] = { planeL.mat, planeA.mat, planeB.mat };
+        cv::split(lab.mat, channels);
+
+        // Convert L* to float for precision
+        ScratchArena::Lease floatL = arena.borrow(size, CV_32FC1);
+        channels[0].convertTo(floatL.mat, CV_32F);
+
+        // Define quantization interval based on OpenCV’s Lab scaling (0-255)
+        double interval = 255.0 / levels;
+
+        // Build a lookup table for the quantized L* value:
+        std::vector<float> lut(levels, 0.0f);
+        for (int i = 0; i < levels; ++i) {
+            lut[i] = (i + 0.5f) * interval;
+            if (lut[i] > 255.0f)
+                lut[i] = 255.0f;
+        }
+
+        // Quantize L* channel using the lookup table
+        for (int i = 0; i < floatL.mat.rows; ++i) {
+            float* ptr = floatL.mat.ptr<float>(i);
+            for (int j = 0; j < floatL.mat.cols; ++j) {
+                float original_L = ptr[j];
+                int bin = static_cast<int>(std::floor(original_L / interval));
+                if (bin >= levels)
+                    bin = levels - 1;
+                ptr[j] = lut[bin];
+            }
+        }
+
+        // Convert the posterized L* channel back to 8-bit, replacing the original L*
+        floatL.mat.convertTo(channels[0], CV_8U);
+
+        // Optional: Normalize the a* and b* channels within each bin
+        if (normalizeAB) {
+            std::vector<cv::Vec2f> avg_ab(levels, cv::Vec2f(0.0f, 0.0f));
+            std::vector<int> count(levels, 0);
+
+            for (int i = 0; i < channels[0].rows; ++i) {
+                for (int j = 0; j < channels[0].cols; ++j) {
+                    uchar l = channels[0].at<uchar>(i, j);
+                    int bin = static_cast<int>(std::floor(static_cast<float>(l) / interval));
+                    if (bin >= levels)
+                        bin = levels - 1;
+                    avg_ab[bin][0] += channels[1].at<uchar>(i, j);
+                    avg_ab[bin][1] += channels[2].at<uchar>(i, j);
+                    count[bin]++;
+                }
+            }
+            for (int i = 0; i < levels; ++i) {
+                if (count[i] > 0) {
+                    avg_ab[i][0] /= static_cast<float>(count[i]);
+                    avg_ab[i][1] /= static_cast<float>(count[i]);
+                }
+            }
+            for (int i = 0; i < channels[0].rows; ++i) {
+                for (int j = 0; j < channels[0].cols; ++j) {
+                    uchar l = channels[0].at<uchar>(i, j);
+                    int bin = static_cast<int>(std::floor(static_cast<float>(l) / interval));
+                    if (bin >= levels)
+                        bin = levels - 1;
+                    channels[1].at<uchar>(i, j) = static_cast<uchar>(avg_ab[bin][0]);
+                    channels[2].at<uchar>(i, j) = static_cast<uchar>(avg_ab[bin][1]);
+                }
+            }
+        }
+
+        // Merge channels back into a Lab image, then back to BGR
+        cv::merge(channels, 3, lab.mat);
+        cv::cvtColor(lab.mat, bgr.mat, cv::COLOR_Lab2BGR);
+
+        // ***** Noise removal step *****
+        // To eliminate isolated "lone" pixels, apply a small morphological opening (3x3):
+        // erode then dilate. Both work per channel, so this runs before the swap to RGB.
+        static const cv::Mat kernel = cv::getStructuringElement(cv::MORPH_RECT, cv::Size(3, 3));
+        cv::erode(bgr.mat, lab.mat, kernel);
+        cv::dilate(lab.mat, bgr.mat, kernel);
+
+        // Convert BGR to RGB, straight into the output QImage
+        return rgbImageFromBgr(bgr.mat);
+    }
+
+    QImage gaussianBlur(const QImage& image, int kernelSize)
+    {
+        if (image.isNull()) return QImage();
+
+        ScratchArena::Lease bgr = bgrScratch(image);
+        ScratchArena::Lease blurred = ScratchArena::local().borrow(bgr.mat.size(), CV_8UC3);
+        cv::GaussianBlur(bgr.mat, blurred.mat, cv::Size(0, 0), kernelSize);
+        return rgbImageFromBgr(blurred.mat);
+    }
+
+    QImage medianFilter(const QImage& image)
+    {
+        if (image.isNull()) return QImage();
+
+        ScratchArena::Lease bgr = bgrScratch(image);
+        int kSize = 1;
+        // Choose a kernel size based on image resolution
+        if (bgr.mat.cols < 1000 && bgr.mat.rows < 1000)
+            kSize = 1;
+        else if (bgr.mat.cols < 2000 && bgr.mat.rows < 2000)
+            kSize = 3;
+        else
+            kSize = 5;
+        ScratchArena::Lease filtered = ScratchArena::local().borrow(bgr.mat.size(), CV_8UC3);
+        cv::medianBlur(bgr.mat, filtered.mat, kSize);
+        return rgbImageFromBgr(filtered.mat);
+    }
+
+    void applyGlobalStyleSheet(const QString& qssFilePath)
+    {
+        if (QApplication::instance() == nullptr) {
+            qWarning() << "No QApplication found. Cannot apply stylesheet.";
+            return;
+        }
+        QApplication* app = qobject_cast<QApplication*>(QApplication::instance());
+        if (!app) {
+            qWarning() << "The application instance is not a QApplication.";
+            return;
+        }
+        if (!qssFilePath.isEmpty()) {
+            QFile file(qssFilePath);
+            if (file.open(QFile::ReadOnly)) {
+                QString styleContent = QString::fromUtf8(file.readAll());
+                app->setStyleSheet(styleContent);
+                qDebug() << "Applied stylesheet from file:" << qssFilePath;
+                return;
+            }
+            else {
+                qWarning() << "Failed to open QSS file:" << qssFilePath;
+            }
+        }
+        QString defaultStyle = R"(
+QMainWindow {
+    background-color: #2b2b2b;
+}
+QPushButton {
+    background-color: #3c8dbc;
+    color: white;
+    border: 1px solid #337ab7;
+    padding: 6px;
+    border-radius: 4px;
+    font: bold 14px "Arial";
+}
+QPushButton:hover {
+    background-color: #2491d1;
+}
+QLabel {
+    color: #ffffff;
+}
+)";
+        app->setStyleSheet(defaultStyle);
+        qDebug() << "Applied default inline stylesheet.";
+    }
+
+} // namespace ImageUtils
@@ -0,0 +1,60 @@
+// imageutilsasync.cpp
+
+#include "imageutilsasync.h"
+#include "memorybudget.h"
+#include "profiler.h"
+
+namespace ImageUtils {
+
+	QFuture<QImage> loadForDisplayAsync(const QString& filePath, TaskScheduler::Priority priority,
+		const TaskScheduler::TaskOptions& options)
+	{
+		TaskScheduler::TaskOptions heavy = options;
+		heavy.memoryHeavy = true;  // the full-size decode plus the resized copy
+		return runAsync(priority, [filePath]() {
+			cv::Mat mat = loadAndApplyColorProfile(filePath);
+			if (mat.empty()) return QImage();
+			ScopedTimer resizeTimer("resize");
+			cv::Mat resampled = lanczosResizeIfNeeded(mat);
+			resizeTimer.stop();
+			mat.release();
+			ScopedTimer convertTimer("qimage conversion");
+			return convertMatToQImage(resampled);
+			}, heavy);
+	}
+
+	QFuture<QImage> convertToGrayscaleAsync(const QImage& image, const TaskScheduler::TaskOptions& options)
+	{
+		return runAsync(TaskScheduler::Priority::InteractiveFilter, [image]() {
+			MemoryBudget::Tracked working(MemoryBudget::Category::Transient, 2 * image.sizeInBytes());  // the input copy and the result, while the filter runs
+			ScopedTimer timer("grayscale");
+			return convertToGrayscale(image);
+			}, options);
+	}
+
+	QFuture<QImage> posterizeAsync(const QImage& image, int levels, bool normalizeAB,
+		const TaskScheduler::TaskOptions& options)
+	{
+		return runAsync(TaskScheduler::Priority::InteractiveFilter, [image, levels, normalizeAB]() {
+			MemoryBudget::Tracked working(MemoryBudget::Category::Transient, 2 * image.sizeInBytes());
+			return posterize(image, levels, normalizeAB);
+			}, options);
+	}
+
+	QFuture<QImage> gaussianBlurAsync(const QImage& image, int kernelSize, const TaskScheduler::TaskOptions& options)
+	{
+		return runAsync(TaskScheduler::Priority::InteractiveFilter, [image, kernelSize]() {
+			MemoryBudget::Tracked working(MemoryBudget::Category::Transient, 2 * image.sizeInBytes());
+			return gaussianBlur(image, kernelSize);
+			}, options);
+	}
+
+	QFuture<QImage> medianFilterAsync(const QImage& image, const TaskScheduler::TaskOptions& options)
+	{
+		return runAsync(TaskScheduler::Priority::InteractiveFilter, [image]() {
+			MemoryBudget::Tracked working(MemoryBudget::Category::Transient, 2 * image.sizeInBytes());
+			return medianFilter(image);
+			}, options);
+	}
+
+} // namespace ImageUtils
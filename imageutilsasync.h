@@ -0,0 +1,82 @@
+// imageutilsasync.h
+
+#ifndef IMAGEUTILSASYNC_H
+#define IMAGEUTILSASYNC_H
+
+#include "imageutils.h"
+#include "profiler.h"
+#include "taskscheduler.h"
+
+#include <QFuture>
+#include <QPromise>
+#include <QImage>
+#include <QString>
+#include <exception>
+#include <memory>
+#include <type_traits>
+
+/*!
+ * \brief Asynchronous counterparts of the ImageUtils functions, run on the TaskScheduler.
+ *
+ *        Each returns a QFuture, so stages compose with QFuture::then() and
+ *        QtFuture::whenAll(), and results reach the GUI thread with then(context, ...).
+ *        Cancelling either the returned future or the TaskOptions token before the task
+ *        starts drops it (the future ends up canceled); a running task completes, and its
+ *        result is simply not needed. Exceptions (e.g. cv::Exception) are stored in the future.
+ */
+namespace ImageUtils {
+
+	/*!
+	 * \brief runAsync runs function on the TaskScheduler and returns its result as a future.
+	 *        The stages function times count for the caller's load (Profiler::LoadScope).
+	 */
+	template <typename Function>
+	auto runAsync(TaskScheduler::Priority priority, Function function,
+		const TaskScheduler::TaskOptions& options = TaskScheduler::TaskOptions())
+		-> QFuture<std::invoke_result_t<Function>>
+	{
+		using Result = std::invoke_result_t<Function>;
+		auto promise = std::make_shared<QPromise<Result>>();
+		QFuture<Result> future = promise->future();
+		promise->start();
+
+		// If the scheduler drops the task, the promise is destroyed unfinished, which cancels it
+		TaskScheduler::instance().submit(priority, [promise, function = std::move(function), token = options.token,
+			load = Profiler::currentLoad()]() mutable {
+			if (promise->isCanceled() || token.isCancelled()) {
+				promise->future().cancel();
+				promise->finish();
+				return;
+			}
+			Profiler::LoadScope loadScope(load);
+			try {
+				promise->addResult(function());
+			}
+			catch (...) {
+				promise->setException(std::current_exception());
+			}
+			promise->finish();
+			}, options);
+		return future;
+	}
+
+	//! Loads a file as MainWindow displays it (color profile, Lanczos resize, RGB888); memory-heavy.
+	QFuture<QImage> loadForDisplayAsync(const QString& filePath,
+		TaskScheduler::Priority priority = TaskScheduler::Priority::VisibleFrame,
+		const TaskScheduler::TaskOptions& options = TaskScheduler::TaskOptions());
+
+	QFuture<QImage> convertToGrayscaleAsync(const QImage& image,
+		const TaskScheduler::TaskOptions& options = TaskScheduler::TaskOptions());
+
+	QFuture<QImage> posterizeAsync(const QImage& image, int levels, bool normalizeAB = false,
+		const TaskScheduler::TaskOptions& options = TaskScheduler::TaskOptions());
+
+	QFuture<QImage> gaussianBlurAsync(const QImage& image, int kernelSize,
+		const TaskScheduler::TaskOptions& options = TaskScheduler::TaskOptions());
+
+	QFuture<QImage> medianFilterAsync(const QImage& image,
+		const TaskScheduler::TaskOptions& options = TaskScheduler::TaskOptions());
+
+} // namespace ImageUtils
+
+#endif // IMAGEUTILSASYNC_H
@@ -0,0 +1,62 @@
+// inflate.cpp
+
+#include "inflate.h"
+
+#include <zlib.h>
+#include <algorithm>
+
+namespace {
+
+    // z_stream counts in uInt; larger buffers are fed in pieces
+    const qint64 kMaxChunk = 1 << 30;
+
+} // namespace
+
+namespace Inflate {
+
+    qint64 inflateRaw(const uchar* input, qint64 inputSize, uchar* output, qint64 outputSize)
+    {
+        if (outputSize <= 0) return 0;
+
+        z_stream stream = {};
+        // Negative window bits: raw DEFLATE, no zlib header or Adler-32 trailer
+        if (inflateInit2(&stream, -MAX_WBITS) != Z_OK) return -1;
+
+        qint64 inputLeft = inputSize;
+        qint64 outputLeft = outputSize;
+        stream.next_in = const_cast<Bytef*>(input);
+        stream.next_out = output;
+        int status = Z_OK;
+        while (status == Z_OK && outputLeft > 0) {
+            if (stream.avail_in == 0 && inputLeft > 0) {
+                stream.avail_in = static_cast<uInt>(std::min(inputLeft, kMaxChunk));
+                inputLeft -= stream.avail_in;
+            }
+            if (stream.avail_out == 0) {
+                stream.avail_out = static_cast<uInt>(std::min(outputLeft, kMaxChunk));
+                outputLeft -= stream.avail_out;
+            }
+            status = inflate(&stream, Z_NO_FLUSH);
+        }
+        const qint64 produced = outputSize - outputLeft - stream.avail_out;
+        inflateEnd(&stream);
+
+        // Stopping on a full buffer gives a prefix; running out of input is a truncated stream
+        if (status == Z_STREAM_END || (status == Z_OK && produced == outputSize))
+            return produced;
+        return -1;
+    }
+
+    quint32 crc32(quint32 crc, const uchar* data, qint64 size)
+    {
+        uLong value = crc;
+        while (size > 0) {
+            const uInt chunk = static_cast<uInt>(std::min(size, kMaxChunk));
+            value = ::crc32(value, data, chunk);
+            data += chunk;
+            size -= chunk;
+        }
+        return static_cast<quint32>(value);
+    }
+
+} // namespace Inflate
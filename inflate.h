@@ -0,0 +1,31 @@
+// inflate.h
+
+#ifndef INFLATE_H
+#define INFLATE_H
+
+#include <QtGlobal>
+
+/*!
+ * \brief The Inflate namespace decodes raw DEFLATE streams (RFC 1951), as stored in ZIP
+ *        archives (compression method 8), with zlib. Qt only exposes zlib-wrapped data via
+ *        qUncompress(), which can't take a ZIP member without its checksum.
+ */
+namespace Inflate {
+
+    /*!
+     * \brief inflateRaw decompresses a raw DEFLATE stream into a caller-provided buffer.
+     * \param input Compressed data.
+     * \param inputSize Size of input in bytes.
+     * \param output Destination buffer.
+     * \param outputSize Capacity of output. Decoding stops (successfully) once it is full, so
+     *        a small buffer gives a cheap prefix of a large member.
+     * \return The number of bytes written, or -1 if the stream is corrupt.
+     */
+    qint64 inflateRaw(const uchar* input, qint64 inputSize, uchar* output, qint64 outputSize);
+
+    // CRC-32 (ZIP/PNG polynomial), continuing from crc (0 to start)
+    quint32 crc32(quint32 crc, const uchar* data, qint64 size);
+
+} // namespace Inflate
+
+#endif // INFLATE_H
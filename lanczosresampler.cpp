@@ -0,0 +1,213 @@
+// lanczosresampler.cpp
+
+#include "lanczosresampler.h"
+#include "scratcharena.h"
+
+#include <opencv2/core/hal/intrin.hpp>
+#include <opencv2/imgproc.hpp>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace {
+
+    // Output rows per parallel task: each stripe filters its source rows horizontally once,
+    // plus the few rows of overlap the vertical taps need at its edges
+    const int kStripeRows = 64;
+    const int kLinearMax = 65535;
+
+    struct GammaTables {
+        ushort toLinear[256];
+        uchar toSrgb[kLinearMax + 1];
+    };
+
+    const GammaTables& gammaTables()
+    {
+        static const GammaTables tables = []() {
+            GammaTables t;
+            for (int v = 0; v < 256; ++v) {
+                const double c = v / 255.0;
+                const double linear = c <= 0.04045 ? c / 12.92 : std::pow((c + 0.055) / 1.055, 2.4);
+                t.toLinear[v] = static_cast<ushort>(std::lround(linear * kLinearMax));
+            }
+            for (int i = 0; i <= kLinearMax; ++i) {
+                const double linear = static_cast<double>(i) / kLinearMax;
+                const double c = linear <= 0.0031308 ? linear * 12.92 : 1.055 * std::pow(linear, 1.0 / 2.4) - 0.055;
+                t.toSrgb[i] = static_cast<uchar>(std::lround(c * 255.0));
+            }
+            return t;
+            }();
+        return tables;
+    }
+
+    double lanczos(double x, int lobes)
+    {
+        if (x == 0.0) return 1.0;
+        if (x <= -lobes || x >= lobes) return 0.0;
+        const double px = CV_PI * x;
+        return lobes * std::sin(px) * std::sin(px / lobes) / (px * px);
+    }
+
+    // The source span and normalized weights of every output index along one axis
+    struct Weights {
+        int taps = 0;                      // coefficients per output index (stride)
+        std::vector<int> first;            // first source index
+        std::vector<int> count;            // source indices used, at most taps
+        std::vector<float> coefficients;
+    };
+
+    Weights weightsFor(int inSize, int outSize, int lobes)
+    {
+        const double scale = static_cast<double>(inSize) / outSize;
+        const double filterScale = std::max(scale, 1.0);  // shrinking widens the kernel
+        const double support = lobes * filterScale;
+
+        Weights weights;
+        weights.taps = static_cast<int>(std::ceil(support)) * 2 + 1;
+        weights.first.resize(outSize);
+        weights.count.resize(outSize);
+        weights.coefficients.assign(static_cast<size_t>(outSize) * weights.taps, 0.0f);
+        std::vector<double> values(weights.taps);
+        for (int i = 0; i < outSize; ++i) {
+            const double center = (i + 0.5) * scale;
+            // Clamped to the image and renormalized: no border extrapolation
+            const int first = std::max(static_cast<int>(std::floor(center - support + 0.5)), 0);
+            const int last = std::min(static_cast<int>(std::floor(center + support + 0.5)), inSize);
+            const int count = std::min(last - first, weights.taps);
+            double sum = 0.0;
+            for (int k = 0; k < count; ++k) {
+                values[k] = lanczos((first + k + 0.5 - center) / filterScale, lobes);
+                sum += values[k];
+            }
+            float* w = &weights.coefficients[static_cast<size_t>(i) * weights.taps];
+            for (int k = 0; k < count; ++k) {
+                w[k] = static_cast<float>(sum != 0.0 ? values[k] / sum : 0.0);
+            }
+            weights.first[i] = first;
+            weights.count[i] = count;
+        }
+        return weights;
+    }
+
+    // One source row to linear light, then filtered horizontally into dst (3 floats per output
+    // pixel, plus one of padding). linear has one element of padding past the row.
+    void horizontalRow(const uchar* src, int srcWidth, ushort* linear, const Weights& weights, float* dst)
+    {
+        const ushort* toLinear = gammaTables().toLinear;
+        const int values = srcWidth * 3;
+        for (int i = 0; i < values; ++i) {
+            linear[i] = toLinear[src[i]];
+        }
+        linear[values] = 0;
+
+        const int outWidth = static_cast<int>(weights.first.size());
+        for (int x = 0; x < outWidth; ++x) {
+            const ushort* p = linear + weights.first[x] * 3;
+            const float* w = &weights.coefficients[static_cast<size_t>(x) * weights.taps];
+            const int count = weights.count[x];
+#if CV_SIMD128
+            // B, G, R and the next pixel's B (weighted too, then overwritten by the next store)
+            cv::v_float32x4 sum = cv::v_setzero_f32();
+            for (int k = 0; k < count; ++k) {
+                const cv::v_float32x4 pixel = cv::v_cvt_f32(cv::v_reinterpret_as_s32(cv::v_load_expand(p + k * 3)));
+                sum = cv::v_fma(pixel, cv::v_setall_f32(w[k]), sum);
+            }
+            cv::v_store(dst + x * 3, sum);
+#else
+            float b = 0.0f, g = 0.0f, r = 0.0f;
+            for (int k = 0; k < count; ++k) {
+                b += p[k * 3] * w[k];
+                g += p[k * 3 + 1] * w[k];
+                r += p[k * 3 + 2] * w[k];
+            }
+            dst[x * 3] = b;
+            dst[x * 3 + 1] = g;
+            dst[x * 3 + 2] = r;
+#endif
+        }
+    }
+
+    // Output row y from the horizontally filtered rows (rows.row(0) is source row firstRow),
+    // back to sRGB and swizzled BGR -> RGB on the store
+    void verticalRow(const cv::Mat& rows, int firstRow, const Weights& weights, int y, int* sum, uchar* out, int outWidth)
+    {
+        const int values = outWidth * 3;
+        const int first = weights.first[y] - firstRow;
+        const int count = weights.count[y];
+        const float* w = &weights.coefficients[static_cast<size_t>(y) * weights.taps];
+
+        int i = 0;
+#if CV_SIMD128
+        const cv::v_int32x4 zero = cv::v_setzero_s32();
+        const cv::v_int32x4 top = cv::v_setall_s32(kLinearMax);
+        for (; i <= values - 4; i += 4) {
+            cv::v_float32x4 acc = cv::v_setzero_f32();
+            for (int k = 0; k < count; ++k) {
+                acc = cv::v_fma(cv::v_load(rows.ptr<float>(first + k) + i), cv::v_setall_f32(w[k]), acc);
+            }
+            cv::v_store(sum + i, cv::v_min(cv::v_max(cv::v_round(acc), zero), top));
+        }
+#endif
+        for (; i < values; ++i) {
+            float acc = 0.0f;
+            for (int k = 0; k < count; ++k) {
+                acc += rows.ptr<float>(first + k)[i] * w[k];
+            }
+            sum[i] = std::min(std::max(static_cast<int>(std::lround(acc)), 0), kLinearMax);
+        }
+
+        const uchar* toSrgb = gammaTables().toSrgb;
+        for (int x = 0; x < outWidth; ++x) {
+            out[x * 3] = toSrgb[sum[x * 3 + 2]];
+            out[x * 3 + 1] = toSrgb[sum[x * 3 + 1]];
+            out[x * 3 + 2] = toSrgb[sum[x * 3]];
+        }
+    }
+
+} // namespace
+
+namespace LanczosResampler {
+
+    cv::Mat resizeBgrToRgb(const cv::Mat& bgr, cv::Size size, int lobes)
+    {
+        if (bgr.empty() || size.width <= 0 || size.height <= 0) return cv::Mat();
+        if (bgr.type() != CV_8UC3) {
+            cv::Mat output;
+            cv::resize(bgr, output, size, 0, 0, cv::INTER_LANCZOS4);
+            if (output.channels() == 3) cv::cvtColor(output, output, cv::COLOR_BGR2RGB);
+            return output;
+        }
+
+        const Weights horizontal = weightsFor(bgr.cols, size.width, lobes);
+        const Weights vertical = weightsFor(bgr.rows, size.height, lobes);
+        gammaTables();  // built once, before the workers race for it
+
+        cv::Mat output(size, CV_8UC3);
+        const int stripes = (size.height + kStripeRows - 1) / kStripeRows;
+        cv::parallel_for_(cv::Range(0, stripes), [&](const cv::Range& range) {
+            ScratchArena& arena = ScratchArena::local();
+            ScratchArena::Lease linear = arena.borrow(1, bgr.cols * 3 + 1, CV_16UC1);
+            ScratchArena::Lease sum = arena.borrow(1, size.width * 3, CV_32SC1);
+
+            for (int stripe = range.start; stripe < range.end; ++stripe) {
+                const int y0 = stripe * kStripeRows;
+                const int y1 = std::min(y0 + kStripeRows, size.height);
+                const int firstRow = vertical.first[y0];
+                int lastRow = firstRow;
+                for (int y = y0; y < y1; ++y) {
+                    lastRow = std::max(lastRow, vertical.first[y] + vertical.count[y]);
+                }
+
+                ScratchArena::Lease rows = arena.borrow(lastRow - firstRow, size.width * 3 + 1, CV_32FC1);
+                for (int r = firstRow; r < lastRow; ++r) {
+                    horizontalRow(bgr.ptr<uchar>(r), bgr.cols, linear.mat.ptr<ushort>(), horizontal, rows.mat.ptr<float>(r - firstRow));
+                }
+                for (int y = y0; y < y1; ++y) {
+                    verticalRow(rows.mat, firstRow, vertical, y, sum.mat.ptr<int>(), output.ptr<uchar>(y), size.width);
+                }
+            }
+            });
+        return output;
+    }
+
+} // namespace LanczosResampler
@@ -0,0 +1,32 @@
+// lanczosresampler.h
+
+#ifndef LANCZOSRESAMPLER_H
+#define LANCZOSRESAMPLER_H
+
+#include <opencv2/core.hpp>
+
+/*!
+ * \brief The LanczosResampler namespace resizes 8-bit images with a separable Lanczos filter
+ *        in linear light, so fine detail keeps its brightness (cv::resize filters the
+ *        gamma-encoded values, which darkens thin light lines and dithered areas).
+ *
+ *        Pixels go through 8 -> 16-bit sRGB-to-linear tables and back through a 16 -> 8-bit
+ *        table. The weights of each output column and row are computed once per call. The
+ *        horizontal pass filters a pixel (3 channels) per SIMD register, the vertical pass
+ *        runs across whole rows; both use OpenCV universal intrinsics. Output rows are split
+ *        into stripes over cv::parallel_for_, each working in its thread's ScratchArena.
+ */
+namespace LanczosResampler {
+
+    /*!
+     * \brief resizeBgrToRgb resamples an 8-bit BGR image and stores it as RGB (the swizzle is
+     *        part of the final store, no separate cvtColor pass).
+     * \param lobes 3 for Lanczos-3, 4 for Lanczos-4 (the kernel of cv::INTER_LANCZOS4).
+     * \return An 8-bit RGB Mat of the given size, or empty if bgr is empty. Other types than
+     *         CV_8UC3 are resized by cv::resize, in their own encoding.
+     */
+    cv::Mat resizeBgrToRgb(const cv::Mat& bgr, cv::Size size, int lobes = 3);
+
+} // namespace LanczosResampler
+
+#endif // LANCZOSRESAMPLER_H
@@ -0,0 +1,108 @@
+// lazyimagemimedata.cpp
+
+#include "lazyimagemimedata.h"
+#include "imageencoders.h"
+#include "taskscheduler.h"
+
+#include <QBuffer>
+#include <QDebug>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <atomic>
+
+namespace {
+
+    const QString kPngMime = QStringLiteral("image/png");
+    const QString kImageMime = QStringLiteral("application/x-qt-image");
+
+    // Tasks that may still write a file, for waitForWrites()
+    TaskScheduler::TaskGroup& writeTasks()
+    {
+        static TaskScheduler::TaskGroup group;
+        return group;
+    }
+
+    // Copies may encode in parallel, but the file must end up holding the latest one
+    std::atomic<quint64> gNextCopy{ 0 };
+    QMutex gFileMutex;
+    quint64 gWrittenCopy = 0;  // guarded by gFileMutex
+
+} // namespace
+
+LazyImageMimeData::LazyImageMimeData(const QImage& image, const QString& pngPath)
+    : m_image(image),
+    m_encode(std::make_shared<Encode>())
+{
+    std::shared_ptr<Encode> encode = m_encode;
+    const quint64 copy = ++gNextCopy;
+    TaskScheduler::TaskOptions options;
+    options.group = writeTasks();
+    // A paste may be waiting for the PNG, so this ranks with interactive work
+    TaskScheduler::instance().submit(TaskScheduler::Priority::InteractiveFilter, [encode, image, pngPath, copy]() {
+        QElapsedTimer timer;
+        timer.start();
+        QByteArray png;
+        QBuffer buffer(&png);
+        buffer.open(QIODevice::WriteOnly);
+        if (!ImageEncoders::writePngFast(image, &buffer)) {
+            qWarning() << "[LazyImageMimeData] PNG encode failed";
+            png.clear();
+        }
+        const qint64 encodeMs = timer.elapsed();
+        {
+            QMutexLocker locker(&encode->mutex);
+            encode->png = png;
+            encode->finished = true;
+            encode->done.wakeAll();
+        }
+
+        // The clipboard is served already; now the copy on disk
+        if (pngPath.isEmpty() || png.isEmpty()) return;
+        QMutexLocker fileLocker(&gFileMutex);
+        if (copy < gWrittenCopy) return;  // a later copy is on disk already
+        gWrittenCopy = copy;
+        QDir().mkpath(QFileInfo(pngPath).absolutePath());
+        QSaveFile file(pngPath);
+        if (!file.open(QIODevice::WriteOnly) || file.write(png) != png.size() || !file.commit()) {
+            qWarning() << "[LazyImageMimeData] Failed to save the displayed image to" << pngPath;
+            return;
+        }
+        qDebug() << "[LazyImageMimeData] Encoded in" << encodeMs << "ms, saved to" << pngPath;
+        }, options);
+}
+
+QStringList LazyImageMimeData::formats() const
+{
+    return { kImageMime, kPngMime };
+}
+
+bool LazyImageMimeData::hasFormat(const QString& mimeType) const
+{
+    return mimeType == kImageMime || mimeType == kPngMime;
+}
+
+QByteArray LazyImageMimeData::png() const
+{
+    QMutexLocker locker(&m_encode->mutex);
+    while (!m_encode->finished) {
+        m_encode->done.wait(&m_encode->mutex);
+    }
+    return m_encode->png;
+}
+
+void LazyImageMimeData::waitForWrites()
+{
+    writeTasks().wait();
+}
+
+QVariant LazyImageMimeData::retrieveData(const QString& mimeType, QMetaType type) const
+{
+    if (mimeType == kImageMime)
+        return m_image;
+    if (mimeType == kPngMime)
+        return png();
+    return QMimeData::retrieveData(mimeType, type);
+}
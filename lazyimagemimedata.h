@@ -0,0 +1,55 @@
+// lazyimagemimedata.h
+
+#ifndef LAZYIMAGEMIMEDATA_H
+#define LAZYIMAGEMIMEDATA_H
+
+#include <QMimeData>
+#include <QImage>
+#include <QMutex>
+#include <QWaitCondition>
+#include <memory>
+
+/*!
+ * \brief The LazyImageMimeData class puts an image on the clipboard without encoding it up front.
+ *
+ *        The raw image is offered as Qt's image format (the platform converts it to DIB etc.
+ *        only when a consumer asks). The PNG is encoded once on the TaskScheduler: that one
+ *        encode answers "image/png" requests and, when a path is given, is also written to
+ *        disk. A consumer asking for PNG before the encode is done waits for it rather than
+ *        encoding a second time.
+ */
+class LazyImageMimeData : public QMimeData
+{
+    Q_OBJECT
+public:
+    /*!
+     * \param image The image to offer; QImage is implicitly shared, so this doesn't copy pixels.
+     * \param pngPath If not empty, the PNG is also written there (off the GUI thread).
+     */
+    explicit LazyImageMimeData(const QImage& image, const QString& pngPath = QString());
+
+    QStringList formats() const override;
+    bool hasFormat(const QString& mimeType) const override;
+
+    // The encoded PNG; blocks until the background encode is done
+    QByteArray png() const;
+
+    // Blocks until every PNG file queued so far is on disk
+    static void waitForWrites();
+
+protected:
+    QVariant retrieveData(const QString& mimeType, QMetaType type) const override;
+
+private:
+    struct Encode {
+        QMutex mutex;
+        QWaitCondition done;
+        bool finished = false;
+        QByteArray png;
+    };
+
+    QImage m_image;
+    std::shared_ptr<Encode> m_encode;  // shared with the worker, which may outlive the clipboard data
+};
+
+#endif // LAZYIMAGEMIMEDATA_H
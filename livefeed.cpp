@@ -0,0 +1,148 @@
+// livefeed.cpp
+
+#include "livefeed.h"
+
+#include <QDebug>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <cstring>
+#include <new>
+
+namespace {
+    const qint64 kCapacityStep = 1 << 20;    // segments are sized to the frame, in whole MB
+    const qint64 kDataAlignment = 64;
+    const int kMaxSegmentAttempts = 16;      // keys taken by stale segments are skipped
+
+    static_assert(std::atomic<quint64>::is_always_lock_free, "the generation must be lock-free across processes");
+
+    qint64 dataOffset()
+    {
+        return (static_cast<qint64>(sizeof(LiveFeed::Header)) + kDataAlignment - 1) / kDataAlignment * kDataAlignment;
+    }
+}
+
+LiveFeed::LiveFeed(const QString& name, QObject* parent)
+    : QObject(parent),
+    m_name(name),
+    m_server(new QLocalServer(this))
+{
+    // A server left behind by a crashed instance would block listen() on Unix
+    QLocalServer::removeServer(m_name);
+    if (!m_server->listen(m_name))
+        qWarning() << "[LiveFeed] Cannot listen on" << m_name << ":" << m_server->errorString();
+    connect(m_server, &QLocalServer::newConnection, this, &LiveFeed::onNewConnection);
+}
+
+LiveFeed::~LiveFeed()
+{
+    if (m_memory.isAttached()) m_memory.detach();
+}
+
+QString LiveFeed::defaultName()
+{
+    return "ReferencePickerLiveFeed";
+}
+
+bool LiveFeed::isListening() const
+{
+    return m_server->isListening();
+}
+
+QString LiveFeed::segmentKey() const
+{
+    return m_memory.isAttached() ? m_memory.nativeKey() : QString();
+}
+
+void LiveFeed::publish(const QImage& image)
+{
+    if (image.isNull() || m_clients.isEmpty()) return;
+
+    // Two 32-bit formats only, so consumers don't have to handle Qt's whole list
+    const QImage::Format format = image.hasAlphaChannel() ? QImage::Format_ARGB32 : QImage::Format_RGB32;
+    const QImage frame = image.format() == format ? image : image.convertToFormat(format);
+    const qint64 bytes = frame.sizeInBytes();
+    if (!ensureCapacity(bytes)) return;
+
+    Header* h = header();
+    const quint64 generation = h->generation.load(std::memory_order_relaxed);
+    h->generation.store(generation + 1, std::memory_order_relaxed);  // odd: readers back off
+    std::atomic_thread_fence(std::memory_order_release);
+
+    h->width = frame.width();
+    h->height = frame.height();
+    h->bytesPerLine = static_cast<qint32>(frame.bytesPerLine());
+    h->format = static_cast<qint32>(format);
+    h->dataSize = static_cast<quint64>(bytes);
+    std::memcpy(static_cast<char*>(m_memory.data()) + h->dataOffset, frame.constBits(), static_cast<size_t>(bytes));
+
+    m_generation = generation + 2;
+    h->generation.store(m_generation, std::memory_order_release);
+    m_width = frame.width();
+    m_height = frame.height();
+
+    const QByteArray message = frameMessage();
+    for (QLocalSocket* client : m_clients) {
+        client->write(message);
+    }
+}
+
+bool LiveFeed::ensureCapacity(qint64 bytes)
+{
+    if (m_memory.isAttached() && static_cast<qint64>(header()->capacity) >= bytes) return true;
+
+    // Segments can't grow: make a new one under the next key
+    const qint64 capacity = (bytes + kCapacityStep - 1) / kCapacityStep * kCapacityStep;
+    if (m_memory.isAttached()) m_memory.detach();
+    for (int attempt = 0; attempt < kMaxSegmentAttempts; ++attempt) {
+        m_memory.setNativeKey(QString("%1-%2").arg(m_name).arg(++m_segmentIndex));
+        if (m_memory.create(static_cast<qsizetype>(dataOffset() + capacity))) {
+            Header* h = new (m_memory.data()) Header;
+            h->magic = Magic;
+            h->version = Version;
+            h->generation.store(m_generation, std::memory_order_relaxed);  // stays monotonic across segments
+            h->width = h->height = h->bytesPerLine = h->format = 0;
+            h->dataOffset = static_cast<quint64>(dataOffset());
+            h->dataSize = 0;
+            h->capacity = static_cast<quint64>(capacity);
+            qDebug() << "[LiveFeed] Created segment" << m_memory.nativeKey() << "with" << capacity / (1024 * 1024) << "MB";
+            return true;
+        }
+        if (m_memory.error() != QSharedMemory::AlreadyExists) break;
+    }
+    qWarning() << "[LiveFeed] Cannot create shared memory:" << m_memory.errorString();
+    return false;
+}
+
+void LiveFeed::releaseSegment()
+{
+    if (!m_memory.isAttached()) return;
+    qDebug() << "[LiveFeed] Released segment" << m_memory.nativeKey();
+    m_memory.detach();
+    m_width = m_height = 0;
+}
+
+LiveFeed::Header* LiveFeed::header()
+{
+    return static_cast<Header*>(m_memory.data());
+}
+
+QByteArray LiveFeed::frameMessage() const
+{
+    return QString("frame %1 %2 %3 %4\n").arg(m_generation).arg(m_width).arg(m_height).arg(segmentKey()).toUtf8();
+}
+
+void LiveFeed::onNewConnection()
+{
+    while (QLocalSocket* client = m_server->nextPendingConnection()) {
+        m_clients.append(client);
+        connect(client, &QLocalSocket::disconnected, this, [this, client]() {
+            m_clients.removeOne(client);
+            client->deleteLater();
+            if (m_clients.isEmpty()) releaseSegment();
+            });
+        if (m_memory.isAttached())
+            client->write(frameMessage());
+        qDebug() << "[LiveFeed] Consumer connected," << m_clients.size() << "connected";
+        emit consumerConnected();
+    }
+}
@@ -0,0 +1,92 @@
+// livefeed.h
+
+#ifndef LIVEFEED_H
+#define LIVEFEED_H
+
+#include <QObject>
+#include <QImage>
+#include <QList>
+#include <QSharedMemory>
+#include <QString>
+#include <atomic>
+
+class QLocalServer;
+class QLocalSocket;
+
+/*!
+ * \brief The LiveFeed class publishes the displayed frame to other processes on the same
+ *        machine through shared memory, so they don't have to poll PNGs in the shared folder.
+ *
+ *        The segment (native key, e.g. a file mapping name on Windows) starts with a Header
+ *        followed by the raw pixels. The generation counter works as a seqlock: it is odd
+ *        while a frame is being written, so a reader copies (or uses) the pixels between two
+ *        reads of an even, unchanged generation, without any lock.
+ *
+ *        A local socket server with the same name tells consumers about every new frame with
+ *        a line "frame <generation> <width> <height> <key>\n" (also sent right after they
+ *        connect). When a bigger frame doesn't fit, a new segment with a new key is created;
+ *        the old one stays valid for consumers that are still attached to it.
+ *
+ *        Nothing is copied while no consumer is connected: publish() returns at once, the
+ *        segment is released when the last consumer disconnects, and consumerConnected() asks
+ *        the owner to publish the current frame for the newcomer.
+ */
+class LiveFeed : public QObject
+{
+    Q_OBJECT
+public:
+    struct Header {
+        quint32 magic;                    // 'RPLF'
+        quint32 version;                  // 1
+        std::atomic<quint64> generation;  // even: stable, odd: being written
+        qint32 width;
+        qint32 height;
+        qint32 bytesPerLine;
+        qint32 format;                    // QImage::Format: RGB32/ARGB32 (B, G, R, A bytes on little-endian)
+        quint64 dataOffset;               // from the start of the segment
+        quint64 dataSize;
+        quint64 capacity;                 // bytes available for pixels
+    };
+
+    static const quint32 Magic = 0x464C5052;  // "RPLF"
+    static const quint32 Version = 1;
+
+    explicit LiveFeed(const QString& name = defaultName(), QObject* parent = nullptr);
+    ~LiveFeed() override;
+
+    static QString defaultName();
+
+    // False if the local server couldn't listen (shared memory may still work)
+    bool isListening() const;
+
+    // Native key of the current segment; empty until the first frame
+    QString segmentKey() const;
+
+    // Copies the frame into shared memory and notifies the connected consumers (if any)
+    void publish(const QImage& image);
+
+    quint64 generation() const { return m_generation; }
+    int consumerCount() const { return m_clients.size(); }
+
+signals:
+    // A consumer connected; publish the current frame so it has something to show
+    void consumerConnected();
+
+private:
+    bool ensureCapacity(qint64 bytes);
+    void releaseSegment();
+    Header* header();
+    QByteArray frameMessage() const;
+    void onNewConnection();
+
+    const QString m_name;
+    QSharedMemory m_memory;
+    int m_segmentIndex = 0;
+    QLocalServer* m_server;
+    QList<QLocalSocket*> m_clients;
+    quint64 m_generation = 0;
+    int m_width = 0;
+    int m_height = 0;
+};
+
+#endif // LIVEFEED_H
@@ -1,1128 +1,1736 @@
-#include "mainwindow.h"
-#include "zoomablegraphicsview.h"
-#include "imageutils.h"    // For image processing utilities
-
-#include <QPushButton>
-#include <QVBoxLayout>
-#include <QHBoxLayout>
-#include <QFileDialog>
-#include <QDir>
-#include <QDirIterator>
-#include <QRandomGenerator>
-#include <QGraphicsScene>
-#include <QMessageBox>
-#include <QClipboard>
-#include <QMimeData>
-#include <QDesktopServices>
-#include <QUrl>
-#include <QProcess>
-#include <QTimer>
-#include <QCheckBox>
-#include <QSpinBox>
-#include <QLabel>
-#include <QMenu>
-#include <QDebug>
-#include <random>
-#include <algorithm>
-#include <QApplication>
-#include <settingsdialog.h>
-#include "settingsdialog.h"
-#include "imageutils.h"
-#include <imageutils.h>
-
-// Example of a small custom QSpinBox for convenience
-class SelectAllSpinBox : public QSpinBox
-{
-public:
-    SelectAllSpinBox(QWidget* parent = nullptr) : QSpinBox(parent)
-    {
-        setFocusPolicy(Qt::ClickFocus);
-    }
-
-protected:
-    void mousePressEvent(QMouseEvent* event) override
-    {
-        QSpinBox::mousePressEvent(event);
-        this->selectAll();
-    }
-};
-
-MainWindow::MainWindow(QWidget* parent)
-    : QWidget(parent),
-    m_countdownTimer(new QTimer(this)),
-    isTimerRunning(false),
-    countdownTime(QTime(0, 10, 0)),
-    scheduleActive(false),
-    m_copyPasteEnabled(false),
-    m_isGrayscale(false),
-    m_isPosterized(false),
-    m_isBlurred(false),
-    m_isMedianFiltered(false),
-    currentScheduleIndex(0),
-    m_originalPixmapItem(nullptr),
-    m_grayscalePixmapItem(nullptr),
-    m_view(nullptr)
-{
-
-    // Initialize m_actionNameMap
-    m_actionNameMap[Action::OpenDirectory] = "Open Directory";
-    m_actionNameMap[Action::History] = "History";
-    m_actionNameMap[Action::NextImage] = "Next Image";
-
-    // Window on top
-    setWindowFlags(windowFlags() | Qt::WindowStaysOnTopHint);
-
-    // Accept drops
-    setAcceptDrops(true);
-
-    // Suppose:
-    m_actionKeyMap[Action::OpenDirectory] = Qt::Key_O;    // 'O' for open
-    m_actionKeyMap[Action::History] = Qt::Key_H;
-    m_actionKeyMap[Action::NextImage] = Qt::Key_Minus;
-    m_actionKeyMap[Action::Flip] = Qt::Key_F;
-    m_actionKeyMap[Action::Grayscale] = Qt::Key_G;
-    // etc. add more for each button
-
-    // Build the reverse map:
-    m_keyActionMap.clear();
-    for (auto it = m_actionKeyMap.cbegin(); it != m_actionKeyMap.cend(); ++it) {
-        const Action action = it.key();
-        const int key = it.value();
-        m_keyActionMap[key] = action;
-    }
-
-    // Initialize m_timeButton as a member variable
-    m_timeButton = new QPushButton(countdownTime.toString("hh:mm:ss"), this);
-    m_timeButton->setToolTip("Start/Stop Timer");
-    m_timeButton->setStyleSheet("QPushButton { color: red; }"); // Initial color
-    connect(m_timeButton, &QPushButton::clicked, this, [this]() {
-        // Toggle the timer running/stopped
-        if (isTimerRunning) {
-            // Stop
-            m_countdownTimer->stop();
-            m_timeButton->setStyleSheet("color: red;");
-            qDebug() << "Timer stopped.";
-        }
-        else {
-            // Start
-            m_countdownTimer->start(1000); // every second
-            m_timeButton->setStyleSheet("color: white;");
-            qDebug() << "Timer started.";
-        }
-        isTimerRunning = !isTimerRunning;
-        });
-
-    // Apply a global dark theme style sheet
-    qApp->setStyleSheet(R"(
-        QWidget {
-            background-color: gray;
-            color: black;
-            font: 18px 'Segoe UI';
-        }
-        QPushButton {
-            background-color: #3E3E3E;
-            color: #FFFFFF;
-            border: none;
-            border-radius: 6px;
-            padding: 6px;
-            min-width: 40px;
-            min-height: 40px;
-        }
-        QPushButton:hover {
-            background-color: #505050;
-        }
-        QPushButton:pressed {
-            background-color: #1E1E1E;
-        }
-        QSpinBox, QCheckBox, QComboBox, QLineEdit {
-            background-color: #3E3E3E;
-            border: 1px solid #555;
-            border-radius: 4px;
-            padding: 2px;
-            color: #FFFFFF;
-        }
-        QGroupBox {
-            border: 1px solid #666;
-            border-radius: 6px;
-            margin-top: 6px;
-            font: bold 18px 'Segoe UI';
-        }
-        QGroupBox::title {
-            subcontrol-origin: margin;
-            subcontrol-position: top center;
-            padding: 2px 10px;
-            background-color: #2D2D2D;
-            color: #FFFFFF;
-            border-radius: 4px;
-        }
-        QLabel {
-            font: 18px 'Segoe UI';
-        }
-    )");
-
-    // UI Layout
-    QVBoxLayout* mainLayout = new QVBoxLayout(this);
-    QHBoxLayout* buttonLayout1 = new QHBoxLayout;
-    QHBoxLayout* buttonLayout2 = new QHBoxLayout;
-
-    // ----- Row 1 Buttons -----
-
-    QPushButton* openButton = new QPushButton("📂");
-    connect(openButton, &QPushButton::clicked, this, [this]() {
-        performAction(Action::OpenDirectory);
-        });
-    buttonLayout1->addWidget(openButton);
-
-    QPushButton* historyButton = new QPushButton("📜");
-    connect(historyButton, &QPushButton::clicked, this, [this]() {
-        performAction(Action::History);
-        });
-    buttonLayout1->addWidget(historyButton);
-
-    QPushButton* nextButton = new QPushButton("➡️");
-    connect(nextButton, &QPushButton::clicked, this, &MainWindow::onNextButtonClicked);
-    buttonLayout1->addWidget(nextButton);
-    
-
-    QPushButton* flipButton = new QPushButton("🔄");
-    connect(flipButton, &QPushButton::clicked, this, &MainWindow::onFlipButtonClicked);
-    buttonLayout1->addWidget(flipButton);
-
-    QPushButton* grayscaleButton = new QPushButton("⚫⚪");
-    connect(grayscaleButton, &QPushButton::clicked, this, &MainWindow::onGrayscaleButtonClicked);
-    buttonLayout1->addWidget(grayscaleButton);
-
-    buttonLayout1->addWidget(m_timeButton);
-
-    // Timer UI (example)
-    // Attempt to load "countdownTime" from settings
-    const QString ctime = settings.value("countdownTime", "00:10:00").toString();
-    countdownTime = QTime::fromString(ctime, "hh:mm:ss");
-    // Or if invalid, fallback to QTime(0,10)
-    if (!countdownTime.isValid()) {
-        countdownTime = QTime(0, 10);
-    }
-
-    // Load the action key map
-    QVariantMap actionKeyMapVariant = settings.value("actionKeyMap").toMap();
-    for (auto it = actionKeyMapVariant.cbegin(); it != actionKeyMapVariant.cend(); ++it) {
-        m_actionKeyMap[static_cast<Action>(it.key().toInt())] = it.value().toInt();
-    }
-    qDebug() << "Loaded action key map:" << actionKeyMapVariant;
-
-
-    // Rebuild the reverse map
-    m_keyActionMap.clear();
-    for (auto it = m_actionKeyMap.cbegin(); it != m_actionKeyMap.cend(); ++it) {
-        m_keyActionMap[it.value()] = it.key();
-    }
-
-    // Create and configure the hours spin box
-    SelectAllSpinBox* hoursSpinBox = new SelectAllSpinBox;
-    hoursSpinBox->setRange(0, 23);
-    hoursSpinBox->setValue(0);
-    hoursSpinBox->setFixedWidth(50); // Set fixed width
-    buttonLayout1->addWidget(hoursSpinBox);
-
-    // Create and configure the minutes spin box
-    SelectAllSpinBox* minutesSpinBox = new SelectAllSpinBox;
-    minutesSpinBox->setRange(0, 59);
-    minutesSpinBox->setValue(10);
-    minutesSpinBox->setFixedWidth(50); // Set fixed width
-    buttonLayout1->addWidget(minutesSpinBox);
-
-    // Create and configure the seconds spin box
-    SelectAllSpinBox* secondsSpinBox = new SelectAllSpinBox;
-    secondsSpinBox->setRange(0, 59);
-    secondsSpinBox->setValue(0);
-    secondsSpinBox->setFixedWidth(50); // Set fixed width
-    buttonLayout1->addWidget(secondsSpinBox);
-
-    // Master "Start Timer" Button
-    startTimerButton = new QPushButton("Start");
-    connect(startTimerButton, &QPushButton::clicked, this, [this, hoursSpinBox, minutesSpinBox, secondsSpinBox]() {
-        // Set the countdown time based on spin boxes
-        this->countdownTime.setHMS(hoursSpinBox->value(), minutesSpinBox->value(), secondsSpinBox->value());
-        // **Store the default countdown time**
-        this->m_defaultCountdownTime = this->countdownTime;
-        // Update the timer button display
-        m_timeButton->setText(this->countdownTime.toString("hh:mm:ss"));
-        qDebug() << "Timer set to: " << this->countdownTime.toString("hh:mm:ss");
-        // **Start the timer automatically**
-        if (!isTimerRunning) {
-            m_timeButton->click(); // This will start the timer
-        }
-        });
-    buttonLayout1->addWidget(startTimerButton);
-
-    // Toggle row 2
-    QPushButton* toggleButton = new QPushButton("Toggle");
-    connect(toggleButton, &QPushButton::clicked, this, [buttonLayout2]() {
-        bool isVisible = buttonLayout2->itemAt(0)->widget()->isVisible();
-        for (int i = 0; i < buttonLayout2->count(); ++i) {
-            QWidget* w = buttonLayout2->itemAt(i)->widget();
-            if (w) w->setVisible(!isVisible);
-        }
-        });
-    buttonLayout1->addWidget(toggleButton);
-
-    // ----- Row 2 Buttons -----
-    QPushButton* startScheduleButton = new QPushButton("📅");
-    connect(startScheduleButton, &QPushButton::clicked, this, &MainWindow::startSchedule);
-    buttonLayout2->addWidget(startScheduleButton);
-
-    QPushButton* editScheduleButton = new QPushButton("📝📅");
-    connect(editScheduleButton, &QPushButton::clicked, this, &MainWindow::editSchedule);
-    buttonLayout2->addWidget(editScheduleButton);
-
-    QPushButton* rotateClockwiseButton = new QPushButton("↩️");
-    connect(rotateClockwiseButton, &QPushButton::clicked, this, [this]() {
-        if (m_view) m_view->rotate(10);
-        });
-    buttonLayout2->addWidget(rotateClockwiseButton);
-
-    QPushButton* rotateCounterclockwiseButton = new QPushButton("↪️");
-    connect(rotateCounterclockwiseButton, &QPushButton::clicked, this, [this]() {
-        if (m_view) m_view->rotate(-10);
-        });
-    buttonLayout2->addWidget(rotateCounterclockwiseButton);
-
-    QPushButton* posterizeButton = new QPushButton("🖼️");
-    buttonLayout2->addWidget(posterizeButton);
-
-    QSpinBox* levelsSpinBox = new QSpinBox;
-    levelsSpinBox->setRange(1, 100);
-	levelsSpinBox->setValue(3);
-    buttonLayout2->addWidget(levelsSpinBox);
-
-    // Connect the posterize button to trigger posterization using the spinbox's current value
-    connect(posterizeButton, &QPushButton::clicked, this, [this, levelsSpinBox]() {
-        int levels = levelsSpinBox->value();
-        onPosterizeButtonClicked(levels);
-        });
-
-    // Connect the spinbox value change to update the posterized image
-    connect(levelsSpinBox, QOverload<int>::of(&QSpinBox::valueChanged), this, [this](int levels) {
-        if (m_isPosterized) {
-            applyPosterization(levels);
-        }
-        });
-
-    QPushButton* blurButton = new QPushButton("💧");
-    connect(blurButton, &QPushButton::clicked, this, &MainWindow::onDegradeButtonClicked);
-    buttonLayout2->addWidget(blurButton);
-
-    QPushButton* medianFilterButton = new QPushButton("📊");
-    connect(medianFilterButton, &QPushButton::clicked, this, &MainWindow::onMedianFilterButtonClicked);
-    buttonLayout2->addWidget(medianFilterButton);
-
-    QPushButton* toggleLinesButton = new QPushButton("📏");
-    connect(toggleLinesButton, &QPushButton::clicked, this, [this]() {
-        if (m_view) {
-            bool isVisible = m_view->areLinesVisible();
-            m_view->setLinesVisibility(!isVisible);
-        }
-        });
-    buttonLayout2->addWidget(toggleLinesButton);
-
-    QPushButton* copyRulerButton = new QPushButton("📏⬆️", this);
-    connect(copyRulerButton, &QPushButton::clicked, this, [this]() {
-        if (!m_view) return;
-
-        // 1) Ensure the ruler lines are visible.
-        m_view->setLinesVisibility(true);
-
-        // 2) Create the folder in the system temporary directory.
-        QString tempFolder = QDir::tempPath();  // system temp folder
-        QString folderPath = QDir(tempFolder).filePath("ruler_images");
-        QDir().mkpath(folderPath);
-
-        // 3) Build the file path for the ruler image.
-        QString rulerFilePath = QDir(folderPath).filePath("ruler_image.png");
-
-        // 4) Tell the view to save just the ruler lines to that file.
-        m_view->saveRulerImage(rulerFilePath);
-
-        // 5) Store this path in a member variable.
-        m_tempRulerFilePath = rulerFilePath;
-        qDebug() << "Saved ruler lines to" << rulerFilePath;
-
-        // 6) Refresh the custom JSX script path from settings.
-        refreshCustomJSXPath();  // This should update m_customJSXPath from QSettings.
-        QString scriptPath;
-        if (!m_customJSXPath.isEmpty()) {
-            scriptPath = m_customJSXPath;
-            qDebug() << "Using custom JSX script path:" << scriptPath;
-        }
-        else {
-            qDebug() << "No custom JSX script path is set. Cannot launch JSX script.";
-            return; // Exit early if no custom JSX file is available.
-        }
-
-        // 7) Build the argument list for cmd.exe using the "start" command.
-        // The command syntax: cmd.exe /C start "" <scriptPath>
-        QStringList args;
-        args << "/C" << "start" << "" << scriptPath;
-        qDebug() << "Launching JSX script using cmd.exe with args:" << args;
-
-        // 8) Launch the JSX file using cmd.exe.
-        bool processStarted = QProcess::startDetached("cmd.exe", args);
-        if (processStarted) {
-            qDebug() << "JSX script launched successfully.";
-        }
-        else {
-            qDebug() << "Failed to launch JSX script.";
-        }
-        });
-    buttonLayout2->addWidget(copyRulerButton);
-
-
-
-    QPushButton* settingsButton = new QPushButton("⚙️");
-    buttonLayout2->addWidget(settingsButton);
-    connect(settingsButton, &QPushButton::clicked, this, &MainWindow::onSettingsButtonClicked);
-
-    QPushButton* copyDisplayedButton = new QPushButton("📋🖼️");
-    buttonLayout2->addWidget(copyDisplayedButton);
-    connect(copyDisplayedButton, &QPushButton::clicked, this, [this]() {
-        // 1) Decide which pixmap is currently shown.
-        //    If you do grayscale by showing/hiding m_grayscalePixmapItem, check isVisible().
-        QPixmap displayedPixmap;
-        if (m_grayscalePixmapItem && m_grayscalePixmapItem->isVisible()) {
-            // The grayscale item is visible.
-            displayedPixmap = m_grayscalePixmapItem->pixmap();
-        }
-        else if (m_originalPixmapItem) {
-            // The "Original" item (which might be blurred, median, or posterized in your code).
-            displayedPixmap = m_originalPixmapItem->pixmap();
-        }
-        else {
-            QMessageBox::warning(this, "Error", "No image is currently displayed.");
-            return;
-        }
-
-        // 2) Remove any old temp file.
-        if (!m_tempDisplayedFilePath.isEmpty()) {
-            QFile::remove(m_tempDisplayedFilePath);
-            m_tempDisplayedFilePath.clear();
-        }
-
-        // 3) Construct a path in the system temporary directory.
-        QString folderPath = QDir::tempPath() + "/displayed_image";  // Portable temp folder
-        QDir().mkpath(folderPath);
-        m_tempDisplayedFilePath = folderPath + "/current_image.png";
-
-        // 4) Save the displayed image to this path.
-        bool ok = displayedPixmap.save(m_tempDisplayedFilePath);
-        if (!ok) {
-            QMessageBox::warning(this, "Error", "Failed to save the displayed image.");
-            return;
-        }
-
-        // 5) Copy the same pixmap to the system clipboard for paste capability.
-        QClipboard* clipboard = QApplication::clipboard();
-        clipboard->setPixmap(displayedPixmap);
-
-        qDebug() << "Saved displayed image to" << m_tempDisplayedFilePath
-            << "and copied to clipboard.";
-        });
-
-
-    // Add both button rows to the main layout
-    mainLayout->addLayout(buttonLayout1);
-    mainLayout->addLayout(buttonLayout2);
-
-    
-
-    // Create and set up the ZoomableGraphicsView
-    m_view = new ZoomableGraphicsView(this);
-    mainLayout->addWidget(m_view);
-    mainLayout->setContentsMargins(0, 0, 0, 0);
-    mainLayout->setSpacing(0);
-
-    setLayout(mainLayout);
-
-    // Restore settings
-
-    m_customJSXPath = settings.value("customJSXPath").toString();
-    qDebug() << "Loaded custom JSX path:" << m_customJSXPath;
-
-    QStringList scheduleStringList = settings.value("schedule").toStringList();
-    for (const QString& timeString : scheduleStringList) {
-        schedule.append(QTime::fromString(timeString));
-    }
-    qDebug() << "Loaded schedule:" << scheduleStringList;
-
-    restoreGeometry(settings.value("mainWindowGeometry").toByteArray());
-    qDebug() << "Loaded main window geometry.";
-
-    m_directory = settings.value("lastDirectory").toString();
-    qDebug() << "Loaded last directory:" << m_directory;
-
-    directoryHistory = settings.value("directoryHistory").toStringList();
-    qDebug() << "Loaded directory history:" << directoryHistory;
-
-    if (!m_directory.isEmpty()) {
-        setDirectory(m_directory);
-        QTimer::singleShot(100, this, [this]() {
-            loadImageFromDirectory(m_directory);
-            });
-    }
-
-    // Connect Timer
-    connect(m_countdownTimer, &QTimer::timeout, this, [this]() {
-        if (!isTimerRunning) return; // If somehow the timer is on but we don't want to run
-
-        // Subtract 1 second
-        countdownTime = countdownTime.addSecs(-1);
-        m_timeButton->setText(countdownTime.toString("hh:mm:ss"));
-        qDebug() << "Timer tick: " << countdownTime.toString("hh:mm:ss");
-
-        // If time is up
-        if (countdownTime <= QTime(0, 0, 0)) {
-            qDebug() << "Time is up.";
-            // 1) Load new image
-            loadImageFromDirectory(m_directory);
-
-            // 2) If scheduleActive, move to next schedule item
-            if (scheduleActive) {
-                currentScheduleIndex++;
-                startNextTimerInSchedule();
-                // This will set countdownTime to the next item or loop the schedule
-            }
-            else {
-                // **In non-schedule mode, reset the countdown time and continue**
-                countdownTime = m_defaultCountdownTime;
-                m_timeButton->setText(countdownTime.toString("hh:mm:ss"));
-                qDebug() << "Timer reset to default: " << countdownTime.toString("hh:mm:ss");
-                // **No need to stop the timer; it continues running**
-            }
-        }
-        });
-}
-
-
-// ---------------  Destructor ---------------
-MainWindow::~MainWindow()
-{
-    if (!m_tempRulerFilePath.isEmpty()) {
-        QFile::remove(m_tempRulerFilePath);
-    }
-    // ...
-}
-
-
-// ---------------  closeEvent ---------------
-void MainWindow::closeEvent(QCloseEvent* event)
-{
-    // Convert schedule to a QStringList
-    QStringList scheduleStringList;
-    for (const QTime& t : schedule) {
-        scheduleStringList.append(t.toString("hh:mm:ss"));
-    }
-    // Remove the displayed image file if it exists
-    if (!m_tempDisplayedFilePath.isEmpty()) {
-        QFile::remove(m_tempDisplayedFilePath);
-    }
-    // Save settings
-    settings.setValue("schedule", scheduleStringList);
-    qDebug() << "Saved schedule:" << scheduleStringList;
-
-    settings.setValue("mainWindowGeometry", saveGeometry());
-    qDebug() << "Saved main window geometry.";
-
-    settings.setValue("lastDirectory", m_directory);
-    qDebug() << "Saved last directory:" << m_directory;
-
-    settings.setValue("directoryHistory", directoryHistory);
-    qDebug() << "Saved directory history:" << directoryHistory;
-
-    settings.setValue("countdownTime", countdownTime.toString("hh:mm:ss"));
-    qDebug() << "Saved countdown time:" << countdownTime.toString("hh:mm:ss");
-
-    // Save the action key map
-    QVariantMap actionKeyMapVariant;
-    for (auto it = m_actionKeyMap.cbegin(); it != m_actionKeyMap.cend(); ++it) {
-        actionKeyMapVariant.insert(QString::number(static_cast<int>(it.key())), it.value());
-    }
-    settings.setValue("actionKeyMap", actionKeyMapVariant);
-    qDebug() << "Saved action key map:" << actionKeyMapVariant;
-
-    QWidget::closeEvent(event);
-}
-
-// ---------------  Key Press for Shortcuts ---------------
-void MainWindow::keyPressEvent(QKeyEvent* event)
-{
-    int key = event->key();
-
-    // check if there's an action
-    if (m_keyActionMap.contains(key)) {
-        Action action = m_keyActionMap[key];
-        performAction(action);
-    }
-    else if ((key == Qt::Key_V) && (event->modifiers() & Qt::ControlModifier)) {
-        // A special case for Ctrl+V
-        processClipboardImage();
-    }
-    else {
-        QWidget::keyPressEvent(event);
-    }
-}
-
-
-void MainWindow::performAction(Action action)
-{
-    switch (action)
-    {
-    case Action::OpenDirectory:
-        onOpenButtonClicked();  // or the same logic inline
-        break;
-    case Action::History:
-        onHistoryButtonClicked();
-        break;
-    case Action::NextImage:
-        onNextButtonClicked();
-        break;
-    case Action::Flip:
-        onFlipButtonClicked();
-        break;
-    case Action::Grayscale:
-        onGrayscaleButtonClicked();
-        break;
-        // ...
-    case Action::SaveRuler:
-        // The same code you'd run in copyRulerButton clicked-lambda
-        break;
-    case Action::CopyDisplayedImage:
-        // The same code you'd run in your copyDisplayedButton lambda
-        break;
-        // etc. for each Action
-    default:
-        qDebug() << "No matching Action logic.";
-        break;
-    }
-}
-
-
-
-// settings
-void MainWindow::onSettingsButtonClicked()
-{
-    QMap<Action, QString> actionNameMap = {
-        { Action::OpenDirectory, "Open Directory" },
-		{ Action::History, "History" },
-		{ Action::NextImage, "Next Image" },
-		{ Action::Flip, "Flip" },
-		{ Action::Grayscale, "Grayscale" },
-		{ Action::StartSchedule, "Start Schedule" },
-		{ Action::EditSchedule, "Edit Schedule" },
-		{ Action::RotateClockwise, "Rotate Clockwise" },
-		{ Action::RotateCounterclockwise, "Rotate Counterclockwise" },
-		{ Action::Posterize, "Posterize" },
-		{ Action::Blur, "Blur" },
-		{ Action::MedianFilter, "Median Filter" },
-		{ Action::ToggleLines, "Toggle Lines" },
-		{ Action::SaveRuler, "Save Ruler" },
-		{ Action::CopyDisplayedImage, "Copy Displayed Image" },
-		{ Action::ProcessClipboard, "Process Clipboard" },
-        // Add other actions here
-    };
-
-    SettingsDialog dialog(this, actionNameMap);
-    dialog.setKeyMap(m_actionKeyMap);
-    if (dialog.exec() == QDialog::Accepted) {
-        m_actionKeyMap = dialog.getKeyMap();
-        // Rebuild the reverse map
-        m_keyActionMap.clear();
-        for (auto it = m_actionKeyMap.cbegin(); it != m_actionKeyMap.cend(); ++it) {
-            m_keyActionMap[it.value()] = it.key();
-        }
-    }
-}
-
-
-void MainWindow::refreshCustomJSXPath() {
-    QSettings settings("YourCompany", "YourApp");
-    m_customJSXPath = settings.value("customJSXPath").toString();
-    qDebug() << "Refreshed custom JSX path:" << m_customJSXPath;
-}
-
-// ---------------  Directory Setup ---------------
-void MainWindow::setDirectory(const QString& directory)
-{
-    m_directory = directory;
-    directoryHistory.removeAll(directory);
-    directoryHistory.prepend(directory);
-
-    if (directoryHistory.size() > 10) {
-        directoryHistory.removeLast();
-    }
-
-    settings.setValue("lastDirectory", m_directory);
-    settings.setValue("directoryHistory", directoryHistory);
-
-    // Populate files
-    m_files.clear();
-    QDirIterator it(directory, QStringList()
-        << "*.jpg" << "*.jpeg" << "*.png" << "*.bmp" << "*.gif" << "*.webp",
-        QDir::Files, QDirIterator::Subdirectories);
-    while (it.hasNext()) {
-        it.next();
-        m_files << it.fileInfo();
-    }
-
-    // Shuffle
-    std::random_device rd;
-    std::mt19937 g(rd());
-    std::shuffle(m_files.begin(), m_files.end(), g);
-
-    m_currentIndex = 0;
-}
-
-QString MainWindow::getRandomImage(const QString& directory)
-{
-    Q_UNUSED(directory);
-    if (m_currentIndex >= m_files.size()) {
-        // reshuffle
-        std::random_device rd;
-        std::mt19937 g(rd());
-        std::shuffle(m_files.begin(), m_files.end(), g);
-        m_currentIndex = 0;
-    }
-    if (m_files.isEmpty()) {
-        return QString();
-    }
-    return m_files[m_currentIndex++].filePath();
-}
-
-// ---------------  Slots ---------------
-void MainWindow::onOpenButtonClicked()
-{
-    QString directory = QFileDialog::getExistingDirectory(this, "Open Directory");
-    if (!directory.isEmpty()) {
-        setDirectory(directory);
-        loadImageFromDirectory(directory);
-    }
-}
-
-void MainWindow::onHistoryButtonClicked()
-{
-    QMenu menu;
-    for (const QString& directory : directoryHistory) {
-        menu.addAction(directory, this, [this, directory]() {
-            setDirectory(directory);
-            loadImageFromDirectory(directory);
-            });
-    }
-    menu.exec(QCursor::pos());
-}
-
-void MainWindow::onNextButtonClicked()
-{
-    if (m_directory.isEmpty()) return;
-
-    QMessageBox::StandardButton reply = QMessageBox::question(
-        this,
-        "Confirmation",
-        "Are you sure you want to load the next image?",
-        QMessageBox::Yes | QMessageBox::No
-    );
-
-    if (reply == QMessageBox::Yes) {
-        if (scheduleActive) {
-            // 1) Manually skip the countdown. That means we treat the current
-            //    countdown as finished. We load the image:
-            loadImageFromDirectory(m_directory);
-
-            // 2) Move on to the next schedule item
-            currentScheduleIndex++;
-            // 3) Start the next timer in schedule
-            startNextTimerInSchedule();
-        }
-        else {
-            // No schedule: normal behavior
-            loadImageFromDirectory(m_directory);
-        }
-    }
-}
-
-
-void MainWindow::onFlipButtonClicked()
-{
-    if (!m_originalPixmapItem || !m_grayscalePixmapItem) return;
-
-    // Flip original
-    QImage origImg = m_originalPixmapItem->pixmap().toImage().mirrored(true, false);
-    m_originalPixmapItem->setPixmap(QPixmap::fromImage(origImg));
-
-    // Flip grayscale
-    QImage grayImg = m_grayscalePixmapItem->pixmap().toImage().mirrored(true, false);
-    m_grayscalePixmapItem->setPixmap(QPixmap::fromImage(grayImg));
-}
-
-void MainWindow::onGrayscaleButtonClicked()
-{
-    if (!m_originalPixmapItem || !m_grayscalePixmapItem) return;
-    bool grayVisible = m_grayscalePixmapItem->isVisible();
-
-    m_originalPixmapItem->setVisible(grayVisible);
-    m_grayscalePixmapItem->setVisible(!grayVisible);
-
-    if (!grayVisible && m_copyPasteEnabled) {
-        // If turning on grayscale and copy/paste is enabled, save grayscale
-        QImage grayscaleImg = m_grayscalePixmapItem->pixmap().toImage();
-        saveImageToSharedFolder(grayscaleImg, "grayscale_shared");
-    }
-}
-
-// New method to apply posterization
-void MainWindow::applyPosterization(int levels)
-{
-    if (!m_originalPixmapItem || !m_grayscalePixmapItem) return;
-
-    // Use the original image for posterization
-    QImage orig = m_originalPixmap.toImage();
-    QImage posterizedOrig = ImageUtils::posterize(orig, levels);
-
-    QImage posterGray = ImageUtils::convertToGrayscale(posterizedOrig);
-
-    m_originalPixmapItem->setPixmap(QPixmap::fromImage(posterizedOrig));
-    m_grayscalePixmapItem->setPixmap(QPixmap::fromImage(posterGray));
-
-    if (m_copyPasteEnabled) {
-        saveImageToSharedFolder(posterizedOrig, "posterized");
-        saveImageToSharedFolder(posterGray, "posterized_grayscale");
-    }
-}
-
-// Updated method to toggle posterization state
-void MainWindow::onPosterizeButtonClicked(int levels)
-{
-    if (!m_originalPixmapItem || !m_grayscalePixmapItem) return;
-
-    if (!m_isPosterized) {
-        applyPosterization(levels);
-        m_isPosterized = true;
-    }
-    else {
-        // Revert to original images
-        m_originalPixmapItem->setPixmap(m_originalPixmap);
-        m_grayscalePixmapItem->setPixmap(m_grayscalePixmap);
-        m_isPosterized = false;
-    }
-}
-
-void MainWindow::onDegradeButtonClicked()
-{
-    if (!m_originalPixmapItem || !m_grayscalePixmapItem) return;
-
-    if (!m_isBlurred) {
-        // blur
-        QImage orig = m_originalPixmapItem->pixmap().toImage();
-        QImage gray = m_grayscalePixmapItem->pixmap().toImage();
-
-        QImage blurredOrig = ImageUtils::gaussianBlur(orig, 5);
-        QImage blurredGray = ImageUtils::gaussianBlur(gray, 5);
-
-        m_originalPixmapItem->setPixmap(QPixmap::fromImage(blurredOrig));
-        m_grayscalePixmapItem->setPixmap(QPixmap::fromImage(blurredGray));
-
-        m_isBlurred = true;
-    }
-    else {
-        // revert
-        m_originalPixmapItem->setPixmap(m_originalPixmap);
-        m_grayscalePixmapItem->setPixmap(m_grayscalePixmap);
-        m_isBlurred = false;
-    }
-}
-
-void MainWindow::onMedianFilterButtonClicked()
-{
-    if (!m_originalPixmapItem) return;
-
-    if (!m_isMedianFiltered) {
-        QImage orig = m_originalPixmapItem->pixmap().toImage();
-        QImage filtered = ImageUtils::medianFilter(orig);
-        m_originalPixmapItem->setPixmap(QPixmap::fromImage(filtered));
-        m_isMedianFiltered = true;
-    }
-    else {
-        // revert
-        m_originalPixmapItem->setPixmap(m_originalPixmap);
-        m_isMedianFiltered = false;
-    }
-}
-
-void MainWindow::confirmAndMoveFileToDeleteFolder()
-{
-    if (m_currentImagePath.isEmpty()) {
-        QMessageBox::information(this, "No Image", "No image is currently loaded.");
-        return;
-    }
-
-    QMessageBox::StandardButton reply = QMessageBox::question(this, "Confirm Delete",
-        "Are you sure you want to delete this file?", QMessageBox::Yes | QMessageBox::No);
-
-    if (reply == QMessageBox::Yes) {
-        QString deleteFolder = "C:/REFERENCE/test/delete";
-        QDir dir(deleteFolder);
-        if (!dir.exists()) {
-            dir.mkpath(".");
-        }
-        QFileInfo fi(m_currentImagePath);
-        QString newFilePath = deleteFolder + "/" + fi.fileName();
-        if (QFile::rename(m_currentImagePath, newFilePath)) {
-            m_currentImagePath.clear();
-            m_view->scene()->clear();
-            loadImageFromDirectory(m_directory);
-        }
-        else {
-            QMessageBox::critical(this, "Error", "Failed to move the file.");
-        }
-    }
-}
-
-// ---------------  Scheduling  ---------------
-void MainWindow::startSchedule()
-{
-    qDebug() << "Starting schedule...";
-    // If you have multiple schedules, you want to cancel any existing normal timer
-    // or unify them into one approach.
-    isTimerRunning = false;            // Make sure the manual timer is considered off
-    scheduleActive = true;
-
-    if (!schedule.isEmpty()) {
-        currentScheduleIndex = 0;
-        qDebug() << "Schedule is not empty. Starting with the first item.";
-        startNextTimerInSchedule();
-    }
-    else {
-        qDebug() << "Schedule is empty. Nothing to start.";
-    }
-}
-
-void MainWindow::startNextTimerInSchedule()
-{
-    if (currentScheduleIndex < schedule.size()) {
-        qDebug() << "Starting next timer in schedule. Index:" << currentScheduleIndex;
-        // 1) Set countdownTime to the next schedule item
-        countdownTime = schedule[currentScheduleIndex];
-        qDebug() << "Countdown time set to:" << countdownTime.toString("hh:mm:ss");
-
-        // 2) Update m_timeButton text
-        m_timeButton->setText(countdownTime.toString("hh:mm:ss"));
-        qDebug() << "Time button text updated to:" << countdownTime.toString("hh:mm:ss");
-
-        // 3) Start the m_countdownTimer if not already started
-        //    or forcibly restart it
-        //    We'll do forcibly restart to ensure it's counting from the new time
-        m_countdownTimer->stop();  // Stop any old countdown
-        m_countdownTimer->start(1000);
-        qDebug() << "Countdown timer started.";
-
-        // Mark isTimerRunning to true
-        isTimerRunning = true;
-        qDebug() << "Timer is now running.";
-    }
-    else {
-        // All schedule items done
-        qDebug() << "All schedule items are done.";
-        scheduleActive = false;
-        isTimerRunning = false;
-        m_countdownTimer->stop();
-        qDebug() << "Countdown timer stopped.";
-
-        // Optionally reset the m_timeButton to something else
-        m_timeButton->setText("Schedule Done");
-        qDebug() << "Time button text set to 'Schedule Done'.";
-
-        // **Loop the schedule by resetting the index and restarting**
-        currentScheduleIndex = 0;
-        scheduleActive = true;
-        qDebug() << "Restarting schedule.";
-        startNextTimerInSchedule();
-    }
-}
-
-
-#include "scheduledialog.h"  // <--- Make sure this is included
-
-void MainWindow::editSchedule()
-{
-    qDebug() << "Editing schedule...";
-    // Pass the current 'schedule' to the dialog, so it can list it
-    ScheduleDialog dialog(this, schedule);
-    // Show the dialog modally
-    if (dialog.exec() == QDialog::Accepted) {
-        // If user pressed OK, retrieve the new schedule
-        schedule = dialog.getSchedule();
-        qDebug() << "New schedule accepted:" << schedule;
-    }
-    else {
-        qDebug() << "Schedule editing canceled.";
-    }
-}
-
-
-// ---------------  Loading Images  ---------------
-void MainWindow::loadImageFromDirectory(const QString& directory)
-{
-    QString imagePath = getRandomImage(directory);
-    if (imagePath.isEmpty()) {
-        QMessageBox::information(this, "No Image Found", "No image found in directory");
-        return;
-    }
-    processAndDisplayImage(imagePath);
-}
-
-void MainWindow::processAndDisplayImage(const QString& filePath)
-{
-    if (filePath.isEmpty()) return;
-    m_currentImagePath = filePath;
-
-    // (1) Load the cv::Mat
-    cv::Mat mat = ImageUtils::loadAndApplyColorProfile(filePath);
-    if (mat.empty()) {
-        QMessageBox::warning(this, "Image Load Error", "Failed to load image: " + filePath);
-        return;
-    }
-
-    // (2) Convert to QImage, then QPixmap
-    cv::Mat resampled = ImageUtils::lanczosResizeIfNeeded(mat);
-    QImage qimg = ImageUtils::convertMatToQImage(resampled);
-    m_view->scene()->clear();  // Clear old items
-
-    // (3) Create original pixmap
-    QPixmap pixmap = QPixmap::fromImage(qimg);
-    m_originalPixmap = pixmap;
-    m_originalPixmapItem = new QGraphicsPixmapItem(pixmap);
-    m_view->scene()->addItem(m_originalPixmapItem);
-
-    // (4) Create grayscale pixmap
-    QImage grayImg = ImageUtils::convertToGrayscale(qimg);
-    m_grayscalePixmap = QPixmap::fromImage(grayImg);
-    m_grayscalePixmapItem = new QGraphicsPixmapItem(m_grayscalePixmap);
-    m_grayscalePixmapItem->setVisible(false);
-    m_view->scene()->addItem(m_grayscalePixmapItem);
-
-    // (5) Determine the image's bounding rectangle
-    QRectF imageRect = m_originalPixmapItem->boundingRect();
-
-    // (6) Create lines based on imageRect
-    m_view->createAndAddLines(imageRect);
-    m_view->setLinesVisibility(false); // Hide lines initially if desired
-
-    // (7) Save the ruler image after scene setup and before setting large margins
-    QString tempFilePath = QDir::tempPath() + "/ruler_images/ruler_image.png";
-    m_view->saveRulerImage(tempFilePath);
-
-    // (8) Set the scene rectangle to imageRect plus margins for panning
-    qreal margin = 100000.0; // Adjust margin as needed
-    QRectF biggerRect = imageRect.adjusted(-margin, -margin, margin, margin);
-    m_view->scene()->setSceneRect(biggerRect);
-
-    // (9) Reset transformations to start fresh
-    m_view->resetTransform();
-
-    // (10) Fit the image within the view while maintaining aspect ratio
-    m_view->fitInView(imageRect, Qt::KeepAspectRatio);
-
-    // (11) Center the view on the original pixmap item
-    m_view->centerOn(m_originalPixmapItem);
-
-    // (12) Start the countdown timer
-    startTimerButton->click();
-
-    // (13) Save the image to a shared folder if enabled
-    if (m_copyPasteEnabled) {
-        saveImageToSharedFolder(qimg, "suffix");
-    }
-
-    // (14) Reset effect toggles
-    m_isBlurred = false;
-    m_isMedianFiltered = false;
-    m_isPosterized = false;
-    m_isGrayscale = false;
-}
-
-
-void MainWindow::processClipboardImage()
-{
-    QClipboard* clipboard = QApplication::clipboard();
-    const QMimeData* mimeData = clipboard->mimeData();
-    if (mimeData->hasImage()) {
-        QImage image = qvariant_cast<QImage>(mimeData->imageData());
-        processImage(image);
-    }
-    else if (mimeData->hasUrls()) {
-        QList<QUrl> urls = mimeData->urls();
-        if (!urls.isEmpty() && urls.first().isLocalFile()) {
-            processAndDisplayImage(urls.first().toLocalFile());
-        }
-        else {
-            QMessageBox::warning(this, "Error", "Clipboard does not contain a valid image path.");
-        }
-    }
-    else {
-        QMessageBox::warning(this, "Error", "No image found in clipboard.");
-    }
-}
-
-void MainWindow::processImage(const QImage& image)
-{
-    if (image.isNull()) {
-        QMessageBox::warning(this, "Error", "Clipboard does not contain a valid image.");
-        return;
-    }
-    // Save to temp + display
-    QString tempImagePath = QDir::tempPath() + "/tempImage.png";
-    if (image.save(tempImagePath)) {
-        processAndDisplayImage(tempImagePath);
-        if (m_copyPasteEnabled) {
-            saveImageToSharedFolder(image, "suffix");
-        }
-    }
-    else {
-        QMessageBox::warning(this, "Error", "Failed to save the clipboard image to a temporary file.");
-    }
-}
-
-void MainWindow::saveImageToSharedFolder(const QImage& image, const QString& suffix)
-{
-    QString baseName = QFileInfo(m_currentImagePath).completeBaseName();
-    QString folderPath = QString("C:/REFERENCE/Sharing/%1").arg(baseName);
-
-    if (!m_folderCreationTimes.contains(folderPath)) {
-        QDir().mkpath(folderPath);
-        m_folderCreationTimes[folderPath] = QDateTime::currentDateTime();
-        deleteOldestFolderIfNeeded();
-    }
-    QString savePath = QString("%1/%2_%3.png").arg(folderPath).arg(baseName).arg(suffix);
-    if (!image.save(savePath)) {
-        qDebug() << "Failed to save image to" << savePath;
-    }
-}
-
-void MainWindow::deleteOldestFolderIfNeeded()
-{
-    const int maxFolders = 5;
-    if (m_folderCreationTimes.size() > maxFolders) {
-        QString oldestFolder;
-        QDateTime oldestTime = QDateTime::currentDateTime();
-        for (auto it = m_folderCreationTimes.begin(); it != m_folderCreationTimes.end(); ++it) {
-            if (it.key().startsWith("C:/REFERENCE/Sharing") && it.value() < oldestTime) {
-                oldestTime = it.value();
-                oldestFolder = it.key();
-            }
-        }
-        if (!oldestFolder.isEmpty()) {
-            QDir dir(oldestFolder);
-            if (dir.removeRecursively()) {
-                m_folderCreationTimes.remove(oldestFolder);
-                qDebug() << "Deleted oldest folder:" << oldestFolder;
-            }
-        }
-    }
-}
+#include "mainwindow.h"
+#include "zoomablegraphicsview.h"
+#include "imageutils.h"    // For image processing utilities
+#include "imageutilsasync.h"
+#include "directorywatcher.h"
+#include "analysisindex.h"
+#include "ziparchive.h"
+#include "exportwriter.h"
+#include "retentionmanager.h"
+#include "livefeed.h"
+#include "lazyimagemimedata.h"
+#include "profiler.h"
+#include "taskscheduler.h"
+#include "tiledimage.h"
+#include "tiledimageitem.h"
+#include "mappedfile.h"
+
+#include <QPushButton>
+#include <QVBoxLayout>
+#include <QHBoxLayout>
+#include <QFileDialog>
+#include <QDir>
+#include <QDirIterator>
+#include <QRandomGenerator>
+#include <QGraphicsScene>
+#include <QMessageBox>
+#include <QClipboard>
+#include <QMimeData>
+#include <QDesktopServices>
+#include <QUrl>
+#include <QProcess>
+#include <QTimer>
+#include <QCheckBox>
+#include <QSpinBox>
+#include <QLabel>
+#include <QMenu>
+#include <QActionGroup>
+#include <QInputDialog>
+#include <QDebug>
+#include <QCryptographicHash>
+#include <random>
+#include <algorithm>
+#include <QApplication>
+#include <settingsdialog.h>
+#include "settingsdialog.h"
+#include "imageutils.h"
+#include <imageutils.h>
+
+// Example of a small custom QSpinBox for convenience
+class SelectAllSpinBox : public QSpinBox
+{
+public:
+    SelectAllSpinBox(QWidget* parent = nullptr) : QSpinBox(parent)
+    {
+        setFocusPolicy(Qt::ClickFocus);
+    }
+
+protected:
+    void mousePressEvent(QMouseEvent* event) override
+    {
+        QSpinBox::mousePressEvent(event);
+        this->selectAll();
+    }
+};
+
+MainWindow::MainWindow(QWidget* parent)
+    : QWidget(parent),
+    m_countdownTimer(new QTimer(this)),
+    isTimerRunning(false),
+    countdownTime(QTime(0, 10, 0)),
+    scheduleActive(false),
+    m_copyPasteEnabled(false),
+    m_isGrayscale(false),
+    m_isPosterized(false),
+    m_isBlurred(false),
+    m_isMedianFiltered(false),
+    currentScheduleIndex(0),
+    m_originalPixmapItem(nullptr),
+    m_grayscalePixmapItem(nullptr),
+    m_view(nullptr),
+    m_directoryWatcher(new DirectoryWatcher(this)),
+    m_analysisIndex(new AnalysisIndex(m_fileIndex, this)),
+    m_exportWriter(new ExportWriter(8, this)),
+    m_retention(new RetentionManager(this)),
+    m_liveFeed(new LiveFeed(LiveFeed::defaultName(), this))
+{
+    m_directoryWatcher->setKnownFilesProvider([this](const QString& dir) {
+        return m_fileIndex.fileNamesInDirectory(dir);
+        });
+    m_directoryWatcher->setKnownMembersProvider([this](const QString& archivePath) {
+        return m_fileIndex.archiveMemberPaths(archivePath);
+        });
+    connect(m_directoryWatcher, &DirectoryWatcher::filesAdded, this, &MainWindow::onFilesAdded);
+    connect(m_directoryWatcher, &DirectoryWatcher::archiveMembersAdded, this, &MainWindow::onArchiveMembersAdded);
+    connect(m_directoryWatcher, &DirectoryWatcher::filesRemoved, this, &MainWindow::onFilesRemoved);
+    // A finished write may have grown its folder; touch() is thread-safe, so call it directly
+    connect(m_exportWriter, &ExportWriter::written, m_retention, [this](const QString& path) {
+        m_retention->touch(QFileInfo(path).absolutePath());
+        }, Qt::DirectConnection);
+    connect(m_analysisIndex, &AnalysisIndex::finished, this, [this]() {
+        // A stats query skips files that weren't analysed yet for the rest of the cycle;
+        // now that they are, start over so they get their chance. Files added while the
+        // folder is open are probed and analysed at once, after probesFinished.
+        if ((m_pickSkippedUnanalysed && m_pickQuery.usesStats()) || m_pickSkippedUnprobed) {
+            m_pickSkippedUnanalysed = false;
+            m_pickSkippedUnprobed = false;
+            m_pickOrder.reset(m_fileIndex.idCount());
+            saveShuffleState();
+            qDebug() << "Analysis finished, restarted the random order for the pick query";
+        }
+        });
+    connect(m_analysisIndex, &AnalysisIndex::probesFinished, this, [this]() {
+        // Same for a size filter and files whose header wasn't probed yet
+        if (m_pickSkippedUnprobed) {
+            m_pickSkippedUnprobed = false;
+            m_pickOrder.reset(m_fileIndex.idCount());
+            saveShuffleState();
+            qDebug() << "Header probe finished, restarted the random order for the pick filter";
+        }
+        });
+
+    // Initialize m_actionNameMap
+    m_actionNameMap[Action::OpenDirectory] = "Open Directory";
+    m_actionNameMap[Action::History] = "History";
+    m_actionNameMap[Action::NextImage] = "Next Image";
+
+    // Window on top
+    setWindowFlags(windowFlags() | Qt::WindowStaysOnTopHint);
+
+    // Accept drops
+    setAcceptDrops(true);
+
+    // Suppose:
+    m_actionKeyMap[Action::OpenDirectory] = Qt::Key_O;    // 'O' for open
+    m_actionKeyMap[Action::History] = Qt::Key_H;
+    m_actionKeyMap[Action::NextImage] = Qt::Key_Minus;
+    m_actionKeyMap[Action::Flip] = Qt::Key_F;
+    m_actionKeyMap[Action::Grayscale] = Qt::Key_G;
+    // etc. add more for each button
+
+    // Build the reverse map:
+    m_keyActionMap.clear();
+    for (auto it = m_actionKeyMap.cbegin(); it != m_actionKeyMap.cend(); ++it) {
+        const Action action = it.key();
+        const int key = it.value();
+        m_keyActionMap[key] = action;
+    }
+
+    // Initialize m_timeButton as a member variable
+    m_timeButton = new QPushButton(countdownTime.toString("hh:mm:ss"), this);
+    m_timeButton->setToolTip("Start/Stop Timer");
+    m_timeButton->setStyleSheet("QPushButton { color: red; }"); // Initial color
+    connect(m_timeButton, &QPushButton::clicked, this, [this]() {
+        // Toggle the timer running/stopped
+        if (isTimerRunning) {
+            // Stop
+            m_countdownTimer->stop();
+            m_timeButton->setStyleSheet("color: red;");
+            qDebug() << "Timer stopped.";
+        }
+        else {
+            // Start
+            m_countdownTimer->start(1000); // every second
+            m_timeButton->setStyleSheet("color: white;");
+            qDebug() << "Timer started.";
+        }
+        isTimerRunning = !isTimerRunning;
+        });
+
+    // Apply a global dark theme style sheet
+    qApp->setStyleSheet(R"(
+        QWidget {
+            background-color: gray;
+            color: black;
+            font: 18px 'Segoe UI';
+        }
+        QPushButton {
+            background-color: #3E3E3E;
+            color: #FFFFFF;
+            border: none;
+            border-radius: 6px;
+            padding: 6px;
+            min-width: 40px;
+            min-height: 40px;
+        }
+        QPushButton:hover {
+            background-color: #505050;
+        }
+        QPushButton:pressed {
+            background-color: #1E1E1E;
+        }
+        QSpinBox, QCheckBox, QComboBox, QLineEdit {
+            background-color: #3E3E3E;
+            border: 1px solid #555;
+            border-radius: 4px;
+            padding: 2px;
+            color: #FFFFFF;
+        }
+        QGroupBox {
+            border: 1px solid #666;
+            border-radius: 6px;
+            margin-top: 6px;
+            font: bold 18px 'Segoe UI';
+        }
+        QGroupBox::title {
+            subcontrol-origin: margin;
+            subcontrol-position: top center;
+            padding: 2px 10px;
+            background-color: #2D2D2D;
+            color: #FFFFFF;
+            border-radius: 4px;
+        }
+        QLabel {
+            font: 18px 'Segoe UI';
+        }
+    )");
+
+    // UI Layout
+    QVBoxLayout* mainLayout = new QVBoxLayout(this);
+    QHBoxLayout* buttonLayout1 = new QHBoxLayout;
+    QHBoxLayout* buttonLayout2 = new QHBoxLayout;
+
+    // ----- Row 1 Buttons -----
+
+    QPushButton* openButton = new QPushButton("📂");
+    connect(openButton, &QPushButton::clicked, this, [this]() {
+        performAction(Action::OpenDirectory);
+        });
+    buttonLayout1->addWidget(openButton);
+
+    QPushButton* historyButton = new QPushButton("📜");
+    connect(historyButton, &QPushButton::clicked, this, [this]() {
+        performAction(Action::History);
+        });
+    buttonLayout1->addWidget(historyButton);
+
+    QPushButton* nextButton = new QPushButton("➡️");
+    connect(nextButton, &QPushButton::clicked, this, &MainWindow::onNextButtonClicked);
+    buttonLayout1->addWidget(nextButton);
+    
+
+    QPushButton* flipButton = new QPushButton("🔄");
+    connect(flipButton, &QPushButton::clicked, this, &MainWindow::onFlipButtonClicked);
+    buttonLayout1->addWidget(flipButton);
+
+    QPushButton* grayscaleButton = new QPushButton("⚫⚪");
+    connect(grayscaleButton, &QPushButton::clicked, this, &MainWindow::onGrayscaleButtonClicked);
+    buttonLayout1->addWidget(grayscaleButton);
+
+    buttonLayout1->addWidget(m_timeButton);
+
+    // Timer UI (example)
+    // Attempt to load "countdownTime" from settings
+    const QString ctime = settings.value("countdownTime", "00:10:00").toString();
+    countdownTime = QTime::fromString(ctime, "hh:mm:ss");
+    // Or if invalid, fallback to QTime(0,10)
+    if (!countdownTime.isValid()) {
+        countdownTime = QTime(0, 10);
+    }
+
+    // Load the action key map
+    QVariantMap actionKeyMapVariant = settings.value("actionKeyMap").toMap();
+    for (auto it = actionKeyMapVariant.cbegin(); it != actionKeyMapVariant.cend(); ++it) {
+        m_actionKeyMap[static_cast<Action>(it.key().toInt())] = it.value().toInt();
+    }
+    qDebug() << "Loaded action key map:" << actionKeyMapVariant;
+
+
+    // Rebuild the reverse map
+    m_keyActionMap.clear();
+    for (auto it = m_actionKeyMap.cbegin(); it != m_actionKeyMap.cend(); ++it) {
+        m_keyActionMap[it.value()] = it.key();
+    }
+
+    // Create and configure the hours spin box
+    SelectAllSpinBox* hoursSpinBox = new SelectAllSpinBox;
+    hoursSpinBox->setRange(0, 23);
+    hoursSpinBox->setValue(0);
+    hoursSpinBox->setFixedWidth(50); // Set fixed width
+    buttonLayout1->addWidget(hoursSpinBox);
+
+    // Create and configure the minutes spin box
+    SelectAllSpinBox* minutesSpinBox = new SelectAllSpinBox;
+    minutesSpinBox->setRange(0, 59);
+    minutesSpinBox->setValue(10);
+    minutesSpinBox->setFixedWidth(50); // Set fixed width
+    buttonLayout1->addWidget(minutesSpinBox);
+
+    // Create and configure the seconds spin box
+    SelectAllSpinBox* secondsSpinBox = new SelectAllSpinBox;
+    secondsSpinBox->setRange(0, 59);
+    secondsSpinBox->setValue(0);
+    secondsSpinBox->setFixedWidth(50); // Set fixed width
+    buttonLayout1->addWidget(secondsSpinBox);
+
+    // Master "Start Timer" Button
+    startTimerButton = new QPushButton("Start");
+    connect(startTimerButton, &QPushButton::clicked, this, [this, hoursSpinBox, minutesSpinBox, secondsSpinBox]() {
+        // Set the countdown time based on spin boxes
+        this->countdownTime.setHMS(hoursSpinBox->value(), minutesSpinBox->value(), secondsSpinBox->value());
+        // **Store the default countdown time**
+        this->m_defaultCountdownTime = this->countdownTime;
+        // Update the timer button display
+        m_timeButton->setText(this->countdownTime.toString("hh:mm:ss"));
+        qDebug() << "Timer set to: " << this->countdownTime.toString("hh:mm:ss");
+        // **Start the timer automatically**
+        if (!isTimerRunning) {
+            m_timeButton->click(); // This will start the timer
+        }
+        });
+    buttonLayout1->addWidget(startTimerButton);
+
+    // Toggle row 2
+    QPushButton* toggleButton = new QPushButton("Toggle");
+    connect(toggleButton, &QPushButton::clicked, this, [buttonLayout2]() {
+        bool isVisible = buttonLayout2->itemAt(0)->widget()->isVisible();
+        for (int i = 0; i < buttonLayout2->count(); ++i) {
+            QWidget* w = buttonLayout2->itemAt(i)->widget();
+            if (w) w->setVisible(!isVisible);
+        }
+        });
+    buttonLayout1->addWidget(toggleButton);
+
+    // ----- Row 2 Buttons -----
+    QPushButton* startScheduleButton = new QPushButton("📅");
+    connect(startScheduleButton, &QPushButton::clicked, this, &MainWindow::startSchedule);
+    buttonLayout2->addWidget(startScheduleButton);
+
+    QPushButton* editScheduleButton = new QPushButton("📝📅");
+    connect(editScheduleButton, &QPushButton::clicked, this, &MainWindow::editSchedule);
+    buttonLayout2->addWidget(editScheduleButton);
+
+    QPushButton* rotateClockwiseButton = new QPushButton("↩️");
+    connect(rotateClockwiseButton, &QPushButton::clicked, this, [this]() {
+        if (m_view) m_view->rotate(10);
+        });
+    buttonLayout2->addWidget(rotateClockwiseButton);
+
+    QPushButton* rotateCounterclockwiseButton = new QPushButton("↪️");
+    connect(rotateCounterclockwiseButton, &QPushButton::clicked, this, [this]() {
+        if (m_view) m_view->rotate(-10);
+        });
+    buttonLayout2->addWidget(rotateCounterclockwiseButton);
+
+    QPushButton* posterizeButton = new QPushButton("🖼️");
+    buttonLayout2->addWidget(posterizeButton);
+
+    QSpinBox* levelsSpinBox = new QSpinBox;
+    levelsSpinBox->setRange(1, 100);
+	levelsSpinBox->setValue(3);
+    buttonLayout2->addWidget(levelsSpinBox);
+
+    // Connect the posterize button to trigger posterization using the spinbox's current value
+    connect(posterizeButton, &QPushButton::clicked, this, [this, levelsSpinBox]() {
+        int levels = levelsSpinBox->value();
+        onPosterizeButtonClicked(levels);
+        });
+
+    // Connect the spinbox value change to update the posterized image
+    connect(levelsSpinBox, QOverload<int>::of(&QSpinBox::valueChanged), this, [this](int levels) {
+        if (m_isPosterized) {
+            applyPosterization(levels);
+        }
+        });
+
+    QPushButton* blurButton = new QPushButton("💧");
+    connect(blurButton, &QPushButton::clicked, this, &MainWindow::onDegradeButtonClicked);
+    buttonLayout2->addWidget(blurButton);
+
+    QPushButton* medianFilterButton = new QPushButton("📊");
+    connect(medianFilterButton, &QPushButton::clicked, this, &MainWindow::onMedianFilterButtonClicked);
+    buttonLayout2->addWidget(medianFilterButton);
+
+    QPushButton* toggleLinesButton = new QPushButton("📏");
+    connect(toggleLinesButton, &QPushButton::clicked, this, [this]() {
+        if (m_view) {
+            bool isVisible = m_view->areLinesVisible();
+            m_view->setLinesVisibility(!isVisible);
+        }
+        });
+    buttonLayout2->addWidget(toggleLinesButton);
+
+    QPushButton* copyRulerButton = new QPushButton("📏⬆️", this);
+    connect(copyRulerButton, &QPushButton::clicked, this, [this]() {
+        if (!m_view) return;
+
+        // 1) Ensure the ruler lines are visible.
+        m_view->setLinesVisibility(true);
+
+        // 2) Create the folder in the system temporary directory.
+        QString tempFolder = QDir::tempPath();  // system temp folder
+        QString folderPath = QDir(tempFolder).filePath("ruler_images");
+        QDir().mkpath(folderPath);
+
+        // 3) Build the file path for the ruler image.
+        QString rulerFilePath = QDir(folderPath).filePath("ruler_image.png");
+
+        // 4) Tell the view to save just the ruler lines to that file.
+        m_view->saveRulerImage(rulerFilePath);
+
+        // 5) Store this path in a member variable.
+        m_tempRulerFilePath = rulerFilePath;
+        qDebug() << "Saved ruler lines to" << rulerFilePath;
+
+        // 6) Refresh the custom JSX script path from settings.
+        refreshCustomJSXPath();  // This should update m_customJSXPath from QSettings.
+        QString scriptPath;
+        if (!m_customJSXPath.isEmpty()) {
+            scriptPath = m_customJSXPath;
+            qDebug() << "Using custom JSX script path:" << scriptPath;
+        }
+        else {
+            qDebug() << "No custom JSX script path is set. Cannot launch JSX script.";
+            return; // Exit early if no custom JSX file is available.
+        }
+
+        // 7) Build the argument list for cmd.exe using the "start" command.
+        // The command syntax: cmd.exe /C start "" <scriptPath>
+        QStringList args;
+        args << "/C" << "start" << "" << scriptPath;
+        qDebug() << "Launching JSX script using cmd.exe with args:" << args;
+
+        // 8) Launch the JSX file using cmd.exe.
+        bool processStarted = QProcess::startDetached("cmd.exe", args);
+        if (processStarted) {
+            qDebug() << "JSX script launched successfully.";
+        }
+        else {
+            qDebug() << "Failed to launch JSX script.";
+        }
+        });
+    buttonLayout2->addWidget(copyRulerButton);
+
+
+
+    QPushButton* filterButton = new QPushButton("🔍");
+    filterButton->setToolTip("Pick filter (orientation, resolution)");
+    connect(filterButton, &QPushButton::clicked, this, &MainWindow::onFilterButtonClicked);
+    buttonLayout2->addWidget(filterButton);
+
+    QPushButton* settingsButton = new QPushButton("⚙️");
+    buttonLayout2->addWidget(settingsButton);
+    connect(settingsButton, &QPushButton::clicked, this, &MainWindow::onSettingsButtonClicked);
+
+    QPushButton* copyDisplayedButton = new QPushButton("📋🖼️");
+    buttonLayout2->addWidget(copyDisplayedButton);
+    connect(copyDisplayedButton, &QPushButton::clicked, this, [this]() {
+        // 1) Decide which pixmap is currently shown.
+        QPixmap displayedPixmap = this->displayedPixmap();
+        if (displayedPixmap.isNull()) {
+            QMessageBox::warning(this, "Error", "No image is currently displayed.");
+            return;
+        }
+
+        // 2) Construct a path in the system temporary directory.
+        QString folderPath = QDir::tempPath() + "/displayed_image";  // Portable temp folder
+        m_tempDisplayedFilePath = folderPath + "/current_image.png";
+
+        // 3) Put the image on the clipboard right away. Formats are rendered only when a
+        //    consumer asks; the PNG is encoded once in the background, serves "image/png"
+        //    requests and is saved to the temp path.
+        QClipboard* clipboard = QApplication::clipboard();
+        clipboard->setMimeData(new LazyImageMimeData(displayedPixmap.toImage(), m_tempDisplayedFilePath));
+
+        qDebug() << "Copied displayed image to clipboard, saving to" << m_tempDisplayedFilePath;
+        });
+
+
+    // Add both button rows to the main layout
+    mainLayout->addLayout(buttonLayout1);
+    mainLayout->addLayout(buttonLayout2);
+
+    
+
+    // Create and set up the ZoomableGraphicsView
+    m_view = new ZoomableGraphicsView(this);
+    mainLayout->addWidget(m_view);
+    // Every filter, flip and grayscale toggle ends up as a scene change; the pixmap's cache key
+    // tells whether the displayed frame actually changed
+    connect(m_view->scene(), &QGraphicsScene::changed, this, &MainWindow::publishDisplayedImage);
+    // A consumer that connects gets the frame on screen, even if it hasn't changed since
+    connect(m_liveFeed, &LiveFeed::consumerConnected, this, [this]() {
+        m_publishedPixmapKey = 0;
+        publishDisplayedImage();
+        });
+    connect(m_view->scene(), &QGraphicsScene::changed, this, &MainWindow::updateImageMemory);
+    connect(m_view->scene(), &QGraphicsScene::changed, this, &MainWindow::updateTileLayer);
+
+    // Timing overlay (settings dialog); doesn't take mouse input so panning is unaffected
+    m_timingHud = new QLabel(m_view->viewport());
+    m_timingHud->setAttribute(Qt::WA_TransparentForMouseEvents);
+    m_timingHud->setStyleSheet("QLabel { background-color: rgba(0, 0, 0, 160); color: #E0E0E0;"
+        " font: 12px 'Consolas'; padding: 6px; border-radius: 4px; }");
+    m_timingHud->move(8, 8);
+    m_timingHud->hide();
+
+    // Image memory: over budget or under system memory pressure, idle scratch memory and then
+    // the hidden grayscale variant are released
+    m_grayscaleEvictor = MemoryBudget::instance().addEvictor(MemoryBudget::Category::Derived, [this]() {
+        return evictGrayscale();
+        });
+    m_memoryTimer = new QTimer(this);
+    connect(m_memoryTimer, &QTimer::timeout, this, [this]() {
+        MemoryBudget::instance().enforce();
+        updateTimingHud();
+        });
+    m_memoryTimer->start(2000);
+    mainLayout->setContentsMargins(0, 0, 0, 0);
+    mainLayout->setSpacing(0);
+
+    setLayout(mainLayout);
+
+    // Restore settings
+
+    m_customJSXPath = settings.value("customJSXPath").toString();
+    qDebug() << "Loaded custom JSX path:" << m_customJSXPath;
+
+    QStringList scheduleStringList = settings.value("schedule").toStringList();
+    for (const QString& timeString : scheduleStringList) {
+        schedule.append(QTime::fromString(timeString));
+    }
+    qDebug() << "Loaded schedule:" << scheduleStringList;
+
+    restoreGeometry(settings.value("mainWindowGeometry").toByteArray());
+    qDebug() << "Loaded main window geometry.";
+
+    m_exportWriter->setEncoder(ExportWriter::encoderFromName(settings.value("exportEncoder", "png").toString()));
+    m_timingHud->setVisible(settings.value("showTimingHud", false).toBool());
+    MemoryBudget::instance().setBudget(settings.value("memoryBudgetMB", 0).toLongLong() << 20);
+
+    RetentionManager::Budget sharingBudget;
+    sharingBudget.maxFolders = settings.value("sharingMaxFolders", sharingBudget.maxFolders).toInt();
+    sharingBudget.maxBytes = settings.value("sharingMaxMB", sharingBudget.maxBytes >> 20).toLongLong() << 20;
+    m_retention->setBudget(sharingBudget);
+    m_retention->setRoot(settings.value("sharingRoot", RetentionManager::defaultRoot()).toString());
+
+    if (!PickQuery::parse(settings.value("pickQuery").toString(), &m_pickQuery))
+        qDebug() << "Ignoring invalid saved pick query";
+    m_pickOrientation = settings.value("pickOrientation", "any").toString();
+    m_pickMinMegapixels = settings.value("pickMinMegapixels", 0.0).toDouble();
+
+    m_directory = settings.value("lastDirectory").toString();
+    qDebug() << "Loaded last directory:" << m_directory;
+
+    directoryHistory = settings.value("directoryHistory").toStringList();
+    qDebug() << "Loaded directory history:" << directoryHistory;
+
+    if (!m_directory.isEmpty()) {
+        setDirectory(m_directory);
+        QTimer::singleShot(100, this, [this]() {
+            loadImageFromDirectory(m_directory);
+            });
+    }
+
+    // Connect Timer
+    connect(m_countdownTimer, &QTimer::timeout, this, [this]() {
+        if (!isTimerRunning) return; // If somehow the timer is on but we don't want to run
+
+        // Subtract 1 second
+        countdownTime = countdownTime.addSecs(-1);
+        m_timeButton->setText(countdownTime.toString("hh:mm:ss"));
+        qDebug() << "Timer tick: " << countdownTime.toString("hh:mm:ss");
+
+        // If time is up
+        if (countdownTime <= QTime(0, 0, 0)) {
+            qDebug() << "Time is up.";
+            // 1) Load new image
+            loadImageFromDirectory(m_directory);
+
+            // 2) If scheduleActive, move to next schedule item
+            if (scheduleActive) {
+                currentScheduleIndex++;
+                startNextTimerInSchedule();
+                // This will set countdownTime to the next item or loop the schedule
+            }
+            else {
+                // **In non-schedule mode, reset the countdown time and continue**
+                countdownTime = m_defaultCountdownTime;
+                m_timeButton->setText(countdownTime.toString("hh:mm:ss"));
+                qDebug() << "Timer reset to default: " << countdownTime.toString("hh:mm:ss");
+                // **No need to stop the timer; it continues running**
+            }
+        }
+        });
+}
+
+
+// ---------------  Destructor ---------------
+MainWindow::~MainWindow()
+{
+    MemoryBudget::instance().removeEvictor(m_grayscaleEvictor);
+    if (!m_tempRulerFilePath.isEmpty()) {
+        QFile::remove(m_tempRulerFilePath);
+    }
+    // ...
+}
+
+
+// ---------------  closeEvent ---------------
+void MainWindow::closeEvent(QCloseEvent* event)
+{
+    // Convert schedule to a QStringList
+    QStringList scheduleStringList;
+    for (const QTime& t : schedule) {
+        scheduleStringList.append(t.toString("hh:mm:ss"));
+    }
+    // Remove the displayed image file if it exists (once its background write is done)
+    LazyImageMimeData::waitForWrites();
+    if (!m_tempDisplayedFilePath.isEmpty()) {
+        QFile::remove(m_tempDisplayedFilePath);
+    }
+    // Stop background analysis and write its cache
+    m_analysisIndex->stop();
+
+    // Finish the shared-folder writes that are still queued
+    m_exportWriter->flush();
+    const ExportWriter::Stats exportStats = m_exportWriter->stats();
+    qDebug() << "[ExportWriter]" << exportStats.written << "written," << exportStats.coalesced << "coalesced,"
+        << exportStats.skipped << "unchanged," << exportStats.linked << "linked,"
+        << exportStats.dropped << "dropped, average" << exportStats.averageWriteMs << "ms, max queue depth"
+        << exportStats.maxQueueDepth;
+    for (const Profiler::StageSummary& stage : Profiler::instance().summaries()) {
+        qDebug() << "[Profiler]" << stage.stage << "p50" << stage.p50Ms << "ms, p95" << stage.p95Ms
+            << "ms, p99" << stage.p99Ms << "ms over" << stage.count << "loads";
+    }
+    const RetentionManager::Stats retentionStats = m_retention->stats();
+    qDebug() << "[RetentionManager]" << retentionStats.folders << "folders," << retentionStats.bytes / (1024 * 1024)
+        << "MB; evicted" << retentionStats.evictedFolders << "folders," << retentionStats.evictedBytes / (1024 * 1024) << "MB";
+    const MemoryBudget::Usage memory = MemoryBudget::instance().usage();
+    qDebug() << "[MemoryBudget] peak" << memory.peak / (1024 * 1024) << "of" << memory.budget / (1024 * 1024)
+        << "MB;" << memory.evictions << "evictions freed" << memory.evictedBytes / (1024 * 1024) << "MB";
+
+    // Save settings
+    settings.setValue("schedule", scheduleStringList);
+    qDebug() << "Saved schedule:" << scheduleStringList;
+
+    settings.setValue("mainWindowGeometry", saveGeometry());
+    qDebug() << "Saved main window geometry.";
+
+    settings.setValue("lastDirectory", m_directory);
+    qDebug() << "Saved last directory:" << m_directory;
+
+    settings.setValue("directoryHistory", directoryHistory);
+    qDebug() << "Saved directory history:" << directoryHistory;
+
+    settings.setValue("countdownTime", countdownTime.toString("hh:mm:ss"));
+    qDebug() << "Saved countdown time:" << countdownTime.toString("hh:mm:ss");
+
+    // Save the action key map
+    QVariantMap actionKeyMapVariant;
+    for (auto it = m_actionKeyMap.cbegin(); it != m_actionKeyMap.cend(); ++it) {
+        actionKeyMapVariant.insert(QString::number(static_cast<int>(it.key())), it.value());
+    }
+    settings.setValue("actionKeyMap", actionKeyMapVariant);
+    qDebug() << "Saved action key map:" << actionKeyMapVariant;
+
+    QWidget::closeEvent(event);
+}
+
+// ---------------  Key Press for Shortcuts ---------------
+void MainWindow::keyPressEvent(QKeyEvent* event)
+{
+    int key = event->key();
+
+    // check if there's an action
+    if (m_keyActionMap.contains(key)) {
+        Action action = m_keyActionMap[key];
+        performAction(action);
+    }
+    else if ((key == Qt::Key_V) && (event->modifiers() & Qt::ControlModifier)) {
+        // A special case for Ctrl+V
+        processClipboardImage();
+    }
+    else {
+        QWidget::keyPressEvent(event);
+    }
+}
+
+
+void MainWindow::performAction(Action action)
+{
+    switch (action)
+    {
+    case Action::OpenDirectory:
+        onOpenButtonClicked();  // or the same logic inline
+        break;
+    case Action::History:
+        onHistoryButtonClicked();
+        break;
+    case Action::NextImage:
+        onNextButtonClicked();
+        break;
+    case Action::Flip:
+        onFlipButtonClicked();
+        break;
+    case Action::Grayscale:
+        onGrayscaleButtonClicked();
+        break;
+        // ...
+    case Action::SaveRuler:
+        // The same code you'd run in copyRulerButton clicked-lambda
+        break;
+    case Action::CopyDisplayedImage:
+        // The same code you'd run in your copyDisplayedButton lambda
+        break;
+        // etc. for each Action
+    default:
+        qDebug() << "No matching Action logic.";
+        break;
+    }
+}
+
+
+
+// settings
+void MainWindow::onSettingsButtonClicked()
+{
+    QMap<Action, QString> actionNameMap = {
+        { Action::OpenDirectory, "Open Directory" },
+		{ Action::History, "History" },
+		{ Action::NextImage, "Next Image" },
+		{ Action::Flip, "Flip" },
+		{ Action::Grayscale, "Grayscale" },
+		{ Action::StartSchedule, "Start Schedule" },
+		{ Action::EditSchedule, "Edit Schedule" },
+		{ Action::RotateClockwise, "Rotate Clockwise" },
+		{ Action::RotateCounterclockwise, "Rotate Counterclockwise" },
+		{ Action::Posterize, "Posterize" },
+		{ Action::Blur, "Blur" },
+		{ Action::MedianFilter, "Median Filter" },
+		{ Action::ToggleLines, "Toggle Lines" },
+		{ Action::SaveRuler, "Save Ruler" },
+		{ Action::CopyDisplayedImage, "Copy Displayed Image" },
+		{ Action::ProcessClipboard, "Process Clipboard" },
+        // Add other actions here
+    };
+
+    SettingsDialog dialog(this, actionNameMap);
+    dialog.setKeyMap(m_actionKeyMap);
+    dialog.setExportEncoder(ExportWriter::encoderName(m_exportWriter->encoder()));
+    dialog.setShowTimingHud(m_timingHud->isVisible());
+    dialog.setMemoryBudgetMB(settings.value("memoryBudgetMB", 0).toLongLong());
+    const RetentionManager::Budget sharingBudget = m_retention->budget();
+    dialog.setSharingFolder(m_retention->root(), sharingBudget.maxFolders, sharingBudget.maxBytes >> 20);
+    if (dialog.exec() == QDialog::Accepted) {
+        m_exportWriter->setEncoder(ExportWriter::encoderFromName(dialog.exportEncoder()));
+        settings.setValue("exportEncoder", dialog.exportEncoder());
+        m_timingHud->setVisible(dialog.showTimingHud());
+        settings.setValue("showTimingHud", dialog.showTimingHud());
+        MemoryBudget::instance().setBudget(dialog.memoryBudgetMB() << 20);
+        settings.setValue("memoryBudgetMB", dialog.memoryBudgetMB());
+        updateTimingHud();
+
+        RetentionManager::Budget budget;
+        budget.maxFolders = dialog.sharingMaxFolders();
+        budget.maxBytes = dialog.sharingMaxMB() << 20;
+        m_retention->setBudget(budget);
+        m_retention->setRoot(dialog.sharingRoot());
+        settings.setValue("sharingRoot", dialog.sharingRoot());
+        settings.setValue("sharingMaxFolders", budget.maxFolders);
+        settings.setValue("sharingMaxMB", dialog.sharingMaxMB());
+
+        m_actionKeyMap = dialog.getKeyMap();
+        // Rebuild the reverse map
+        m_keyActionMap.clear();
+        for (auto it = m_actionKeyMap.cbegin(); it != m_actionKeyMap.cend(); ++it) {
+            m_keyActionMap[it.value()] = it.key();
+        }
+    }
+}
+
+
+void MainWindow::refreshCustomJSXPath() {
+    QSettings settings("YourCompany", "YourApp");
+    m_customJSXPath = settings.value("customJSXPath").toString();
+    qDebug() << "Refreshed custom JSX path:" << m_customJSXPath;
+}
+
+// ---------------  Directory Setup ---------------
+void MainWindow::setDirectory(const QString& directory)
+{
+    m_directory = directory;
+    directoryHistory.removeAll(directory);
+    directoryHistory.prepend(directory);
+
+    if (directoryHistory.size() > 10) {
+        directoryHistory.removeLast();
+    }
+
+    settings.setValue("lastDirectory", m_directory);
+    settings.setValue("directoryHistory", directoryHistory);
+
+    // Populate files
+    m_fileIndex.build(directory, DirectoryWatcher::imageNameFilters());
+
+    // Continue the random order saved for this folder (or start a new one)
+    restoreShuffleState();
+
+    // Header probes (for the pick filter), then perceptual hashes for near-duplicate
+    // skipping, computed in the background
+    m_analysisIndex->start(directory);
+
+    // Keep the index current while the folder is open
+    m_directoryWatcher->setRoot(directory);
+}
+
+void MainWindow::onFilesAdded(const QStringList& paths)
+{
+    addToIndex(paths, false);
+}
+
+void MainWindow::onArchiveMembersAdded(const QStringList& paths)
+{
+    addToIndex(paths, true);
+}
+
+void MainWindow::addToIndex(const QStringList& paths, bool archiveMembers)
+{
+    // New files get new ids past the end of the range; the permutation makes sure
+    // they come up in the current cycle, without reshuffling anything.
+    for (const QString& path : paths) {
+        const FileIndex::Id id = m_fileIndex.append(path, archiveMembers);
+        if (id != FileIndex::InvalidId) {
+            m_pickOrder.makeEligible(id);
+            m_analysisIndex->enqueue(id);
+        }
+    }
+    qDebug() << "Added" << paths.size() << "file(s) to the index, now" << m_fileIndex.size();
+}
+
+void MainWindow::onFilesRemoved(const QStringList& paths)
+{
+    for (const QString& path : paths) {
+        m_fileIndex.remove(path);
+    }
+    qDebug() << "Removed" << paths.size() << "file(s) from the index, now" << m_fileIndex.size();
+
+    // Removed ids stay in the random order and every pick walks past them; once most of the
+    // range is dead (a big deletion), renumber the live files and start a new order over them
+    const qsizetype minCompactIds = 1024;
+    if (m_fileIndex.idCount() >= minCompactIds && m_fileIndex.size() * 4 < m_fileIndex.idCount()) {
+        qDebug() << "Compacting the index:" << m_fileIndex.size() << "live of" << m_fileIndex.idCount() << "ids";
+        m_analysisIndex->stop();  // writes its cache while the old ids still name the files
+        m_fileIndex.compact();
+        m_pickOrder.reset(m_fileIndex.idCount());
+        saveShuffleState();
+        m_analysisIndex->start(m_directory);
+    }
+}
+
+QString MainWindow::getRandomImage(const QString& directory)
+{
+    Q_UNUSED(directory);
+
+    std::vector<FileIndex::Id> unprobed;
+    const auto alive = [this, &unprobed](quint64 candidate) {
+        const FileIndex::Id id = static_cast<FileIndex::Id>(candidate);
+        return m_fileIndex.isAlive(id) && matchesPickFilter(id, &unprobed);
+    };
+
+    // Near-duplicates of what was just shown are pushed back to later in the pass
+    // (not dropped). Give up after a few tries so a folder of variants still works.
+    const bool skipDuplicates = settings.value("skipNearDuplicates", true).toBool();
+    const int maxDistance = settings.value("nearDuplicateDistance", 10).toInt();
+    const int maxSkips = 16;
+
+    quint64 id = RandomPermutation::InvalidValue;
+    for (int attempt = 0; attempt <= maxSkips; ++attempt) {
+        id = m_pickOrder.next(m_fileIndex.idCount(), alive);
+        if (id == RandomPermutation::InvalidValue) {
+            break;
+        }
+        if (!skipDuplicates || attempt == maxSkips
+            || !m_analysisIndex->isNearDuplicateOfRecent(static_cast<FileIndex::Id>(id))) {
+            break;
+        }
+        qDebug() << "Deferring near-duplicate:" << m_fileIndex.filePath(static_cast<FileIndex::Id>(id));
+        m_pickOrder.makeEligible(id);
+    }
+
+    // The first few files still waiting for their header probe are probed next and come
+    // back later in this cycle; the others wait for the restart on probesFinished
+    for (FileIndex::Id waiting : unprobed) {
+        m_analysisIndex->prioritizeProbe(waiting);
+        m_pickOrder.makeEligible(waiting);
+    }
+    if (id == RandomPermutation::InvalidValue) {
+        return QString();
+    }
+    m_analysisIndex->markShown(static_cast<FileIndex::Id>(id), maxDistance);
+    saveShuffleState();
+    return m_fileIndex.filePath(static_cast<FileIndex::Id>(id));
+}
+
+bool MainWindow::matchesPickFilter(FileIndex::Id id, std::vector<FileIndex::Id>* unprobed)
+{
+    // Called per candidate, possibly across the whole folder: the cached settings only
+    const QString& orientation = m_pickOrientation;
+    const double minMegapixels = m_pickMinMegapixels;
+    const bool sizeFilter = orientation != "any" || minMegapixels > 0.0;
+    if (!sizeFilter && m_pickQuery.isEmpty()) return true;
+
+    PickQuery::Values values;
+    if (m_pickQuery.usesStats()) {
+        // Statistics come only from the background pass; never decode at pick time
+        ImageStats::Stats stats;
+        if (!m_analysisIndex->stats(id, &stats)) {
+            m_pickSkippedUnanalysed = true;
+            return false;
+        }
+        values.fields[PickQuery::MeanLuma] = stats.meanLuma * 100.0 / 255.0;
+        values.fields[PickQuery::P10Luma] = stats.p10Luma * 100.0 / 255.0;
+        values.fields[PickQuery::P50Luma] = stats.p50Luma * 100.0 / 255.0;
+        values.fields[PickQuery::P90Luma] = stats.p90Luma * 100.0 / 255.0;
+        values.fields[PickQuery::Saturation] = stats.saturation * 100.0 / 255.0;
+        values.fields[PickQuery::Colorfulness] = stats.colorfulness;
+        values.hueBins = stats.hueBins;
+    }
+
+    if (sizeFilter || m_pickQuery.usesSize()) {
+        // Header info comes only from the background probe; never read a file at pick time
+        if (!m_analysisIndex->isProbed(id)) {
+            const size_t maxUnprobed = 64;
+            m_pickSkippedUnprobed = true;
+            if (unprobed && unprobed->size() < maxUnprobed) unprobed->push_back(id);
+            return false;
+        }
+        const ImageProbe::Info info = m_analysisIndex->probeInfo(id);
+        if (!info.valid) return false;
+
+        const QSize size = info.displaySize();
+        if (orientation == "landscape" && size.width() <= size.height()) return false;
+        if (orientation == "portrait" && size.height() <= size.width()) return false;
+        const double megapixels = static_cast<double>(size.width()) * size.height() / 1e6;
+        if (megapixels < minMegapixels) return false;
+
+        values.fields[PickQuery::Width] = size.width();
+        values.fields[PickQuery::Height] = size.height();
+        values.fields[PickQuery::Megapixels] = megapixels;
+        values.fields[PickQuery::Aspect] = static_cast<double>(size.width()) / size.height();
+    }
+
+    return m_pickQuery.matches(values);
+}
+
+bool MainWindow::setPickQuery(const QString& text)
+{
+    QString error;
+    PickQuery query;
+    if (!PickQuery::parse(text, &query, &error)) {
+        QMessageBox::warning(this, "Pick query", QString("Invalid query: %1").arg(error));
+        return false;
+    }
+    m_pickQuery = query;
+    m_pickSkippedUnanalysed = false;
+    settings.setValue("pickQuery", query.text());
+    qDebug() << "Pick query:" << (query.isEmpty() ? QString("(none)") : query.text());
+    return true;
+}
+
+void MainWindow::onFilterButtonClicked()
+{
+    const QString orientation = m_pickOrientation;
+    const double minMegapixels = m_pickMinMegapixels;
+
+    QMenu menu;
+    QActionGroup orientationGroup(&menu);
+    const QList<QPair<QString, QString>> orientations = {
+        { "any", "Any orientation" }, { "landscape", "Landscape" }, { "portrait", "Portrait" } };
+    for (const auto& entry : orientations) {
+        QAction* action = menu.addAction(entry.second);
+        action->setCheckable(true);
+        action->setChecked(orientation == entry.first);
+        action->setData(entry.first);
+        orientationGroup.addAction(action);
+    }
+    menu.addSeparator();
+    QActionGroup sizeGroup(&menu);
+    for (double megapixels : { 0.0, 2.0, 4.0, 8.0, 12.0, 24.0 }) {
+        QAction* action = menu.addAction(megapixels > 0.0 ? QString("At least %1 MP").arg(megapixels) : "Any resolution");
+        action->setCheckable(true);
+        action->setChecked(qFuzzyCompare(megapixels + 1.0, minMegapixels + 1.0));
+        action->setData(megapixels);
+        sizeGroup.addAction(action);
+    }
+
+    menu.addSeparator();
+    QAction* queryAction = menu.addAction(m_pickQuery.isEmpty()
+        ? QString("Query...") : QString("Query: %1").arg(m_pickQuery.text()));
+    QAction* clearQueryAction = menu.addAction("Clear query");
+    clearQueryAction->setEnabled(!m_pickQuery.isEmpty());
+
+    QAction* chosen = menu.exec(QCursor::pos());
+    if (!chosen) return;
+    if (chosen == queryAction) {
+        bool ok = false;
+        const QString text = QInputDialog::getMultiLineText(this, "Pick query", PickQuery::help(), m_pickQuery.text(), &ok);
+        if (!ok || !setPickQuery(text.simplified())) return;
+    }
+    else if (chosen == clearQueryAction) {
+        setPickQuery(QString());
+    }
+    else if (chosen->actionGroup() == &orientationGroup) {
+        m_pickOrientation = chosen->data().toString();
+        settings.setValue("pickOrientation", m_pickOrientation);
+    }
+    else {
+        m_pickMinMegapixels = chosen->data().toDouble();
+        settings.setValue("pickMinMegapixels", m_pickMinMegapixels);
+    }
+
+    // Files rejected under the old filter were skipped for the current cycle; start a new one
+    m_pickOrder.reset(m_fileIndex.idCount());
+    saveShuffleState();
+    qDebug() << "Pick filter:" << m_pickOrientation << m_pickMinMegapixels << "MP";
+}
+
+// The random order is stored per folder as (seed, bits, position, pending ids),
+// plus the index size and id -> path fingerprint it was made for.
+static QString shuffleStateGroup(const QString& directory)
+{
+    const QByteArray key = QCryptographicHash::hash(directory.toUtf8(), QCryptographicHash::Md5).toHex();
+    return "shuffleState/" + QString::fromLatin1(key);
+}
+
+void MainWindow::saveShuffleState()
+{
+    if (m_directory.isEmpty()) return;
+    QStringList pending;
+    for (quint64 id : m_pickOrder.pending()) {
+        pending << QString::number(id);
+    }
+    settings.beginGroup(shuffleStateGroup(m_directory));
+    settings.setValue("seed", QString::number(m_pickOrder.seed()));
+    settings.setValue("bits", m_pickOrder.bits());
+    settings.setValue("position", QString::number(m_pickOrder.position()));
+    settings.setValue("rangeSize", QString::number(m_fileIndex.idCount()));
+    settings.setValue("fingerprint", QString::number(m_fileIndex.fingerprint()));
+    settings.setValue("pending", pending);
+    settings.endGroup();
+}
+
+void MainWindow::restoreShuffleState()
+{
+    const quint64 rangeSize = static_cast<quint64>(m_fileIndex.idCount());
+
+    settings.beginGroup(shuffleStateGroup(m_directory));
+    const bool hasState = settings.contains("seed");
+    const quint64 seed = settings.value("seed").toString().toULongLong();
+    const int bits = settings.value("bits").toInt();
+    const quint64 position = settings.value("position").toString().toULongLong();
+    const quint64 savedRange = settings.value("rangeSize").toString().toULongLong();
+    const QString savedFingerprint = settings.value("fingerprint").toString();
+    std::vector<quint64> pending;
+    for (const QString& id : settings.value("pending").toStringList()) {
+        pending.push_back(id.toULongLong());
+    }
+    settings.endGroup();
+
+    // Ids follow path order, so a file added or removed while we weren't running shifts
+    // the ids of every path after it and the saved order no longer matches; start over.
+    // Only files sorted after all the old ones leave the saved ids as they were, and just
+    // extend the range.
+    const bool sameIds = savedRange <= rangeSize
+        && savedFingerprint == QString::number(m_fileIndex.fingerprint(static_cast<qsizetype>(savedRange)));
+    if (hasState && sameIds && m_pickOrder.restore(seed, bits, position, pending)) {
+        for (quint64 id = savedRange; id < rangeSize; ++id) {
+            m_pickOrder.makeEligible(id);
+        }
+        qDebug() << "Restored random order at position" << position << "of" << m_pickOrder.domainSize();
+    }
+    else {
+        m_pickOrder.reset(rangeSize);
+        qDebug() << "Started a new random order over" << rangeSize << "files";
+    }
+}
+
+// ---------------  Slots ---------------
+void MainWindow::onOpenButtonClicked()
+{
+    QString directory = QFileDialog::getExistingDirectory(this, "Open Directory");
+    if (!directory.isEmpty()) {
+        setDirectory(directory);
+        loadImageFromDirectory(directory);
+    }
+}
+
+void MainWindow::onHistoryButtonClicked()
+{
+    QMenu menu;
+    for (const QString& directory : directoryHistory) {
+        menu.addAction(directory, this, [this, directory]() {
+            setDirectory(directory);
+            loadImageFromDirectory(directory);
+            });
+    }
+    menu.exec(QCursor::pos());
+}
+
+void MainWindow::onNextButtonClicked()
+{
+    if (m_directory.isEmpty()) return;
+
+    QMessageBox::StandardButton reply = QMessageBox::question(
+        this,
+        "Confirmation",
+        "Are you sure you want to load the next image?",
+        QMessageBox::Yes | QMessageBox::No
+    );
+
+    if (reply == QMessageBox::Yes) {
+        if (scheduleActive) {
+            // 1) Manually skip the countdown. That means we treat the current
+            //    countdown as finished. We load the image:
+            loadImageFromDirectory(m_directory);
+
+            // 2) Move on to the next schedule item
+            currentScheduleIndex++;
+            // 3) Start the next timer in schedule
+            startNextTimerInSchedule();
+        }
+        else {
+            // No schedule: normal behavior
+            loadImageFromDirectory(m_directory);
+        }
+    }
+}
+
+
+void MainWindow::onFlipButtonClicked()
+{
+    if (!m_originalPixmapItem || !m_grayscalePixmapItem) return;
+    restoreGrayscale();
+
+    // Flip original
+    QImage origImg = m_originalPixmapItem->pixmap().toImage().mirrored(true, false);
+    m_originalPixmapItem->setPixmap(QPixmap::fromImage(origImg));
+
+    // Flip grayscale
+    QImage grayImg = m_grayscalePixmapItem->pixmap().toImage().mirrored(true, false);
+    m_grayscalePixmapItem->setPixmap(QPixmap::fromImage(grayImg));
+}
+
+void MainWindow::onGrayscaleButtonClicked()
+{
+    if (!m_originalPixmapItem || !m_grayscalePixmapItem) return;
+    restoreGrayscale();
+    bool grayVisible = m_grayscalePixmapItem->isVisible();
+
+    m_originalPixmapItem->setVisible(grayVisible);
+    m_grayscalePixmapItem->setVisible(!grayVisible);
+
+    if (!grayVisible && m_copyPasteEnabled) {
+        // If turning on grayscale and copy/paste is enabled, save grayscale
+        QImage grayscaleImg = m_grayscalePixmapItem->pixmap().toImage();
+        saveImageToSharedFolder(grayscaleImg, "grayscale_shared");
+    }
+}
+
+void MainWindow::cancelPendingFilters()
+{
+    m_filterToken.cancel();
+    m_filterToken = TaskScheduler::CancellationToken();
+    ++m_filterGeneration;
+}
+
+void MainWindow::cancelPendingLoad()
+{
+    m_loadToken.cancel();
+    m_loadToken = TaskScheduler::CancellationToken();
+    ++m_loadGeneration;
+}
+
+// New method to apply posterization
+void MainWindow::applyPosterization(int levels)
+{
+    if (!m_originalPixmapItem || !m_grayscalePixmapItem) return;
+
+    // The spin box can fire faster than posterize runs: only the latest level matters
+    cancelPendingFilters();
+    TaskScheduler::TaskOptions options;
+    options.token = m_filterToken;
+    const int generation = m_filterGeneration;
+
+    // Use the original image for posterization; the grayscale variant is of the posterized one
+    QImage orig = m_originalPixmap.toImage();
+    QFuture<QImage> posterized = ImageUtils::posterizeAsync(orig, levels, false, options);
+    QFuture<QImage> posterGray = posterized.then(QtFuture::Launch::Sync, [](const QImage& color) {
+        return ImageUtils::convertToGrayscale(color);
+        });
+
+    // The colour result is shown as soon as it's ready, the grayscale one when it follows
+    posterized.then(this, [this, generation](const QImage& posterizedOrig) {
+        if (generation != m_filterGeneration || !m_originalPixmapItem) return;
+        m_originalPixmapItem->setPixmap(QPixmap::fromImage(posterizedOrig));
+        if (m_copyPasteEnabled) saveImageToSharedFolder(posterizedOrig, "posterized");
+        });
+    posterGray.then(this, [this, generation](const QImage& gray) {
+        if (generation != m_filterGeneration || !m_grayscalePixmapItem) return;
+        m_grayscalePixmapItem->setPixmap(QPixmap::fromImage(gray));
+        if (m_copyPasteEnabled) saveImageToSharedFolder(gray, "posterized_grayscale");
+        });
+}
+
+// Updated method to toggle posterization state
+void MainWindow::onPosterizeButtonClicked(int levels)
+{
+    if (!m_originalPixmapItem || !m_grayscalePixmapItem) return;
+    restoreGrayscale();
+
+    if (!m_isPosterized) {
+        applyPosterization(levels);
+        m_isPosterized = true;
+    }
+    else {
+        // Revert to original images
+        cancelPendingFilters();
+        m_originalPixmapItem->setPixmap(m_originalPixmap);
+        m_grayscalePixmapItem->setPixmap(m_grayscalePixmap);
+        m_isPosterized = false;
+    }
+}
+
+void MainWindow::onDegradeButtonClicked()
+{
+    if (!m_originalPixmapItem || !m_grayscalePixmapItem) return;
+    restoreGrayscale();
+
+    if (!m_isBlurred) {
+        // blur both variants at once
+        cancelPendingFilters();
+        TaskScheduler::TaskOptions options;
+        options.token = m_filterToken;
+        const int generation = m_filterGeneration;
+
+        QImage orig = m_originalPixmapItem->pixmap().toImage();
+        QImage gray = m_grayscalePixmapItem->pixmap().toImage();
+        const QList<QFuture<QImage>> blurred = {
+            ImageUtils::gaussianBlurAsync(orig, 5, options),
+            ImageUtils::gaussianBlurAsync(gray, 5, options),
+        };
+        QtFuture::whenAll(blurred.begin(), blurred.end()).then(this, [this, generation](const QList<QFuture<QImage>>& results) {
+            if (generation != m_filterGeneration || !m_originalPixmapItem || !m_grayscalePixmapItem) return;
+            if (results[0].isCanceled() || results[1].isCanceled()) return;
+            m_originalPixmapItem->setPixmap(QPixmap::fromImage(results[0].result()));
+            m_grayscalePixmapItem->setPixmap(QPixmap::fromImage(results[1].result()));
+            });
+
+        m_isBlurred = true;
+    }
+    else {
+        // revert
+        cancelPendingFilters();
+        m_originalPixmapItem->setPixmap(m_originalPixmap);
+        m_grayscalePixmapItem->setPixmap(m_grayscalePixmap);
+        m_isBlurred = false;
+    }
+}
+
+void MainWindow::onMedianFilterButtonClicked()
+{
+    if (!m_originalPixmapItem) return;
+
+    if (!m_isMedianFiltered) {
+        cancelPendingFilters();
+        TaskScheduler::TaskOptions options;
+        options.token = m_filterToken;
+        const int generation = m_filterGeneration;
+
+        QImage orig = m_originalPixmapItem->pixmap().toImage();
+        ImageUtils::medianFilterAsync(orig, options).then(this, [this, generation](const QImage& filtered) {
+            if (generation != m_filterGeneration || !m_originalPixmapItem) return;
+            m_originalPixmapItem->setPixmap(QPixmap::fromImage(filtered));
+            });
+        m_isMedianFiltered = true;
+    }
+    else {
+        // revert
+        cancelPendingFilters();
+        m_originalPixmapItem->setPixmap(m_originalPixmap);
+        m_isMedianFiltered = false;
+    }
+}
+
+void MainWindow::confirmAndMoveFileToDeleteFolder()
+{
+    if (m_currentImagePath.isEmpty()) {
+        QMessageBox::information(this, "No Image", "No image is currently loaded.");
+        return;
+    }
+    if (ZipArchive::isMemberPath(m_currentImagePath)) {
+        QMessageBox::information(this, "Archive", "This image is inside an archive and can't be moved.");
+        return;
+    }
+
+    QMessageBox::StandardButton reply = QMessageBox::question(this, "Confirm Delete",
+        "Are you sure you want to delete this file?", QMessageBox::Yes | QMessageBox::No);
+
+    if (reply == QMessageBox::Yes) {
+        QString deleteFolder = "C:/REFERENCE/test/delete";
+        QDir dir(deleteFolder);
+        if (!dir.exists()) {
+            dir.mkpath(".");
+        }
+        QFileInfo fi(m_currentImagePath);
+        QString newFilePath = deleteFolder + "/" + fi.fileName();
+        if (QFile::rename(m_currentImagePath, newFilePath)) {
+            m_currentImagePath.clear();
+            cancelPendingFilters();
+            m_view->scene()->clear();
+            m_originalPixmapItem = nullptr;  // deleted by clear()
+            m_grayscalePixmapItem = nullptr;
+            loadImageFromDirectory(m_directory);
+        }
+        else {
+            QMessageBox::critical(this, "Error", "Failed to move the file.");
+        }
+    }
+}
+
+// ---------------  Scheduling  ---------------
+void MainWindow::startSchedule()
+{
+    qDebug() << "Starting schedule...";
+    // If you have multiple schedules, you want to cancel any existing normal timer
+    // or unify them into one approach.
+    isTimerRunning = false;            // Make sure the manual timer is considered off
+    scheduleActive = true;
+
+    if (!schedule.isEmpty()) {
+        currentScheduleIndex = 0;
+        qDebug() << "Schedule is not empty. Starting with the first item.";
+        startNextTimerInSchedule();
+    }
+    else {
+        qDebug() << "Schedule is empty. Nothing to start.";
+    }
+}
+
+void MainWindow::startNextTimerInSchedule()
+{
+    if (currentScheduleIndex < schedule.size()) {
+        qDebug() << "Starting next timer in schedule. Index:" << currentScheduleIndex;
+        // 1) Set countdownTime to the next schedule item
+        countdownTime = schedule[currentScheduleIndex];
+        qDebug() << "Countdown time set to:" << countdownTime.toString("hh:mm:ss");
+
+        // 2) Update m_timeButton text
+        m_timeButton->setText(countdownTime.toString("hh:mm:ss"));
+        qDebug() << "Time button text updated to:" << countdownTime.toString("hh:mm:ss");
+
+        // 3) Start the m_countdownTimer if not already started
+        //    or forcibly restart it
+        //    We'll do forcibly restart to ensure it's counting from the new time
+        m_countdownTimer->stop();  // Stop any old countdown
+        m_countdownTimer->start(1000);
+        qDebug() << "Countdown timer started.";
+
+        // Mark isTimerRunning to true
+        isTimerRunning = true;
+        qDebug() << "Timer is now running.";
+    }
+    else {
+        // All schedule items done
+        qDebug() << "All schedule items are done.";
+        scheduleActive = false;
+        isTimerRunning = false;
+        m_countdownTimer->stop();
+        qDebug() << "Countdown timer stopped.";
+
+        // Optionally reset the m_timeButton to something else
+        m_timeButton->setText("Schedule Done");
+        qDebug() << "Time button text set to 'Schedule Done'.";
+
+        // **Loop the schedule by resetting the index and restarting**
+        currentScheduleIndex = 0;
+        scheduleActive = true;
+        qDebug() << "Restarting schedule.";
+        startNextTimerInSchedule();
+    }
+}
+
+
+#include "scheduledialog.h"  // <--- Make sure this is included
+
+void MainWindow::editSchedule()
+{
+    qDebug() << "Editing schedule...";
+    // Pass the current 'schedule' to the dialog, so it can list it
+    ScheduleDialog dialog(this, schedule);
+    // Show the dialog modally
+    if (dialog.exec() == QDialog::Accepted) {
+        // If user pressed OK, retrieve the new schedule
+        schedule = dialog.getSchedule();
+        qDebug() << "New schedule accepted:" << schedule;
+    }
+    else {
+        qDebug() << "Schedule editing canceled.";
+    }
+}
+
+
+// ---------------  Loading Images  ---------------
+void MainWindow::loadImageFromDirectory(const QString& directory)
+{
+    QString imagePath = getRandomImage(directory);
+    if (imagePath.isEmpty()) {
+        QMessageBox::information(this, "No Image Found", "No image found in directory");
+        return;
+    }
+    processAndDisplayImage(imagePath);
+    prefetchNextPick();
+}
+
+void MainWindow::prefetchNextPick()
+{
+    // A copy of the order predicts the next pick without consuming it (a near-duplicate
+    // deferral can still change it); its file is read into the OS cache while this one is viewed
+    const bool skippedUnanalysed = m_pickSkippedUnanalysed;
+    const bool skippedUnprobed = m_pickSkippedUnprobed;
+    RandomPermutation lookahead = m_pickOrder;
+    const quint64 id = lookahead.next(m_fileIndex.idCount(), [this](quint64 candidate) {
+        const FileIndex::Id fileId = static_cast<FileIndex::Id>(candidate);
+        return m_fileIndex.isAlive(fileId) && matchesPickFilter(fileId);
+        });
+    m_pickSkippedUnanalysed = skippedUnanalysed;
+    m_pickSkippedUnprobed = skippedUnprobed;
+    if (id != RandomPermutation::InvalidValue)
+        MappedFile::prefetch(m_fileIndex.filePath(static_cast<FileIndex::Id>(id)));
+}
+
+void MainWindow::processAndDisplayImage(const QString& filePath)
+{
+    if (filePath.isEmpty()) return;
+    cancelPendingLoad();  // the previous pick may still be decoding
+    const quint64 loadId = Profiler::instance().beginLoad(QFileInfo(filePath).fileName());
+    Profiler::LoadScope loadScope(loadId);  // the tasks submitted below time their stages for it
+    const qint64 loadStart = Profiler::instance().now();
+    TaskScheduler::TaskOptions options;
+    options.token = m_loadToken;
+    const int generation = m_loadGeneration;
+
+    // Gigapixel files: an overview built in bounded memory, full-resolution tiles on zoom.
+    // Building the overview streams the whole file, so it runs on the scheduler too.
+    if (TiledImage::isLarge(filePath)) {
+        options.memoryHeavy = true;
+        ImageUtils::runAsync(TaskScheduler::Priority::VisibleFrame, [filePath]() {
+            std::shared_ptr<TiledImage> tiled = TiledImage::open(filePath);
+            // Lives on the GUI thread from here on, with the item that shows it
+            if (tiled) tiled->moveToThread(QCoreApplication::instance()->thread());
+            return tiled;
+            }, options)
+            .then(this, [this, generation, filePath, loadId, loadStart](const std::shared_ptr<TiledImage>& tiled) {
+                if (generation != m_loadGeneration) return;
+                Profiler::LoadScope loadScope(loadId);
+                if (!tiled) {
+                    QMessageBox::warning(this, "Image Load Error", "Failed to load image: " + filePath);
+                    return;
+                }
+                m_currentImagePath = filePath;
+                displayImage(tiled->takeOverview());
+                m_tileLayer = new TiledImageItem(tiled, m_originalPixmapItem);
+
+                Profiler& profiler = Profiler::instance();
+                profiler.record("load", loadStart, profiler.now() - loadStart);
+                updateTimingHud();
+                });
+        return;
+    }
+
+    // Decoded, colour managed and resampled on the scheduler; the GUI thread keeps showing
+    // the previous image until this one is ready, then only makes the pixmaps
+    ImageUtils::loadForDisplayAsync(filePath, TaskScheduler::Priority::VisibleFrame, options)
+        .then(this, [this, generation, filePath, loadId, loadStart](const QImage& qimg) {
+            if (generation != m_loadGeneration) return;
+            Profiler::LoadScope loadScope(loadId);
+            if (qimg.isNull()) {
+                QMessageBox::warning(this, "Image Load Error", "Failed to load image: " + filePath);
+                return;
+            }
+            m_currentImagePath = filePath;
+            displayImage(qimg);
+
+            Profiler& profiler = Profiler::instance();
+            profiler.record("load", loadStart, profiler.now() - loadStart);
+            updateTimingHud();
+            });
+}
+
+void MainWindow::displayImage(const QImage& qimg)
+{
+    cancelPendingFilters();    // they were for the previous image
+    m_view->scene()->clear();  // Clear old items
+
+    // (3) Create original pixmap
+    ScopedTimer pixmapTimer("qpixmap conversion");
+    QPixmap pixmap = QPixmap::fromImage(qimg);
+    pixmapTimer.stop();
+    m_originalPixmap = pixmap;
+    m_originalPixmapItem = new QGraphicsPixmapItem(pixmap);
+    m_view->scene()->addItem(m_originalPixmapItem);
+
+    // (4) Create grayscale pixmap. It's computed on the scheduler and counts as evicted
+    // until it arrives, so a button that needs it sooner makes it with restoreGrayscale()
+    m_grayscalePixmap = QPixmap();
+    m_grayscaleEvicted = true;
+    m_grayscalePixmapItem = new QGraphicsPixmapItem();
+    m_grayscalePixmapItem->setVisible(false);
+    m_view->scene()->addItem(m_grayscalePixmapItem);
+    TaskScheduler::TaskOptions options;
+    options.token = m_filterToken;
+    const qint64 originalKey = m_originalPixmap.cacheKey();
+    ImageUtils::convertToGrayscaleAsync(qimg, options).then(this, [this, originalKey](const QImage& gray) {
+        // Dropped if another image is shown by now, or the variant was already restored
+        if (m_originalPixmap.cacheKey() != originalKey || !m_grayscaleEvicted || !m_grayscalePixmapItem) return;
+        m_grayscalePixmap = QPixmap::fromImage(gray);
+        if (m_grayscalePixmapItem->pixmap().isNull())
+            m_grayscalePixmapItem->setPixmap(m_grayscalePixmap);
+        m_grayscaleEvicted = false;
+        updateImageMemory();
+        });
+
+    // (5) Determine the image's bounding rectangle
+    ScopedTimer sceneTimer("scene setup");
+    QRectF imageRect = m_originalPixmapItem->boundingRect();
+
+    // (6) Create lines based on imageRect
+    m_view->createAndAddLines(imageRect);
+    m_view->setLinesVisibility(false); // Hide lines initially if desired
+    sceneTimer.stop();
+
+    // (7) Save the ruler image after scene setup and before setting large margins
+    ScopedTimer rulerTimer("ruler save");
+    QString tempFilePath = QDir::tempPath() + "/ruler_images/ruler_image.png";
+    m_view->saveRulerImage(tempFilePath);
+    rulerTimer.stop();
+
+    // (8) Set the scene rectangle to imageRect plus margins for panning
+    ScopedTimer fitTimer("view fit");
+    qreal margin = 100000.0; // Adjust margin as needed
+    QRectF biggerRect = imageRect.adjusted(-margin, -margin, margin, margin);
+    m_view->scene()->setSceneRect(biggerRect);
+
+    // (9) Reset transformations to start fresh
+    m_view->resetTransform();
+
+    // (10) Fit the image within the view while maintaining aspect ratio
+    m_view->fitInView(imageRect, Qt::KeepAspectRatio);
+
+    // (11) Center the view on the original pixmap item
+    m_view->centerOn(m_originalPixmapItem);
+    fitTimer.stop();
+
+    // (12) Start the countdown timer
+    startTimerButton->click();
+
+    // (13) Save the image to a shared folder if enabled
+    if (m_copyPasteEnabled) {
+        saveImageToSharedFolder(qimg, "suffix");
+    }
+
+    // (14) Reset effect toggles
+    m_isBlurred = false;
+    m_isMedianFiltered = false;
+    m_isPosterized = false;
+    m_isGrayscale = false;
+}
+
+
+void MainWindow::processClipboardImage()
+{
+    QClipboard* clipboard = QApplication::clipboard();
+    const QMimeData* mimeData = clipboard->mimeData();
+    if (mimeData->hasImage()) {
+        QImage image = qvariant_cast<QImage>(mimeData->imageData());
+        processImage(image);
+    }
+    else if (mimeData->hasUrls()) {
+        QList<QUrl> urls = mimeData->urls();
+        if (!urls.isEmpty() && urls.first().isLocalFile()) {
+            processAndDisplayImage(urls.first().toLocalFile());
+        }
+        else {
+            QMessageBox::warning(this, "Error", "Clipboard does not contain a valid image path.");
+        }
+    }
+    else {
+        QMessageBox::warning(this, "Error", "No image found in clipboard.");
+    }
+}
+
+void MainWindow::processImage(const QImage& image)
+{
+    if (image.isNull()) {
+        QMessageBox::warning(this, "Error", "Clipboard does not contain a valid image.");
+        return;
+    }
+    // Straight from memory: no temp file, no encode/decode round trip. The colour profile
+    // comes from the clipboard data; the shared-folder export (if enabled) is written by
+    // the export thread.
+    cancelPendingLoad();  // the pasted image wins over a file still decoding
+    const quint64 loadId = Profiler::instance().beginLoad("clipboard");
+    Profiler::LoadScope loadScope(loadId);  // the task submitted below times its stages for it
+    const qint64 loadStart = Profiler::instance().now();
+    TaskScheduler::TaskOptions options;
+    options.token = m_loadToken;
+    options.memoryHeavy = true;
+    const int generation = m_loadGeneration;
+
+    // Colour managed and resampled on the scheduler, like a file; a large paste doesn't
+    // freeze the window, which keeps showing the previous image until this one is ready
+    ImageUtils::runAsync(TaskScheduler::Priority::InteractiveFilter, [image]() {
+        const cv::Mat mat = ImageUtils::convertQImageToMatWithColorProfile(image);
+        if (mat.empty()) return QImage();
+        ScopedTimer resizeTimer("resize");
+        const cv::Mat resampled = ImageUtils::lanczosResizeIfNeeded(mat);
+        resizeTimer.stop();
+        ScopedTimer convertTimer("qimage conversion");
+        return ImageUtils::convertMatToQImage(resampled);
+        }, options)
+        .then(this, [this, generation, loadId, loadStart](const QImage& qimg) {
+            if (generation != m_loadGeneration) return;
+            Profiler::LoadScope loadScope(loadId);
+            if (qimg.isNull()) {
+                QMessageBox::warning(this, "Error", "Failed to convert the clipboard image.");
+                return;
+            }
+            m_currentImagePath.clear();  // not a file: nothing to delete
+            displayImage(qimg);
+
+            Profiler& profiler = Profiler::instance();
+            profiler.record("load", loadStart, profiler.now() - loadStart);
+            updateTimingHud();
+            });
+}
+
+void MainWindow::saveImageToSharedFolder(const QImage& image, const QString& suffix)
+{
+    // Pasted images have no file
+    QString baseName = m_currentImagePath.isEmpty() ? QString("clipboard") : QFileInfo(m_currentImagePath).completeBaseName();
+    QString folderPath = QString("%1/%2").arg(m_retention->root()).arg(baseName);
+
+    // The folder is created by the export thread; old folders are evicted in the background
+    m_retention->touch(folderPath);
+    // Encoded and written on the export thread; the extension depends on the chosen format
+    QString basePath = QString("%1/%2_%3").arg(folderPath).arg(baseName).arg(suffix);
+    m_exportWriter->enqueue(image, basePath);
+}
+
+QPixmap MainWindow::displayedPixmap() const
+{
+    // Grayscale is done by showing/hiding m_grayscalePixmapItem
+    if (m_grayscalePixmapItem && m_grayscalePixmapItem->isVisible())
+        return m_grayscalePixmapItem->pixmap();
+    // The "Original" item (which might be blurred, median, or posterized)
+    if (m_originalPixmapItem)
+        return m_originalPixmapItem->pixmap();
+    return QPixmap();
+}
+
+void MainWindow::publishDisplayedImage()
+{
+    // toImage() is a full-frame copy: skip it while nobody is watching
+    if (m_liveFeed->consumerCount() == 0) return;
+    const QPixmap pixmap = displayedPixmap();
+    if (pixmap.isNull() || pixmap.cacheKey() == m_publishedPixmapKey) return;
+    m_publishedPixmapKey = pixmap.cacheKey();
+    m_liveFeed->publish(pixmap.toImage());
+}
+
+void MainWindow::updateImageMemory()
+{
+    m_originalMemory.set(m_originalPixmap);
+    m_grayscaleMemory.set(m_grayscalePixmap);
+    // An item showing a filtered or flipped image holds a pixmap of its own
+    qint64 filtered = 0;
+    if (m_originalPixmapItem && m_originalPixmapItem->pixmap().cacheKey() != m_originalPixmap.cacheKey())
+        filtered += MemoryBudget::bytesOf(m_originalPixmapItem->pixmap());
+    if (m_grayscalePixmapItem && m_grayscalePixmapItem->pixmap().cacheKey() != m_grayscalePixmap.cacheKey())
+        filtered += MemoryBudget::bytesOf(m_grayscalePixmapItem->pixmap());
+    m_filteredMemory.set(filtered);
+}
+
+qint64 MainWindow::evictGrayscale()
+{
+    // Only while it's hidden and unfiltered: then restoreGrayscale() gives back the same pixels
+    if (m_grayscaleEvicted || !m_grayscalePixmapItem || m_grayscalePixmapItem->isVisible()) return 0;
+    if (m_grayscalePixmapItem->pixmap().cacheKey() != m_grayscalePixmap.cacheKey()) return 0;
+
+    const qint64 bytes = MemoryBudget::bytesOf(m_grayscalePixmap);
+    m_grayscalePixmapItem->setPixmap(QPixmap());
+    m_grayscalePixmap = QPixmap();
+    m_grayscaleEvicted = true;
+    updateImageMemory();
+    qDebug() << "[MemoryBudget] Evicted the grayscale variant," << bytes / (1024 * 1024) << "MB";
+    return bytes;
+}
+
+void MainWindow::restoreGrayscale()
+{
+    if (!m_grayscaleEvicted || !m_grayscalePixmapItem) return;
+    ScopedTimer grayscaleTimer("grayscale restore");
+    m_grayscalePixmap = QPixmap::fromImage(ImageUtils::convertToGrayscale(m_originalPixmap.toImage()));
+    // A posterized grayscale delivered since the eviction stays
+    if (m_grayscalePixmapItem->pixmap().isNull())
+        m_grayscalePixmapItem->setPixmap(m_grayscalePixmap);
+    m_grayscaleEvicted = false;
+    updateImageMemory();
+}
+
+void MainWindow::updateTileLayer()
+{
+    // Filters, flips and the grayscale variant are of the overview; tiles would undo them
+    if (m_tileLayer && m_originalPixmapItem)
+        m_tileLayer->setVisible(m_originalPixmapItem->pixmap().cacheKey() == m_originalPixmap.cacheKey());
+}
+
+void MainWindow::updateTimingHud()
+{
+    if (!m_timingHud || !m_timingHud->isVisible()) return;
+
+    const Profiler& profiler = Profiler::instance();
+    const Profiler::StageSummary total = profiler.summary("load");
+    QStringList lines;
+    lines << profiler.lastLoadLabel();
+    lines << QString("%1 ms  (p50 %2 / p95 %3 / p99 %4)")
+        .arg(total.lastMs, 0, 'f', 1).arg(total.p50Ms, 0, 'f', 1)
+        .arg(total.p95Ms, 0, 'f', 1).arg(total.p99Ms, 0, 'f', 1);
+    for (const auto& stage : profiler.lastLoad()) {
+        if (stage.first == "load") continue;
+        lines << QString("%1 %2 ms").arg(stage.first, -20).arg(stage.second, 8, 'f', 1);
+    }
+    lines << MemoryBudget::instance().summary();
+    m_timingHud->setText(lines.join('\n'));
+    m_timingHud->adjustSize();
+}
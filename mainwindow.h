@@ -1,159 +1,218 @@
-#ifndef MAINWINDOW_H
-#define MAINWINDOW_H
-
-#include <QWidget>
-#include <QTime>
-#include <QTimer>
-#include <QFileInfoList>
-#include <QList>
-#include <QCloseEvent>
-#include <QMap>
-#include <QDateTime>
-#include <QSettings>
-#include <QGraphicsPixmapItem>
-#include <QKeyEvent>
-#include <QCheckBox>
-#include <QPushButton>
-#include <qguiapplication.h>
-
-class ZoomableGraphicsView;  // forward declaration
-class ScheduleDialog;
-
-class MainWindow : public QWidget
-{
-    Q_OBJECT
-public:
-    explicit MainWindow(QWidget* parent = nullptr);
-    ~MainWindow();   // destructor
-
-    // Enum for actions
-    enum class Action {
-        OpenDirectory,
-        History,
-        NextImage,
-        Flip,
-        Grayscale,
-        StartSchedule,
-        EditSchedule,
-        RotateClockwise,
-        RotateCounterclockwise,
-        Posterize,
-        Blur,
-        MedianFilter,
-        ToggleLines,
-        SaveRuler,
-        CopyDisplayedImage,
-        ProcessClipboard,
-        ConfirmDelete,
-        // etc.
-    };
-
-    //settings
-    QMap<QString, QString> m_hotkeyMappings;
-    QMap<Action, QString> m_actionNameMap;
-    QString m_customJSXPath;
-
-protected:
-    void closeEvent(QCloseEvent* event) override;
-    void keyPressEvent(QKeyEvent* event) override;
-
-    void performAction(Action action);
-
-    void onSettingsButtonClicked();
-
-    void refreshCustomJSXPath();
-
-private slots:
-    // UI-related slots
-    void onOpenButtonClicked();
-    void onHistoryButtonClicked();
-    void onNextButtonClicked();
-    void onFlipButtonClicked();
-    void onGrayscaleButtonClicked();
-    void onPosterizeButtonClicked(int levels);
-    void onDegradeButtonClicked();
-    void onMedianFilterButtonClicked();
-    void confirmAndMoveFileToDeleteFolder();
-    void startSchedule();
-    void editSchedule();
-
-private:
-    // Internal helper methods
-    void setDirectory(const QString& directory);
-    void loadImageFromDirectory(const QString& directory);
-    QString getRandomImage(const QString& directory);
-    void processAndDisplayImage(const QString& filePath);
-    void processClipboardImage();
-    void processImage(const QImage& image);
-    void saveImageToSharedFolder(const QImage& image, const QString& suffix);
-    void deleteOldestFolderIfNeeded();
-    QString m_tempDisplayedFilePath;
-    // Scheduling
-    void startNextTimerInSchedule();
-
-    // UI members
-    ZoomableGraphicsView* m_view;
-    QGraphicsPixmapItem* m_originalPixmapItem;
-    QGraphicsPixmapItem* m_grayscalePixmapItem;
-    QPushButton* startTimerButton;
-
-    // Pixmaps
-    QPixmap m_originalPixmap;
-    QPixmap m_grayscalePixmap;
-    QString m_tempRulerFilePath;
-    QString m_tempOriginalFilePath;
-    QString m_tempGrayscaleFilePath;
-
-    // Directory & file handling
-    QString m_directory;
-    QFileInfoList m_files;
-    int m_currentIndex = 0;
-    QStringList directoryHistory;
-    QString m_currentImagePath;
-
-    // Timers
-    bool scheduleActive;
-    QTime countdownTime;
-    QList<QTime> schedule;
-    int currentScheduleIndex;
-    QList<QTimer*> timers;
-    QTimer* m_countdownTimer;
-    bool isTimerRunning;
-
-    QPushButton* m_timeButton;
-    QTime m_defaultCountdownTime;
-
-    // Image states
-    bool m_isGrayscale;
-    bool m_isPosterized;
-    bool m_isBlurred;
-    bool m_isMedianFiltered;
-
-    // Folder housekeeping
-    QMap<QString, QDateTime> m_folderCreationTimes;
-    QString m_tempFilePath;
-
-    // Settings
-    QSettings settings;  // used to store/restore QSettings
-
-    // New member variable
-    bool m_copyPasteEnabled;
-
-    // Map each Action to a key code (Qt::Key_*)
-    QMap<Action, int> m_actionKeyMap;
-
-    // Reverse lookup: key code => Action
-    QMap<int, Action> m_keyActionMap;
-
-    // We'll store key->action. e.g. Qt::Key_F1 -> Action::ProcessClipboard
-    QMap<int, Action> m_defaultKeyMap;
-
-    // Also, some actions might open dynamic URLs. We'll keep a map of Action -> URL
-    // for the ones that are just open-URL type:
-    QMap<Action, QString> m_actionUrlMap;
-
-    // New method to apply posterization
-    void applyPosterization(int levels);
-};
-
+#ifndef MAINWINDOW_H
+#define MAINWINDOW_H
+
+#include <QWidget>
+#include <QTime>
+#include <QTimer>
+#include <QList>
+#include <QCloseEvent>
+#include <QMap>
+#include <QDateTime>
+#include <QSettings>
+#include <QGraphicsPixmapItem>
+#include <QKeyEvent>
+#include <QCheckBox>
+#include <QPushButton>
+#include <QPointer>
+#include <qguiapplication.h>
+#include "fileindex.h"
+#include "randompermutation.h"
+#include "pickquery.h"
+#include "taskscheduler.h"
+#include "memorybudget.h"
+
+class ZoomableGraphicsView;  // forward declaration
+class ScheduleDialog;
+class DirectoryWatcher;
+class AnalysisIndex;
+class ExportWriter;
+class RetentionManager;
+class LiveFeed;
+class QLabel;
+class TiledImageItem;
+
+class MainWindow : public QWidget
+{
+    Q_OBJECT
+public:
+    explicit MainWindow(QWidget* parent = nullptr);
+    ~MainWindow();   // destructor
+
+    // Enum for actions
+    enum class Action {
+        OpenDirectory,
+        History,
+        NextImage,
+        Flip,
+        Grayscale,
+        StartSchedule,
+        EditSchedule,
+        RotateClockwise,
+        RotateCounterclockwise,
+        Posterize,
+        Blur,
+        MedianFilter,
+        ToggleLines,
+        SaveRuler,
+        CopyDisplayedImage,
+        ProcessClipboard,
+        ConfirmDelete,
+        // etc.
+    };
+
+    //settings
+    QMap<QString, QString> m_hotkeyMappings;
+    QMap<Action, QString> m_actionNameMap;
+    QString m_customJSXPath;
+
+protected:
+    void closeEvent(QCloseEvent* event) override;
+    void keyPressEvent(QKeyEvent* event) override;
+
+    void performAction(Action action);
+
+    void onSettingsButtonClicked();
+
+    void refreshCustomJSXPath();
+
+private slots:
+    // UI-related slots
+    void onOpenButtonClicked();
+    void onHistoryButtonClicked();
+    void onNextButtonClicked();
+    void onFlipButtonClicked();
+    void onGrayscaleButtonClicked();
+    void onPosterizeButtonClicked(int levels);
+    void onDegradeButtonClicked();
+    void onMedianFilterButtonClicked();
+    void confirmAndMoveFileToDeleteFolder();
+    void startSchedule();
+    void editSchedule();
+    void onFilterButtonClicked();
+
+    // Live index updates from the directory watcher
+    void onFilesAdded(const QStringList& paths);
+    void onArchiveMembersAdded(const QStringList& paths);
+    void onFilesRemoved(const QStringList& paths);
+
+private:
+    // Internal helper methods
+    void addToIndex(const QStringList& paths, bool archiveMembers);
+    void setDirectory(const QString& directory);
+    void loadImageFromDirectory(const QString& directory);
+    QString getRandomImage(const QString& directory);
+    void prefetchNextPick();  // hints the OS to cache the likely next pick
+    void processAndDisplayImage(const QString& filePath);
+    void displayImage(const QImage& qimg);  // shows an already loaded and resampled image
+    void processClipboardImage();
+    void processImage(const QImage& image);
+    void saveImageToSharedFolder(const QImage& image, const QString& suffix);
+    QPixmap displayedPixmap() const;  // grayscale or original, whichever is visible
+    void publishDisplayedImage();
+    void updateTimingHud();  // last load's stage breakdown, if the HUD is enabled
+    void cancelPendingFilters();  // results of filters still computing are dropped
+    void cancelPendingLoad();     // a file still decoding is not shown
+    void updateImageMemory();     // reports the pixmaps to the MemoryBudget
+    qint64 evictGrayscale();      // MemoryBudget evictor for the hidden grayscale variant
+    void restoreGrayscale();      // recomputes it if it was evicted
+    void updateTileLayer();       // full-resolution tiles only over the unmodified image
+    QString m_tempDisplayedFilePath;
+    // Scheduling
+    void startNextTimerInSchedule();
+
+    // UI members
+    ZoomableGraphicsView* m_view;
+    QGraphicsPixmapItem* m_originalPixmapItem;
+    QGraphicsPixmapItem* m_grayscalePixmapItem;
+    QPointer<TiledImageItem> m_tileLayer;  // over m_originalPixmapItem for gigapixel files
+    QPushButton* startTimerButton;
+
+    // Pixmaps
+    QPixmap m_originalPixmap;
+    QPixmap m_grayscalePixmap;
+    QString m_tempRulerFilePath;
+    QString m_tempOriginalFilePath;
+    QString m_tempGrayscaleFilePath;
+    // Filtered item pixmaps count as derived too; the hidden, unfiltered grayscale is evictable
+    MemoryBudget::Tracked m_originalMemory{ MemoryBudget::Category::Display };
+    MemoryBudget::Tracked m_grayscaleMemory{ MemoryBudget::Category::Derived };
+    MemoryBudget::Tracked m_filteredMemory{ MemoryBudget::Category::Derived };
+    QTimer* m_memoryTimer = nullptr;  // MemoryBudget::enforce() every few seconds
+    int m_grayscaleEvictor = 0;
+    bool m_grayscaleEvicted = false;
+
+    // Directory & file handling
+    QString m_directory;
+    FileIndex m_fileIndex;
+    DirectoryWatcher* m_directoryWatcher;
+    RandomPermutation m_pickOrder;  // no-repeat order over m_fileIndex ids, persisted per folder
+    AnalysisIndex* m_analysisIndex;
+    ExportWriter* m_exportWriter;   // writes the shared-folder images off the GUI thread
+    RetentionManager* m_retention;  // keeps the shared folder within its budget
+    LiveFeed* m_liveFeed;           // displayed frame in shared memory for local consumers
+    qint64 m_publishedPixmapKey = 0;
+    QLabel* m_timingHud = nullptr;  // overlay on the view, see updateTimingHud()
+    void saveShuffleState();
+    void restoreShuffleState();
+    // unprobed collects (some of) the files left out because their header wasn't probed yet
+    bool matchesPickFilter(FileIndex::Id id, std::vector<FileIndex::Id>* unprobed = nullptr);
+    bool setPickQuery(const QString& text);
+    PickQuery m_pickQuery;              // optional filter on the analysed statistics
+    QString m_pickOrientation = "any";  // "any", "landscape" or "portrait" (settings pickOrientation)
+    double m_pickMinMegapixels = 0.0;   // settings pickMinMegapixels
+    bool m_pickSkippedUnanalysed = false;
+    bool m_pickSkippedUnprobed = false;
+    QStringList directoryHistory;
+    QString m_currentImagePath;
+
+    // Timers
+    bool scheduleActive;
+    QTime countdownTime;
+    QList<QTime> schedule;
+    int currentScheduleIndex;
+    QList<QTimer*> timers;
+    QTimer* m_countdownTimer;
+    bool isTimerRunning;
+
+    QPushButton* m_timeButton;
+    QTime m_defaultCountdownTime;
+
+    // Image states
+    bool m_isGrayscale;
+    bool m_isPosterized;
+    bool m_isBlurred;
+    bool m_isMedianFiltered;
+    // Filters run on the TaskScheduler; a newer request or image supersedes pending ones
+    TaskScheduler::CancellationToken m_filterToken;
+    int m_filterGeneration = 0;
+    // The same for the file being decoded; a newer pick or paste supersedes it
+    TaskScheduler::CancellationToken m_loadToken;
+    int m_loadGeneration = 0;
+
+    // Folder housekeeping
+    QString m_tempFilePath;
+
+    // Settings
+    QSettings settings;  // used to store/restore QSettings
+
+    // New member variable
+    bool m_copyPasteEnabled;
+
+    // Map each Action to a key code (Qt::Key_*)
+    QMap<Action, int> m_actionKeyMap;
+
+    // Reverse lookup: key code => Action
+    QMap<int, Action> m_keyActionMap;
+
+    // We'll store key->action. e.g. Qt::Key_F1 -> Action::ProcessClipboard
+    QMap<int, Action> m_defaultKeyMap;
+
+    // Also, some actions might open dynamic URLs. We'll keep a map of Action -> URL
+    // for the ones that are just open-URL type:
+    QMap<Action, QString> m_actionUrlMap;
+
+    // New method to apply posterization
+    void applyPosterization(int levels);
+};
+
 #endif // MAINWINDOW_H
\ No newline at end of file
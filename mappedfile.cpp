@@ -0,0 +1,97 @@
+// mappedfile.cpp
+
+#include "mappedfile.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QStorageInfo>
+
+#ifdef Q_OS_WIN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#endif
+
+namespace {
+    // Asks for the pages of a mapping to be read in ahead of the first access
+    void adviseWillNeed(uchar* data, qint64 size)
+    {
+#ifdef Q_OS_WIN
+#if _WIN32_WINNT >= 0x0602
+        WIN32_MEMORY_RANGE_ENTRY range{ data, static_cast<SIZE_T>(size) };
+        PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+#else
+        Q_UNUSED(data);
+        Q_UNUSED(size);
+#endif
+#else
+        madvise(data, static_cast<size_t>(size), MADV_WILLNEED);
+#endif
+    }
+}
+
+MappedFile::MappedFile(const QString& filePath)
+    : m_file(filePath)
+{
+    const QFileInfo info(filePath);
+    if (!canMapSafely(filePath) || !m_file.open(QIODevice::ReadOnly)) return;
+    m_size = m_file.size();
+    m_modified = info.lastModified();
+    m_data = m_size > 0 ? m_file.map(0, m_size) : nullptr;
+    if (!m_data) {
+        qDebug() << "[MappedFile] Cannot map" << filePath;
+        m_size = 0;
+        return;
+    }
+    adviseWillNeed(m_data, m_size);
+}
+
+MappedFile::~MappedFile()
+{
+    if (m_data)
+        m_file.unmap(m_data);
+}
+
+bool MappedFile::isUnchanged() const
+{
+    const QFileInfo info(m_file.fileName());
+    return info.size() == m_size && info.lastModified() == m_modified;
+}
+
+QByteArray MappedFile::bytes() const
+{
+    return QByteArray::fromRawData(reinterpret_cast<const char*>(m_data), static_cast<qsizetype>(m_size));
+}
+
+bool MappedFile::canMapSafely(const QString& filePath)
+{
+#ifdef Q_OS_WIN
+    const QFileInfo info(filePath);
+    if (!info.isFile()) return false;
+    const QString root = QDir::toNativeSeparators(QStorageInfo(info.absoluteFilePath()).rootPath());
+    return !root.isEmpty() && GetDriveTypeW(reinterpret_cast<LPCWSTR>(root.utf16())) == DRIVE_FIXED;
+#else
+    Q_UNUSED(filePath);
+    return false;  // any process may truncate the file under the reader
+#endif
+}
+
+void MappedFile::prefetch(const QString& filePath)
+{
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) return;
+
+#ifdef Q_OS_LINUX
+    // Queues read-ahead for the whole file and returns
+    posix_fadvise(file.handle(), 0, 0, POSIX_FADV_WILLNEED);
+#else
+    // The pages stay in the OS file cache after the view is unmapped
+    const qint64 size = file.size();
+    uchar* data = size > 0 ? file.map(0, size) : nullptr;
+    if (!data) return;
+    adviseWillNeed(data, size);
+    file.unmap(data);
+#endif
+}
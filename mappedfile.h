@@ -0,0 +1,58 @@
+// mappedfile.h
+
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <QByteArray>
+#include <QDateTime>
+#include <QFile>
+#include <QString>
+#include <QtGlobal>
+
+/*!
+ * \brief The MappedFile class maps a whole file read-only, so the decoders read the page
+ *        cache directly instead of a heap copy of the file.
+ *
+ *        The pages of the mapping are requested up front (PrefetchVirtualMemory), so the disk
+ *        works ahead of the decoder. bytes() wraps the mapping without copying it and is valid
+ *        for as long as the MappedFile lives. prefetch() starts reading a file into the OS
+ *        cache without mapping it, for files that are likely to be opened next.
+ *
+ *        A page of the mapping that can't be read any more faults in whatever code touches it
+ *        (SIGBUS on POSIX when another process truncates the file, an in-page error on Windows
+ *        when a network or removable drive goes away), so files are only mapped on local fixed
+ *        drives on Windows, which refuses to truncate a file with a mapped view. Elsewhere
+ *        isValid() is false and the caller reads the file. A file rewritten in place while
+ *        mapped gives torn bytes instead: isUnchanged() tells the caller to read it again.
+ */
+class MappedFile
+{
+public:
+    explicit MappedFile(const QString& filePath);
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // False if the file isn't mapped (see above), can't be opened, or is empty
+    bool isValid() const { return m_data != nullptr; }
+    // False if the file's size or modification time changed since it was mapped
+    bool isUnchanged() const;
+    const uchar* data() const { return m_data; }
+    qint64 size() const { return m_size; }
+    // The mapping as a QByteArray, without a copy; don't keep it past the MappedFile
+    QByteArray bytes() const;
+
+    // Hints the OS to read filePath into its cache in the background. Cheap; never blocks on I/O
+    static void prefetch(const QString& filePath);
+
+    // Whether a mapping of filePath stays readable for as long as it is mapped (see above)
+    static bool canMapSafely(const QString& filePath);
+
+private:
+    QFile m_file;
+    uchar* m_data = nullptr;
+    qint64 m_size = 0;
+    QDateTime m_modified;
+};
+
+#endif // MAPPEDFILE_H
@@ -0,0 +1,285 @@
+// memorybudget.cpp
+
+#include "memorybudget.h"
+#include "scratcharena.h"
+
+#include <QDebug>
+#include <QFile>
+#include <QMutexLocker>
+#include <QStringList>
+#include <algorithm>
+#include <atomic>
+
+#ifdef Q_OS_WIN
+#include <windows.h>
+#endif
+
+namespace {
+    const qint64 kMinAutoBudget = qint64(1) << 30;   // 1 GiB
+    const qint64 kFallbackBudget = qint64(2) << 30;  // physical memory unknown
+    const double kStallThreshold = 10.0;             // % of the last 10 s some task waited on memory
+    const double kLowAvailableFraction = 0.10;
+
+    std::atomic<qint64> g_bytes[MemoryBudget::kCategoryCount];
+    std::atomic<qint64> g_peak{ 0 };
+
+    // Cheapest to rebuild first; Display is never evicted
+    const MemoryBudget::Category kEvictionOrder[] = {
+        MemoryBudget::Category::Scratch,
+        MemoryBudget::Category::Transient,
+        MemoryBudget::Category::Overlay,
+        MemoryBudget::Category::Derived,
+    };
+
+    qint64 toMB(qint64 bytes)
+    {
+        return bytes / (1024 * 1024);
+    }
+
+#ifdef Q_OS_LINUX
+    // Value of "key" in a line like "some avg10=1.20 avg60=0.35 avg300=0.08 total=1234"
+    double psiField(const QByteArray& line, const QByteArray& key)
+    {
+        for (const QByteArray& field : line.simplified().split(' ')) {
+            if (field.startsWith(key + '=')) {
+                bool ok = false;
+                const double value = field.mid(key.size() + 1).toDouble(&ok);
+                return ok ? value : -1.0;
+            }
+        }
+        return -1.0;
+    }
+#endif
+}
+
+MemoryBudget::Tracked::Tracked(Category category, qint64 bytes)
+    : m_category(category)
+{
+    set(bytes);
+}
+
+MemoryBudget::Tracked::~Tracked()
+{
+    set(0);
+}
+
+MemoryBudget::Tracked::Tracked(Tracked&& other) noexcept
+    : m_category(other.m_category),
+    m_bytes(other.m_bytes)
+{
+    other.m_bytes = 0;
+}
+
+MemoryBudget::Tracked& MemoryBudget::Tracked::operator=(Tracked&& other) noexcept
+{
+    if (this != &other) {
+        set(0);
+        m_category = other.m_category;
+        m_bytes = other.m_bytes;
+        other.m_bytes = 0;
+    }
+    return *this;
+}
+
+void MemoryBudget::Tracked::set(qint64 bytes)
+{
+    bytes = qMax<qint64>(0, bytes);
+    if (bytes == m_bytes) return;
+    MemoryBudget::instance().account(m_category, bytes - m_bytes);
+    m_bytes = bytes;
+}
+
+MemoryBudget& MemoryBudget::instance()
+{
+    static MemoryBudget budget;
+    return budget;
+}
+
+MemoryBudget::MemoryBudget()
+{
+    addEvictor(Category::Scratch, []() { return ScratchArena::trimAll(); });
+}
+
+void MemoryBudget::account(Category category, qint64 delta)
+{
+    g_bytes[static_cast<int>(category)].fetch_add(delta, std::memory_order_relaxed);
+    if (delta <= 0) return;
+    const qint64 total = trackedTotal();
+    qint64 peak = g_peak.load(std::memory_order_relaxed);
+    while (total > peak && !g_peak.compare_exchange_weak(peak, total, std::memory_order_relaxed)) {
+    }
+}
+
+qint64 MemoryBudget::trackedTotal() const
+{
+    qint64 total = 0;
+    for (int i = 0; i < kCategoryCount; ++i) {
+        if (i == static_cast<int>(Category::Scratch)) continue;
+        total += g_bytes[i].load(std::memory_order_relaxed);
+    }
+    const ScratchArena::Stats scratch = ScratchArena::stats();
+    return total + scratch.idleBytes + scratch.leasedBytes;
+}
+
+void MemoryBudget::setBudget(qint64 bytes)
+{
+    QMutexLocker locker(&m_mutex);
+    m_budget = qMax<qint64>(0, bytes);
+}
+
+qint64 MemoryBudget::budget() const
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_budget > 0) return m_budget;
+    }
+    static const qint64 automatic = []() {
+        const Pressure pressure = readPressure();
+        if (pressure.totalBytes <= 0) return kFallbackBudget;
+        return qMax(kMinAutoBudget, pressure.totalBytes / 4);
+    }();
+    return automatic;
+}
+
+int MemoryBudget::addEvictor(Category category, Evictor evictor)
+{
+    QMutexLocker locker(&m_mutex);
+    const int id = m_nextEvictorId++;
+    m_evictors.push_back({ id, category, std::move(evictor) });
+    return id;
+}
+
+void MemoryBudget::removeEvictor(int id)
+{
+    QMutexLocker locker(&m_mutex);
+    m_evictors.erase(std::remove_if(m_evictors.begin(), m_evictors.end(),
+        [id](const Entry& entry) { return entry.id == id; }), m_evictors.end());
+}
+
+qint64 MemoryBudget::enforce()
+{
+    const Pressure pressure = readPressure();
+    const Usage now = usage();
+    std::vector<Entry> evictors;
+    {
+        QMutexLocker locker(&m_mutex);
+        m_pressure = pressure;
+        evictors = m_evictors;  // evictors may add or remove evictors
+    }
+
+    // Under pressure everything but the displayed image goes
+    qint64 excess = now.total - now.budget;
+    if (pressure.high)
+        excess = qMax(excess, now.total - now.bytes[static_cast<int>(Category::Display)]);
+    if (excess <= 0) return 0;
+
+    qint64 freed = 0;
+    for (Category category : kEvictionOrder) {
+        for (const Entry& entry : evictors) {
+            if (freed >= excess) break;
+            if (entry.category == category) freed += entry.evictor();
+        }
+    }
+    if (freed <= 0) return 0;
+
+    {
+        QMutexLocker locker(&m_mutex);
+        ++m_evictions;
+        m_evictedBytes += freed;
+    }
+    qDebug() << "[MemoryBudget]" << (pressure.high ? "Under memory pressure," : "Over budget,") << "using"
+        << toMB(now.total) << "of" << toMB(now.budget) << "MB; freed" << toMB(freed) << "MB";
+    return freed;
+}
+
+MemoryBudget::Usage MemoryBudget::usage() const
+{
+    Usage usage;
+    for (int i = 0; i < kCategoryCount; ++i) {
+        usage.bytes[i] = g_bytes[i].load(std::memory_order_relaxed);
+    }
+    const ScratchArena::Stats scratch = ScratchArena::stats();
+    usage.bytes[static_cast<int>(Category::Scratch)] = scratch.idleBytes + scratch.leasedBytes;
+    for (qint64 bytes : usage.bytes) {
+        usage.total += bytes;
+    }
+    usage.peak = qMax(usage.total, g_peak.load(std::memory_order_relaxed));
+    usage.budget = budget();
+
+    QMutexLocker locker(&m_mutex);
+    usage.pressure = m_pressure;
+    usage.evictions = m_evictions;
+    usage.evictedBytes = m_evictedBytes;
+    return usage;
+}
+
+QString MemoryBudget::summary() const
+{
+    const Usage now = usage();
+    QStringList parts;
+    for (int i = 0; i < kCategoryCount; ++i) {
+        if (now.bytes[i] > 0)
+            parts << QString("%1 %2").arg(QString::fromLatin1(categoryName(static_cast<Category>(i)))).arg(toMB(now.bytes[i]));
+    }
+    QString text = QString("memory %1 / %2 MB").arg(toMB(now.total)).arg(toMB(now.budget));
+    if (!parts.isEmpty())
+        text += "  (" + parts.join(", ") + ")";
+    if (now.pressure.high)
+        text += "  PRESSURE";
+    return text;
+}
+
+MemoryBudget::Pressure MemoryBudget::readPressure()
+{
+    Pressure pressure;
+#ifdef Q_OS_WIN
+    MEMORYSTATUSEX status;
+    status.dwLength = sizeof(status);
+    if (GlobalMemoryStatusEx(&status)) {
+        pressure.totalBytes = static_cast<qint64>(status.ullTotalPhys);
+        pressure.availableBytes = static_cast<qint64>(status.ullAvailPhys);
+    }
+#elif defined(Q_OS_LINUX)
+    // Pressure stall information (Linux 4.20+): the share of time tasks waited on memory
+    QFile psi("/proc/pressure/memory");
+    if (psi.open(QIODevice::ReadOnly)) {
+        for (const QByteArray& line : psi.readAll().split('\n')) {
+            if (line.startsWith("some ")) pressure.stallPercent = psiField(line, "avg10");
+        }
+    }
+    QFile meminfo("/proc/meminfo");
+    if (meminfo.open(QIODevice::ReadOnly)) {
+        for (const QByteArray& line : meminfo.readAll().split('\n')) {
+            // "MemAvailable:    1234567 kB"
+            const QList<QByteArray> fields = line.simplified().split(' ');
+            if (fields.size() < 2) continue;
+            if (fields[0] == "MemTotal:") pressure.totalBytes = fields[1].toLongLong() * 1024;
+            else if (fields[0] == "MemAvailable:") pressure.availableBytes = fields[1].toLongLong() * 1024;
+        }
+    }
+#endif
+    if (pressure.stallPercent >= kStallThreshold)
+        pressure.high = true;
+    if (pressure.totalBytes > 0 && pressure.availableBytes >= 0
+        && pressure.availableBytes < static_cast<qint64>(pressure.totalBytes * kLowAvailableFraction))
+        pressure.high = true;
+    return pressure;
+}
+
+qint64 MemoryBudget::bytesOf(const QPixmap& pixmap)
+{
+    if (pixmap.isNull()) return 0;
+    return static_cast<qint64>(pixmap.width()) * pixmap.height() * pixmap.depth() / 8;
+}
+
+const char* MemoryBudget::categoryName(Category category)
+{
+    switch (category) {
+    case Category::Display: return "display";
+    case Category::Derived: return "derived";
+    case Category::Overlay: return "overlay";
+    case Category::Transient: return "transient";
+    case Category::Scratch: return "scratch";
+    }
+    return "";
+}
@@ -0,0 +1,128 @@
+// memorybudget.h
+
+#ifndef MEMORYBUDGET_H
+#define MEMORYBUDGET_H
+
+#include <QImage>
+#include <QMutex>
+#include <QPixmap>
+#include <QString>
+#include <QtGlobal>
+#include <functional>
+#include <vector>
+
+/*!
+ * \brief The MemoryBudget class accounts for the image buffers alive in the process, by
+ *        category, and frees what can be rebuilt when they exceed the budget or the system
+ *        runs short of memory.
+ *
+ *        Owners report their buffers through Tracked members (any thread); the scratch
+ *        arenas are read from ScratchArena::stats(). enforce() is called periodically on the
+ *        GUI thread: it reads the memory pressure (PSI or /proc/meminfo on Linux,
+ *        GlobalMemoryStatusEx on Windows) and, over budget or under pressure, runs the
+ *        registered evictors, idle scratch memory first, then derived images. The displayed
+ *        image is never evicted.
+ */
+class MemoryBudget
+{
+public:
+    enum class Category {
+        Display,    // the loaded image
+        Derived,    // grayscale and filtered variants, rebuilt from the loaded image
+        Overlay,    // ruler and other drawn layers
+        Transient,  // copies held while a filter runs
+        Scratch     // ScratchArena workspace, leased and idle
+    };
+    static const int kCategoryCount = 5;
+
+    /*!
+     * \brief The Tracked class reports one buffer (or a group of them) to the budget for as
+     *        long as it lives. Thread-safe, move-only.
+     */
+    class Tracked {
+    public:
+        explicit Tracked(Category category, qint64 bytes = 0);
+        ~Tracked();
+        Tracked(Tracked&& other) noexcept;
+        Tracked& operator=(Tracked&& other) noexcept;
+        Tracked(const Tracked&) = delete;
+        Tracked& operator=(const Tracked&) = delete;
+
+        void set(qint64 bytes);
+        void set(const QImage& image) { set(image.sizeInBytes()); }
+        void set(const QPixmap& pixmap) { set(bytesOf(pixmap)); }
+        qint64 bytes() const { return m_bytes; }
+
+    private:
+        Category m_category;
+        qint64 m_bytes = 0;
+    };
+
+    struct Pressure {
+        qint64 totalBytes = -1;      // physical memory, -1 if unknown
+        qint64 availableBytes = -1;
+        double stallPercent = -1.0;  // PSI "some avg10", -1 if unavailable
+        bool high = false;
+    };
+
+    struct Usage {
+        qint64 bytes[kCategoryCount] = {};
+        qint64 total = 0;
+        qint64 peak = 0;
+        qint64 budget = 0;
+        Pressure pressure;           // as of the last enforce()
+        quint64 evictions = 0;       // enforce() passes that freed something
+        qint64 evictedBytes = 0;
+    };
+
+    // Returns the bytes it freed
+    using Evictor = std::function<qint64()>;
+
+    static MemoryBudget& instance();
+
+    // 0 selects the automatic budget: a quarter of physical memory, at least 1 GiB
+    void setBudget(qint64 bytes);
+    qint64 budget() const;
+
+    // Evictors run on the GUI thread, from enforce()
+    int addEvictor(Category category, Evictor evictor);
+    void removeEvictor(int id);
+
+    /*!
+     * \brief enforce evicts until usage is back within the budget, or everything evictable
+     *        when the system is under memory pressure. GUI thread. Returns the bytes freed.
+     */
+    qint64 enforce();
+
+    Usage usage() const;
+    // One line for the timing HUD and the log
+    QString summary() const;
+
+    static Pressure readPressure();
+    static qint64 bytesOf(const QPixmap& pixmap);
+    static const char* categoryName(Category category);
+
+private:
+    MemoryBudget();
+    MemoryBudget(const MemoryBudget&) = delete;
+    MemoryBudget& operator=(const MemoryBudget&) = delete;
+
+    void account(Category category, qint64 delta);
+    qint64 trackedTotal() const;
+
+    struct Entry {
+        int id;
+        Category category;
+        Evictor evictor;
+    };
+
+    mutable QMutex m_mutex;
+    std::vector<Entry> m_evictors;
+    int m_nextEvictorId = 1;
+    qint64 m_budget = 0;  // 0: automatic
+    Pressure m_pressure;
+    quint64 m_evictions = 0;
+    qint64 m_evictedBytes = 0;
+};
+
+#endif // MEMORYBUDGET_H
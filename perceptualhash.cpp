@@ -0,0 +1,103 @@
+// perceptualhash.cpp
+
+#include "perceptualhash.h"
+
+#include <QImageReader>
+#include <QDebug>
+
+namespace PerceptualHash {
+
+    quint64 fromImage(const QImage& image)
+    {
+        if (image.isNull()) return 0;
+
+        // 9x8 so every row gives 8 left/right comparisons
+        const QImage small = image.convertToFormat(QImage::Format_Grayscale8)
+            .scaled(9, 8, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+
+        quint64 hash = 0;
+        for (int y = 0; y < 8; ++y) {
+            const uchar* row = small.constScanLine(y);
+            for (int x = 0; x < 8; ++x) {
+                hash = (hash << 1) | (row[x] > row[x + 1] ? 1u : 0u);
+            }
+        }
+        return hash;
+    }
+
+    quint64 fromFile(const QString& filePath, bool* ok)
+    {
+        QImageReader reader(filePath);
+        reader.setAutoTransform(true);  // hash what the user sees, not the raw EXIF orientation
+
+        // Asking for a small size lets the JPEG plugin decode at 1/8 scale
+        const QSize fullSize = reader.size();
+        if (fullSize.isValid())
+            reader.setScaledSize(fullSize.scaled(72, 64, Qt::KeepAspectRatioByExpanding).boundedTo(fullSize));
+
+        const QImage image = reader.read();
+        if (image.isNull()) {
+            if (ok) *ok = false;
+            return 0;
+        }
+        if (ok) *ok = true;
+        return fromImage(image);
+    }
+
+} // namespace PerceptualHash
+
+void HammingBKTree::insert(quint64 hash, quint32 value)
+{
+    Node node;
+    node.hash = hash;
+    node.value = value;
+    node.firstChild = -1;
+    node.nextSibling = -1;
+    node.distanceToParent = 0;
+
+    if (m_nodes.empty()) {
+        m_nodes.push_back(node);
+        return;
+    }
+
+    qint32 current = 0;
+    for (;;) {
+        const int d = PerceptualHash::distance(hash, m_nodes[current].hash);
+        qint32 child = m_nodes[current].firstChild;
+        while (child >= 0 && m_nodes[child].distanceToParent != d) {
+            child = m_nodes[child].nextSibling;
+        }
+        if (child < 0) {
+            node.distanceToParent = d;
+            node.nextSibling = m_nodes[current].firstChild;
+            const qint32 index = static_cast<qint32>(m_nodes.size());
+            m_nodes.push_back(node);
+            m_nodes[current].firstChild = index;
+            return;
+        }
+        current = child;
+    }
+}
+
+void HammingBKTree::find(quint64 hash, int maxDistance, std::vector<quint32>* values) const
+{
+    if (m_nodes.empty()) return;
+
+    std::vector<qint32> stack;
+    stack.push_back(0);
+    while (!stack.empty()) {
+        const Node& node = m_nodes[stack.back()];
+        stack.pop_back();
+
+        const int d = PerceptualHash::distance(hash, node.hash);
+        if (d <= maxDistance)
+            values->push_back(node.value);
+
+        // Triangle inequality: only subtrees at distance [d - max, d + max] can match
+        for (qint32 child = node.firstChild; child >= 0; child = m_nodes[child].nextSibling) {
+            const int cd = m_nodes[child].distanceToParent;
+            if (cd >= d - maxDistance && cd <= d + maxDistance)
+                stack.push_back(child);
+        }
+    }
+}
@@ -0,0 +1,68 @@
+// perceptualhash.h
+
+#ifndef PERCEPTUALHASH_H
+#define PERCEPTUALHASH_H
+
+#include <QtGlobal>
+#include <QtAlgorithms>
+#include <QImage>
+#include <QString>
+#include <vector>
+
+/*!
+ * \brief The PerceptualHash namespace computes 64-bit difference hashes (dHash) that stay
+ *        (nearly) the same across resaves, recompression, small crops and resolution changes.
+ */
+namespace PerceptualHash {
+
+    /*!
+     * \brief fromImage computes the dHash of an already decoded image.
+     * \param image Any QImage; it is reduced to a 9x8 grayscale thumbnail.
+     * \return The 64-bit hash (bit set where a pixel is brighter than its right neighbour).
+     */
+    quint64 fromImage(const QImage& image);
+
+    /*!
+     * \brief fromFile decodes a small version of the file (JPEG is decoded at reduced scale)
+     *        and hashes it. Safe to call from worker threads (no ImageMagick involved).
+     * \param filePath Path to the image file.
+     * \param ok Set to false if the file could not be decoded.
+     */
+    quint64 fromFile(const QString& filePath, bool* ok = nullptr);
+
+    // Number of differing bits (popcount of the xor)
+    inline int distance(quint64 a, quint64 b)
+    {
+        return qPopulationCount(a ^ b);
+    }
+
+} // namespace PerceptualHash
+
+/*!
+ * \brief The HammingBKTree class is a BK-tree over 64-bit hashes for "everything within
+ *        N bits of this hash" queries without comparing against every entry.
+ */
+class HammingBKTree
+{
+public:
+    void clear() { m_nodes.clear(); }
+    void insert(quint64 hash, quint32 value);
+    bool isEmpty() const { return m_nodes.empty(); }
+
+    // Appends the values of all hashes within maxDistance bits of hash
+    void find(quint64 hash, int maxDistance, std::vector<quint32>* values) const;
+
+private:
+    // Children are kept as a sibling list (distance to parent stored in the child)
+    // so a node stays small even with a million entries.
+    struct Node {
+        quint64 hash;
+        quint32 value;
+        qint32 firstChild;
+        qint32 nextSibling;
+        qint32 distanceToParent;
+    };
+    std::vector<Node> m_nodes;
+};
+
+#endif // PERCEPTUALHASH_H
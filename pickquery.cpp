@@ -0,0 +1,313 @@
+// pickquery.cpp
+
+#include "pickquery.h"
+#include "imagestats.h"
+
+#include <QStringList>
+
+namespace {
+
+    struct FieldName {
+        const char* name;
+        PickQuery::Field field;
+    };
+    const FieldName kFieldNames[] = {
+        { "key", PickQuery::MeanLuma },     { "luma", PickQuery::MeanLuma },  { "mean", PickQuery::MeanLuma },
+        { "p10", PickQuery::P10Luma },      { "p50", PickQuery::P50Luma },    { "median", PickQuery::P50Luma },
+        { "p90", PickQuery::P90Luma },      { "sat", PickQuery::Saturation }, { "saturation", PickQuery::Saturation },
+        { "color", PickQuery::Colorfulness }, { "colorfulness", PickQuery::Colorfulness },
+        { "width", PickQuery::Width },      { "height", PickQuery::Height },
+        { "mp", PickQuery::Megapixels },    { "megapixels", PickQuery::Megapixels },
+        { "aspect", PickQuery::Aspect },
+    };
+
+    struct Preset {
+        const char* name;
+        const char* expression;
+    };
+    const Preset kPresets[] = {
+        { "highkey", "p50 >= 65 and p10 >= 30" },
+        { "lowkey", "p50 <= 35 and p90 <= 70" },
+        { "muted", "sat <= 20" },
+        { "colorful", "color >= 60" },
+        { "gray", "color < 5" },
+        { "landscape", "aspect > 1" },
+        { "portrait", "aspect < 1" },
+    };
+
+    const int kMaxPresetDepth = 4;
+
+} // namespace
+
+class PickQuery::Parser
+{
+public:
+    Parser(const QString& text, PickQuery* query, int depth)
+        : m_text(text), m_query(query), m_depth(depth)
+    {
+        advance();
+    }
+
+    bool parseAll(QString* error)
+    {
+        if (!expression()) {
+            if (error) *error = m_error;
+            return false;
+        }
+        if (m_token != Token::End) {
+            if (error) *error = QString("Unexpected '%1'").arg(m_word);
+            return false;
+        }
+        return true;
+    }
+
+private:
+    enum class Token { End, Word, Number, Symbol, LeftParen, RightParen };
+
+    void advance()
+    {
+        while (m_pos < m_text.size() && m_text[m_pos].isSpace()) ++m_pos;
+        m_word.clear();
+        if (m_pos >= m_text.size()) {
+            m_token = Token::End;
+            return;
+        }
+
+        const QChar c = m_text[m_pos];
+        const int start = m_pos;
+        if (c.isLetter() || c == '_') {
+            while (m_pos < m_text.size() && (m_text[m_pos].isLetterOrNumber() || m_text[m_pos] == '_')) ++m_pos;
+            m_token = Token::Word;
+            m_word = m_text.mid(start, m_pos - start).toLower();
+        }
+        else if (c.isDigit() || c == '.' || (c == '-' && m_pos + 1 < m_text.size() && m_text[m_pos + 1].isDigit())) {
+            ++m_pos;
+            while (m_pos < m_text.size() && (m_text[m_pos].isDigit() || m_text[m_pos] == '.')) ++m_pos;
+            m_token = Token::Number;
+            m_word = m_text.mid(start, m_pos - start);
+            m_number = m_word.toDouble();
+            if (m_pos < m_text.size() && m_text[m_pos] == '%') ++m_pos;  // "sat < 20%" reads naturally
+        }
+        else if (c == '(' || c == ')') {
+            ++m_pos;
+            m_token = c == '(' ? Token::LeftParen : Token::RightParen;
+            m_word = c;
+        }
+        else {
+            static const char* const symbols[] = { "<=", ">=", "!=", "==", "&&", "||", "<", ">", "=", "!" };
+            m_token = Token::Symbol;
+            for (const char* symbol : symbols) {
+                const QLatin1String s(symbol);
+                if (QStringView(m_text).mid(m_pos).startsWith(s)) {
+                    m_word = s;
+                    m_pos += s.size();
+                    return;
+                }
+            }
+            m_word = c;  // unknown character; reported by the caller
+            ++m_pos;
+        }
+    }
+
+    bool fail(const QString& message)
+    {
+        if (m_error.isEmpty()) m_error = message;
+        return false;
+    }
+
+    void append(Instruction::Kind kind)
+    {
+        m_query->m_program.push_back({ kind, MeanLuma, Compare::Equal, 0.0, 0 });
+    }
+
+    bool isWord(const char* word) const
+    {
+        return m_token == Token::Word && m_word == QLatin1String(word);
+    }
+
+    bool startsFactor() const
+    {
+        return (m_token == Token::Word && m_word != "or" && m_word != "and")
+            || m_token == Token::LeftParen || (m_token == Token::Symbol && m_word == "!");
+    }
+
+    bool expression()
+    {
+        if (!term()) return false;
+        while (isWord("or") || (m_token == Token::Symbol && m_word == "||")) {
+            advance();
+            if (!term()) return false;
+            append(Instruction::Or);
+        }
+        return true;
+    }
+
+    bool term()
+    {
+        if (!factor()) return false;
+        for (;;) {
+            if (isWord("and") || (m_token == Token::Symbol && m_word == "&&")) {
+                advance();
+            }
+            else if (!startsFactor()) {
+                return true;
+            }
+            if (!factor()) return false;
+            append(Instruction::And);
+        }
+    }
+
+    bool factor()
+    {
+        if (isWord("not") || (m_token == Token::Symbol && m_word == "!")) {
+            advance();
+            if (!factor()) return false;
+            append(Instruction::Not);
+            return true;
+        }
+        if (m_token == Token::LeftParen) {
+            advance();
+            if (!expression()) return false;
+            if (m_token != Token::RightParen) return fail("Expected ')'");
+            advance();
+            return true;
+        }
+        if (m_token != Token::Word) {
+            return fail(m_token == Token::End ? QString("Unexpected end of query") : QString("Unexpected '%1'").arg(m_word));
+        }
+
+        const QString name = m_word;
+        for (const Preset& preset : kPresets) {
+            if (name == QLatin1String(preset.name)) {
+                advance();
+                if (m_depth >= kMaxPresetDepth) return fail("Presets nested too deeply");
+                Parser nested(QString::fromLatin1(preset.expression), m_query, m_depth + 1);
+                return nested.parseAll(&m_error);
+            }
+        }
+
+        if (name == "hue") {
+            advance();
+            if (m_token != Token::Symbol || (m_word != "=" && m_word != "==" && m_word != "!="))
+                return fail("Expected '=' or '!=' after 'hue'");
+            const bool negate = m_word == "!=";
+            advance();
+            const int bin = m_token == Token::Word ? ImageStats::hueBinFromName(m_word) : -1;
+            if (bin < 0) return fail(QString("Unknown hue '%1'").arg(m_word));
+            advance();
+            m_query->m_program.push_back({ Instruction::HasHue, MeanLuma, Compare::Equal, 0.0, static_cast<quint16>(1u << bin) });
+            if (negate) append(Instruction::Not);
+            m_query->m_usesStats = true;
+            return true;
+        }
+
+        const FieldName* field = nullptr;
+        for (const FieldName& candidate : kFieldNames) {
+            if (name == QLatin1String(candidate.name)) field = &candidate;
+        }
+        if (!field) return fail(QString("Unknown field '%1'").arg(name));
+        advance();
+
+        Compare compare;
+        if (m_token != Token::Symbol) return fail(QString("Expected a comparison after '%1'").arg(name));
+        if (m_word == "<") compare = Compare::Less;
+        else if (m_word == "<=") compare = Compare::LessEqual;
+        else if (m_word == ">") compare = Compare::Greater;
+        else if (m_word == ">=") compare = Compare::GreaterEqual;
+        else if (m_word == "=" || m_word == "==") compare = Compare::Equal;
+        else if (m_word == "!=") compare = Compare::NotEqual;
+        else return fail(QString("Expected a comparison after '%1'").arg(name));
+        const QString op = m_word;
+        advance();
+
+        if (m_token != Token::Number) return fail(QString("Expected a number after '%1 %2'").arg(name, op));
+        m_query->m_program.push_back({ Instruction::Test, field->field, compare, m_number, 0 });
+        if (field->field >= Width) m_query->m_usesSize = true;
+        else m_query->m_usesStats = true;
+        advance();
+        return true;
+    }
+
+    const QString m_text;
+    PickQuery* m_query;
+    const int m_depth;
+    int m_pos = 0;
+    Token m_token = Token::End;
+    QString m_word;
+    double m_number = 0.0;
+    QString m_error;
+};
+
+bool PickQuery::parse(const QString& text, PickQuery* query, QString* error)
+{
+    PickQuery result;
+    result.m_text = text.trimmed();
+    if (!result.m_text.isEmpty()) {
+        Parser parser(result.m_text, &result, 0);
+        if (!parser.parseAll(error))
+            return false;
+    }
+    *query = result;
+    return true;
+}
+
+bool PickQuery::matches(const Values& values) const
+{
+    if (m_program.empty()) return true;
+
+    // Nesting is bounded by the query length, so a small fixed stack is plenty in practice
+    std::vector<bool> stack;
+    stack.reserve(16);
+    for (const Instruction& instruction : m_program) {
+        switch (instruction.kind) {
+        case Instruction::Test: {
+            const double v = values.fields[instruction.field];
+            bool result = false;
+            switch (instruction.compare) {
+            case Compare::Less: result = v < instruction.value; break;
+            case Compare::LessEqual: result = v <= instruction.value; break;
+            case Compare::Greater: result = v > instruction.value; break;
+            case Compare::GreaterEqual: result = v >= instruction.value; break;
+            case Compare::Equal: result = v == instruction.value; break;
+            case Compare::NotEqual: result = v != instruction.value; break;
+            }
+            stack.push_back(result);
+            break;
+        }
+        case Instruction::HasHue:
+            stack.push_back((values.hueBins & instruction.hueMask) != 0);
+            break;
+        case Instruction::Not:
+            stack.back() = !stack.back();
+            break;
+        case Instruction::And:
+        case Instruction::Or: {
+            const bool right = stack.back();
+            stack.pop_back();
+            stack.back() = instruction.kind == Instruction::And ? (stack.back() && right) : (stack.back() || right);
+            break;
+        }
+        }
+    }
+    return stack.back();
+}
+
+QString PickQuery::help()
+{
+    QStringList presets;
+    for (const Preset& preset : kPresets) {
+        presets << QString("%1 (%2)").arg(QLatin1String(preset.name), QLatin1String(preset.expression));
+    }
+    QStringList hues;
+    for (int bin = 0; bin < ImageStats::kHueBinCount; ++bin) {
+        hues << ImageStats::hueName(bin);
+    }
+    return QString(
+        "Fields: key (mean luma %), p10, p50, p90 (luma percentiles %), sat (saturation %), "
+        "color (colourfulness, 0 gray .. 60 vivid), width, height, mp, aspect.\n"
+        "Compare with < <= > >= = !=, combine with and, or, not and parentheses. "
+        "hue = <name> matches images with a significant share of that hue: %1.\n"
+        "Presets: %2.\n"
+        "Statistics are computed in the background; files not analysed yet don't match.")
+        .arg(hues.join(", "), presets.join(", "));
+}
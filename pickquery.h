@@ -0,0 +1,87 @@
+// pickquery.h
+
+#ifndef PICKQUERY_H
+#define PICKQUERY_H
+
+#include <QtGlobal>
+#include <QString>
+#include <vector>
+
+/*!
+ * \brief The PickQuery class is a small filter language for random picks, evaluated
+ *        against the per-file values in the AnalysisIndex (no decoding at pick time).
+ *
+ *        Examples:
+ *          highkey
+ *          key >= 60 and sat < 25
+ *          (hue = blue or hue = teal) and not lowkey
+ *          mp >= 8 aspect < 1
+ *
+ *        Comparisons are "field op number" with op one of < <= > >= = !=. Terms are combined
+ *        with and/or/not (also && || !) and parentheses; terms next to each other are and-ed.
+ *        See help() for the fields and presets.
+ */
+class PickQuery
+{
+public:
+    enum Field {
+        MeanLuma,       // key, luma: mean luma in percent
+        P10Luma,        // p10: shadows, percent
+        P50Luma,        // p50, median: percent
+        P90Luma,        // p90: highlights, percent
+        Saturation,     // sat: mean saturation in percent
+        Colorfulness,   // color: Hasler-Suesstrunk colourfulness (0 gray .. 100+ vivid)
+        Width,          // displayed size in pixels
+        Height,
+        Megapixels,     // mp
+        Aspect,         // width / height as displayed
+        FieldCount
+    };
+
+    // The values of one file; statistics and size are filled in only if the query uses them
+    struct Values {
+        double fields[FieldCount] = {};
+        quint16 hueBins = 0;
+    };
+
+    /*!
+     * \brief parse compiles a query.
+     * \param text The query; empty (or whitespace) gives an empty query that matches everything.
+     * \param error Set to a short description when parsing fails.
+     * \return True on success (query is only modified then).
+     */
+    static bool parse(const QString& text, PickQuery* query, QString* error = nullptr);
+
+    bool isEmpty() const { return m_program.empty(); }
+    const QString& text() const { return m_text; }
+
+    // Whether evaluating needs the image statistics / the probed size
+    bool usesStats() const { return m_usesStats; }
+    bool usesSize() const { return m_usesSize; }
+
+    bool matches(const Values& values) const;
+
+    // One-paragraph description of the syntax, fields and presets for the UI
+    static QString help();
+
+private:
+    class Parser;
+
+    enum class Compare { Less, LessEqual, Greater, GreaterEqual, Equal, NotEqual };
+
+    // Reverse Polish notation: comparisons push a bool, And/Or/Not combine the top of the stack
+    struct Instruction {
+        enum Kind { Test, HasHue, And, Or, Not } kind;
+        Field field;
+        Compare compare;
+        double value;
+        quint16 hueMask;
+    };
+
+    std::vector<Instruction> m_program;
+    QString m_text;
+    bool m_usesStats = false;
+    bool m_usesSize = false;
+};
+
+#endif // PICKQUERY_H
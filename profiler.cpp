@@ -0,0 +1,210 @@
+// profiler.cpp
+
+#include "profiler.h"
+
+#include <QDebug>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <QThread>
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    const int kWindow = 256;        // samples per stage for the percentiles
+    const size_t kMaxEvents = 20000;
+    const int kMaxLoadStages = 64;  // lastLoad() entries
+
+    thread_local quint64 tCurrentLoad = 0;
+}
+
+Profiler::LoadScope::LoadScope(quint64 loadId)
+    : m_previous(tCurrentLoad)
+{
+    tCurrentLoad = loadId;
+}
+
+Profiler::LoadScope::~LoadScope()
+{
+    tCurrentLoad = m_previous;
+}
+
+Profiler& Profiler::instance()
+{
+    static Profiler profiler;
+    return profiler;
+}
+
+Profiler::Profiler()
+{
+    m_clock.start();
+    m_events.reserve(kMaxEvents);
+}
+
+qint64 Profiler::now() const
+{
+    return m_clock.nsecsElapsed();
+}
+
+quint64 Profiler::currentLoad()
+{
+    return tCurrentLoad;
+}
+
+int Profiler::threadIndex()
+{
+    const quintptr id = reinterpret_cast<quintptr>(QThread::currentThreadId());
+    auto it = m_threads.constFind(id);
+    if (it != m_threads.constEnd()) return it.value();
+    const int index = m_threads.size() + 1;
+    m_threads.insert(id, index);
+    return index;
+}
+
+void Profiler::record(const char* stage, qint64 startNs, qint64 durationNs)
+{
+    const double ms = durationNs / 1e6;
+    const quint64 load = tCurrentLoad;
+    QMutexLocker locker(&m_mutex);
+
+    Event event{ stage, startNs, durationNs, threadIndex(), load, QString() };
+    if (m_events.size() < kMaxEvents) m_events.push_back(event);
+    else m_events[m_nextEvent] = event;
+    m_nextEvent = (m_nextEvent + 1) % kMaxEvents;
+
+    // Only in the trace: a filter's or the export's "resize" isn't a load's
+    if (load == 0) return;
+
+    const QByteArray name(stage);
+    auto it = m_stages.find(name);
+    if (it == m_stages.end()) {
+        it = m_stages.insert(name, Stage());
+        it->samples.reserve(kWindow);
+        m_stageOrder.append(name);
+    }
+    Stage& s = it.value();
+    if (static_cast<int>(s.samples.size()) < kWindow) s.samples.push_back(ms);
+    else s.samples[s.next] = ms;
+    s.next = (s.next + 1) % kWindow;
+    s.lastMs = ms;
+
+    // A superseded load's tasks may still finish after the next one began
+    if (load == m_loadId && m_lastLoad.size() < kMaxLoadStages)
+        m_lastLoad.append({ QString::fromLatin1(stage), ms });
+}
+
+quint64 Profiler::beginLoad(const QString& label)
+{
+    QMutexLocker locker(&m_mutex);
+    ++m_loadId;
+    m_loadLabel = label;
+    m_lastLoad.clear();
+
+    Event event{ nullptr, now(), 0, threadIndex(), m_loadId, label };
+    if (m_events.size() < kMaxEvents) m_events.push_back(event);
+    else m_events[m_nextEvent] = event;
+    m_nextEvent = (m_nextEvent + 1) % kMaxEvents;
+    return m_loadId;
+}
+
+QString Profiler::lastLoadLabel() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_loadLabel;
+}
+
+QList<QPair<QString, double>> Profiler::lastLoad() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_lastLoad;
+}
+
+Profiler::StageSummary Profiler::summarize(const QByteArray& name, const Stage& stage) const
+{
+    StageSummary summary;
+    summary.stage = QString::fromLatin1(name);
+    summary.count = static_cast<int>(stage.samples.size());
+    summary.lastMs = stage.lastMs;
+    if (stage.samples.empty()) return summary;
+
+    std::vector<double> sorted = stage.samples;
+    std::sort(sorted.begin(), sorted.end());
+    auto percentile = [&sorted](double p) {
+        // Nearest-rank
+        const size_t rank = static_cast<size_t>(std::ceil(p * sorted.size()));
+        return sorted[rank > 0 ? rank - 1 : 0];
+    };
+    summary.p50Ms = percentile(0.50);
+    summary.p95Ms = percentile(0.95);
+    summary.p99Ms = percentile(0.99);
+    return summary;
+}
+
+QList<Profiler::StageSummary> Profiler::summaries() const
+{
+    QMutexLocker locker(&m_mutex);
+    QList<StageSummary> result;
+    for (const QByteArray& name : m_stageOrder) {
+        result.append(summarize(name, m_stages.value(name)));
+    }
+    return result;
+}
+
+Profiler::StageSummary Profiler::summary(const char* stage) const
+{
+    QMutexLocker locker(&m_mutex);
+    const QByteArray name(stage);
+    return summarize(name, m_stages.value(name));
+}
+
+bool Profiler::writeChromeTrace(const QString& path) const
+{
+    QJsonArray events;
+    {
+        QMutexLocker locker(&m_mutex);
+        // Oldest first
+        const size_t count = m_events.size();
+        const size_t first = count < kMaxEvents ? 0 : m_nextEvent;
+        for (size_t i = 0; i < count; ++i) {
+            const Event& e = m_events[(first + i) % count];
+            QJsonObject event;
+            event["pid"] = 1;
+            event["tid"] = e.thread;
+            event["ts"] = e.startNs / 1000.0;  // microseconds
+            if (e.load) event["args"] = QJsonObject{ { "load", static_cast<qint64>(e.load) } };
+            if (e.name) {
+                event["name"] = QString::fromLatin1(e.name);
+                event["cat"] = "load";
+                event["ph"] = "X";
+                event["dur"] = e.durationNs / 1000.0;
+            }
+            else {
+                event["name"] = "load " + e.label;
+                event["cat"] = "marker";
+                event["ph"] = "i";
+                event["s"] = "t";
+            }
+            events.append(event);
+        }
+    }
+
+    QJsonObject root;
+    root["traceEvents"] = events;
+    root["displayTimeUnit"] = "ms";
+
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "[Profiler] Cannot write trace:" << path;
+        return false;
+    }
+    file.write(QJsonDocument(root).toJson(QJsonDocument::Compact));
+    if (!file.commit()) {
+        qWarning() << "[Profiler] Cannot write trace:" << path;
+        return false;
+    }
+    qDebug() << "[Profiler] Wrote" << events.size() << "trace events to" << path;
+    return true;
+}
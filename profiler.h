@@ -0,0 +1,137 @@
+// profiler.h
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <QString>
+#include <QList>
+#include <QPair>
+#include <QHash>
+#include <QByteArray>
+#include <QMutex>
+#include <QElapsedTimer>
+#include <vector>
+
+/*!
+ * \brief The Profiler class collects stage timings (see ScopedTimer) for the image loading
+ *        pipeline.
+ *
+ *        A stage belongs to the load its thread works on (see LoadScope). Stages of a load
+ *        keep their last samples for rolling p50/p95/p99 figures, and those of the latest
+ *        load make up lastLoad(); stages timed outside any load (filters, prefetch, export,
+ *        tiles) don't skew either. Every timing is also kept in a bounded event log that can
+ *        be written as Chrome trace-event JSON (open it in chrome://tracing or
+ *        https://ui.perfetto.dev). Thread-safe.
+ */
+class Profiler
+{
+public:
+    struct StageSummary {
+        QString stage;
+        int count = 0;       // samples in the rolling window
+        double lastMs = 0.0;
+        double p50Ms = 0.0;
+        double p95Ms = 0.0;
+        double p99Ms = 0.0;
+    };
+
+    /*!
+     * \brief The LoadScope class makes the stages timed on this thread, until it's destroyed,
+     *        count for a load. ImageUtils::runAsync carries the submitting thread's load
+     *        over to the task.
+     */
+    class LoadScope
+    {
+    public:
+        explicit LoadScope(quint64 loadId);
+        ~LoadScope();
+
+    private:
+        quint64 m_previous;
+
+        LoadScope(const LoadScope&) = delete;
+        LoadScope& operator=(const LoadScope&) = delete;
+    };
+
+    static Profiler& instance();
+
+    // Nanoseconds since the profiler was created (the trace's time base)
+    qint64 now() const;
+
+    // stage must be a string literal (or otherwise outlive the profiler)
+    void record(const char* stage, qint64 startNs, qint64 durationNs);
+
+    // Starts a new load: lastLoad() collects the stages recorded for it. Returns its id,
+    // for the LoadScopes of the code that works on it
+    quint64 beginLoad(const QString& label);
+    // The load this thread works on, 0 if none
+    static quint64 currentLoad();
+    QString lastLoadLabel() const;
+    QList<QPair<QString, double>> lastLoad() const;  // stage, ms, in recording order
+
+    QList<StageSummary> summaries() const;
+    StageSummary summary(const char* stage) const;
+
+    bool writeChromeTrace(const QString& path) const;
+
+private:
+    Profiler();
+
+    struct Stage {
+        std::vector<double> samples;  // ring buffer, ms
+        int next = 0;
+        double lastMs = 0.0;
+    };
+    struct Event {
+        const char* name;      // nullptr: load marker
+        qint64 startNs;
+        qint64 durationNs;
+        int thread;
+        quint64 load;          // 0: outside any load
+        QString label;         // load markers only
+    };
+
+    StageSummary summarize(const QByteArray& name, const Stage& stage) const;
+    int threadIndex();
+
+    QElapsedTimer m_clock;
+    mutable QMutex m_mutex;
+    QHash<QByteArray, Stage> m_stages;
+    QList<QByteArray> m_stageOrder;
+    std::vector<Event> m_events;  // ring buffer
+    size_t m_nextEvent = 0;
+    QHash<quintptr, int> m_threads;
+    quint64 m_loadId = 0;
+    QString m_loadLabel;
+    QList<QPair<QString, double>> m_lastLoad;
+};
+
+/*!
+ * \brief The ScopedTimer class times the enclosing scope (or until stop()) as one stage.
+ */
+class ScopedTimer
+{
+public:
+    explicit ScopedTimer(const char* stage)
+        : m_stage(stage), m_start(Profiler::instance().now())
+    {
+    }
+    ~ScopedTimer() { stop(); }
+
+    void stop()
+    {
+        if (!m_stage) return;
+        Profiler& profiler = Profiler::instance();
+        profiler.record(m_stage, m_start, profiler.now() - m_start);
+        m_stage = nullptr;
+    }
+
+private:
+    const char* m_stage;
+    qint64 m_start;
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+};
+
+#endif // PROFILER_H
@@ -0,0 +1,169 @@
+// randompermutation.cpp
+
+#include "randompermutation.h"
+
+#include <algorithm>
+
+namespace {
+    // splitmix64 finalizer: cheap, well-mixed 64-bit hash
+    inline quint64 mix64(quint64 x)
+    {
+        x += 0x9E3779B97F4A7C15ull;
+        x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+        x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+        return x ^ (x >> 31);
+    }
+
+    // Smallest power-of-two exponent covering rangeSize (at least 2 so both Feistel halves exist)
+    int bitsFor(quint64 rangeSize)
+    {
+        int bits = 2;
+        while (bits < 62 && (quint64(1) << bits) < rangeSize) {
+            ++bits;
+        }
+        return bits;
+    }
+
+    quint64 freshSeed()
+    {
+        std::random_device rd;
+        return (quint64(rd()) << 32) ^ quint64(rd());
+    }
+}
+
+RandomPermutation::RandomPermutation()
+{
+    setKey(0, 2);
+    m_position = domainSize();  // "exhausted": the first next() starts a real cycle
+}
+
+void RandomPermutation::setKey(quint64 seed, int bits)
+{
+    m_seed = seed;
+    m_bits = bits;
+    m_halfBits = (bits + 1) / 2;
+    m_halfMask = (quint64(1) << m_halfBits) - 1;
+    quint64 k = seed;
+    for (int i = 0; i < kRounds; ++i) {
+        k = mix64(k);
+        m_roundKeys[i] = k;
+    }
+}
+
+void RandomPermutation::reset(quint64 rangeSize)
+{
+    const quint64 seed = freshSeed();
+    setKey(seed, bitsFor(rangeSize));
+    m_position = 0;
+    m_pending.clear();
+    m_rng.seed(seed);
+}
+
+bool RandomPermutation::restore(quint64 seed, int bits, quint64 position, const std::vector<quint64>& pending)
+{
+    if (bits < 2 || bits > 62 || position > (quint64(1) << bits))
+        return false;
+    setKey(seed, bits);
+    m_position = position;
+    m_pending = pending;
+    m_rng.seed(seed ^ position);
+    return true;
+}
+
+quint64 RandomPermutation::round(quint64 half, int i) const
+{
+    return mix64(half ^ m_roundKeys[i]) & m_halfMask;
+}
+
+quint64 RandomPermutation::encrypt(quint64 x) const
+{
+    quint64 left = x >> m_halfBits;
+    quint64 right = x & m_halfMask;
+    for (int i = 0; i < kRounds; ++i) {
+        const quint64 newRight = left ^ round(right, i);
+        left = right;
+        right = newRight;
+    }
+    return (left << m_halfBits) | right;
+}
+
+quint64 RandomPermutation::decrypt(quint64 x) const
+{
+    quint64 left = x >> m_halfBits;
+    quint64 right = x & m_halfMask;
+    for (int i = kRounds - 1; i >= 0; --i) {
+        const quint64 newLeft = right ^ round(left, i);
+        right = left;
+        left = newLeft;
+    }
+    return (left << m_halfBits) | right;
+}
+
+quint64 RandomPermutation::map(quint64 index) const
+{
+    // The Feistel domain is 2^(2*halfBits), at most twice 2^bits: cycle-walk back into range
+    const quint64 domain = domainSize();
+    quint64 value = encrypt(index);
+    while (value >= domain) {
+        value = encrypt(value);
+    }
+    return value;
+}
+
+quint64 RandomPermutation::inverse(quint64 value) const
+{
+    const quint64 domain = domainSize();
+    quint64 index = decrypt(value);
+    while (index >= domain) {
+        index = decrypt(index);
+    }
+    return index;
+}
+
+void RandomPermutation::makeEligible(quint64 value)
+{
+    if (value < domainSize() && inverse(value) >= m_position)
+        return;  // the counter will still get there
+    if (std::find(m_pending.cbegin(), m_pending.cend(), value) == m_pending.cend())
+        m_pending.push_back(value);
+}
+
+quint64 RandomPermutation::next(quint64 rangeSize, const std::function<bool(quint64)>& eligible)
+{
+    if (rangeSize == 0) return InvalidValue;
+
+    int newCycles = 0;
+    for (;;) {
+        const quint64 domain = domainSize();
+        const quint64 remaining = m_position < domain ? domain - m_position : 0;
+
+        // Interleave the pending values uniformly with what is left of the counter
+        if (!m_pending.empty()) {
+            const double inRange = static_cast<double>(std::min(rangeSize, domain)) / static_cast<double>(domain);
+            const quint64 left = static_cast<quint64>(static_cast<double>(remaining) * inRange);
+            std::uniform_int_distribution<quint64> dist(0, m_pending.size() + left - 1);
+            if (remaining == 0 || dist(m_rng) < m_pending.size()) {
+                std::uniform_int_distribution<size_t> pick(0, m_pending.size() - 1);
+                const size_t i = pick(m_rng);
+                const quint64 value = m_pending[i];
+                m_pending[i] = m_pending.back();
+                m_pending.pop_back();
+                if (value < rangeSize && (!eligible || eligible(value)))
+                    return value;
+                continue;
+            }
+        }
+
+        if (remaining == 0) {
+            // Cycle finished: start a new one sized for the current range.
+            // If a whole fresh cycle produced nothing, nothing is eligible.
+            if (++newCycles > 1) return InvalidValue;
+            reset(rangeSize);
+            continue;
+        }
+
+        const quint64 value = map(m_position++);
+        if (value < rangeSize && (!eligible || eligible(value)))
+            return value;
+    }
+}
@@ -0,0 +1,76 @@
+// randompermutation.h
+
+#ifndef RANDOMPERMUTATION_H
+#define RANDOMPERMUTATION_H
+
+#include <QtGlobal>
+#include <functional>
+#include <random>
+#include <vector>
+
+/*!
+ * \brief The RandomPermutation class walks [0, N) in a random order without storing it.
+ *
+ *        The order is a keyed Feistel network over [0, 2^bits), cycle-walked down to the
+ *        power-of-two domain M >= N. A traversal ("cycle") is just a counter running from 0
+ *        to M; values >= N are skipped, so the whole state is (seed, bits, position) and can be
+ *        saved in QSettings to continue the same no-repeat order after a restart.
+ *
+ *        Growing the range: M stays fixed for the rest of a cycle. A new id that maps to a
+ *        position the counter hasn't reached yet is picked up naturally; ids whose position was
+ *        already passed (or that don't fit in M) go to a small pending list that is drawn
+ *        interleaved with the rest of the cycle. The next cycle is sized for the new N.
+ */
+class RandomPermutation
+{
+public:
+    static constexpr quint64 InvalidValue = ~quint64(0);
+
+    RandomPermutation();
+
+    // Starts a new cycle with a fresh random seed, sized for rangeSize
+    void reset(quint64 rangeSize);
+
+    // Continues a saved cycle. Returns false (and leaves the state untouched) if it doesn't look valid.
+    bool restore(quint64 seed, int bits, quint64 position, const std::vector<quint64>& pending);
+
+    /*!
+     * \brief next returns the next value of the traversal.
+     * \param rangeSize Current N; values >= N are skipped.
+     * \param eligible Optional filter (e.g. "not removed"); rejected values are skipped for this cycle.
+     * \return A value in [0, rangeSize), or InvalidValue if nothing is eligible.
+     */
+    quint64 next(quint64 rangeSize, const std::function<bool(quint64)>& eligible = {});
+
+    // Makes sure value is visited in the current cycle even if its position was already passed
+    void makeEligible(quint64 value);
+
+    // The bijection on [0, 2^bits) and its inverse
+    quint64 map(quint64 index) const;
+    quint64 inverse(quint64 value) const;
+
+    quint64 seed() const { return m_seed; }
+    int bits() const { return m_bits; }
+    quint64 position() const { return m_position; }
+    quint64 domainSize() const { return quint64(1) << m_bits; }
+    const std::vector<quint64>& pending() const { return m_pending; }
+
+private:
+    void setKey(quint64 seed, int bits);
+    quint64 encrypt(quint64 x) const;
+    quint64 decrypt(quint64 x) const;
+    quint64 round(quint64 half, int i) const;
+
+    static const int kRounds = 6;
+
+    quint64 m_seed = 0;
+    int m_bits = 2;
+    int m_halfBits = 1;
+    quint64 m_halfMask = 1;
+    quint64 m_roundKeys[kRounds] = {};
+    quint64 m_position = 0;
+    std::vector<quint64> m_pending;
+    std::mt19937_64 m_rng;
+};
+
+#endif // RANDOMPERMUTATION_H
@@ -1,12 +1,12 @@
-﻿// reference picker REFRACTORED.cpp : Defines the entry point for the application.
-//
-
-#include "reference picker REFRACTORED.h"
-
-using namespace std;
-
-int main()
-{
-	cout << "Hello CMake." << endl;
-	return 0;
-}
+﻿// reference picker REFRACTORED.cpp : Defines the entry point for the application.
+//
+
+#include "reference picker REFRACTORED.h"
+
+using namespace std;
+
+int main()
+{
+	cout << "Hello CMake." << endl;
+	return 0;
+}
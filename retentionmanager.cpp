@@ -0,0 +1,416 @@
+// retentionmanager.cpp
+
+#include "retentionmanager.h"
+#include "exportwriter.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QRegularExpression>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QThread>
+#include <algorithm>
+#include <functional>
+#include <vector>
+
+#ifdef Q_OS_WIN
+#include <windows.h>
+#else
+#include <sys/stat.h>
+#endif
+
+namespace {
+    const int kSettleMs = 2000;         // let the writes that follow a touch land before measuring
+    const qint64 kProtectMs = 60000;    // folders used this recently are never evicted
+
+    const quint32 kManifestMagic = 0x52524554;  // "RRET"
+    const quint32 kManifestVersion = 2;         // 2: adds the legacy-adoption flag
+
+    // Identity and link count of a file, so hard links are counted once
+    bool fileIdentity(const QString& path, quint64* volume, quint64* index, quint32* links)
+    {
+#ifdef Q_OS_WIN
+        const QString native = QDir::toNativeSeparators(path);
+        HANDLE handle = CreateFileW(reinterpret_cast<LPCWSTR>(native.utf16()), 0,
+            FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, 0, nullptr);
+        if (handle == INVALID_HANDLE_VALUE) return false;
+        BY_HANDLE_FILE_INFORMATION info;
+        const bool ok = GetFileInformationByHandle(handle, &info) != 0;
+        CloseHandle(handle);
+        if (!ok) return false;
+        *volume = info.dwVolumeSerialNumber;
+        *index = (quint64(info.nFileIndexHigh) << 32) | info.nFileIndexLow;
+        *links = info.nNumberOfLinks;
+#else
+        struct stat st;
+        if (::stat(QFile::encodeName(path).constData(), &st) != 0) return false;
+        *volume = static_cast<quint64>(st.st_dev);
+        *index = static_cast<quint64>(st.st_ino);
+        *links = static_cast<quint32>(st.st_nlink);
+#endif
+        return true;
+    }
+}
+
+RetentionManager::RetentionManager(QObject* parent)
+    : QObject(parent),
+    m_thread(QThread::create([this]() { run(); }))
+{
+    m_thread->setObjectName("RetentionManager");
+    m_thread->start(QThread::LowestPriority);
+}
+
+RetentionManager::~RetentionManager()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_stopping = true;
+        m_wake.wakeAll();
+    }
+    m_thread->wait();
+    delete m_thread;
+}
+
+QString RetentionManager::defaultRoot()
+{
+    return "C:/REFERENCE/Sharing";
+}
+
+void RetentionManager::setRoot(const QString& root)
+{
+    QMutexLocker locker(&m_mutex);
+    const QString cleaned = QDir::cleanPath(root);
+    if (cleaned == m_root) return;
+    m_root = cleaned;
+    m_pending = true;
+    m_wake.wakeAll();
+}
+
+QString RetentionManager::root() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_root;
+}
+
+void RetentionManager::setBudget(const Budget& budget)
+{
+    QMutexLocker locker(&m_mutex);
+    m_budget = budget;
+    m_pending = true;
+    m_wake.wakeAll();
+}
+
+RetentionManager::Budget RetentionManager::budget() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_budget;
+}
+
+void RetentionManager::touch(const QString& folderPath)
+{
+    const QString cleaned = QDir::cleanPath(folderPath);
+    QMutexLocker locker(&m_mutex);
+    if (m_root.isEmpty() || !cleaned.startsWith(m_root + "/")) return;
+
+    // Only direct subfolders are managed
+    const QString name = cleaned.mid(m_root.size() + 1).section('/', 0, 0);
+    m_touched.insert(name, QDateTime::currentMSecsSinceEpoch());
+    m_pending = true;
+    m_wake.wakeAll();
+}
+
+RetentionManager::Stats RetentionManager::stats() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_stats;
+}
+
+void RetentionManager::run()
+{
+    for (;;) {
+        QString root;
+        Budget budget;
+        QHash<QString, qint64> touched;
+        {
+            QMutexLocker locker(&m_mutex);
+            while (!m_pending && !m_stopping) {
+                m_wake.wait(&m_mutex);
+            }
+            // Touches come in bursts (one per export); wait for a quiet moment
+            while (!m_stopping && m_wake.wait(&m_mutex, kSettleMs)) {
+            }
+            if (m_stopping) break;
+            m_pending = false;
+            root = m_root;
+            budget = m_budget;
+            touched.swap(m_touched);
+        }
+        pass(root, budget, touched);
+    }
+
+    // Remember the uses that came in after the last pass
+    QHash<QString, qint64> touched;
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_root == m_activeRoot) touched.swap(m_touched);
+    }
+    applyTouches(touched);
+    if (m_manifestDirty) saveManifest();
+}
+
+void RetentionManager::applyTouches(const QHash<QString, qint64>& touched)
+{
+    for (auto it = touched.constBegin(); it != touched.constEnd(); ++it) {
+        Folder& folder = m_folders[it.key()];
+        folder.lastUsed = qMax(folder.lastUsed, it.value());
+        folder.dirty = true;
+        m_manifestDirty = true;
+    }
+}
+
+void RetentionManager::pass(const QString& root, const Budget& budget, const QHash<QString, qint64>& touched)
+{
+    if (root != m_activeRoot) switchRoot(root);
+    if (m_activeRoot.isEmpty()) return;
+
+    applyTouches(touched);
+
+    if (!m_scanned) {
+        // Pick up export folders from earlier runs and forget deleted ones
+        QHash<QString, Folder> present;
+        const QFileInfoList entries = QDir(m_activeRoot).entryInfoList(QDir::Dirs | QDir::NoDotAndDotDot);
+        for (const QFileInfo& entry : entries) {
+            // Once per root, folders exported before the marker existed are marked now
+            if (!isOwned(entry.filePath()) && (m_legacyAdopted || !adoptLegacyFolder(entry.filePath())))
+                continue;
+            Folder folder = m_folders.value(entry.fileName());
+            if (folder.lastUsed == 0) folder.lastUsed = entry.lastModified().toMSecsSinceEpoch();
+            present.insert(entry.fileName(), folder);
+        }
+        // Touched folders that don't exist yet (the export is still queued) stay tracked
+        for (auto it = touched.constBegin(); it != touched.constEnd(); ++it) {
+            if (!present.contains(it.key())) present.insert(it.key(), m_folders.value(it.key()));
+        }
+        m_folders.swap(present);
+        m_scanned = true;
+        m_legacyAdopted = true;
+        m_manifestDirty = true;
+        qDebug() << "[RetentionManager] Found" << m_folders.size() << "folders in" << m_activeRoot;
+    }
+
+    // Re-measure folders that changed since the manifest / last pass. Most recently used
+    // first: a file linked from several folders counts toward the one that is kept longest.
+    std::vector<std::pair<qint64, QString>> byUse;
+    byUse.reserve(m_folders.size());
+    for (auto it = m_folders.constBegin(); it != m_folders.constEnd(); ++it) {
+        byUse.emplace_back(it.value().lastUsed, it.key());
+    }
+    std::sort(byUse.begin(), byUse.end(), std::greater<std::pair<qint64, QString>>());
+
+    const qint64 protectAfter = QDateTime::currentMSecsSinceEpoch() - kProtectMs;
+    qint64 totalBytes = 0;
+    QSet<FileKey> seenLinks;
+    for (const std::pair<qint64, QString>& entry : byUse) {
+        Folder& folder = m_folders[entry.second];
+        const QFileInfo info(m_activeRoot + "/" + entry.second);
+        if (!info.exists() && folder.lastUsed <= protectAfter) {
+            // Deleted by hand, or its export never happened
+            m_folders.remove(entry.second);
+            m_manifestDirty = true;
+            continue;
+        }
+        if (info.exists() && !isOwned(info.filePath())) {
+            // A folder of the user's that an export wrote into: not ours to delete
+            m_folders.remove(entry.second);
+            m_manifestDirty = true;
+            continue;
+        }
+        const qint64 modified = info.exists() ? info.lastModified().toMSecsSinceEpoch() : -1;
+        if (folder.dirty || folder.linked || modified != folder.modified) {
+            folder.linked = false;
+            folder.bytes = modified >= 0 ? folderBytes(info.filePath(), &seenLinks, &folder.linked) : 0;
+            folder.modified = modified;
+            folder.dirty = false;
+            m_manifestDirty = true;
+        }
+        totalBytes += folder.bytes;
+    }
+
+    // Least recently used first
+    std::vector<std::pair<qint64, QString>> order;
+    order.reserve(m_folders.size());
+    for (auto it = m_folders.constBegin(); it != m_folders.constEnd(); ++it) {
+        order.emplace_back(it.value().lastUsed, it.key());
+    }
+    std::sort(order.begin(), order.end());
+
+    int folderCount = static_cast<int>(m_folders.size());
+    quint64 evictedFolders = 0;
+    qint64 evictedBytes = 0;
+    for (size_t i = 0; i + 1 < order.size(); ++i) {  // the newest folder is never a candidate
+        if (folderCount <= budget.maxFolders && totalBytes <= budget.maxBytes) break;
+        if (order[i].first > protectAfter) break;
+
+        const QString path = m_activeRoot + "/" + order[i].second;
+        const qint64 bytes = m_folders.value(order[i].second).bytes;
+        QDir dir(path);
+        if (dir.exists() && !isOwned(path)) {
+            m_folders.remove(order[i].second);  // lost its marker since it was measured
+            m_manifestDirty = true;
+            --folderCount;
+            totalBytes -= bytes;
+            continue;
+        }
+        if (dir.exists() && !dir.removeRecursively()) {
+            qWarning() << "[RetentionManager] Could not delete" << path;
+            continue;
+        }
+        m_folders.remove(order[i].second);
+        m_manifestDirty = true;
+        --folderCount;
+        totalBytes -= bytes;
+        ++evictedFolders;
+        evictedBytes += bytes;
+        qDebug() << "[RetentionManager] Evicted" << path << "(" << bytes / 1024 << "KB)";
+        emit evicted(path, bytes);
+    }
+
+    {
+        QMutexLocker locker(&m_mutex);
+        m_stats.folders = folderCount;
+        m_stats.bytes = totalBytes;
+        m_stats.evictedFolders += evictedFolders;
+        m_stats.evictedBytes += evictedBytes;
+    }
+    if (m_manifestDirty) saveManifest();
+}
+
+void RetentionManager::switchRoot(const QString& root)
+{
+    if (m_manifestDirty) saveManifest();
+    m_activeRoot = root;
+    m_folders.clear();
+    m_scanned = false;
+    m_legacyAdopted = false;
+    m_manifestDirty = false;
+    if (!m_activeRoot.isEmpty()) loadManifest();
+}
+
+QString RetentionManager::manifestPath(const QString& root) const
+{
+    const QString dir = QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation) + "/retention";
+    const QByteArray key = QCryptographicHash::hash(root.toUtf8(), QCryptographicHash::Md5).toHex();
+    return dir + "/" + QString::fromLatin1(key) + ".manifest";
+}
+
+void RetentionManager::loadManifest()
+{
+    QFile file(manifestPath(m_activeRoot));
+    if (!file.open(QIODevice::ReadOnly)) return;
+
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_6_0);
+    quint32 magic = 0, version = 0, count = 0;
+    in >> magic >> version;
+    if (magic != kManifestMagic || version < 1 || version > kManifestVersion) {
+        qDebug() << "[RetentionManager] Ignoring manifest with an old format:" << file.fileName();
+        return;
+    }
+    quint8 legacyAdopted = 0;
+    if (version >= 2) in >> legacyAdopted;
+    m_legacyAdopted = legacyAdopted != 0;
+    in >> count;
+    for (quint32 i = 0; i < count && in.status() == QDataStream::Ok; ++i) {
+        QString name;
+        Folder folder;
+        in >> name >> folder.lastUsed >> folder.bytes >> folder.modified;
+        folder.dirty = false;
+        m_folders.insert(name, folder);
+    }
+}
+
+void RetentionManager::saveManifest()
+{
+    if (m_activeRoot.isEmpty()) return;
+
+    const QString path = manifestPath(m_activeRoot);
+    QDir().mkpath(QFileInfo(path).absolutePath());
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "[RetentionManager] Cannot write manifest:" << path;
+        return;
+    }
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_6_0);
+    out << kManifestMagic << kManifestVersion << quint8(m_legacyAdopted ? 1 : 0)
+        << static_cast<quint32>(m_folders.size());
+    for (auto it = m_folders.constBegin(); it != m_folders.constEnd(); ++it) {
+        // A dirty (or linked) folder is stored unmeasured so the next run measures it
+        out << it.key() << it.value().lastUsed << it.value().bytes
+            << (it.value().dirty || it.value().linked ? qint64(-1) : it.value().modified);
+    }
+    if (file.commit())
+        m_manifestDirty = false;
+    else
+        qWarning() << "[RetentionManager] Cannot write manifest:" << path;
+}
+
+qint64 RetentionManager::folderBytes(const QString& path, QSet<FileKey>* seenLinks, bool* linked)
+{
+    qint64 bytes = 0;
+    QDirIterator it(path, QDir::Files | QDir::Hidden | QDir::NoDotAndDotDot, QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+        const QString filePath = it.next();
+        quint64 volume = 0, index = 0;
+        quint32 links = 1;
+        if (fileIdentity(filePath, &volume, &index, &links) && links > 1) {
+            *linked = true;
+            const FileKey key(volume, index);
+            if (seenLinks->contains(key)) continue;  // counted in a more recently used folder
+            seenLinks->insert(key);
+        }
+        bytes += it.fileInfo().size();
+    }
+    return bytes;
+}
+
+bool RetentionManager::isOwned(const QString& path)
+{
+    return QFileInfo::exists(path + "/" + ExportWriter::ownerMarker());
+}
+
+bool RetentionManager::isLegacyExportFolder(const QString& path)
+{
+    // "<name>/<name>_<kind>.<ext>" and nothing else, with the kinds MainWindow exports and
+    // the extensions ExportWriter writes: a folder of the user's won't look like that
+    const QDir dir(path);
+    if (!dir.entryList(QDir::Dirs | QDir::NoDotAndDotDot | QDir::Hidden).isEmpty()) return false;
+    const QStringList files = dir.entryList(QDir::Files | QDir::Hidden);
+    if (files.isEmpty()) return false;
+    const QRegularExpression exportName(
+        "^" + QRegularExpression::escape(dir.dirName())
+        + "_(suffix|grayscale_shared|posterized|posterized_grayscale)\\.(png|qoi|tif)$");
+    for (const QString& file : files) {
+        if (!exportName.match(file).hasMatch()) return false;
+    }
+    return true;
+}
+
+bool RetentionManager::adoptLegacyFolder(const QString& path)
+{
+    if (!isLegacyExportFolder(path)) return false;
+    QFile marker(path + "/" + ExportWriter::ownerMarker());
+    if (!marker.open(QIODevice::WriteOnly)) {
+        qWarning() << "[RetentionManager] Cannot mark" << path << "as an export folder";
+        return false;
+    }
+    qDebug() << "[RetentionManager] Adopted export folder from an earlier version:" << path;
+    return true;
+}
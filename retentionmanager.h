@@ -0,0 +1,116 @@
+// retentionmanager.h
+
+#ifndef RETENTIONMANAGER_H
+#define RETENTIONMANAGER_H
+
+#include <QObject>
+#include <QString>
+#include <QHash>
+#include <QMutex>
+#include <QPair>
+#include <QSet>
+#include <QWaitCondition>
+
+class QThread;
+
+/*!
+ * \brief The RetentionManager class keeps the shared export folder within a folder-count and
+ *        a byte budget by deleting the least recently used subfolders.
+ *
+ *        It only manages folders directly under root() that ExportWriter created, i.e. that
+ *        hold ExportWriter::ownerMarker(); anything else under the root belongs to the user
+ *        and is neither counted nor deleted. Folders exported before the marker existed are
+ *        adopted (marked) once per root if they hold nothing but the app's own exports (see
+ *        isLegacyExportFolder()). The first pass lists the marked folders left by earlier
+ *        runs and takes their sizes from a manifest (kept per root in the app data folder),
+ *        re-measuring only folders whose modification time changed. Deduplicated exports are
+ *        hard links, so a file is counted once per pass, in the most recently used folder
+ *        that links it; folders holding links are re-measured on every pass.
+ *        All file system work happens on a private thread; touch() only records the use, so
+ *        exports never wait for a scan or a deletion. Folders used in the last minute are
+ *        never evicted, nor is the most recently used one.
+ */
+class RetentionManager : public QObject
+{
+    Q_OBJECT
+public:
+    struct Budget {
+        int maxFolders = 5;
+        qint64 maxBytes = qint64(2) << 30;  // 2 GiB
+    };
+
+    struct Stats {
+        int folders = 0;
+        qint64 bytes = 0;
+        quint64 evictedFolders = 0;
+        qint64 evictedBytes = 0;
+    };
+
+    explicit RetentionManager(QObject* parent = nullptr);
+    ~RetentionManager() override;  // writes the manifest
+
+    static QString defaultRoot();
+
+    // Folder whose subfolders are managed; starts a scan when it changes
+    void setRoot(const QString& root);
+    QString root() const;
+
+    void setBudget(const Budget& budget);
+    Budget budget() const;
+
+    /*!
+     * \brief touch marks a folder under root() as just used (and possibly grown). Thread-safe
+     *        and cheap: the measuring and any eviction run later on the retention thread.
+     */
+    void touch(const QString& folderPath);
+
+    Stats stats() const;
+
+signals:
+    // Emitted from the retention thread
+    void evicted(const QString& folderPath, qint64 bytes);
+
+private:
+    struct Folder {
+        qint64 lastUsed = 0;   // msecs since epoch
+        qint64 bytes = 0;
+        qint64 modified = -1;  // folder mtime when bytes was measured
+        bool dirty = true;     // re-measure on the next pass
+        bool linked = false;   // holds hard links; re-measured on every pass
+    };
+    // (volume, file index) of a file with more than one link
+    using FileKey = QPair<quint64, quint64>;
+
+    void run();
+    void pass(const QString& root, const Budget& budget, const QHash<QString, qint64>& touched);
+    void applyTouches(const QHash<QString, qint64>& touched);
+    void switchRoot(const QString& root);
+    QString manifestPath(const QString& root) const;
+    void loadManifest();
+    void saveManifest();
+    static qint64 folderBytes(const QString& path, QSet<FileKey>* seenLinks, bool* linked);
+    static bool isOwned(const QString& path);
+    static bool isLegacyExportFolder(const QString& path);
+    static bool adoptLegacyFolder(const QString& path);
+
+    QThread* m_thread;
+
+    // Shared with the GUI (and export) thread
+    mutable QMutex m_mutex;
+    QWaitCondition m_wake;
+    QString m_root;
+    Budget m_budget;
+    QHash<QString, qint64> m_touched;  // folder name -> time, since the last pass
+    bool m_pending = false;
+    bool m_stopping = false;
+    Stats m_stats;
+
+    // Only touched by the retention thread
+    QString m_activeRoot;
+    QHash<QString, Folder> m_folders;  // by folder name
+    bool m_scanned = false;
+    bool m_legacyAdopted = false;      // unmarked export folders were adopted for this root
+    bool m_manifestDirty = false;
+};
+
+#endif // RETENTIONMANAGER_H
@@ -0,0 +1,195 @@
+// scratcharena.cpp
+
+#include "scratcharena.h"
+
+#include <QMutexLocker>
+#include <algorithm>
+#include <atomic>
+
+namespace {
+    const size_t kMinBlockBytes = 4096;
+
+    std::atomic<qint64> g_maxIdleBytes{ qint64(256) << 20 };
+
+    std::atomic<quint64> g_borrows{ 0 };
+    std::atomic<quint64> g_reused{ 0 };
+    std::atomic<quint64> g_allocations{ 0 };
+    std::atomic<qint64> g_idleBytes{ 0 };
+    std::atomic<qint64> g_leasedBytes{ 0 };
+
+    // Every thread's arena, for trimAll()
+    QMutex g_registryMutex;
+    std::vector<ScratchArena*>& registry()
+    {
+        static std::vector<ScratchArena*> arenas;
+        return arenas;
+    }
+}
+
+ScratchArena::Lease::~Lease()
+{
+    if (m_arena) m_arena->giveBack(m_block, m_capacity);
+}
+
+ScratchArena::Lease::Lease(Lease&& other) noexcept
+    : mat(std::move(other.mat)),
+    m_arena(other.m_arena),
+    m_block(other.m_block),
+    m_capacity(other.m_capacity)
+{
+    other.m_arena = nullptr;
+    other.m_block = nullptr;
+}
+
+ScratchArena::Lease& ScratchArena::Lease::operator=(Lease&& other) noexcept
+{
+    if (this != &other) {
+        if (m_arena) m_arena->giveBack(m_block, m_capacity);
+        mat = std::move(other.mat);
+        m_arena = other.m_arena;
+        m_block = other.m_block;
+        m_capacity = other.m_capacity;
+        other.m_arena = nullptr;
+        other.m_block = nullptr;
+    }
+    return *this;
+}
+
+ScratchArena& ScratchArena::local()
+{
+    thread_local ScratchArena arena;
+    return arena;
+}
+
+ScratchArena::ScratchArena()
+{
+    QMutexLocker locker(&g_registryMutex);
+    registry().push_back(this);
+}
+
+ScratchArena::~ScratchArena()
+{
+    {
+        QMutexLocker locker(&g_registryMutex);
+        std::vector<ScratchArena*>& arenas = registry();
+        arenas.erase(std::remove(arenas.begin(), arenas.end(), this), arenas.end());
+    }
+    releaseIdle();
+}
+
+size_t ScratchArena::sizeClass(size_t bytes)
+{
+    if (bytes <= kMinBlockBytes) return kMinBlockBytes;
+    // Four classes per power of two: at most ~19% of a block goes unused
+    int bit = 0;
+    for (size_t v = bytes - 1; v > 1; v >>= 1) ++bit;
+    const size_t step = size_t(1) << (bit - 2);
+    return (bytes + step - 1) / step * step;
+}
+
+ScratchArena::Lease ScratchArena::borrow(int rows, int cols, int type)
+{
+    const size_t bytes = static_cast<size_t>(qMax(rows, 0)) * static_cast<size_t>(qMax(cols, 0)) * CV_ELEM_SIZE(type);
+    const size_t capacity = sizeClass(bytes);
+    g_borrows.fetch_add(1, std::memory_order_relaxed);
+
+    uchar* block = nullptr;
+    {
+        QMutexLocker locker(&m_mutex);
+        for (FreeList& list : m_free) {
+            if (list.capacity == capacity && !list.blocks.empty()) {
+                block = list.blocks.back();
+                list.blocks.pop_back();
+                m_idleBytes -= static_cast<qint64>(capacity);
+                break;
+            }
+        }
+    }
+    if (block) {
+        g_reused.fetch_add(1, std::memory_order_relaxed);
+        g_idleBytes.fetch_sub(static_cast<qint64>(capacity), std::memory_order_relaxed);
+    }
+    else {
+        block = static_cast<uchar*>(cv::fastMalloc(capacity));
+        g_allocations.fetch_add(1, std::memory_order_relaxed);
+    }
+    g_leasedBytes.fetch_add(static_cast<qint64>(capacity), std::memory_order_relaxed);
+
+    Lease lease;
+    lease.mat = cv::Mat(rows, cols, type, block);
+    lease.m_arena = this;
+    lease.m_block = block;
+    lease.m_capacity = capacity;
+    return lease;
+}
+
+void ScratchArena::giveBack(uchar* block, size_t capacity)
+{
+    g_leasedBytes.fetch_sub(static_cast<qint64>(capacity), std::memory_order_relaxed);
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_idleBytes + static_cast<qint64>(capacity) <= g_maxIdleBytes.load(std::memory_order_relaxed)) {
+            auto it = std::find_if(m_free.begin(), m_free.end(),
+                [capacity](const FreeList& list) { return list.capacity == capacity; });
+            if (it == m_free.end()) {
+                m_free.push_back({ capacity, {} });
+                it = m_free.end() - 1;
+            }
+            it->blocks.push_back(block);
+            m_idleBytes += static_cast<qint64>(capacity);
+            g_idleBytes.fetch_add(static_cast<qint64>(capacity), std::memory_order_relaxed);
+            return;
+        }
+    }
+    cv::fastFree(block);
+}
+
+qint64 ScratchArena::releaseIdle()
+{
+    std::vector<FreeList> idle;
+    qint64 released = 0;
+    {
+        QMutexLocker locker(&m_mutex);
+        idle.swap(m_free);
+        released = m_idleBytes;
+        m_idleBytes = 0;
+    }
+    for (FreeList& list : idle) {
+        for (uchar* block : list.blocks) {
+            cv::fastFree(block);
+        }
+    }
+    g_idleBytes.fetch_sub(released, std::memory_order_relaxed);
+    return released;
+}
+
+void ScratchArena::trim()
+{
+    releaseIdle();
+}
+
+ScratchArena::Stats ScratchArena::stats()
+{
+    Stats stats;
+    stats.borrows = g_borrows.load(std::memory_order_relaxed);
+    stats.reused = g_reused.load(std::memory_order_relaxed);
+    stats.allocations = g_allocations.load(std::memory_order_relaxed);
+    stats.idleBytes = g_idleBytes.load(std::memory_order_relaxed);
+    stats.leasedBytes = g_leasedBytes.load(std::memory_order_relaxed);
+    return stats;
+}
+
+qint64 ScratchArena::trimAll()
+{
+    QMutexLocker locker(&g_registryMutex);
+    qint64 released = 0;
+    for (ScratchArena* arena : registry()) {
+        released += arena->releaseIdle();
+    }
+    return released;
+}
+
+void ScratchArena::setMaxIdleBytes(qint64 bytes)
+{
+    g_maxIdleBytes.store(qMax<qint64>(0, bytes));
+}
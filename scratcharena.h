@@ -0,0 +1,95 @@
+// scratcharena.h
+
+#ifndef SCRATCHARENA_H
+#define SCRATCHARENA_H
+
+#include <QMutex>
+#include <QtGlobal>
+#include <opencv2/core.hpp>
+#include <cstddef>
+#include <vector>
+
+/*!
+ * \brief The ScratchArena class lends per-thread workspace to the image kernels, so their
+ *        full-frame temporaries are reused across calls instead of allocated every time.
+ *
+ *        Blocks are kept in size classes (quarter-octave steps), so a workspace freed by one
+ *        image serves the next image of the same or a slightly smaller size. Each thread has
+ *        its own arena (local()); a filter update on an image size seen before takes every
+ *        temporary from the arena and performs no heap allocation for it. Idle blocks are
+ *        capped per thread (setMaxIdleBytes) and can be released under memory pressure
+ *        (trimAll).
+ */
+class ScratchArena
+{
+public:
+    /*!
+     * \brief The Lease class is a borrowed block viewed as a cv::Mat; the block goes back to
+     *        the arena when the lease is destroyed. Don't let OpenCV reallocate mat (pass it
+     *        only where the output has exactly its size and type).
+     */
+    class Lease {
+    public:
+        Lease() = default;
+        ~Lease();
+        Lease(Lease&& other) noexcept;
+        Lease& operator=(Lease&& other) noexcept;
+        Lease(const Lease&) = delete;
+        Lease& operator=(const Lease&) = delete;
+
+        cv::Mat mat;
+
+    private:
+        friend class ScratchArena;
+        ScratchArena* m_arena = nullptr;
+        uchar* m_block = nullptr;
+        size_t m_capacity = 0;
+    };
+
+    struct Stats {
+        quint64 borrows = 0;
+        quint64 reused = 0;        // borrows served from an idle block
+        quint64 allocations = 0;   // blocks allocated (the borrows that weren't reused)
+        qint64 idleBytes = 0;      // held by the arenas, ready for reuse
+        qint64 leasedBytes = 0;    // currently borrowed
+    };
+
+    // This thread's arena
+    static ScratchArena& local();
+
+    // Workspace for a rows x cols matrix of the given OpenCV type (continuous)
+    Lease borrow(int rows, int cols, int type);
+    Lease borrow(cv::Size size, int type) { return borrow(size.height, size.width, type); }
+
+    // Frees this arena's idle blocks
+    void trim();
+
+    // All threads together
+    static Stats stats();
+    // Frees the idle blocks of every thread's arena; returns the bytes released
+    static qint64 trimAll();
+    // Idle bytes each arena keeps at most (default 256 MiB); blocks beyond it are freed on return
+    static void setMaxIdleBytes(qint64 bytes);
+
+    ~ScratchArena();
+
+private:
+    ScratchArena();
+    ScratchArena(const ScratchArena&) = delete;
+    ScratchArena& operator=(const ScratchArena&) = delete;
+
+    struct FreeList {
+        size_t capacity;
+        std::vector<uchar*> blocks;
+    };
+
+    static size_t sizeClass(size_t bytes);
+    void giveBack(uchar* block, size_t capacity);
+    qint64 releaseIdle();
+
+    QMutex m_mutex;  // only contended by trimAll()
+    std::vector<FreeList> m_free;  // few entries: one per size class in use
+    qint64 m_idleBytes = 0;
+};
+
+#endif // SCRATCHARENA_H
@@ -1,41 +1,68 @@
-// settingsdialog.h
-
-#ifndef SETTINGSDIALOG_H
-#define SETTINGSDIALOG_H
-
-#include <QDialog>
-#include <QMap>
-#include <QLabel>  // Include QLabel header
-#include "mainwindow.h"  // Include the new header file
-
-class QLineEdit;
-
-class SettingsDialog : public QDialog
-{
-    Q_OBJECT
-public:
-    explicit SettingsDialog(QWidget* parent = nullptr, const QMap<MainWindow::Action, QString>& actionNameMap = {});
-
-    void setKeyMap(const QMap<MainWindow::Action, int>& actionKeyMap);
-    QMap<MainWindow::Action, int> getKeyMap() const;
-
-private slots:
-    void onOkClicked();
-    void onCancelClicked();
-
-private:
-    struct ActionEdit {
-        QLabel* label;
-        QLineEdit* lineEdit;
-        MainWindow::Action action;
-    };
-
-    QVector<ActionEdit> m_actionsEdits;
-    QMap<MainWindow::Action, int> m_tempKeyMap;
-    QMap<MainWindow::Action, QString> m_actionNameMap; // Add this line
-
-
-    void buildUI();
-};
-
+// settingsdialog.h
+
+#ifndef SETTINGSDIALOG_H
+#define SETTINGSDIALOG_H
+
+#include <QDialog>
+#include <QMap>
+#include <QLabel>  // Include QLabel header
+#include "mainwindow.h"  // Include the new header file
+
+class QLineEdit;
+class QComboBox;
+class QSpinBox;
+class QCheckBox;
+
+class SettingsDialog : public QDialog
+{
+    Q_OBJECT
+public:
+    explicit SettingsDialog(QWidget* parent = nullptr, const QMap<MainWindow::Action, QString>& actionNameMap = {});
+
+    void setKeyMap(const QMap<MainWindow::Action, int>& actionKeyMap);
+    QMap<MainWindow::Action, int> getKeyMap() const;
+
+    // Format of the images written to the shared folder ("png", "qoi", "tiff")
+    void setExportEncoder(const QString& name);
+    QString exportEncoder() const;
+
+    // Shared folder location and the budget old folders are evicted to
+    void setSharingFolder(const QString& root, int maxFolders, qint64 maxMB);
+    QString sharingRoot() const;
+    int sharingMaxFolders() const;
+    qint64 sharingMaxMB() const;
+
+    // Overlay with the last load's stage timings
+    void setShowTimingHud(bool show);
+    bool showTimingHud() const;
+
+    // RAM for image buffers before derived images are evicted; 0 is automatic
+    void setMemoryBudgetMB(qint64 mb);
+    qint64 memoryBudgetMB() const;
+
+private slots:
+    void onOkClicked();
+    void onCancelClicked();
+
+private:
+    struct ActionEdit {
+        QLabel* label;
+        QLineEdit* lineEdit;
+        MainWindow::Action action;
+    };
+
+    QVector<ActionEdit> m_actionsEdits;
+    QMap<MainWindow::Action, int> m_tempKeyMap;
+    QMap<MainWindow::Action, QString> m_actionNameMap; // Add this line
+    QComboBox* m_exportEncoderCombo;
+    QLineEdit* m_sharingRootEdit;
+    QSpinBox* m_sharingMaxFoldersSpin;
+    QSpinBox* m_sharingMaxMBSpin;
+    QCheckBox* m_timingHudCheck;
+    QSpinBox* m_memoryBudgetSpin;
+
+
+    void buildUI();
+};
+
 #endif // SETTINGSDIALOG_H
\ No newline at end of file
@@ -0,0 +1,217 @@
+// taskscheduler.cpp
+
+#include "taskscheduler.h"
+
+#include <QDeadlineTimer>
+#include <QDebug>
+#include <QMutexLocker>
+#include <exception>
+
+namespace {
+    // Which scheduler and queue the current thread works for, if any
+    thread_local const TaskScheduler* tCurrentScheduler = nullptr;
+    thread_local int tCurrentWorker = -1;
+}
+
+struct TaskScheduler::TaskGroup::State {
+    QMutex mutex;
+    QWaitCondition done;
+    int pending = 0;
+};
+
+TaskScheduler::TaskGroup::TaskGroup()
+    : m_state(std::make_shared<State>())
+{
+}
+
+void TaskScheduler::TaskGroup::wait() const
+{
+    QMutexLocker locker(&m_state->mutex);
+    while (m_state->pending > 0) {
+        m_state->done.wait(&m_state->mutex);
+    }
+}
+
+bool TaskScheduler::TaskGroup::wait(int timeoutMs) const
+{
+    QDeadlineTimer deadline(timeoutMs);
+    QMutexLocker locker(&m_state->mutex);
+    while (m_state->pending > 0) {
+        if (!m_state->done.wait(&m_state->mutex, deadline)) break;
+    }
+    return m_state->pending == 0;
+}
+
+int TaskScheduler::TaskGroup::pending() const
+{
+    QMutexLocker locker(&m_state->mutex);
+    return m_state->pending;
+}
+
+TaskScheduler& TaskScheduler::instance()
+{
+    static TaskScheduler scheduler;
+    return scheduler;
+}
+
+TaskScheduler::TaskScheduler(int threadCount, int reservedThreads, int maxMemoryHeavy)
+{
+    const int count = qMax(1, threadCount);
+    m_backgroundLimit = qMax(1, count - qMax(0, reservedThreads));
+    m_heavyLimit = qMax(1, maxMemoryHeavy);
+
+    m_workers.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        m_workers.push_back(std::make_unique<Worker>());
+    }
+    for (int i = 0; i < count; ++i) {
+        Worker* worker = m_workers[i].get();
+        worker->thread = QThread::create([this, i]() { run(i); });
+        worker->thread->setObjectName(QString("TaskScheduler-%1").arg(i));
+        worker->thread->start();
+    }
+}
+
+TaskScheduler::~TaskScheduler()
+{
+    shutdown();
+}
+
+void TaskScheduler::shutdown()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_stopping = true;
+        m_wake.wakeAll();
+    }
+    for (const auto& worker : m_workers) {
+        if (!worker->thread) continue;
+        worker->thread->wait();
+        delete worker->thread;
+        worker->thread = nullptr;
+    }
+}
+
+void TaskScheduler::submit(Priority priority, Task task)
+{
+    submit(priority, std::move(task), TaskOptions());
+}
+
+void TaskScheduler::submit(Priority priority, Task task, const TaskOptions& options)
+{
+    {
+        QMutexLocker groupLocker(&options.group.m_state->mutex);
+        ++options.group.m_state->pending;
+    }
+
+    QMutexLocker locker(&m_mutex);
+    int index = tCurrentWorker;
+    if (tCurrentScheduler != this || index < 0) {
+        index = static_cast<int>(m_nextWorker++ % m_workers.size());
+    }
+    m_workers[index]->queues[static_cast<int>(priority)].push_back({ std::move(task), options });
+    ++m_queued;
+    m_wake.wakeOne();
+}
+
+TaskScheduler::Stats TaskScheduler::stats() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_stats;
+}
+
+bool TaskScheduler::takeFrom(std::deque<Entry>& queue, bool newest, Entry* entry)
+{
+    if (queue.empty()) return false;
+
+    // At the heavy cap, pass over heavy tasks (they keep their place) and take a light one
+    const bool heavyAllowed = m_heavyRunning < m_heavyLimit;
+    const int size = static_cast<int>(queue.size());
+    for (int n = 0; n < size; ++n) {
+        const int i = newest ? size - 1 - n : n;
+        if (!heavyAllowed && queue[i].options.memoryHeavy && !queue[i].options.token.isCancelled()) continue;
+        *entry = std::move(queue[i]);
+        queue.erase(queue.begin() + i);
+        return true;
+    }
+    return false;
+}
+
+bool TaskScheduler::takeTask(int index, Entry* entry, int* priority, bool* stolen)
+{
+    const int count = static_cast<int>(m_workers.size());
+    for (int p = 0; p < kPriorityCount; ++p) {
+        // Lower classes are background too, so stop looking
+        if (isBackground(p) && m_backgroundRunning >= m_backgroundLimit) break;
+
+        *priority = p;
+        if (takeFrom(m_workers[index]->queues[p], true, entry)) {
+            *stolen = false;
+            return true;
+        }
+        for (int offset = 1; offset < count; ++offset) {
+            if (takeFrom(m_workers[(index + offset) % count]->queues[p], false, entry)) {
+                *stolen = true;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void TaskScheduler::finish(const TaskGroup& group)
+{
+    QMutexLocker locker(&group.m_state->mutex);
+    if (--group.m_state->pending == 0)
+        group.m_state->done.wakeAll();
+}
+
+void TaskScheduler::run(int index)
+{
+    tCurrentScheduler = this;
+    tCurrentWorker = index;
+
+    QMutexLocker locker(&m_mutex);
+    for (;;) {
+        Entry entry;
+        int priority = 0;
+        bool stolen = false;
+        if (!takeTask(index, &entry, &priority, &stolen)) {
+            if (m_stopping && m_queued == 0) return;
+            m_wake.wait(&m_mutex);
+            continue;
+        }
+        --m_queued;
+
+        if (entry.options.token.isCancelled()) {
+            ++m_stats.cancelled;
+            locker.unlock();
+            entry.task = nullptr;
+            finish(entry.options.group);
+            locker.relock();
+            continue;
+        }
+
+        const bool background = isBackground(priority);
+        const bool heavy = entry.options.memoryHeavy;
+        if (background) ++m_backgroundRunning;
+        if (heavy) ++m_heavyRunning;
+        if (stolen) ++m_stats.stolen;
+        locker.unlock();
+
+        try {
+            entry.task();
+        }
+        catch (const std::exception& e) {
+            qWarning() << "[TaskScheduler] Task failed:" << e.what();
+        }
+        entry.task = nullptr;  // release captures before the group sees the task finish
+        finish(entry.options.group);
+
+        locker.relock();
+        ++m_stats.executed;
+        if (background) --m_backgroundRunning;
+        if (heavy) --m_heavyRunning;
+        if (background || heavy) m_wake.wakeAll();  // a held-back task may start now
+    }
+}
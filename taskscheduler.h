@@ -0,0 +1,143 @@
+// taskscheduler.h
+
+#ifndef TASKSCHEDULER_H
+#define TASKSCHEDULER_H
+
+#include <QMutex>
+#include <QWaitCondition>
+#include <QThread>
+#include <array>
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <vector>
+
+/*!
+ * \brief The TaskScheduler class runs image work on a work-stealing thread pool with
+ *        priority classes, shared by the whole application (instance()).
+ *
+ *        A worker always takes the most urgent task available anywhere: from its own queue
+ *        the newest (so a pipeline it started finishes first), from the other workers' the
+ *        oldest. Background classes (Prefetch and below) never occupy the reserved threads,
+ *        so a visible frame or an interactive filter starts at once even while indexing
+ *        keeps every other core busy. Memory-heavy tasks (full-size decodes, large
+ *        intermediates) are capped separately; the rest keep running meanwhile.
+ *
+ *        Tasks whose CancellationToken is cancelled before they start are dropped; running
+ *        tasks can poll the token themselves. TaskGroup waits for a set of tasks.
+ */
+class TaskScheduler
+{
+public:
+    // Most urgent first
+    enum class Priority {
+        VisibleFrame,       // the image the user is waiting for
+        InteractiveFilter,  // a filter toggle on the displayed image
+        Prefetch,           // images that might be shown next
+        Export,             // writing results out
+        Indexing,           // probing and hashing the library
+    };
+    static constexpr int kPriorityCount = 5;
+
+    // Copies share the flag; a default-constructed token is a fresh, uncancelled one
+    class CancellationToken {
+    public:
+        CancellationToken() : m_cancelled(std::make_shared<std::atomic_bool>(false)) {}
+        void cancel() const { m_cancelled->store(true); }
+        bool isCancelled() const { return m_cancelled->load(); }
+    private:
+        std::shared_ptr<std::atomic_bool> m_cancelled;
+    };
+
+    // Counts its tasks in flight; copies share the count
+    class TaskGroup {
+    public:
+        TaskGroup();
+        void wait() const;
+        bool wait(int timeoutMs) const;  // true when no task is left
+        int pending() const;
+    private:
+        friend class TaskScheduler;
+        struct State;
+        std::shared_ptr<State> m_state;
+    };
+
+    struct TaskOptions {
+        CancellationToken token;
+        TaskGroup group;
+        bool memoryHeavy = false;
+    };
+
+    struct Stats {
+        quint64 executed = 0;
+        quint64 stolen = 0;     // run by a worker other than the one they were queued on
+        quint64 cancelled = 0;  // dropped before they started
+    };
+
+    using Task = std::function<void()>;
+
+    static TaskScheduler& instance();
+
+    /*!
+     * \param threadCount Worker threads.
+     * \param reservedThreads Threads background classes may not use (0 for a batch run).
+     * \param maxMemoryHeavy Memory-heavy tasks running at once.
+     */
+    explicit TaskScheduler(int threadCount = QThread::idealThreadCount(), int reservedThreads = 1,
+        int maxMemoryHeavy = 2);
+    ~TaskScheduler();  // shutdown()
+
+    TaskScheduler(const TaskScheduler&) = delete;
+    TaskScheduler& operator=(const TaskScheduler&) = delete;
+
+    int threadCount() const { return static_cast<int>(m_workers.size()); }
+
+    // Thread-safe; may be called from inside a task
+    void submit(Priority priority, Task task);
+    void submit(Priority priority, Task task, const TaskOptions& options);
+
+    Stats stats() const;
+
+    /*!
+     * \brief shutdown runs what is still queued, then joins the threads. For instance(),
+     *        whose destructor only runs after main() returns: call it before tearing down
+     *        what the tasks use. Tasks submitted afterwards never run.
+     */
+    void shutdown();
+
+private:
+    struct Entry {
+        Task task;
+        TaskOptions options;
+    };
+
+    struct Worker {
+        std::array<std::deque<Entry>, kPriorityCount> queues;
+        QThread* thread = nullptr;
+    };
+
+    static bool isBackground(int priority) { return priority >= static_cast<int>(Priority::Prefetch); }
+
+    void run(int index);
+    bool takeTask(int index, Entry* entry, int* priority, bool* stolen);
+    bool takeFrom(std::deque<Entry>& queue, bool newest, Entry* entry);
+    static void finish(const TaskGroup& group);
+
+    std::vector<std::unique_ptr<Worker>> m_workers;
+    unsigned m_nextWorker = 0;
+
+    // One lock for all queues: tasks are whole-image operations, milliseconds each, so it is
+    // never held long; the per-worker queues are for the order tasks run in.
+    mutable QMutex m_mutex;
+    QWaitCondition m_wake;
+    int m_queued = 0;
+    int m_backgroundRunning = 0;
+    int m_heavyRunning = 0;
+    int m_backgroundLimit = 1;
+    int m_heavyLimit = 2;
+    bool m_stopping = false;
+    Stats m_stats;
+};
+
+#endif // TASKSCHEDULER_H
@@ -0,0 +1,405 @@
+// tiledimage.cpp
+
+#include "tiledimage.h"
+#include "imageutils.h"
+#include "imageprobe.h"
+#include "profiler.h"
+#include "scratcharena.h"
+#include "taskscheduler.h"
+#include "ziparchive.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <MagickWand.h>
+#include <opencv2/opencv.hpp>
+#include <algorithm>
+
+namespace {
+    // Above either, a file is opened tiled
+    const qint64 kLargePixels = qint64(100) * 1000 * 1000;
+    const int kLargeSide = 16384;
+
+    // ImageMagick's in-RAM pixel cache while a tiled frame is open; larger frames go to a
+    // mapped or disk file. The limit is process-wide, so it's restored after the last one.
+    const MagickSizeType kPixelCacheMemory = MagickSizeType(1) << 30;
+
+    const int kOverviewBandRows = 16;  // overview rows per streamed band
+    const int kTileCacheKiB = 256 * 1024;
+
+    QMutex pixelCacheMutex;
+    int pixelCacheUsers = 0;
+    MagickSizeType previousPixelCacheMemory = 0;
+
+    void limitPixelCache()
+    {
+        QMutexLocker locker(&pixelCacheMutex);
+        if (pixelCacheUsers++ > 0) return;
+        previousPixelCacheMemory = MagickGetResourceLimit(MemoryResource);
+        MagickSetResourceLimit(MemoryResource, qMin(previousPixelCacheMemory, kPixelCacheMemory));
+    }
+
+    void restorePixelCache()
+    {
+        QMutexLocker locker(&pixelCacheMutex);
+        if (--pixelCacheUsers > 0) return;
+        MagickSetResourceLimit(MemoryResource, previousPixelCacheMemory);
+    }
+
+    QString magickError(MagickWand* wand)
+    {
+        ExceptionType severity;
+        char* description = MagickGetException(wand, &severity);
+        const QString text = QString::fromUtf8(description ? description : "");
+        if (description) MagickRelinquishMemory(description);
+        return text;
+    }
+
+    QByteArray iccProfileOf(MagickWand* wand)
+    {
+        size_t length = 0;
+        unsigned char* profile = MagickGetImageProfile(wand, "ICC", &length);
+        if (!profile) return QByteArray();
+        QByteArray data(reinterpret_cast<const char*>(profile), static_cast<int>(length));
+        MagickRelinquishMemory(profile);
+        return data;
+    }
+
+    // First frame only: multi-page TIFFs would otherwise decode every page
+    QByteArray magickPath(const QString& filePath)
+    {
+        return (QDir::toNativeSeparators(filePath) + "[0]").toUtf8();
+    }
+}
+
+struct TiledImage::Source {
+    MagickWand* wand = nullptr;  // the full frame, once decoded
+    bool decoded = false;
+
+    Source() { limitPixelCache(); }
+    ~Source()
+    {
+        if (wand) DestroyMagickWand(wand);
+        restorePixelCache();
+    }
+};
+
+bool TiledImage::isLarge(const QString& filePath, QSize* size)
+{
+    if (ZipArchive::isMemberPath(filePath)) return false;
+
+    QSize fullSize;
+    const ImageProbe::Info info = ImageProbe::probeFile(filePath);
+    if (info.valid) {
+        fullSize = QSize(info.width, info.height);
+    }
+    else {
+        // TIFF and PSB (what most scans come as) aren't probed; a ping reads only the header
+        const QString suffix = QFileInfo(filePath).suffix().toLower();
+        if (suffix != "tif" && suffix != "tiff" && suffix != "psb") return false;
+        ImageUtils::initializeMagick();
+        MagickWand* wand = NewMagickWand();
+        if (MagickPingImage(wand, magickPath(filePath).constData()) == MagickTrue)
+            fullSize = QSize(static_cast<int>(MagickGetImageWidth(wand)), static_cast<int>(MagickGetImageHeight(wand)));
+        DestroyMagickWand(wand);
+    }
+    if (size) *size = fullSize;
+    if (fullSize.isEmpty()) return false;
+    return static_cast<qint64>(fullSize.width()) * fullSize.height() >= kLargePixels
+        || qMax(fullSize.width(), fullSize.height()) > kLargeSide;
+}
+
+TiledImage::TiledImage(const QString& filePath)
+    : m_filePath(filePath),
+    m_source(std::make_unique<Source>()),
+    m_tiles(kTileCacheKiB)
+{
+}
+
+TiledImage::~TiledImage()
+{
+    MemoryBudget::instance().removeEvictor(m_evictor);
+}
+
+std::shared_ptr<TiledImage> TiledImage::open(const QString& filePath, int overviewSide)
+{
+    ScopedTimer openTimer("tiled open");
+    ImageUtils::initializeMagick();
+
+    std::shared_ptr<TiledImage> image(new TiledImage(filePath));
+    if (!image->buildOverview(qMax(256, overviewSide))) return nullptr;
+
+    // Cached tiles are the first thing to go under pressure; they're re-rendered on demand
+    std::weak_ptr<TiledImage> weak = image;
+    image->m_evictor = MemoryBudget::instance().addEvictor(MemoryBudget::Category::Derived, [weak]() {
+        const std::shared_ptr<TiledImage> self = weak.lock();
+        return self ? self->evictTiles() : qint64(0);
+        });
+    qDebug() << "[TiledImage] Opened" << filePath << image->m_size << "overview" << image->m_overview.size()
+        << "levels" << image->m_levelCount;
+    return image;
+}
+
+bool TiledImage::buildOverview(int overviewSide)
+{
+    const QByteArray path = magickPath(m_filePath);
+
+    MagickWand* ping = NewMagickWand();
+    if (MagickPingImage(ping, path.constData()) == MagickFalse) {
+        qWarning() << "[TiledImage] Cannot read" << m_filePath << magickError(ping);
+        DestroyMagickWand(ping);
+        return false;
+    }
+    m_size = QSize(static_cast<int>(MagickGetImageWidth(ping)), static_cast<int>(MagickGetImageHeight(ping)));
+    char* format = MagickGetImageFormat(ping);
+    const bool jpeg = format && qstrcmp(format, "JPEG") == 0;
+    if (format) MagickRelinquishMemory(format);
+    DestroyMagickWand(ping);
+    if (m_size.isEmpty()) return false;
+
+    const double scale = qMin(1.0, static_cast<double>(overviewSide) / qMax(m_size.width(), m_size.height()));
+    const cv::Size overviewSize(qMax(1, qRound(m_size.width() * scale)), qMax(1, qRound(m_size.height() * scale)));
+    cv::Mat overview(overviewSize, CV_8UC3);
+
+    if (jpeg) {
+        // libjpeg scales in the DCT by 1/2..1/8: the overview decodes without the full frame
+        ScopedTimer decodeTimer("jpeg scaled decode");
+        MagickWand* wand = NewMagickWand();
+        const QByteArray hint = QByteArray::number(overviewSize.width) + 'x' + QByteArray::number(overviewSize.height);
+        MagickSetOption(wand, "jpeg:size", hint.constData());
+        if (MagickReadImage(wand, path.constData()) == MagickFalse) {
+            qWarning() << "[TiledImage] Cannot decode" << m_filePath << magickError(wand);
+            DestroyMagickWand(wand);
+            return false;
+        }
+        const int width = static_cast<int>(MagickGetImageWidth(wand));
+        const int height = static_cast<int>(MagickGetImageHeight(wand));
+        cv::Mat scaled(height, width, CV_8UC3);
+        MagickExportImagePixels(wand, 0, 0, width, height, "BGR", CharPixel, scaled.data);
+        m_iccProfile = iccProfileOf(wand);
+        DestroyMagickWand(wand);
+        cv::resize(scaled, overview, overviewSize, 0, 0, cv::INTER_AREA);
+    }
+    else {
+        // Decode into the pixel cache, then stream it out a band of rows at a time
+        QMutexLocker wandLocker(&m_wandMutex);
+        if (!ensureDecoded()) return false;
+        m_iccProfile = iccProfileOf(m_source->wand);
+
+        ScopedTimer bandTimer("overview bands");
+        for (int y = 0; y < overviewSize.height; y += kOverviewBandRows) {
+            const int bandEnd = qMin(overviewSize.height, y + kOverviewBandRows);
+            const int sourceTop = static_cast<int>(static_cast<qint64>(y) * m_size.height() / overviewSize.height);
+            const int sourceBottom = static_cast<int>(static_cast<qint64>(bandEnd) * m_size.height() / overviewSize.height);
+            ScratchArena::Lease band = ScratchArena::local().borrow(sourceBottom - sourceTop, m_size.width(), CV_8UC3);
+            if (MagickExportImagePixels(m_source->wand, 0, sourceTop, m_size.width(), sourceBottom - sourceTop,
+                "BGR", CharPixel, band.mat.data) == MagickFalse) {
+                qWarning() << "[TiledImage] Cannot read rows of" << m_filePath << magickError(m_source->wand);
+                return false;
+            }
+            cv::Mat target = overview.rowRange(y, bandEnd);
+            cv::resize(band.mat, target, target.size(), 0, 0, cv::INTER_AREA);
+        }
+    }
+
+    ImageUtils::convertToSRgb(overview, m_iccProfile);
+    cv::cvtColor(overview, overview, cv::COLOR_BGR2RGB);
+    m_overview = ImageUtils::convertMatToQImage(overview);
+    m_overviewSize = m_overview.size();
+
+    const int overviewLong = qMax(overviewSize.width, overviewSize.height);
+    int level = 0;
+    while ((qMax(m_size.width(), m_size.height()) >> level) > overviewLong) ++level;
+    m_levelCount = level + 1;
+    return !m_overview.isNull();
+}
+
+bool TiledImage::ensureDecoded()
+{
+    if (m_source->decoded) return true;
+    ScopedTimer decodeTimer("magick decode");
+    if (!m_source->wand) m_source->wand = NewMagickWand();
+    if (MagickReadImage(m_source->wand, magickPath(m_filePath).constData()) == MagickFalse) {
+        qWarning() << "[TiledImage] Cannot decode" << m_filePath << magickError(m_source->wand);
+        return false;
+    }
+    m_source->decoded = true;
+    return true;
+}
+
+QImage TiledImage::takeOverview()
+{
+    QImage overview = m_overview;
+    m_overview = QImage();
+    return overview;
+}
+
+QSize TiledImage::levelSize(int level) const
+{
+    const int factor = 1 << level;
+    return QSize((m_size.width() + factor - 1) / factor, (m_size.height() + factor - 1) / factor);
+}
+
+QRect TiledImage::tileRegion(int level, int column, int row) const
+{
+    const int span = kTileSize << level;
+    return QRect(column * span, row * span, span, span) & QRect(QPoint(0, 0), m_size);
+}
+
+quint64 TiledImage::tileKey(int level, int column, int row)
+{
+    return (static_cast<quint64>(level) << 48) | (static_cast<quint64>(column) << 24) | static_cast<quint64>(row);
+}
+
+QImage TiledImage::tile(int level, int column, int row) const
+{
+    QMutexLocker locker(&m_mutex);
+    const QImage* image = m_tiles.object(tileKey(level, column, row));
+    return image ? *image : QImage();
+}
+
+void TiledImage::requestTile(int level, int column, int row)
+{
+    const quint64 key = tileKey(level, column, row);
+    QMutexLocker locker(&m_mutex);
+    if (m_tiles.contains(key) || m_queued.contains(key)) return;
+    m_queue.push_back(key);
+    m_queued.insert(key);
+    if (m_draining) return;
+
+    // One task renders the queue: the wand is serialized anyway, and this keeps the other
+    // workers free for the visible frame and filters
+    m_draining = true;
+    TaskScheduler::instance().submit(TaskScheduler::Priority::VisibleFrame, [self = shared_from_this()]() {
+        self->drain();
+        });
+}
+
+void TiledImage::cancelRequests()
+{
+    QMutexLocker locker(&m_mutex);
+    m_queue.clear();
+    m_queued.clear();
+}
+
+void TiledImage::drain()
+{
+    for (;;) {
+        quint64 key;
+        {
+            QMutexLocker locker(&m_mutex);
+            if (m_queue.empty()) {
+                m_draining = false;
+                return;
+            }
+            // The latest paint asked last and is what's on screen now
+            key = m_queue.back();
+            m_queue.pop_back();
+        }
+        const int level = static_cast<int>(key >> 48);
+        const int column = static_cast<int>((key >> 24) & 0xffffff);
+        const int row = static_cast<int>(key & 0xffffff);
+        // Already cached if a coarser tile rendered since was built from it
+        QImage image = tile(level, column, row);
+        if (image.isNull()) {
+            image = renderTile(level, column, row);
+            if (!image.isNull()) storeTile(key, image);
+        }
+
+        {
+            QMutexLocker locker(&m_mutex);
+            m_queued.remove(key);
+        }
+        if (!image.isNull()) emit tileReady(level, column, row);
+    }
+}
+
+void TiledImage::storeTile(quint64 key, const QImage& image)
+{
+    QMutexLocker locker(&m_mutex);
+    m_tiles.insert(key, new QImage(image), qMax<qint64>(1, image.sizeInBytes() / 1024));
+    m_tileMemory.set(static_cast<qint64>(m_tiles.totalCost()) * 1024);
+}
+
+QImage TiledImage::renderTile(int level, int column, int row)
+{
+    const QRect region = tileRegion(level, column, row);
+    if (region.isEmpty()) return QImage();
+    if (level > 0) return downsampleTile(level, column, row);
+
+    ScopedTimer tileTimer("tile render");
+
+    // Full-resolution pixels of the tile's area, straight from the pixel cache
+    ScratchArena::Lease pixels = ScratchArena::local().borrow(region.height(), region.width(), CV_8UC3);
+    {
+        QMutexLocker wandLocker(&m_wandMutex);
+        if (!ensureDecoded()) return QImage();
+        if (MagickExportImagePixels(m_source->wand, region.x(), region.y(), region.width(), region.height(),
+            "BGR", CharPixel, pixels.mat.data) == MagickFalse) {
+            qWarning() << "[TiledImage] Cannot read tile of" << m_filePath << magickError(m_source->wand);
+            return QImage();
+        }
+    }
+
+    cv::Mat bgr = pixels.mat;
+    ImageUtils::convertToSRgb(bgr, m_iccProfile);
+
+    // RGB32 draws without a per-paint conversion
+    cv::cvtColor(bgr, bgr, cv::COLOR_BGR2RGB);
+    return ImageUtils::convertMatToQImage(bgr).convertToFormat(QImage::Format_RGB32);
+}
+
+QImage TiledImage::downsampleTile(int level, int column, int row)
+{
+    // The (up to) four tiles under this one on the next finer level, cached or rendered and
+    // cached now: a level-n tile reads 4 tiles instead of (kTileSize << n)² source pixels,
+    // and its neighbours and the coarser levels reuse what it rendered
+    QImage children[2][2];
+    for (int dy = 0; dy < 2; ++dy) {
+        for (int dx = 0; dx < 2; ++dx) {
+            const int childColumn = column * 2 + dx;
+            const int childRow = row * 2 + dy;
+            if (tileRegion(level - 1, childColumn, childRow).isEmpty()) continue;  // past the edge
+            QImage child = tile(level - 1, childColumn, childRow);
+            if (child.isNull()) {
+                child = renderTile(level - 1, childColumn, childRow);
+                if (child.isNull()) return QImage();
+                storeTile(tileKey(level - 1, childColumn, childRow), child);
+            }
+            children[dy][dx] = child;
+        }
+    }
+
+    ScopedTimer downsampleTimer("tile downsample");
+    const int leftWidth = children[0][0].width();
+    const int topHeight = children[0][0].height();
+    ScratchArena::Lease canvas = ScratchArena::local().borrow(topHeight + children[1][0].height(),
+        leftWidth + children[0][1].width(), CV_8UC4);
+    for (int dy = 0; dy < 2; ++dy) {
+        for (int dx = 0; dx < 2; ++dx) {
+            const QImage& child = children[dy][dx];
+            if (child.isNull()) continue;
+            const cv::Mat view(child.height(), child.width(), CV_8UC4, const_cast<uchar*>(child.constBits()),
+                static_cast<size_t>(child.bytesPerLine()));
+            view.copyTo(canvas.mat(cv::Rect(dx * leftWidth, dy * topHeight, child.width(), child.height())));
+        }
+    }
+
+    // Already sRGB and RGB32: averaged as is
+    const QRect region = tileRegion(level, column, row);
+    const int factor = 1 << level;
+    QImage image((region.width() + factor - 1) / factor, (region.height() + factor - 1) / factor, QImage::Format_RGB32);
+    cv::Mat target(image.height(), image.width(), CV_8UC4, image.bits(), static_cast<size_t>(image.bytesPerLine()));
+    cv::resize(canvas.mat, target, target.size(), 0, 0, cv::INTER_AREA);
+    return image;
+}
+
+qint64 TiledImage::evictTiles()
+{
+    QMutexLocker locker(&m_mutex);
+    const qint64 bytes = static_cast<qint64>(m_tiles.totalCost()) * 1024;
+    m_tiles.clear();
+    m_tileMemory.set(0);
+    return bytes;
+}
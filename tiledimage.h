@@ -0,0 +1,111 @@
+// tiledimage.h
+
+#ifndef TILEDIMAGE_H
+#define TILEDIMAGE_H
+
+#include "memorybudget.h"
+
+#include <QCache>
+#include <QImage>
+#include <QMutex>
+#include <QObject>
+#include <QRect>
+#include <QSet>
+#include <QSize>
+#include <QString>
+#include <memory>
+#include <vector>
+
+/*!
+ * \brief The TiledImage class opens images too large to decode into memory in one piece
+ *        (gigapixel panoramas, museum scans) and serves them as a display overview plus
+ *        full-resolution tiles on demand.
+ *
+ *        The full frame lives in ImageMagick's pixel cache, which is capped in RAM and spills
+ *        to a memory-mapped or disk file beyond that; the overview is built by streaming
+ *        bands of rows out of it, so the process never holds more than a band and the
+ *        overview. JPEGs get their overview from a DCT-scaled decode ("jpeg:size") and are
+ *        only decoded in full when the first tile is needed. Tiles are rendered one at a
+ *        time on the TaskScheduler (newest request first) and kept in an LRU cache that
+ *        reports to the MemoryBudget and is dropped under pressure. Only level 0 tiles are
+ *        read from the pixel cache; each coarser level is downsampled from the one below.
+ */
+class TiledImage : public QObject, public std::enable_shared_from_this<TiledImage>
+{
+    Q_OBJECT
+public:
+    static const int kTileSize = 512;             // tile edge, in the pixels of its level
+    static const int kDefaultOverviewSide = 8192;
+
+    /*!
+     * \brief isLarge tells from the file header whether filePath should be opened tiled.
+     * \param size Receives the full size, if known.
+     */
+    static bool isLarge(const QString& filePath, QSize* size = nullptr);
+
+    // Decodes filePath and builds the overview; nullptr if it can't be read
+    static std::shared_ptr<TiledImage> open(const QString& filePath, int overviewSide = kDefaultOverviewSide);
+
+    ~TiledImage() override;
+
+    QSize size() const { return m_size; }
+    // The overview built by open(): RGB888, sRGB, at most overviewSide on the long side.
+    // The image keeps no copy of it.
+    QImage takeOverview();
+    QSize overviewSize() const { return m_overviewSize; }
+
+    /*!
+     * \brief Level 0 is full resolution, each next level halves it; the last level is the
+     *        first one not larger than the overview.
+     */
+    int levelCount() const { return m_levelCount; }
+    QSize levelSize(int level) const;
+    // Tile (column, row) of a level, in full-resolution pixels
+    QRect tileRegion(int level, int column, int row) const;
+
+    // The cached tile (RGB32), or a null image
+    QImage tile(int level, int column, int row) const;
+    // Renders the tile in the background unless it is cached or queued; emits tileReady
+    void requestTile(int level, int column, int row);
+    // Drops the queued requests (e.g. after a zoom or pan); the tile being rendered completes
+    void cancelRequests();
+
+signals:
+    // Emitted from a scheduler thread
+    void tileReady(int level, int column, int row);
+
+private:
+    explicit TiledImage(const QString& filePath);
+
+    struct Source;
+
+    static quint64 tileKey(int level, int column, int row);
+    bool buildOverview(int overviewSide);
+    bool ensureDecoded();  // m_wandMutex held
+    QImage renderTile(int level, int column, int row);
+    QImage downsampleTile(int level, int column, int row);  // from the next finer level
+    void storeTile(quint64 key, const QImage& image);
+    void drain();
+    qint64 evictTiles();
+
+    QString m_filePath;
+    QSize m_size;
+    QImage m_overview;
+    QSize m_overviewSize;
+    QByteArray m_iccProfile;
+    int m_levelCount = 1;
+
+    QMutex m_wandMutex;               // the wand isn't thread-safe
+    std::unique_ptr<Source> m_source;
+
+    mutable QMutex m_mutex;
+    mutable QCache<quint64, QImage> m_tiles;  // cost in KiB
+    std::vector<quint64> m_queue;     // requests, newest last
+    QSet<quint64> m_queued;
+    bool m_draining = false;
+
+    MemoryBudget::Tracked m_tileMemory{ MemoryBudget::Category::Derived };
+    int m_evictor = 0;
+};
+
+#endif // TILEDIMAGE_H
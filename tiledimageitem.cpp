@@ -0,0 +1,91 @@
+// tiledimageitem.cpp
+
+#include "tiledimageitem.h"
+#include "tiledimage.h"
+
+#include <QPainter>
+#include <QStyleOptionGraphicsItem>
+#include <cmath>
+
+TiledImageItem::TiledImageItem(std::shared_ptr<TiledImage> image, QGraphicsItem* parent)
+    : QGraphicsObject(parent),
+    m_image(std::move(image)),
+    m_scale(static_cast<qreal>(m_image->overviewSize().width()) / m_image->size().width())
+{
+    setFlag(QGraphicsItem::ItemUsesExtendedStyleOption);  // exposedRect
+    connect(m_image.get(), &TiledImage::tileReady, this, &TiledImageItem::onTileReady, Qt::QueuedConnection);
+}
+
+QRectF TiledImageItem::boundingRect() const
+{
+    return QRectF(QPointF(0, 0), QSizeF(m_image->overviewSize()));
+}
+
+QRectF TiledImageItem::itemRect(const QRect& region) const
+{
+    return QRectF(region.x() * m_scale, region.y() * m_scale, region.width() * m_scale, region.height() * m_scale);
+}
+
+void TiledImageItem::paint(QPainter* painter, const QStyleOptionGraphicsItem* option, QWidget* widget)
+{
+    Q_UNUSED(widget);
+
+    // Up to one screen pixel per overview pixel the pixmap underneath is as sharp as it gets
+    const qreal lod = QStyleOptionGraphicsItem::levelOfDetailFromTransform(painter->worldTransform());
+    if (lod <= 1.0) {
+        if (m_level >= 0) m_image->cancelRequests();
+        m_level = -1;
+        return;
+    }
+
+    // The coarsest level with at least one pixel per screen pixel
+    const qreal density = lod * m_scale;  // screen pixels per full-resolution pixel
+    const int level = qBound(0, static_cast<int>(std::floor(std::log2(1.0 / density))), m_image->levelCount() - 1);
+    if (level != m_level) {
+        m_image->cancelRequests();  // for a zoom that's already gone
+        m_level = level;
+    }
+
+    const QRectF exposed = option->exposedRect & boundingRect();
+    if (exposed.isEmpty()) return;
+    const qreal span = static_cast<qreal>(TiledImage::kTileSize << level) * m_scale;
+    const int firstColumn = static_cast<int>(std::floor(exposed.left() / span));
+    const int lastColumn = static_cast<int>(std::ceil(exposed.right() / span)) - 1;
+    const int firstRow = static_cast<int>(std::floor(exposed.top() / span));
+    const int lastRow = static_cast<int>(std::ceil(exposed.bottom() / span)) - 1;
+
+    painter->setRenderHint(QPainter::SmoothPixmapTransform);
+    for (int row = firstRow; row <= lastRow; ++row) {
+        for (int column = firstColumn; column <= lastColumn; ++column) {
+            const QRect region = m_image->tileRegion(level, column, row);
+            if (region.isEmpty()) continue;
+            const QRectF target = itemRect(region);
+
+            const QImage tile = m_image->tile(level, column, row);
+            if (!tile.isNull()) {
+                painter->drawImage(target, tile);
+                continue;
+            }
+            m_image->requestTile(level, column, row);
+
+            // Meanwhile, the part of a coarser tile that covers it, if one is cached
+            for (int coarser = level + 1; coarser < m_image->levelCount(); ++coarser) {
+                const int shift = coarser - level;
+                const QImage parent = m_image->tile(coarser, column >> shift, row >> shift);
+                if (parent.isNull()) continue;
+                const QRect parentRegion = m_image->tileRegion(coarser, column >> shift, row >> shift);
+                const qreal factor = 1.0 / (1 << coarser);
+                const QRectF source((region.x() - parentRegion.x()) * factor, (region.y() - parentRegion.y()) * factor,
+                    region.width() * factor, region.height() * factor);
+                painter->drawImage(target, parent, source);
+                break;
+            }
+        }
+    }
+}
+
+void TiledImageItem::onTileReady(int level, int column, int row)
+{
+    if (level != m_level) return;
+    update(itemRect(m_image->tileRegion(level, column, row)));
+}
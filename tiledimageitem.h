@@ -0,0 +1,40 @@
+// tiledimageitem.h
+
+#ifndef TILEDIMAGEITEM_H
+#define TILEDIMAGEITEM_H
+
+#include <QGraphicsObject>
+#include <memory>
+
+class TiledImage;
+
+/*!
+ * \brief The TiledImageItem class draws full-resolution tiles of a TiledImage over its
+ *        overview pixmap, for the visible area only, once the view is zoomed in past the
+ *        overview's own resolution.
+ *
+ *        Make it a child of the item showing the overview (it uses the overview's pixel
+ *        coordinates). Missing tiles are requested from the TiledImage and, until they
+ *        arrive, stand in with a cached coarser level or the overview underneath.
+ */
+class TiledImageItem : public QGraphicsObject
+{
+    Q_OBJECT
+public:
+    explicit TiledImageItem(std::shared_ptr<TiledImage> image, QGraphicsItem* parent = nullptr);
+
+    QRectF boundingRect() const override;
+    void paint(QPainter* painter, const QStyleOptionGraphicsItem* option, QWidget* widget) override;
+
+private slots:
+    void onTileReady(int level, int column, int row);
+
+private:
+    QRectF itemRect(const QRect& region) const;  // full-resolution pixels -> item coordinates
+
+    std::shared_ptr<TiledImage> m_image;
+    qreal m_scale;     // item units per full-resolution pixel
+    int m_level = -1;  // level of the last paint, -1 while the overview suffices
+};
+
+#endif // TILEDIMAGEITEM_H
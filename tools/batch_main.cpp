@@ -0,0 +1,108 @@
+// batch_main.cpp
+//
+// RefPickerBatch: applies the GUI filters to a whole folder, without the GUI.
+// Usage: RefPickerBatch -i IN -o OUT -c CHAIN [-c CHAIN ...] [-f png|qoi|tiff] [-j N]
+//                       [--in-flight N] [--skip-existing] [--verbose]
+// A chain is "[name=]step,step,..." with steps gray, posterize[:levels], blur[:sigma], median,
+// e.g.  -c gray -c posterize:4 -c "poster_gray=posterize:4,gray"
+
+#include "batchprocessor.h"
+#include "imageutils.h"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDir>
+#include <QFileInfo>
+#include <cstdio>
+
+namespace {
+
+    bool gVerbose = false;
+
+    // ImageUtils logs every load with qDebug; keep the console for the progress lines
+    void quietMessageHandler(QtMsgType type, const QMessageLogContext& context, const QString& message)
+    {
+        if (type == QtDebugMsg && !gVerbose) return;
+        Q_UNUSED(context);
+        std::fprintf(stderr, "%s\n", qPrintable(message));
+    }
+
+    void printProgress(const BatchProcessor::Progress& p)
+    {
+        const double seconds = qMax<qint64>(p.elapsedMs, 1) / 1000.0;
+        std::printf("[batch] %lld/%lld files | %lld written, %lld skipped, %lld failed | %.1f files/s | %.1f MP/s decoded | %d in flight | %.1f s\n",
+            static_cast<long long>(p.filesDone), static_cast<long long>(p.files),
+            static_cast<long long>(p.outputsWritten), static_cast<long long>(p.outputsSkipped),
+            static_cast<long long>(p.outputsFailed + p.filesFailed),
+            p.filesDone / seconds, p.megapixels / seconds, p.inFlight, seconds);
+        std::fflush(stdout);
+    }
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("RefPickerBatch");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Applies the reference picker filters to every image below a folder.");
+    parser.addHelpOption();
+    const QCommandLineOption inputOption({ "i", "input" }, "Folder to process (recursively).", "dir");
+    const QCommandLineOption outputOption({ "o", "output" }, "Folder for the results; the input tree is mirrored.", "dir");
+    const QCommandLineOption chainOption({ "c", "chain" },
+        "Filter chain, \"[name=]step,step,...\"; steps: gray, posterize[:levels], blur[:sigma], median. Repeatable.", "chain");
+    const QCommandLineOption formatOption({ "f", "format" }, "Output format: png, qoi or tiff (default png).", "format", "png");
+    const QCommandLineOption threadsOption({ "j", "threads" }, "Worker threads (default: one per core).", "n");
+    const QCommandLineOption inFlightOption("in-flight", "Decoded images held in memory at once (default: 2 per thread).", "n");
+    const QCommandLineOption skipOption("skip-existing", "Leave outputs that already exist.");
+    const QCommandLineOption verboseOption("verbose", "Show the per-image log.");
+    parser.addOptions({ inputOption, outputOption, chainOption, formatOption, threadsOption,
+        inFlightOption, skipOption, verboseOption });
+    parser.process(app);
+
+    gVerbose = parser.isSet(verboseOption);
+    qInstallMessageHandler(quietMessageHandler);
+
+    BatchProcessor::Options options;
+    options.inputDirectory = QDir::cleanPath(parser.value(inputOption));
+    options.outputDirectory = QDir::cleanPath(parser.value(outputOption));
+    if (parser.value(inputOption).isEmpty() || !QFileInfo(options.inputDirectory).isDir()) {
+        std::fprintf(stderr, "Input folder missing or not a folder: %s\n", qPrintable(parser.value(inputOption)));
+        return 2;
+    }
+    if (parser.value(outputOption).isEmpty()) {
+        std::fprintf(stderr, "No output folder given (-o)\n");
+        return 2;
+    }
+
+    for (const QString& spec : parser.values(chainOption)) {
+        BatchProcessor::Chain chain;
+        QString error;
+        if (!BatchProcessor::parseChain(spec, &chain, &error)) {
+            std::fprintf(stderr, "%s\n", qPrintable(error));
+            return 2;
+        }
+        options.chains << chain;
+    }
+    if (options.chains.isEmpty()) {
+        std::fprintf(stderr, "No filter chain given (-c), e.g. -c gray -c posterize:4\n");
+        return 2;
+    }
+
+    const QString format = parser.value(formatOption).toLower();
+    if (format != "png" && format != "qoi" && format != "tiff") {
+        std::fprintf(stderr, "Unknown format: %s\n", qPrintable(format));
+        return 2;
+    }
+    options.encoder = ExportWriter::encoderFromName(format);
+    if (parser.isSet(threadsOption)) options.threads = parser.value(threadsOption).toInt();
+    if (parser.isSet(inFlightOption)) options.maxInFlight = parser.value(inFlightOption).toInt();
+    options.skipExisting = parser.isSet(skipOption);
+
+    BatchProcessor processor(options);
+    const BatchProcessor::Progress result = processor.run(printProgress);
+    // run() has joined its scheduler, so nothing decodes any more
+    ImageUtils::terminateMagick();
+    return result.filesFailed + result.outputsFailed > 0 ? 1 : 0;
+}
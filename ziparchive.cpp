@@ -0,0 +1,293 @@
+// ziparchive.cpp
+
+#include "ziparchive.h"
+#include "inflate.h"
+#include "mappedfile.h"
+
+#include <QDebug>
+#include <QFileInfo>
+#include <QMutex>
+#include <QMutexLocker>
+#include <list>
+
+namespace {
+
+    const quint32 kLocalHeaderSignature = 0x04034b50;
+    const quint32 kCentralHeaderSignature = 0x02014b50;
+    const quint32 kEndSignature = 0x06054b50;
+    const quint32 kZip64EndSignature = 0x06064b50;
+    const quint32 kZip64LocatorSignature = 0x07064b50;
+
+    const qint64 kEndRecordSize = 22;
+    const qint64 kMaxCommentSize = 0xFFFF;
+    const int kCachedArchives = 8;
+
+    inline quint32 le16(const uchar* p) { return quint32(p[0]) | (quint32(p[1]) << 8); }
+    inline quint32 le32(const uchar* p) { return le16(p) | (le16(p + 2) << 16); }
+    inline quint64 le64(const uchar* p) { return quint64(le32(p)) | (quint64(le32(p + 4)) << 32); }
+
+    // Most recently used first
+    QMutex s_cacheMutex;
+    std::list<std::shared_ptr<const ZipArchive>> s_cache;
+
+} // namespace
+
+ZipArchive::~ZipArchive()
+{
+    if (m_map)
+        m_file.unmap(const_cast<uchar*>(m_map));
+}
+
+std::shared_ptr<const ZipArchive> ZipArchive::open(const QString& archivePath)
+{
+    const QFileInfo info(archivePath);
+    if (!info.isFile()) return nullptr;
+
+    QMutexLocker locker(&s_cacheMutex);
+    for (auto it = s_cache.begin(); it != s_cache.end(); ++it) {
+        if ((*it)->path() != archivePath) continue;
+        if ((*it)->m_fileSize == info.size() && (*it)->lastModified() == info.lastModified()) {
+            s_cache.splice(s_cache.begin(), s_cache, it);
+            return s_cache.front();
+        }
+        s_cache.erase(it);  // changed on disk; readers still holding it keep the old mapping
+        break;
+    }
+
+    std::shared_ptr<ZipArchive> archive(new ZipArchive);
+    if (!archive->load(archivePath))
+        return nullptr;
+
+    s_cache.push_front(archive);
+    if (s_cache.size() > static_cast<size_t>(kCachedArchives))
+        s_cache.pop_back();
+    return archive;
+}
+
+bool ZipArchive::load(const QString& archivePath)
+{
+    m_path = archivePath;
+    m_file.setFileName(archivePath);
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        qWarning() << "[ZipArchive] Cannot open" << archivePath;
+        return false;
+    }
+    const QFileInfo info(m_file);
+    m_fileSize = m_file.size();
+    m_modified = info.lastModified();
+
+    // A truncated or unreachable mapped archive faults its reader, so only map where that
+    // can't happen; otherwise (or if mapping fails) read through m_file
+    if (m_fileSize > 0 && MappedFile::canMapSafely(archivePath))
+        m_map = m_file.map(0, m_fileSize);
+    if (!readCentralDirectory()) {
+        qWarning() << "[ZipArchive] Not a readable ZIP archive:" << archivePath;
+        return false;
+    }
+    return true;
+}
+
+QByteArray ZipArchive::bytesAt(qint64 offset, qint64 length) const
+{
+    if (offset < 0 || length < 0 || offset > m_fileSize || length > m_fileSize - offset)
+        return QByteArray();
+    if (m_map)
+        return QByteArray::fromRawData(reinterpret_cast<const char*>(m_map + offset), static_cast<qsizetype>(length));
+
+    QMutexLocker locker(&m_fileMutex);
+    if (!m_file.seek(offset)) return QByteArray();
+    return m_file.read(length);
+}
+
+bool ZipArchive::readCentralDirectory()
+{
+    // The end record is the last thing in the file, followed only by an optional comment
+    const qint64 searchStart = qMax<qint64>(0, m_fileSize - kEndRecordSize - kMaxCommentSize);
+    const QByteArray tailBytes = bytesAt(searchStart, m_fileSize - searchStart);
+    if (tailBytes.size() != m_fileSize - searchStart) return false;
+    const uchar* tail = reinterpret_cast<const uchar*>(tailBytes.constData());
+    qint64 endOffset = -1;
+    for (qint64 pos = m_fileSize - kEndRecordSize; pos >= searchStart; --pos) {
+        if (le32(tail + (pos - searchStart)) == kEndSignature) {
+            endOffset = pos;
+            break;
+        }
+    }
+    if (endOffset < 0) return false;
+
+    const uchar* end = tail + (endOffset - searchStart);
+    quint64 count = le16(end + 10);
+    quint64 directorySize = le32(end + 12);
+    quint64 directoryOffset = le32(end + 16);
+
+    // ZIP64: the real values are in the ZIP64 end record, found through the locator
+    if (count == 0xFFFF || directorySize == 0xFFFFFFFFu || directoryOffset == 0xFFFFFFFFu) {
+        const QByteArray locatorBytes = bytesAt(endOffset - 20, 20);
+        const uchar* locator = reinterpret_cast<const uchar*>(locatorBytes.constData());
+        if (locatorBytes.size() == 20 && le32(locator) == kZip64LocatorSignature) {
+            const QByteArray end64Bytes = bytesAt(static_cast<qint64>(le64(locator + 8)), 56);
+            const uchar* end64 = reinterpret_cast<const uchar*>(end64Bytes.constData());
+            if (end64Bytes.size() != 56 || le32(end64) != kZip64EndSignature) return false;
+            count = le64(end64 + 32);
+            directorySize = le64(end64 + 40);
+            directoryOffset = le64(end64 + 48);
+        }
+    }
+
+    if (directoryOffset > quint64(m_fileSize) || directorySize > quint64(m_fileSize)) return false;
+    const QByteArray directoryBytes = bytesAt(static_cast<qint64>(directoryOffset), static_cast<qint64>(directorySize));
+    if (directoryBytes.size() != static_cast<qsizetype>(directorySize)) return false;
+    const uchar* directory = reinterpret_cast<const uchar*>(directoryBytes.constData());
+
+    m_members.reserve(static_cast<size_t>(qMin<quint64>(count, directorySize / 46)));
+    const uchar* p = directory;
+    const uchar* directoryEnd = directory + directorySize;
+    for (quint64 i = 0; i < count; ++i) {
+        if (directoryEnd - p < 46 || le32(p) != kCentralHeaderSignature) return false;
+        const quint32 flags = le16(p + 8);
+        const quint16 method = static_cast<quint16>(le16(p + 10));
+        const quint32 nameLength = le16(p + 28);
+        const quint32 extraLength = le16(p + 30);
+        const quint32 commentLength = le16(p + 32);
+        const qint64 recordSize = 46 + qint64(nameLength) + extraLength + commentLength;
+        if (directoryEnd - p < recordSize) return false;
+
+        Member member;
+        member.crc = le32(p + 16);
+        member.compressedSize = le32(p + 20);
+        member.size = le32(p + 24);
+        member.localHeaderOffset = le32(p + 42);
+        member.method = method;
+
+        // ZIP64 extra field: 64-bit values for whichever fields are saturated, in this order
+        const uchar* extra = p + 46 + nameLength;
+        const uchar* extraEnd = extra + extraLength;
+        while (extraEnd - extra >= 4) {
+            const quint32 id = le16(extra);
+            const quint32 size = le16(extra + 2);
+            const uchar* value = extra + 4;
+            const uchar* valueEnd = value + qMin<qint64>(size, extraEnd - value);
+            if (id == 0x0001) {
+                if (member.size == 0xFFFFFFFFu && valueEnd - value >= 8) { member.size = le64(value); value += 8; }
+                if (member.compressedSize == 0xFFFFFFFFu && valueEnd - value >= 8) { member.compressedSize = le64(value); value += 8; }
+                if (member.localHeaderOffset == 0xFFFFFFFFu && valueEnd - value >= 8) { member.localHeaderOffset = le64(value); }
+                break;
+            }
+            extra += 4 + size;
+        }
+
+        const QByteArray rawName(reinterpret_cast<const char*>(p + 46), static_cast<int>(nameLength));
+        // Bit 11 means UTF-8; older tools write the OEM code page, which is mostly ASCII anyway
+        member.name = QString::fromUtf8(rawName);
+        if (!(flags & 0x800) && member.name.contains(QChar::ReplacementCharacter))
+            member.name = QString::fromLatin1(rawName);
+        member.name.replace('\\', '/');
+        p += recordSize;
+
+        // Keep only what we can read: files, not encrypted, stored or deflated, no macOS metadata
+        if (member.name.endsWith('/') || (flags & 0x1) || (method != 0 && method != 8)
+            || member.name.startsWith("__MACOSX/") || member.size < 0 || member.compressedSize < 0) {
+            continue;
+        }
+        m_index.insert(member.name, static_cast<int>(m_members.size()));
+        m_members.push_back(member);
+    }
+    return true;
+}
+
+QByteArray ZipArchive::read(int index, qint64 maxBytes) const
+{
+    if (index < 0 || index >= static_cast<int>(m_members.size())) return QByteArray();
+    const Member& member = m_members[static_cast<size_t>(index)];
+
+    const QByteArray headerBytes = bytesAt(member.localHeaderOffset, 30);
+    const uchar* header = reinterpret_cast<const uchar*>(headerBytes.constData());
+    if (headerBytes.size() != 30 || le32(header) != kLocalHeaderSignature) {
+        qWarning() << "[ZipArchive] Bad local header for" << member.name << "in" << m_path;
+        return QByteArray();
+    }
+    const qint64 dataOffset = member.localHeaderOffset + 30 + le16(header + 26) + le16(header + 28);
+    const qint64 length = (maxBytes >= 0) ? qMin(maxBytes, member.size) : member.size;
+    if (member.method == 0) {
+        // Mapped: no copy, valid as long as this archive is alive (see Data)
+        const qint64 storedLength = qMin(length, member.compressedSize);
+        const QByteArray stored = bytesAt(dataOffset, storedLength);
+        return stored.size() == storedLength ? stored : QByteArray();
+    }
+
+    const QByteArray compressed = bytesAt(dataOffset, member.compressedSize);
+    if (compressed.size() != member.compressedSize) return QByteArray();
+    QByteArray bytes(static_cast<qsizetype>(length), Qt::Uninitialized);
+    const qint64 produced = Inflate::inflateRaw(reinterpret_cast<const uchar*>(compressed.constData()), member.compressedSize,
+        reinterpret_cast<uchar*>(bytes.data()), length);
+    if (produced != length) {
+        qWarning() << "[ZipArchive] Corrupt deflate data for" << member.name << "in" << m_path;
+        return QByteArray();
+    }
+    if (length == member.size && Inflate::crc32(0, reinterpret_cast<const uchar*>(bytes.constData()), length) != member.crc) {
+        qWarning() << "[ZipArchive] CRC mismatch for" << member.name << "in" << m_path;
+        return QByteArray();
+    }
+    return bytes;
+}
+
+bool ZipArchive::isArchiveFile(const QString& path)
+{
+    return path.endsWith(".zip", Qt::CaseInsensitive) || path.endsWith(".cbz", Qt::CaseInsensitive);
+}
+
+QStringList ZipArchive::archiveNameFilters()
+{
+    return { "*.zip", "*.cbz" };
+}
+
+bool ZipArchive::isMemberPath(const QString& path)
+{
+    return path.contains(".zip::", Qt::CaseInsensitive) || path.contains(".cbz::", Qt::CaseInsensitive);
+}
+
+bool ZipArchive::splitMemberPath(const QString& path, QString* archivePath, QString* memberName)
+{
+    qsizetype split = -1;
+    for (const char* suffix : { ".zip::", ".cbz::" }) {
+        const qsizetype at = path.indexOf(QLatin1String(suffix), 0, Qt::CaseInsensitive);
+        if (at >= 0 && (split < 0 || at < split)) split = at;
+    }
+    if (split < 0) return false;
+    if (archivePath) *archivePath = path.left(split + 4);
+    if (memberName) *memberName = path.mid(split + 6);
+    return true;
+}
+
+QString ZipArchive::memberPath(const QString& archivePath, const QString& memberName)
+{
+    return archivePath + "::" + memberName;
+}
+
+bool ZipArchive::readPath(const QString& memberPath, Data* data, qint64 maxBytes)
+{
+    QString archivePath, memberName;
+    if (!splitMemberPath(memberPath, &archivePath, &memberName)) return false;
+    std::shared_ptr<const ZipArchive> archive = open(archivePath);
+    if (!archive) return false;
+    const int index = archive->indexOf(memberName);
+    if (index < 0) return false;
+
+    data->bytes = archive->read(index, maxBytes);
+    data->archive = archive;
+    return !data->bytes.isNull() || archive->members()[static_cast<size_t>(index)].size == 0;
+}
+
+bool ZipArchive::statPath(const QString& memberPath, qint64* size, QDateTime* modified)
+{
+    QString archivePath, memberName;
+    if (!splitMemberPath(memberPath, &archivePath, &memberName)) return false;
+    std::shared_ptr<const ZipArchive> archive = open(archivePath);
+    if (!archive) return false;
+    const int index = archive->indexOf(memberName);
+    if (index < 0) return false;
+
+    if (size) *size = archive->members()[static_cast<size_t>(index)].size;
+    if (modified) *modified = archive->lastModified();
+    return true;
+}
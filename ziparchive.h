@@ -0,0 +1,104 @@
+// ziparchive.h
+
+#ifndef ZIPARCHIVE_H
+#define ZIPARCHIVE_H
+
+#include <QString>
+#include <QStringList>
+#include <QByteArray>
+#include <QDateTime>
+#include <QFile>
+#include <QHash>
+#include <QMutex>
+#include <memory>
+#include <vector>
+
+/*!
+ * \brief The ZipArchive class gives read-only access to the members of a ZIP/CBZ file
+ *        without extracting it.
+ *
+ *        Opening an archive only reads its central directory. Where MappedFile::canMapSafely()
+ *        allows it the archive is memory mapped, and stored members (the usual case for
+ *        JPEG/PNG packs) are returned as a QByteArray that points straight into the mapping;
+ *        elsewhere the central directory and the members are read from the file and stored
+ *        members are copies. Deflated members are decompressed on demand.
+ *
+ *        Members are addressed with virtual paths "<archive path>::<member name>", e.g.
+ *        "C:/refs/hands.cbz::set 2/014.jpg", so they can live in the FileIndex next to loose
+ *        files. open() keeps a small cache of open archives and is thread-safe; a ZipArchive
+ *        itself is immutable and can be read from any thread.
+ */
+class ZipArchive
+{
+public:
+    struct Member {
+        QString name;
+        qint64 localHeaderOffset;
+        qint64 compressedSize;
+        qint64 size;
+        quint32 crc;
+        quint16 method;   // 0 = stored, 8 = deflated
+    };
+
+    // The bytes of a member plus whatever keeps them valid (stored members of a mapped archive alias the mapping)
+    struct Data {
+        QByteArray bytes;
+        std::shared_ptr<const ZipArchive> archive;
+    };
+
+    ~ZipArchive();
+
+    /*!
+     * \brief open returns the (cached) archive at archivePath, or nullptr if it can't be read.
+     *        A cached archive is reopened when the file's size or modification time changed.
+     */
+    static std::shared_ptr<const ZipArchive> open(const QString& archivePath);
+
+    // True for *.zip / *.cbz
+    static bool isArchiveFile(const QString& path);
+    static QStringList archiveNameFilters();
+
+    // Virtual member paths: "<archive>::<member>"
+    static bool isMemberPath(const QString& path);
+    static bool splitMemberPath(const QString& path, QString* archivePath, QString* memberName);
+    static QString memberPath(const QString& archivePath, const QString& memberName);
+
+    /*!
+     * \brief readPath reads a member given its virtual path.
+     * \param maxBytes Read only this much of the member (-1 = all); enough for header probes.
+     * \return False if the archive or member doesn't exist or is corrupt.
+     */
+    static bool readPath(const QString& memberPath, Data* data, qint64 maxBytes = -1);
+
+    /*!
+     * \brief statPath gives the member's (uncompressed) size and the archive's modification time.
+     */
+    static bool statPath(const QString& memberPath, qint64* size, QDateTime* modified);
+
+    const QString& path() const { return m_path; }
+    const QDateTime& lastModified() const { return m_modified; }
+    const std::vector<Member>& members() const { return m_members; }
+    int indexOf(const QString& memberName) const { return m_index.value(memberName, -1); }
+
+    // Member bytes; see Data. Deflated members are checked against their CRC when read whole.
+    QByteArray read(int index, qint64 maxBytes = -1) const;
+
+private:
+    ZipArchive() = default;
+    bool load(const QString& archivePath);
+    bool readCentralDirectory();
+    // length bytes at offset: a view of the mapping, or read from the file if the archive
+    // isn't mapped. Shorter than length if the range is outside the file or unreadable.
+    QByteArray bytesAt(qint64 offset, qint64 length) const;
+
+    QString m_path;
+    qint64 m_fileSize = 0;
+    QDateTime m_modified;
+    mutable QFile m_file;
+    mutable QMutex m_fileMutex;  // reads when not mapped
+    const uchar* m_map = nullptr;
+    std::vector<Member> m_members;
+    QHash<QString, int> m_index;
+};
+
+#endif // ZIPARCHIVE_H